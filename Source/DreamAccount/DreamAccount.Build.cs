@@ -42,6 +42,7 @@ public class DreamAccount : ModuleRules
 				"Slate",
 				"SlateCore",
 				"DeveloperSettings",
+				"WebSockets",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -3,108 +3,256 @@
 
 #include "Async/DreamAccountAsyncAction.h"
 
+#include "DreamAccountCallbackDispatcher.h"
 #include "DreamAccountSettings.h"
-#include "HttpModule.h"
+#include "DreamAccountUtil.h"
 #include "Kismet/GameplayStatics.h"
 
-#define CREATE_NODE() ThisClass* Node = NewObject<ThisClass>();
+namespace DreamAccountAsyncAction
+{
+	/** 把结果交给回调分发器，在分发时节点已被回收则丢弃 */
+	template <typename NodeType, typename FuncType>
+	void DispatchToNode(const TWeakObjectPtr<NodeType>& WeakNode, EDreamAccountDispatchPriority Priority, FuncType Func)
+	{
+		FDreamAccountCallbackDispatcher::Get().Dispatch(Priority, [WeakNode, Func = MoveTemp(Func)]()
+		{
+			if (NodeType* Node = WeakNode.Get())
+			{
+				Func(*Node);
+			}
+		});
+	}
+}
 
-UDreamAccountAsyncAction_UserRegister* UDreamAccountAsyncAction_UserRegister::UserRegister(UObject* WorldContextObject, FDreamAccountInfo User)
+UDreamAccountAsyncActionBase* UDreamAccountAsyncActionBase::CreateNode(UClass* NodeClass, UObject* WorldContextObject, float InTimeout)
 {
-	CREATE_NODE()
-	Node->Info = User;
-	Node->Subsystem = GEngine->GetEngineSubsystem<UDreamAccountSubsystem>();
+	UDreamAccountAsyncActionBase* Node = NewObject<UDreamAccountAsyncActionBase>(GetTransientPackage(), NodeClass);
+	Node->Subsystem = GEngine ? GEngine->GetEngineSubsystem<UDreamAccountSubsystem>() : nullptr;
+	Node->TimeoutSeconds = InTimeout;
 	Node->RegisterWithGameInstance(WorldContextObject);
 	return Node;
 }
 
-void UDreamAccountAsyncAction_UserRegister::Activate()
+void UDreamAccountAsyncActionBase::Activate()
 {
-	if (Subsystem)
+	if (bActive || bFinished)
 	{
-		Subsystem->UserRegister_Internal(Info, [this](const FDreamAccountResult& Result)
-		{
-			if (Result.ErrorType == EDreamAccountErrorType::NORMAL)
-			{
-				OnSuccess.Broadcast(Result);
-			}
-			else
-			{
-				OnFailure.Broadcast(Result);
-			}
-		});
+		return;
 	}
-	else
+
+	if (!Subsystem)
+	{
+		BroadcastUnavailable();
+		Finish();
+		return;
+	}
+
+	bActive = true;
+	if (TimeoutSeconds > 0.0f)
+	{
+		TimeoutHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::HandleTimeout), TimeoutSeconds);
+	}
+
+	Execute();
+}
+
+void UDreamAccountAsyncActionBase::Cancel()
+{
+	if (!bActive)
+	{
+		return;
+	}
+
+	bActive = false;
+	CancelOperation();
+	OnCancelled.Broadcast();
+	Finish();
+}
+
+bool UDreamAccountAsyncActionBase::IsActive() const
+{
+	return bActive;
+}
+
+bool UDreamAccountAsyncActionBase::HandleTimeout(float DeltaTime)
+{
+	TimeoutHandle.Reset();
+
+	if (bActive)
 	{
-		OnFailure.Broadcast(FDreamAccountResult());
+		bActive = false;
+		CancelOperation();
+		OnTimeout.Broadcast();
+		Finish();
+	}
+
+	return false;
+}
+
+void UDreamAccountAsyncActionBase::Finish()
+{
+	bActive = false;
+	bFinished = true;
+	if (TimeoutHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TimeoutHandle);
+		TimeoutHandle.Reset();
 	}
 
 	SetReadyToDestroy();
 }
 
-UDreamAccountAsyncAction_UserLogin* UDreamAccountAsyncAction_UserLogin::UserLogin(UObject* WorldContextObject, FDreamAccountInfo User)
+void UDreamAccountAsyncAction_AccountResult::BroadcastUnavailable()
 {
-	CREATE_NODE()
-	Node->Info = User;
-	Node->Subsystem = GEngine->GetEngineSubsystem<UDreamAccountSubsystem>();
-	Node->RegisterWithGameInstance(WorldContextObject);
-	return Node;
+	OnFailure.Broadcast(FDreamAccountResult());
 }
 
-void UDreamAccountAsyncAction_UserLogin::Activate()
+void UDreamAccountAsyncAction_AccountResult::BroadcastResult(const FDreamAccountResult& Result)
 {
-	if (Subsystem)
+	if (Result.ErrorType == EDreamAccountErrorType::NORMAL)
 	{
-		Subsystem->UserLogin_Internal(Info, [this](const FDreamAccountResult& Result)
-		{
-			if (Result.ErrorType == EDreamAccountErrorType::NORMAL)
-			{
-				OnSuccess.Broadcast(Result);
-			}
-			else
-			{
-				OnFailure.Broadcast(Result);
-			}
-		});
+		OnSuccess.Broadcast(Result);
 	}
 	else
 	{
-		OnFailure.Broadcast(FDreamAccountResult());	
+		OnFailure.Broadcast(Result);
 	}
+}
 
-	SetReadyToDestroy();
+UDreamAccountAsyncAction_UserRegister* UDreamAccountAsyncAction_UserRegister::UserRegister(UObject* WorldContextObject, FDreamAccountInfo User, float Timeout)
+{
+	ThisClass* Node = AcquireNode<ThisClass>(WorldContextObject, Timeout);
+	Node->Info = User;
+	return Node;
 }
 
-UDreamAccountAsyncAction_UserAuthentication* UDreamAccountAsyncAction_UserAuthentication::UserAuthentication(UObject* WorldContextObject)
+void UDreamAccountAsyncAction_UserRegister::Execute()
 {
-	CREATE_NODE()
-	Node->Subsystem =GEngine->GetEngineSubsystem<UDreamAccountSubsystem>();
-	Node->RegisterWithGameInstance(WorldContextObject);
+	Subsystem->UserRegister_Internal(MoveTemp(Info), MakeCallback(&ThisClass::BroadcastResult));
+}
+
+UDreamAccountAsyncAction_UserLogin* UDreamAccountAsyncAction_UserLogin::UserLogin(UObject* WorldContextObject, FDreamAccountInfo User, float Timeout)
+{
+	ThisClass* Node = AcquireNode<ThisClass>(WorldContextObject, Timeout);
+	Node->Info = User;
+	return Node;
+}
+
+void UDreamAccountAsyncAction_UserLogin::Execute()
+{
+	Subsystem->UserLogin_Internal(MoveTemp(Info), MakeCallback(&ThisClass::BroadcastResult));
+}
+
+UDreamAccountAsyncAction_UserLoginWithQueue* UDreamAccountAsyncAction_UserLoginWithQueue::UserLoginWithQueue(UObject* WorldContextObject, FDreamAccountInfo User, float Timeout)
+{
+	ThisClass* Node = AcquireNode<ThisClass>(WorldContextObject, Timeout);
+	Node->Info = User;
 	return Node;
 }
 
-void UDreamAccountAsyncAction_UserAuthentication::Activate()
+void UDreamAccountAsyncAction_UserLoginWithQueue::Execute()
 {
-	if (Subsystem)
+	WaitingRoom = Subsystem->UserLogin_Internal(MoveTemp(Info), MakeCallback(&ThisClass::BroadcastResult), MakeCallback(&ThisClass::BroadcastQueueUpdate, false));
+}
+
+void UDreamAccountAsyncAction_UserLoginWithQueue::CancelOperation()
+{
+	// 离开本次登录的排队，服务器可以把名额让给其他玩家；其他节点或代码发起的排队不受影响
+	Subsystem->CancelWaitingRoom(WaitingRoom);
+	WaitingRoom.Reset();
+}
+
+void UDreamAccountAsyncAction_UserLoginWithQueue::BroadcastQueueUpdate(const FDreamAccountQueueStatus& Status)
+{
+	OnQueueUpdate.Broadcast(Status);
+}
+
+UDreamAccountAsyncAction_UserRegisterAndLogin* UDreamAccountAsyncAction_UserRegisterAndLogin::UserRegisterAndLogin(UObject* WorldContextObject, FDreamAccountInfo User, float Timeout)
+{
+	ThisClass* Node = AcquireNode<ThisClass>(WorldContextObject, Timeout);
+	Node->Info = User;
+	return Node;
+}
+
+void UDreamAccountAsyncAction_UserRegisterAndLogin::Execute()
+{
+	Subsystem->UserRegisterAndLogin_Internal(MoveTemp(Info), MakeCallback(&ThisClass::BroadcastResult));
+}
+
+UDreamAccountAsyncAction_UserAuthentication* UDreamAccountAsyncAction_UserAuthentication::UserAuthentication(UObject* WorldContextObject, float Timeout)
+{
+	return AcquireNode<ThisClass>(WorldContextObject, Timeout);
+}
+
+void UDreamAccountAsyncAction_UserAuthentication::Execute()
+{
+	Subsystem->AuthenticationToken_Internal(MakeCallback(&ThisClass::BroadcastResult));
+}
+
+UDreamAccountAsyncAction_LookupUsers* UDreamAccountAsyncAction_LookupUsers::LookupUsers(UObject* WorldContextObject, const TArray<int32>& UserIDs, float Timeout)
+{
+	ThisClass* Node = AcquireNode<ThisClass>(WorldContextObject, Timeout);
+	Node->UserIDs = UserIDs;
+	return Node;
+}
+
+void UDreamAccountAsyncAction_LookupUsers::Execute()
+{
+	Subsystem->LookupUsers_Internal(UserIDs, MakeCallback(&ThisClass::BroadcastResult, true, EDreamAccountDispatchPriority::Background));
+}
+
+void UDreamAccountAsyncAction_LookupUsers::BroadcastUnavailable()
+{
+	OnFailure.Broadcast(FDreamAccountUserLookupResult());
+}
+
+void UDreamAccountAsyncAction_LookupUsers::BroadcastResult(const FDreamAccountUserLookupResult& Result)
+{
+	if (Result.ErrorType == EDreamAccountErrorType::NORMAL)
 	{
-		Subsystem->AuthenticationToken_Internal([this](const FDreamAccountResult& Result)
-		{
-			if (Result.ErrorType == EDreamAccountErrorType::NORMAL)
-			{
-				OnSuccess.Broadcast(Result);
-			}
-			else
-			{
-				OnFailure.Broadcast(Result);
-			}
-		});
+		OnSuccess.Broadcast(Result);
 	}
 	else
 	{
-		OnFailure.Broadcast(FDreamAccountResult());
+		OnFailure.Broadcast(Result);
 	}
+}
 
-	SetReadyToDestroy();
+UDreamAccountAsyncAction_CheckUsername* UDreamAccountAsyncAction_CheckUsername::CheckUsernameAvailability(UObject* WorldContextObject, FName FieldKey, const FString& UserName, float Timeout)
+{
+	ThisClass* Node = AcquireNode<ThisClass>(WorldContextObject, Timeout);
+	Node->FieldKey = FieldKey;
+	Node->UserName = UserName;
+	return Node;
+}
+
+void UDreamAccountAsyncAction_CheckUsername::Execute()
+{
+	Subsystem->CheckUsernameAvailability_Internal(FieldKey, UserName, MakeCallback(&ThisClass::BroadcastResult));
+}
+
+void UDreamAccountAsyncAction_CheckUsername::BroadcastUnavailable()
+{
+	OnFailure.Broadcast(FDreamAccountUsernameCheckResult());
+}
+
+void UDreamAccountAsyncAction_CheckUsername::BroadcastResult(const FDreamAccountUsernameCheckResult& Result)
+{
+	if (Result.ErrorType == EDreamAccountErrorType::NORMAL)
+	{
+		if (Result.bAvailable)
+		{
+			OnAvailable.Broadcast(Result);
+		}
+		else
+		{
+			OnTaken.Broadcast(Result);
+		}
+	}
+	else if (Result.ErrorType != EDreamAccountErrorType::LOCAL_REQUEST_CANCELLED)
+	{
+		OnFailure.Broadcast(Result);
+	}
 }
 
 UDreamPingServer* UDreamPingServer::PingServer(UObject* WorldContextObject, const FString& InURL)
@@ -119,28 +267,22 @@ void UDreamPingServer::Activate()
 {
 	StartTime = FPlatformTime::Seconds();
 
-	FHttpModule* Http = &FHttpModule::Get();
-	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = Http->CreateRequest();
-	Request->SetURL(URL);
-	Request->SetVerb(TEXT("GET"));
-	Request->SetTimeout(UDreamAccountSettings::Get()->TimeoutTime);
-
-	Request->OnProcessRequestComplete().BindLambda([this](FHttpRequestPtr, FHttpResponsePtr, bool bSuccess)
+	FDreamAccountUtil::SendHttpRequest(URL, TEXT("GET"), TMap<FString, FString>(), [WeakThis = TWeakObjectPtr<ThisClass>(this), StartTime = StartTime](const FDreamAccountHttpResponse& Response)
 	{
-		float PingMs = -1.0f;
-		if (bSuccess)
-		{
-			double EndTime = FPlatformTime::Seconds();
-			PingMs = static_cast<float>((EndTime - StartTime) * 1000.0);
-			OnSuccess.Broadcast(PingMs);
-		}
-		else
+		// 在排队分发之前计算延迟，排队时间不计入
+		const float PingMs = Response.bSucceeded ? static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0) : -1.0f;
+		DreamAccountAsyncAction::DispatchToNode(WeakThis, EDreamAccountDispatchPriority::Background, [PingMs](ThisClass& Node)
 		{
-			OnFailure.Broadcast(-1.f);
-		}
+			if (PingMs >= 0.0f)
+			{
+				Node.OnSuccess.Broadcast(PingMs);
+			}
+			else
+			{
+				Node.OnFailure.Broadcast(-1.f);
+			}
 
-		SetReadyToDestroy();
+			Node.SetReadyToDestroy();
+		});
 	});
-
-	Request->ProcessRequest();
 }
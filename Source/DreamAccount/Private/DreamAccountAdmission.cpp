@@ -0,0 +1,360 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountAdmission.h"
+
+#include "DreamAccountBanList.h"
+#include "DreamAccountCallbackDispatcher.h"
+#include "DreamAccountModule.h"
+#include "HAL/IConsoleManager.h"
+
+namespace DreamAccountAdmission
+{
+	static FAutoConsoleCommand CmdStats(
+		TEXT("DreamAccount.Admission.Stats"),
+		TEXT("输出玩家加入时令牌校验的排队、复用与等待时间统计"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const FDreamAccountAdmissionStats Stats = FDreamAccountAdmissionController::Get().GetStats();
+			UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount admission: Admitted=%d Rejected=%d Busy=%d CacheHits=%d Validations=%d InFlight=%d Queued=%d PeakQueue=%d AvgWait=%.1fms MaxWait=%.1fms"),
+				Stats.AdmittedCount, Stats.RejectedCount, Stats.BusyCount, Stats.CacheHitCount, Stats.ValidationCount,
+				Stats.InFlightCount, Stats.QueueLength, Stats.PeakQueueLength, Stats.AverageWaitMs, Stats.MaxWaitMs);
+		}));
+
+	static FAutoConsoleCommand CmdReset(
+		TEXT("DreamAccount.Admission.Reset"),
+		TEXT("清空准入统计与复用的校验结果"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FDreamAccountAdmissionController::Get().ResetStats();
+			FDreamAccountAdmissionController::Get().EmptyCache();
+		}));
+}
+
+FDreamAccountAdmissionController& FDreamAccountAdmissionController::Get()
+{
+	static FDreamAccountAdmissionController Instance;
+	return Instance;
+}
+
+FDreamAccountAdmissionController::FDreamAccountAdmissionController()
+{
+}
+
+void FDreamAccountAdmissionController::Configure(int32 InMaxInFlight, int32 InMaxQueueLength, double InQueueTimeout, double InResultTimeToLive)
+{
+	MaxInFlight = FMath::Max(InMaxInFlight, 1);
+	MaxQueueLength = FMath::Max(InMaxQueueLength, 0);
+	QueueTimeout = InQueueTimeout;
+	ResultTimeToLive = InResultTimeToLive;
+}
+
+void FDreamAccountAdmissionController::Admit(const FString& Token, const FString& UserName, FDreamAccountAdmissionCallback Callback)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (Token.IsEmpty())
+	{
+		Deliver({{MoveTemp(Callback), Now}}, EDreamAccountErrorType::LOCAL_TOKEN_NOT_VALID, FDreamAccountUser(), Now, false);
+		return;
+	}
+
+	if (const FCacheEntry* Entry = Cache.Find(Token))
+	{
+		if (Now < Entry->ExpireTime)
+		{
+			++CacheHitCount;
+			Deliver({{MoveTemp(Callback), Now}}, Entry->ErrorType, Entry->User, Now, true);
+			return;
+		}
+		Cache.Remove(Token);
+	}
+
+	// 同一令牌已在排队或校验中时只挂接等待
+	if (FPendingToken* Existing = Pending.Find(Token))
+	{
+		Existing->Waiters.Add({MoveTemp(Callback), Now});
+		return;
+	}
+
+	if (MaxQueueLength > 0 && GetQueueLength() >= MaxQueueLength)
+	{
+		++BusyCount;
+		Deliver({{MoveTemp(Callback), Now}}, EDreamAccountErrorType::LOCAL_SERVER_BUSY, FDreamAccountUser(), Now, false);
+		return;
+	}
+
+	FPendingToken& NewPending = Pending.Add(Token);
+	NewPending.UserName = UserName;
+	NewPending.EnqueueTime = Now;
+	NewPending.Waiters.Add({MoveTemp(Callback), Now});
+
+	Queue.Add(Token);
+	PeakQueueLength = FMath::Max(PeakQueueLength, GetQueueLength());
+
+	Pump();
+
+	if (QueueTimeout > 0.0 && GetQueueLength() > 0 && !ExpireHandle.IsValid())
+	{
+		const float Interval = static_cast<float>(FMath::Clamp(QueueTimeout * 0.1, 0.05, 1.0));
+		ExpireHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FDreamAccountAdmissionController::HandleExpireTimer), Interval);
+	}
+}
+
+void FDreamAccountAdmissionController::CancelAll()
+{
+	TMap<FString, FPendingToken> Cancelled = MoveTemp(Pending);
+	Pending.Reset();
+	Queue.Reset();
+	QueueHead = 0;
+	InFlightCount = 0;
+	++CancelGeneration;
+
+	if (ExpireHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ExpireHandle);
+		ExpireHandle.Reset();
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	for (TPair<FString, FPendingToken>& Pair : Cancelled)
+	{
+		Deliver(MoveTemp(Pair.Value.Waiters), EDreamAccountErrorType::LOCAL_REQUEST_CANCELLED, FDreamAccountUser(), Now, false);
+	}
+}
+
+FDreamAccountAdmissionStats FDreamAccountAdmissionController::GetStats() const
+{
+	FDreamAccountAdmissionStats Stats;
+	Stats.AdmittedCount = AdmittedCount;
+	Stats.RejectedCount = RejectedCount;
+	Stats.BusyCount = BusyCount;
+	Stats.CacheHitCount = CacheHitCount;
+	Stats.ValidationCount = ValidationCount;
+	Stats.InFlightCount = InFlightCount;
+	Stats.QueueLength = GetQueueLength();
+	Stats.PeakQueueLength = PeakQueueLength;
+	Stats.AverageWaitMs = WaitSampleCount > 0 ? static_cast<float>(TotalWaitSeconds * 1000.0 / WaitSampleCount) : 0.0f;
+	Stats.MaxWaitMs = static_cast<float>(MaxWaitSeconds * 1000.0);
+	return Stats;
+}
+
+void FDreamAccountAdmissionController::ResetStats()
+{
+	AdmittedCount = 0;
+	RejectedCount = 0;
+	BusyCount = 0;
+	CacheHitCount = 0;
+	ValidationCount = 0;
+	PeakQueueLength = GetQueueLength();
+	TotalWaitSeconds = 0.0;
+	MaxWaitSeconds = 0.0;
+	WaitSampleCount = 0;
+}
+
+void FDreamAccountAdmissionController::Pump()
+{
+	while (InFlightCount < MaxInFlight && GetQueueLength() > 0)
+	{
+		const FString Token = PopQueue();
+
+		FPendingToken* Entry = Pending.Find(Token);
+		if (!Entry)
+		{
+			continue;
+		}
+
+		const double Now = FPlatformTime::Seconds();
+
+		// 排队过久的玩家大多已经断开，不再占用校验名额
+		if (QueueTimeout > 0.0 && Now - Entry->EnqueueTime > QueueTimeout)
+		{
+			TArray<FWaiter> Waiters = MoveTemp(Entry->Waiters);
+			Pending.Remove(Token);
+			BusyCount += Waiters.Num();
+			Deliver(MoveTemp(Waiters), EDreamAccountErrorType::LOCAL_SERVER_BUSY, FDreamAccountUser(), Now, false);
+			continue;
+		}
+
+		if (!Validator)
+		{
+			TArray<FWaiter> Waiters = MoveTemp(Entry->Waiters);
+			Pending.Remove(Token);
+			Deliver(MoveTemp(Waiters), EDreamAccountErrorType::UNKNOWN, FDreamAccountUser(), Now, false);
+			continue;
+		}
+
+		Entry->bInFlight = true;
+		Entry->DispatchTime = Now;
+		++InFlightCount;
+		++ValidationCount;
+
+		// 校验函数可能同步回调并移除 Entry，先复制参数
+		const FString UserName = Entry->UserName;
+		Validator(Token, UserName, [this, Token, Generation = CancelGeneration](const FDreamAccountResult& Result)
+		{
+			HandleValidated(Token, Generation, Result);
+		});
+	}
+}
+
+void FDreamAccountAdmissionController::ExpireQueued(double Now)
+{
+	// 令牌按到达顺序排队，超时的只会在队首
+	while (GetQueueLength() > 0)
+	{
+		const FPendingToken* Entry = Pending.Find(Queue[QueueHead]);
+		if (Entry && Now - Entry->EnqueueTime <= QueueTimeout)
+		{
+			break;
+		}
+
+		const FString Token = PopQueue();
+		if (Entry)
+		{
+			TArray<FWaiter> Waiters = MoveTemp(Pending[Token].Waiters);
+			Pending.Remove(Token);
+			BusyCount += Waiters.Num();
+			Deliver(MoveTemp(Waiters), EDreamAccountErrorType::LOCAL_SERVER_BUSY, FDreamAccountUser(), Now, false);
+		}
+	}
+}
+
+bool FDreamAccountAdmissionController::HandleExpireTimer(float DeltaTime)
+{
+	if (QueueTimeout > 0.0)
+	{
+		ExpireQueued(FPlatformTime::Seconds());
+	}
+
+	if (QueueTimeout <= 0.0 || GetQueueLength() == 0)
+	{
+		ExpireHandle.Reset();
+		return false;
+	}
+	return true;
+}
+
+FString FDreamAccountAdmissionController::PopQueue()
+{
+	FString Token = MoveTemp(Queue[QueueHead++]);
+
+	// 已出队的部分超过一半时整体移除，每个令牌平均只移动常数次
+	if (QueueHead == Queue.Num())
+	{
+		Queue.Reset();
+		QueueHead = 0;
+	}
+	else if (QueueHead >= 64 && QueueHead * 2 >= Queue.Num())
+	{
+		Queue.RemoveAt(0, QueueHead, EAllowShrinking::No);
+		QueueHead = 0;
+	}
+
+	return Token;
+}
+
+void FDreamAccountAdmissionController::HandleValidated(const FString& Token, uint32 Generation, const FDreamAccountResult& Result)
+{
+	// 已被 CancelAll 取消；同一令牌此后可能已重新排队，不能按令牌匹配
+	if (Generation != CancelGeneration)
+	{
+		return;
+	}
+
+	FPendingToken* Entry = Pending.Find(Token);
+	if (!Entry || !Entry->bInFlight)
+	{
+		return;
+	}
+
+	--InFlightCount;
+	TArray<FWaiter> Waiters = MoveTemp(Entry->Waiters);
+	const double DispatchTime = Entry->DispatchTime;
+	Pending.Remove(Token);
+
+	const double Now = FPlatformTime::Seconds();
+	if (ResultTimeToLive > 0.0 && IsCacheable(Result.ErrorType))
+	{
+		if (Cache.Num() >= MaxCacheEntries)
+		{
+			for (auto It = Cache.CreateIterator(); It; ++It)
+			{
+				if (Now >= It.Value().ExpireTime)
+				{
+					It.RemoveCurrent();
+				}
+			}
+		}
+
+		if (Cache.Num() < MaxCacheEntries)
+		{
+			FCacheEntry& CacheEntry = Cache.Add(Token);
+			CacheEntry.ErrorType = Result.ErrorType;
+			CacheEntry.User = Result.User;
+			CacheEntry.ExpireTime = Now + ResultTimeToLive;
+		}
+	}
+
+	Deliver(MoveTemp(Waiters), Result.ErrorType, Result.User, DispatchTime, false);
+
+	// 回调之后再补充名额，回调中新加入的请求也按顺序排队
+	Pump();
+}
+
+void FDreamAccountAdmissionController::Deliver(TArray<FWaiter> Waiters, EDreamAccountErrorType ErrorType, const FDreamAccountUser& User, double DispatchTime, bool bFromCache)
+{
+	// 封禁可能发生在结果被复用期间，每次都按本地封禁列表再检查一次
+	if (ErrorType == EDreamAccountErrorType::NORMAL && FDreamAccountBanList::Get().IsBanned(User.UserID))
+	{
+		ErrorType = EDreamAccountErrorType::NETWORK_USER_BANNED;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	for (FWaiter& Waiter : Waiters)
+	{
+		FDreamAccountAdmissionResult Result;
+		Result.ErrorType = ErrorType;
+		Result.User = ErrorType == EDreamAccountErrorType::NORMAL ? User : FDreamAccountUser();
+		Result.bFromCache = bFromCache;
+		Result.WaitMs = static_cast<float>(FMath::Max(DispatchTime - Waiter.EnqueueTime, 0.0) * 1000.0);
+		Result.ValidationMs = static_cast<float>(FMath::Max(Now - FMath::Max(DispatchTime, Waiter.EnqueueTime), 0.0) * 1000.0);
+		Result.bIsValidResult = true;
+
+		if (ErrorType == EDreamAccountErrorType::NORMAL)
+		{
+			++AdmittedCount;
+		}
+		else if (ErrorType != EDreamAccountErrorType::LOCAL_SERVER_BUSY && ErrorType != EDreamAccountErrorType::LOCAL_REQUEST_CANCELLED)
+		{
+			++RejectedCount;
+		}
+
+		const double WaitSeconds = Result.WaitMs / 1000.0;
+		TotalWaitSeconds += WaitSeconds;
+		MaxWaitSeconds = FMath::Max(MaxWaitSeconds, WaitSeconds);
+		++WaitSampleCount;
+
+		UE_LOG(LogDreamAccount, Verbose, TEXT("DreamAccount admission: user=%d result=%d wait=%.1fms validation=%.1fms cache=%d"),
+			Result.User.UserID, static_cast<int32>(ErrorType), Result.WaitMs, Result.ValidationMs, bFromCache);
+
+		// 玩家集中加入时大量结果在同一帧完成，回调（含 OnPlayerAdmitted 蓝图事件）按帧预算分发
+		FDreamAccountCallbackDispatcher::Get().Dispatch(EDreamAccountDispatchPriority::Background, [Callback = MoveTemp(Waiter.Callback), Result]()
+		{
+			Callback(Result);
+		});
+	}
+}
+
+bool FDreamAccountAdmissionController::IsCacheable(EDreamAccountErrorType ErrorType)
+{
+	switch (ErrorType)
+	{
+	case EDreamAccountErrorType::NORMAL:
+	case EDreamAccountErrorType::NETWORK_INVALID_TOKEN:
+	case EDreamAccountErrorType::NETWORK_USER_BANNED:
+	case EDreamAccountErrorType::NETWORK_USER_NOT_FOUND:
+		return true;
+	default:
+		return false;
+	}
+}
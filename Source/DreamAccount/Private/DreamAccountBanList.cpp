@@ -0,0 +1,432 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountBanList.h"
+
+#include "Async/Async.h"
+#include "DreamAccountModule.h"
+#include "DreamAccountUtil.h"
+#include "Dom/JsonObject.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeRWLock.h"
+#include "Serialization/JsonSerializer.h"
+
+using namespace FDreamAccountFields;
+
+namespace DreamAccountBans
+{
+	/** 增量条目数超过基础表的该比例（且不少于 MinCompactOverlay）时重建基础表 */
+	static constexpr int32 CompactOverlayDivisor = 8;
+	static constexpr int32 MinCompactOverlay = 1024;
+
+	/** MurmurHash3 的 fmix32：每一位都影响结果的低位，连续或同余的 UserID 在按掩码取低位后也均匀分布 */
+	FORCEINLINE uint32 HashUserID(int32 UserID)
+	{
+		uint32 Hash = static_cast<uint32>(UserID);
+		Hash ^= Hash >> 16;
+		Hash *= 0x85EBCA6Bu;
+		Hash ^= Hash >> 13;
+		Hash *= 0xC2B2AE35u;
+		Hash ^= Hash >> 16;
+		return Hash;
+	}
+
+	void ReadUserIDs(const TSharedPtr<FJsonObject>& Json, const FString& Field, TArray<int32>& OutUserIDs)
+	{
+		const TArray<TSharedPtr<FJsonValue>>* Values;
+		if (Json->TryGetArrayField(Field, Values))
+		{
+			OutUserIDs.Reserve(Values->Num());
+			for (const TSharedPtr<FJsonValue>& Value : *Values)
+			{
+				int32 UserID;
+				if (Value.IsValid() && Value->TryGetNumber(UserID) && UserID >= 0)
+				{
+					OutUserIDs.Add(UserID);
+				}
+			}
+		}
+	}
+
+	static FAutoConsoleCommand CmdStats(
+		TEXT("DreamAccount.BanList.Stats"),
+		TEXT("输出本地封禁列表的版本、条目数、内存占用与同步延迟"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const FDreamAccountBanListStats Stats = FDreamAccountBanList::Get().GetStats();
+			UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount ban list: Ready=%d Version=%lld Banned=%d Overlay=%d Memory=%.1fKB Lag=%.1fs LastSync=%.1fms Snapshots=%d Deltas=%d Failures=%d"),
+				Stats.bReady, Stats.Version, Stats.BannedCount, Stats.OverlayCount, Stats.MemoryBytes / 1024.0f,
+				Stats.LagSeconds, Stats.LastSyncDurationMs, Stats.SnapshotCount, Stats.DeltaCount, Stats.FailureCount);
+		}));
+
+	static FAutoConsoleCommand CmdSync(
+		TEXT("DreamAccount.BanList.Sync"),
+		TEXT("立即同步一次封禁列表"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FDreamAccountBanList::Get().SyncNow();
+		}));
+
+	static FAutoConsoleCommand CmdCheck(
+		TEXT("DreamAccount.BanList.Check"),
+		TEXT("查询本地封禁列表：DreamAccount.BanList.Check <UserID>"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			if (Args.Num() > 0)
+			{
+				const int32 UserID = FCString::Atoi(*Args[0]);
+				UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount ban list: %d is %s"), UserID,
+					FDreamAccountBanList::Get().IsBanned(UserID) ? TEXT("banned") : TEXT("not banned"));
+			}
+		}));
+}
+
+FDreamAccountBanSet::FTable::FTable(const TArray<int32>& UserIDs)
+{
+	const int32 Capacity = FMath::Max(16, static_cast<int32>(FMath::RoundUpToPowerOfTwo(static_cast<uint32>(UserIDs.Num()) * 2)));
+	Slots.Init(INDEX_NONE, Capacity);
+	Mask = static_cast<uint32>(Capacity - 1);
+
+	for (int32 UserID : UserIDs)
+	{
+		uint32 Index = DreamAccountBans::HashUserID(UserID) & Mask;
+		while (Slots[Index] != INDEX_NONE && Slots[Index] != UserID)
+		{
+			Index = (Index + 1) & Mask;
+		}
+
+		if (Slots[Index] == INDEX_NONE)
+		{
+			Slots[Index] = UserID;
+			++Num;
+		}
+	}
+}
+
+bool FDreamAccountBanSet::FTable::Contains(int32 UserID) const
+{
+	uint32 Index = DreamAccountBans::HashUserID(UserID) & Mask;
+	while (true)
+	{
+		const int32 Slot = Slots[Index];
+		if (Slot == UserID)
+		{
+			return true;
+		}
+		if (Slot == INDEX_NONE)
+		{
+			return false;
+		}
+		Index = (Index + 1) & Mask;
+	}
+}
+
+FDreamAccountBanSet::FRef FDreamAccountBanSet::MakeSnapshot(int64 InVersion, const TArray<int32>& UserIDs)
+{
+	TSharedRef<FDreamAccountBanSet, ESPMode::ThreadSafe> Set = MakeShared<FDreamAccountBanSet, ESPMode::ThreadSafe>();
+	Set->Base = MakeShared<const FTable, ESPMode::ThreadSafe>(UserIDs);
+	Set->Count = Set->Base->Num;
+	Set->Version = InVersion;
+	return Set;
+}
+
+FDreamAccountBanSet::FRef FDreamAccountBanSet::ApplyDelta(int64 NewVersion, const TArray<int32>& AddedUserIDs, const TArray<int32>& RemovedUserIDs) const
+{
+	TSharedRef<FDreamAccountBanSet, ESPMode::ThreadSafe> Set = MakeShared<FDreamAccountBanSet, ESPMode::ThreadSafe>();
+	Set->Base = Base;
+	Set->Added = Added;
+	Set->Removed = Removed;
+	Set->Version = NewVersion;
+
+	for (int32 UserID : RemovedUserIDs)
+	{
+		Set->Added.Remove(UserID);
+		if (Base.IsValid() && Base->Contains(UserID))
+		{
+			Set->Removed.Add(UserID);
+		}
+	}
+
+	for (int32 UserID : AddedUserIDs)
+	{
+		Set->Removed.Remove(UserID);
+		if (!Base.IsValid() || !Base->Contains(UserID))
+		{
+			Set->Added.Add(UserID);
+		}
+	}
+
+	const int32 BaseNum = Base.IsValid() ? Base->Num : 0;
+	Set->Count = BaseNum + Set->Added.Num() - Set->Removed.Num();
+
+	// 增量过多时重建，保持查询只需要查一张紧凑的表
+	if (Set->GetOverlayNum() > FMath::Max(DreamAccountBans::MinCompactOverlay, BaseNum / DreamAccountBans::CompactOverlayDivisor))
+	{
+		TArray<int32> UserIDs;
+		UserIDs.Reserve(Set->Count);
+		if (Base.IsValid())
+		{
+			for (int32 Slot : Base->Slots)
+			{
+				if (Slot != INDEX_NONE && !Set->Removed.Contains(Slot))
+				{
+					UserIDs.Add(Slot);
+				}
+			}
+		}
+		UserIDs.Append(Set->Added.Array());
+		return MakeSnapshot(NewVersion, UserIDs);
+	}
+
+	return Set;
+}
+
+bool FDreamAccountBanSet::Contains(int32 UserID) const
+{
+	if (UserID < 0)
+	{
+		return false;
+	}
+
+	if (Added.Num() > 0 && Added.Contains(UserID))
+	{
+		return true;
+	}
+
+	return Base.IsValid() && Base->Contains(UserID) && (Removed.Num() == 0 || !Removed.Contains(UserID));
+}
+
+int64 FDreamAccountBanSet::GetAllocatedSize() const
+{
+	int64 Size = sizeof(FDreamAccountBanSet) + Added.GetAllocatedSize() + Removed.GetAllocatedSize();
+	if (Base.IsValid())
+	{
+		Size += sizeof(FTable) + Base->Slots.GetAllocatedSize();
+	}
+	return Size;
+}
+
+FDreamAccountBanList& FDreamAccountBanList::Get()
+{
+	static FDreamAccountBanList Instance;
+	return Instance;
+}
+
+FDreamAccountBanList::FDreamAccountBanList()
+	: Current(FDreamAccountBanSet::MakeSnapshot(-1, TArray<int32>()))
+	, Version(-1)
+{
+}
+
+void FDreamAccountBanList::Start(double InIntervalSeconds)
+{
+	Stop();
+
+	IntervalSeconds = FMath::Max(InIntervalSeconds, 1.0);
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this](float)
+	{
+		SyncNow();
+		return true;
+	}), static_cast<float>(IntervalSeconds));
+
+	SyncNow();
+}
+
+void FDreamAccountBanList::Stop()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	++SyncSerial;
+	bSyncInProgress = false;
+}
+
+void FDreamAccountBanList::SyncNow()
+{
+	if (bSyncInProgress)
+	{
+		return;
+	}
+	bSyncInProgress = true;
+
+	FDreamAccountHttpRequest Request;
+	Request.URL = API_BANS;
+	Request.Verb = TEXT("GET");
+
+	const int64 CurrentVersion = Version.load(std::memory_order_relaxed);
+	if (CurrentVersion >= 0)
+	{
+		Request.URL += FString::Printf(TEXT("?%s=%lld"), *FIELD_SINCE, CurrentVersion);
+	}
+
+	const uint32 Serial = SyncSerial;
+	const double RequestTime = FPlatformTime::Seconds();
+	FDreamAccountUtil::SendHttpRequest(Request, [this, Serial, RequestTime](const FDreamAccountHttpResponse& Response)
+	{
+		HandleResponse(Serial, RequestTime, Response);
+	});
+}
+
+bool FDreamAccountBanList::IsBanned(int32 UserID) const
+{
+	// 只有游戏线程发布新集合，游戏线程上直接读取不会与替换并发
+	if (IsInGameThread())
+	{
+		return Current->Contains(UserID);
+	}
+
+	FReadScopeLock Lock(CurrentLock);
+	return Current->Contains(UserID);
+}
+
+FDreamAccountBanSet::FRef FDreamAccountBanList::GetCurrent() const
+{
+	if (IsInGameThread())
+	{
+		return Current;
+	}
+
+	FReadScopeLock Lock(CurrentLock);
+	return Current;
+}
+
+FDreamAccountBanListStats FDreamAccountBanList::GetStats() const
+{
+	const FDreamAccountBanSet::FRef Set = GetCurrent();
+
+	FDreamAccountBanListStats Stats;
+	Stats.bReady = IsReady();
+	Stats.Version = Set->GetVersion();
+	Stats.BannedCount = Set->Num();
+	Stats.OverlayCount = Set->GetOverlayNum();
+	Stats.MemoryBytes = Set->GetAllocatedSize();
+	Stats.LagSeconds = Stats.bReady ? static_cast<float>(FPlatformTime::Seconds() - LastSyncRequestTime) : -1.0f;
+	Stats.LastSyncDurationMs = static_cast<float>(LastSyncDurationSeconds * 1000.0);
+	Stats.SnapshotCount = SnapshotCount;
+	Stats.DeltaCount = DeltaCount;
+	Stats.FailureCount = FailureCount;
+	return Stats;
+}
+
+void FDreamAccountBanList::HandleResponse(uint32 Serial, double RequestTime, const FDreamAccountHttpResponse& Response)
+{
+	if (Serial != SyncSerial)
+	{
+		return;
+	}
+
+	if (!Response.bSucceeded || Response.ResponseCode != 200)
+	{
+		UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount ban list sync failed: %d"), Response.ResponseCode);
+		FinishSync(false);
+		return;
+	}
+
+	// 完整快照可能有数十万条，解析和建表都放到后台线程
+	const FDreamAccountBanSet::FRef BaseSet = GetCurrent();
+	const bool bHasBase = IsReady();
+	Async(EAsyncExecution::ThreadPool, [this, Serial, RequestTime, BaseSet, bHasBase, Content = Response.Content]()
+	{
+		auto FailSync = [this, Serial](const TCHAR* Reason)
+		{
+			UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount ban list sync rejected the response: %s"), Reason);
+			AsyncTask(ENamedThreads::GameThread, [this, Serial]()
+			{
+				if (Serial == SyncSerial)
+				{
+					FinishSync(false);
+				}
+			});
+		};
+
+		TSharedPtr<FJsonObject> Json;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Content);
+		int64 NewVersion = -1;
+		if (!FJsonSerializer::Deserialize(Reader, Json) || !Json.IsValid() || !Json->TryGetNumberField(FIELD_VERSION, NewVersion))
+		{
+			FailSync(TEXT("invalid json"));
+			return;
+		}
+
+		// 只有明确标记为快照、或没有标记但带有完整列表时才按快照处理，省略 snapshot 的增量不能清空列表
+		bool bSnapshot = false;
+		if (!Json->TryGetBoolField(FIELD_SNAPSHOT, bSnapshot))
+		{
+			bSnapshot = Json->HasField(FIELD_USER_IDS);
+		}
+
+		if (bSnapshot && !Json->HasField(FIELD_USER_IDS))
+		{
+			FailSync(TEXT("snapshot without user_ids"));
+			return;
+		}
+
+		// 还没有基础列表时无法应用增量，下一次同步不带版本号，服务器会返回完整快照
+		if (!bSnapshot && !bHasBase)
+		{
+			FailSync(TEXT("delta without a base snapshot"));
+			return;
+		}
+
+		TSharedPtr<const FDreamAccountBanSet, ESPMode::ThreadSafe> NewSet;
+		if (bSnapshot)
+		{
+			TArray<int32> UserIDs;
+			DreamAccountBans::ReadUserIDs(Json, FIELD_USER_IDS, UserIDs);
+			NewSet = FDreamAccountBanSet::MakeSnapshot(NewVersion, UserIDs);
+		}
+		else
+		{
+			TArray<int32> AddedUserIDs;
+			TArray<int32> RemovedUserIDs;
+			DreamAccountBans::ReadUserIDs(Json, FIELD_ADDED, AddedUserIDs);
+			DreamAccountBans::ReadUserIDs(Json, FIELD_REMOVED, RemovedUserIDs);
+			NewSet = BaseSet->ApplyDelta(NewVersion, AddedUserIDs, RemovedUserIDs);
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [this, Serial, RequestTime, bSnapshot, NewSet]()
+		{
+			if (Serial == SyncSerial)
+			{
+				Publish(NewSet.ToSharedRef(), bSnapshot, RequestTime);
+			}
+		});
+	});
+}
+
+void FDreamAccountBanList::Publish(FDreamAccountBanSet::FRef NewSet, bool bSnapshot, double RequestTime)
+{
+	check(IsInGameThread());
+
+	const double Now = FPlatformTime::Seconds();
+
+	FDreamAccountBanSet::FRef Previous = NewSet;
+	{
+		FWriteScopeLock Lock(CurrentLock);
+		Swap(Previous, Current);
+	}
+	Version.store(NewSet->GetVersion(), std::memory_order_release);
+
+	if (bSnapshot)
+	{
+		++SnapshotCount;
+	}
+	else
+	{
+		++DeltaCount;
+	}
+	LastSyncRequestTime = RequestTime;
+	LastSyncDurationSeconds = Now - RequestTime;
+	FinishSync(true);
+}
+
+void FDreamAccountBanList::FinishSync(bool bSucceeded)
+{
+	bSyncInProgress = false;
+	if (!bSucceeded)
+	{
+		++FailureCount;
+	}
+}
@@ -0,0 +1,271 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountCallbackDispatcher.h"
+
+#include "Async/Async.h"
+#include "DreamAccountModule.h"
+#include "DreamAccountSettings.h"
+#include "DreamAccountTracing.h"
+#include "HAL/IConsoleManager.h"
+
+namespace DreamAccountDispatch
+{
+	/** 队列头部已执行的元素超过该数量且占队列一半以上时才移除，避免频繁移动数组 */
+	static constexpr int32 CompactThreshold = 64;
+
+	static FAutoConsoleCommand CmdStats(
+		TEXT("DreamAccount.Dispatch.Stats"),
+		TEXT("输出结果回调的排队延迟、队列长度与每帧预算超出次数"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const FDreamAccountDispatchStats Stats = FDreamAccountCallbackDispatcher::Get().GetStats();
+			UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount dispatch: Dispatched=%d Deferred=%d Queued=%d PeakQueue=%d InteractiveLatency=%.2fms BackgroundLatency=%.2fms MaxLatency=%.2fms BudgetExceededFrames=%d SlowCallbacks=%d LongestCallback=%.2fms"),
+				Stats.DispatchedCount, Stats.DeferredCount, Stats.QueueLength, Stats.PeakQueueLength,
+				Stats.InteractiveAverageLatencyMs, Stats.BackgroundAverageLatencyMs, Stats.MaxQueueLatencyMs,
+				Stats.BudgetExceededFrameCount, Stats.SlowCallbackCount, Stats.LongestCallbackMs);
+		}));
+
+	static FAutoConsoleCommand CmdReset(
+		TEXT("DreamAccount.Dispatch.Reset"),
+		TEXT("清空结果回调分发统计"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FDreamAccountCallbackDispatcher::Get().ResetStats();
+		}));
+}
+
+FDreamAccountCallbackDispatcher::FQueuedCallback FDreamAccountCallbackDispatcher::FQueue::Pop()
+{
+	FQueuedCallback Item = MoveTemp(Items[Head]);
+	++Head;
+
+	if (Head == Items.Num())
+	{
+		Items.Reset();
+		Head = 0;
+	}
+	else if (Head >= DreamAccountDispatch::CompactThreshold && Head * 2 >= Items.Num())
+	{
+		// 已出队的部分超过一半时才整体移除，积压很多时每个回调平均只移动常数次
+		Items.RemoveAt(0, Head, EAllowShrinking::No);
+		Head = 0;
+	}
+	return Item;
+}
+
+FDreamAccountCallbackDispatcher& FDreamAccountCallbackDispatcher::Get()
+{
+	static FDreamAccountCallbackDispatcher Instance;
+	return Instance;
+}
+
+FDreamAccountCallbackDispatcher::FDreamAccountCallbackDispatcher()
+{
+}
+
+void FDreamAccountCallbackDispatcher::Dispatch(EDreamAccountDispatchPriority Priority, TFunction<void()> Callback)
+{
+	if (!IsInGameThread())
+	{
+		AsyncTask(ENamedThreads::GameThread, [Priority, Callback = MoveTemp(Callback)]() mutable
+		{
+			FDreamAccountCallbackDispatcher::Get().Dispatch(Priority, MoveTemp(Callback));
+		});
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(DreamAccount);
+
+	++DispatchedCount;
+	BeginFrame();
+
+	// 只有被采样的追踪需要保存上下文
+	const FDreamAccountTraceContext& CurrentTrace = FDreamAccountTracer::GetCurrentContext();
+	const FDreamAccountTraceContext Trace = CurrentTrace.bSampled ? CurrentTrace : FDreamAccountTraceContext();
+
+	// 没有排队的回调且本帧预算有剩余时直接执行，平时不增加任何延迟
+	const double Budget = GetFrameBudgetSeconds();
+	if (Budget <= 0.0 || (!bExecuting && Num() == 0 && FrameSpentSeconds < Budget))
+	{
+		Execute(Callback, Trace);
+		return;
+	}
+
+	++DeferredCount;
+	Queues[static_cast<int32>(Priority)].Push({MoveTemp(Callback), FPlatformTime::Seconds(), Trace});
+	PeakQueueLength = FMath::Max(PeakQueueLength, Num());
+	EnsureTicker();
+}
+
+void FDreamAccountCallbackDispatcher::Flush()
+{
+	FQueuedCallback Item;
+	EDreamAccountDispatchPriority Priority;
+	while (PopNext(Item, Priority))
+	{
+		FDreamAccountTracer::Get().RecordSpan(TEXT("queue_wait"), Item.Trace, Item.EnqueueTime, FPlatformTime::Seconds());
+		Execute(Item.Callback, Item.Trace);
+	}
+}
+
+void FDreamAccountCallbackDispatcher::Reset()
+{
+	for (FQueue& Queue : Queues)
+	{
+		Queue.Items.Empty();
+		Queue.Head = 0;
+	}
+
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+}
+
+int32 FDreamAccountCallbackDispatcher::Num() const
+{
+	int32 Result = 0;
+	for (const FQueue& Queue : Queues)
+	{
+		Result += Queue.Num();
+	}
+	return Result;
+}
+
+FDreamAccountDispatchStats FDreamAccountCallbackDispatcher::GetStats() const
+{
+	const int32 Interactive = static_cast<int32>(EDreamAccountDispatchPriority::Interactive);
+	const int32 Background = static_cast<int32>(EDreamAccountDispatchPriority::Background);
+
+	FDreamAccountDispatchStats Stats;
+	Stats.DispatchedCount = static_cast<int32>(DispatchedCount);
+	Stats.DeferredCount = static_cast<int32>(DeferredCount);
+	Stats.QueueLength = Num();
+	Stats.PeakQueueLength = PeakQueueLength;
+	Stats.InteractiveAverageLatencyMs = QueueLatencySampleCount[Interactive] > 0
+		? static_cast<float>(TotalQueueLatencySeconds[Interactive] * 1000.0 / QueueLatencySampleCount[Interactive]) : 0.0f;
+	Stats.BackgroundAverageLatencyMs = QueueLatencySampleCount[Background] > 0
+		? static_cast<float>(TotalQueueLatencySeconds[Background] * 1000.0 / QueueLatencySampleCount[Background]) : 0.0f;
+	Stats.MaxQueueLatencyMs = static_cast<float>(MaxQueueLatencySeconds * 1000.0);
+	Stats.BudgetExceededFrameCount = BudgetExceededFrameCount;
+	Stats.SlowCallbackCount = SlowCallbackCount;
+	Stats.LongestCallbackMs = static_cast<float>(LongestCallbackSeconds * 1000.0);
+	return Stats;
+}
+
+void FDreamAccountCallbackDispatcher::ResetStats()
+{
+	DispatchedCount = 0;
+	DeferredCount = 0;
+	PeakQueueLength = Num();
+	BudgetExceededFrameCount = 0;
+	SlowCallbackCount = 0;
+	LongestCallbackSeconds = 0.0;
+	MaxQueueLatencySeconds = 0.0;
+	for (int32 Index = 0; Index < static_cast<int32>(EDreamAccountDispatchPriority::Count); ++Index)
+	{
+		TotalQueueLatencySeconds[Index] = 0.0;
+		QueueLatencySampleCount[Index] = 0;
+	}
+}
+
+bool FDreamAccountCallbackDispatcher::Tick(float DeltaTime)
+{
+	LLM_SCOPE_BYTAG(DreamAccount);
+
+	BeginFrame();
+
+	const double Budget = GetFrameBudgetSeconds();
+	bool bExecutedAny = false;
+
+	FQueuedCallback Item;
+	EDreamAccountDispatchPriority Priority;
+	while ((!bExecutedAny || Budget <= 0.0 || FrameSpentSeconds < Budget) && PopNext(Item, Priority))
+	{
+		const double Latency = FPlatformTime::Seconds() - Item.EnqueueTime;
+		TotalQueueLatencySeconds[static_cast<int32>(Priority)] += Latency;
+		++QueueLatencySampleCount[static_cast<int32>(Priority)];
+		MaxQueueLatencySeconds = FMath::Max(MaxQueueLatencySeconds, Latency);
+
+		FDreamAccountTracer::Get().RecordSpan(TEXT("queue_wait"), Item.Trace, Item.EnqueueTime, Item.EnqueueTime + Latency);
+		Execute(Item.Callback, Item.Trace);
+		bExecutedAny = true;
+	}
+
+	if (Num() > 0)
+	{
+		++BudgetExceededFrameCount;
+		return true;
+	}
+
+	TickerHandle.Reset();
+	return false;
+}
+
+void FDreamAccountCallbackDispatcher::BeginFrame()
+{
+	if (BudgetFrame != GFrameCounter)
+	{
+		BudgetFrame = GFrameCounter;
+		FrameSpentSeconds = 0.0;
+	}
+}
+
+void FDreamAccountCallbackDispatcher::Execute(TFunction<void()>& Callback, const FDreamAccountTraceContext& Trace)
+{
+	const bool bWasExecuting = bExecuting;
+	bExecuting = true;
+
+	const double StartTime = FPlatformTime::Seconds();
+	{
+		FDreamAccountScopedSpan Span(TEXT("callback"), Trace);
+		Callback();
+	}
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+	bExecuting = bWasExecuting;
+
+	// 嵌套执行（Flush 中的回调再次 Flush）只由最外层计时
+	if (bWasExecuting)
+	{
+		return;
+	}
+
+	FrameSpentSeconds += Elapsed;
+	LongestCallbackSeconds = FMath::Max(LongestCallbackSeconds, Elapsed);
+
+	const double Budget = GetFrameBudgetSeconds();
+	if (Budget > 0.0 && Elapsed > Budget)
+	{
+		++SlowCallbackCount;
+	}
+}
+
+bool FDreamAccountCallbackDispatcher::PopNext(FQueuedCallback& OutItem, EDreamAccountDispatchPriority& OutPriority)
+{
+	for (int32 Index = 0; Index < static_cast<int32>(EDreamAccountDispatchPriority::Count); ++Index)
+	{
+		if (Queues[Index].Num() > 0)
+		{
+			OutItem = Queues[Index].Pop();
+			OutPriority = static_cast<EDreamAccountDispatchPriority>(Index);
+			return true;
+		}
+	}
+	return false;
+}
+
+void FDreamAccountCallbackDispatcher::EnsureTicker()
+{
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FDreamAccountCallbackDispatcher::Tick));
+	}
+}
+
+double FDreamAccountCallbackDispatcher::GetFrameBudgetSeconds()
+{
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	return Settings ? Settings->DispatchFrameBudgetMs / 1000.0 : 0.0;
+}
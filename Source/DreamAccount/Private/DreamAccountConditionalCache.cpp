@@ -0,0 +1,144 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountConditionalCache.h"
+
+void FDreamAccountConditionalCache::Configure(int32 InMaxEntries)
+{
+	MaxEntries = InMaxEntries;
+	if (MaxEntries <= 0)
+	{
+		Entries.Empty();
+		return;
+	}
+
+	while (Entries.Num() > MaxEntries)
+	{
+		EvictLeastRecentlyUsed();
+	}
+}
+
+bool FDreamAccountConditionalCache::ApplyValidators(const FString& Key, FDreamAccountHttpRequest& Request)
+{
+	const FEntry* Entry = Entries.Find(Key);
+	if (!Entry)
+	{
+		return false;
+	}
+
+	if (!Entry->ETag.IsEmpty())
+	{
+		Request.Headers.Add(TEXT("If-None-Match"), Entry->ETag);
+	}
+	if (!Entry->LastModified.IsEmpty())
+	{
+		Request.Headers.Add(TEXT("If-Modified-Since"), Entry->LastModified);
+	}
+
+	++ConditionalRequestCount;
+	return true;
+}
+
+const TArray<FDreamAccountUser>* FDreamAccountConditionalCache::HandleNotModified(const FString& Key, const FDreamAccountHttpResponse& Response)
+{
+	if (!Response.bSucceeded || Response.ResponseCode != 304)
+	{
+		return nullptr;
+	}
+
+	FEntry* Entry = Entries.Find(Key);
+	if (!Entry)
+	{
+		return nullptr;
+	}
+
+	// 服务器可能在 304 中更新校验器
+	const FString ETag = Response.GetHeader(TEXT("ETag"));
+	if (!ETag.IsEmpty())
+	{
+		Entry->ETag = ETag;
+	}
+
+	Entry->LastUsedTime = FPlatformTime::Seconds();
+	++NotModifiedCount;
+	BytesSaved += FMath::Max<int64>(Entry->ContentBytes - Response.Content.Len(), 0);
+	ParseSecondsSaved += Entry->ParseSeconds;
+	return &Entry->Users;
+}
+
+void FDreamAccountConditionalCache::Store(const FString& Key, const FDreamAccountHttpResponse& Response, const TArray<FDreamAccountUser>& Users, double ParseSeconds)
+{
+	if (MaxEntries <= 0)
+	{
+		return;
+	}
+
+	FString ETag = Response.GetHeader(TEXT("ETag"));
+	FString LastModified = Response.GetHeader(TEXT("Last-Modified"));
+	if (ETag.IsEmpty() && LastModified.IsEmpty())
+	{
+		Entries.Remove(Key);
+		return;
+	}
+
+	if (!Entries.Contains(Key) && Entries.Num() >= MaxEntries)
+	{
+		EvictLeastRecentlyUsed();
+	}
+
+	FEntry& Entry = Entries.FindOrAdd(Key);
+	Entry.ETag = MoveTemp(ETag);
+	Entry.LastModified = MoveTemp(LastModified);
+	Entry.Users = Users;
+	Entry.ContentBytes = FTCHARToUTF8(*Response.Content).Length();
+	Entry.ParseSeconds = ParseSeconds;
+	Entry.LastUsedTime = FPlatformTime::Seconds();
+}
+
+void FDreamAccountConditionalCache::Remove(const FString& Key)
+{
+	Entries.Remove(Key);
+}
+
+void FDreamAccountConditionalCache::Empty()
+{
+	Entries.Empty();
+}
+
+FDreamAccountConditionalStats FDreamAccountConditionalCache::GetStats() const
+{
+	FDreamAccountConditionalStats Stats;
+	Stats.EntryCount = Entries.Num();
+	Stats.ConditionalRequestCount = ConditionalRequestCount;
+	Stats.NotModifiedCount = NotModifiedCount;
+	Stats.NotModifiedRate = ConditionalRequestCount > 0 ? static_cast<float>(NotModifiedCount) / ConditionalRequestCount : 0.0f;
+	Stats.BytesSaved = BytesSaved;
+	Stats.ParseTimeSavedMs = static_cast<float>(ParseSecondsSaved * 1000.0);
+	return Stats;
+}
+
+void FDreamAccountConditionalCache::ResetStats()
+{
+	ConditionalRequestCount = 0;
+	NotModifiedCount = 0;
+	BytesSaved = 0;
+	ParseSecondsSaved = 0.0;
+}
+
+void FDreamAccountConditionalCache::EvictLeastRecentlyUsed()
+{
+	const FString* OldestKey = nullptr;
+	double OldestTime = TNumericLimits<double>::Max();
+	for (const TPair<FString, FEntry>& Pair : Entries)
+	{
+		if (Pair.Value.LastUsedTime < OldestTime)
+		{
+			OldestTime = Pair.Value.LastUsedTime;
+			OldestKey = &Pair.Key;
+		}
+	}
+
+	if (OldestKey)
+	{
+		Entries.Remove(FString(*OldestKey));
+	}
+}
@@ -0,0 +1,144 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountGameModeBase.h"
+
+#include "DreamAccountAdmission.h"
+#include "DreamAccountModule.h"
+#include "DreamAccountSubsystem.h"
+#include "GameFramework/PlayerController.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "Kismet/GameplayStatics.h"
+
+const TCHAR* ADreamAccountGameModeBase::TokenOptionName = TEXT("DreamToken");
+const TCHAR* ADreamAccountGameModeBase::UserNameOptionName = TEXT("DreamUser");
+
+namespace DreamAccountGameMode
+{
+	/** 通过 PreLogin 后等待 InitNewPlayer 的最长时间，超过后认为连接已断开 */
+	static constexpr double AdmittedPlayerTimeout = 120.0;
+
+	/** 读取经过 URL 编码的选项值 */
+	static FString ParseEncodedOption(const FString& Options, const TCHAR* Key)
+	{
+		return FGenericPlatformHttp::UrlDecode(UGameplayStatics::ParseOption(Options, Key));
+	}
+}
+
+FString ADreamAccountGameModeBase::MakeLoginOptions()
+{
+	const FDreamAccountSessionRef Session = UDreamAccountSubsystem::GetSession();
+	if (!Session->IsLoggedIn())
+	{
+		return FString();
+	}
+
+	// 令牌和用户名中的 ? = # 等字符会破坏选项解析，两者都经过 URL 编码
+	FString Options = FString::Printf(TEXT("?%s=%s"), TokenOptionName, *FGenericPlatformHttp::UrlEncode(Session->Token));
+	if (!Session->User.UserInfo.Name.IsEmpty())
+	{
+		Options += FString::Printf(TEXT("?%s=%s"), UserNameOptionName, *FGenericPlatformHttp::UrlEncode(Session->User.UserInfo.Name));
+	}
+	return Options;
+}
+
+bool ADreamAccountGameModeBase::GetPlayerAccount(APlayerController* PlayerController, FDreamAccountUser& OutUser) const
+{
+	if (const FDreamAccountUser* User = PlayerAccounts.Find(PlayerController))
+	{
+		OutUser = *User;
+		return true;
+	}
+	return false;
+}
+
+void ADreamAccountGameModeBase::PreLoginAsync(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, const FOnPreLoginCompleteDelegate& OnComplete)
+{
+	// 先执行同步的 PreLogin 检查（服务器已满等），通过后再排队校验令牌
+	FString ErrorMessage;
+	PreLogin(Options, Address, UniqueId, ErrorMessage);
+	if (!ErrorMessage.IsEmpty())
+	{
+		OnComplete.ExecuteIfBound(ErrorMessage);
+		return;
+	}
+
+	const FString Token = DreamAccountGameMode::ParseEncodedOption(Options, TokenOptionName);
+	if (Token.IsEmpty())
+	{
+		OnComplete.ExecuteIfBound(bRequireAccountToken ? MakeErrorMessage(EDreamAccountErrorType::NETWORK_USER_NOT_AUTHENTICATED) : FString());
+		return;
+	}
+
+	const FString UserName = DreamAccountGameMode::ParseEncodedOption(Options, UserNameOptionName);
+	TWeakObjectPtr<ADreamAccountGameModeBase> WeakThis(this);
+	FDreamAccountAdmissionController::Get().Admit(Token, UserName, [WeakThis, Token, OnComplete](const FDreamAccountAdmissionResult& Result)
+	{
+		ADreamAccountGameModeBase* GameMode = WeakThis.Get();
+		if (!GameMode || Result.ErrorType == EDreamAccountErrorType::LOCAL_REQUEST_CANCELLED)
+		{
+			OnComplete.ExecuteIfBound(MakeErrorMessage(EDreamAccountErrorType::LOCAL_REQUEST_CANCELLED));
+			return;
+		}
+
+		UE_LOG(LogDreamAccount, Log, TEXT("DreamAccount PreLogin: user=%d result=%s wait=%.1fms validation=%.1fms%s"),
+			Result.User.UserID, *MakeErrorMessage(Result.ErrorType), Result.WaitMs, Result.ValidationMs, Result.bFromCache ? TEXT(" (cached)") : TEXT(""));
+
+		if (Result.ErrorType != EDreamAccountErrorType::NORMAL)
+		{
+			OnComplete.ExecuteIfBound(MakeErrorMessage(Result.ErrorType));
+			return;
+		}
+
+		const FString AdmitError = GameMode->OnPlayerAdmitted(Result);
+		if (!AdmitError.IsEmpty())
+		{
+			OnComplete.ExecuteIfBound(AdmitError);
+			return;
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		GameMode->PruneAdmittedPlayers(Now);
+		GameMode->AdmittedPlayers.Add(Token, {Result.User, Now});
+		OnComplete.ExecuteIfBound(FString());
+	});
+}
+
+FString ADreamAccountGameModeBase::InitNewPlayer(APlayerController* NewPlayerController, const FUniqueNetIdRepl& UniqueId, const FString& Options, const FString& Portal)
+{
+	const FString Token = DreamAccountGameMode::ParseEncodedOption(Options, TokenOptionName);
+	FAdmittedPlayer Admitted;
+	if (!Token.IsEmpty() && AdmittedPlayers.RemoveAndCopyValue(Token, Admitted))
+	{
+		PlayerAccounts.Add(NewPlayerController, Admitted.User);
+	}
+
+	return Super::InitNewPlayer(NewPlayerController, UniqueId, Options, Portal);
+}
+
+void ADreamAccountGameModeBase::Logout(AController* Exiting)
+{
+	PlayerAccounts.Remove(Cast<APlayerController>(Exiting));
+
+	Super::Logout(Exiting);
+}
+
+FString ADreamAccountGameModeBase::OnPlayerAdmitted_Implementation(const FDreamAccountAdmissionResult& Result)
+{
+	return FString();
+}
+
+FString ADreamAccountGameModeBase::MakeErrorMessage(EDreamAccountErrorType ErrorType)
+{
+	return StaticEnum<EDreamAccountErrorType>()->GetNameStringByValue(static_cast<int64>(ErrorType));
+}
+
+void ADreamAccountGameModeBase::PruneAdmittedPlayers(double Now)
+{
+	for (auto It = AdmittedPlayers.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value().AdmitTime > DreamAccountGameMode::AdmittedPlayerTimeout)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -0,0 +1,145 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountHttp.h"
+
+#include "DreamAccountRequestHedger.h"
+#include "DreamAccountSettings.h"
+#include "DreamAccountTimeoutEstimator.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+
+void FDreamAccountHttpCancellation::Cancel()
+{
+	if (bCancelled)
+	{
+		return;
+	}
+
+	bCancelled = true;
+	if (AbortHandler)
+	{
+		TFunction<void()> Handler = MoveTemp(AbortHandler);
+		AbortHandler = nullptr;
+		Handler();
+	}
+}
+
+void FDreamAccountHttpCancellation::SetAbortHandler(TFunction<void()> Handler)
+{
+	if (bCancelled)
+	{
+		if (Handler)
+		{
+			Handler();
+		}
+		return;
+	}
+
+	AbortHandler = MoveTemp(Handler);
+}
+
+FString FDreamAccountHttpRequest::GetPath() const
+{
+	int32 PathStart = 0;
+	const int32 SchemeEnd = URL.Find(TEXT("://"));
+	if (SchemeEnd != INDEX_NONE)
+	{
+		PathStart = URL.Find(TEXT("/"), ESearchCase::CaseSensitive, ESearchDir::FromStart, SchemeEnd + 3);
+		if (PathStart == INDEX_NONE)
+		{
+			return TEXT("/");
+		}
+	}
+
+	int32 PathEnd = URL.Find(TEXT("?"), ESearchCase::CaseSensitive, ESearchDir::FromStart, PathStart);
+	if (PathEnd == INDEX_NONE)
+	{
+		PathEnd = URL.Len();
+	}
+
+	return URL.Mid(PathStart, PathEnd - PathStart);
+}
+
+FString FDreamAccountHttpRequest::GetQueryParameter(const FString& Name) const
+{
+	FString Query;
+	if (!URL.Split(TEXT("?"), nullptr, &Query))
+	{
+		return FString();
+	}
+
+	TArray<FString> Pairs;
+	Query.ParseIntoArray(Pairs, TEXT("&"));
+	for (const FString& Pair : Pairs)
+	{
+		FString Key;
+		FString Value;
+		if (!Pair.Split(TEXT("="), &Key, &Value))
+		{
+			Key = Pair;
+		}
+
+		if (Key == Name)
+		{
+			return FGenericPlatformHttp::UrlDecode(Value);
+		}
+	}
+
+	return FString();
+}
+
+float FDreamAccountHttpRequest::GetEffectiveTimeout() const
+{
+	if (Timeout > 0.0f)
+	{
+		return Timeout;
+	}
+
+	const FDreamAccountTimeoutEstimator& TimeoutEstimator = FDreamAccountTimeoutEstimator::Get();
+	if (TimeoutEstimator.IsEnabled())
+	{
+		return static_cast<float>(TimeoutEstimator.GetTimeout(FDreamAccountRequestHedger::GetEndpointKey(*this)));
+	}
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	return Settings ? Settings->TimeoutTime : 5.0f;
+}
+
+FString FDreamAccountHttpResponse::GetHeader(const FString& Name) const
+{
+	for (const TPair<FString, FString>& Pair : Headers)
+	{
+		if (Pair.Key.Equals(Name, ESearchCase::IgnoreCase))
+		{
+			return Pair.Value;
+		}
+	}
+
+	return FString();
+}
+
+FString FDreamAccountTraceContext::ToTraceParent() const
+{
+	return FString::Printf(TEXT("00-%s-%s-%s"), *TraceId, *SpanId, bSampled ? TEXT("01") : TEXT("00"));
+}
+
+FDreamAccountHttpResponse FDreamAccountHttpResponse::MakeFailure(double InElapsedSeconds)
+{
+	FDreamAccountHttpResponse Response;
+	Response.ElapsedSeconds = InElapsedSeconds;
+	return Response;
+}
+
+FDreamAccountHttpResponse FDreamAccountHttpResponse::MakeJson(int32 InResponseCode, FString InContent)
+{
+	FDreamAccountHttpResponse Response;
+	Response.bSucceeded = true;
+	Response.ResponseCode = InResponseCode;
+	Response.Content = MoveTemp(InContent);
+	Response.Headers.Add(TEXT("Content-Type"), TEXT("application/json;charset=UTF-8"));
+	return Response;
+}
+
+FDreamAccountHttpResponse FDreamAccountHttpResponse::MakeError(int32 InResponseCode, const FString& ErrorCode)
+{
+	return MakeJson(InResponseCode, FString::Printf(TEXT("{\"error\":\"%s\"}"), *ErrorCode));
+}
@@ -0,0 +1,741 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountInProcessServer.h"
+
+#include "DreamAccountUtil.h"
+#include "Dom/JsonObject.h"
+#include "Misc/Base64.h"
+#include "Misc/Compression.h"
+#include "Misc/Guid.h"
+#include "Serialization/JsonSerializer.h"
+
+using namespace FDreamAccountFields;
+
+namespace
+{
+	FString MakeHandlerKey(const FString& Verb, const FString& Path)
+	{
+		return Verb.ToUpper() + TEXT(" ") + Path;
+	}
+
+	TArray<uint8> ToUtf8Bytes(const FString& Text)
+	{
+		const FTCHARToUTF8 Converter(*Text);
+		return TArray<uint8>(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+	}
+
+	/** 服务器保存的派生密码校验值：派生结果的 SHA-256 */
+	FString MakeKdfVerifier(const FString& DerivedKey)
+	{
+		const TArray<uint8> Digest = FDreamAccountKeyDerivation::Sha256(ToUtf8Bytes(DerivedKey));
+		return BytesToHex(Digest.GetData(), Digest.Num()).ToLower();
+	}
+}
+
+FDreamAccountInProcessServer::FDreamAccountInProcessServer()
+{
+	RegisterHandler(TEXT("POST"), TEXT("/api/account/register"), [this](const FDreamAccountHttpRequest& Request) { return HandleRegister(Request); });
+	RegisterHandler(TEXT("POST"), TEXT("/api/account/login"), [this](const FDreamAccountHttpRequest& Request) { return HandleLogin(Request); });
+	RegisterHandler(TEXT("POST"), TEXT("/api/account/register_login"), [this](const FDreamAccountHttpRequest& Request) { return HandleRegisterAndLogin(Request); });
+	RegisterHandler(TEXT("GET"), TEXT("/api/account/auth"), [this](const FDreamAccountHttpRequest& Request) { return HandleAuth(Request); });
+	RegisterHandler(TEXT("POST"), TEXT("/api/account/refresh"), [this](const FDreamAccountHttpRequest& Request) { return HandleRefresh(Request); });
+	RegisterHandler(TEXT("GET"), TEXT("/api/account/username_available"), [this](const FDreamAccountHttpRequest& Request) { return HandleUsernameAvailable(Request); });
+	RegisterHandler(TEXT("GET"), TEXT("/api/account/validation_rules"), [this](const FDreamAccountHttpRequest& Request) { return HandleValidationRules(Request); });
+	RegisterHandler(TEXT("POST"), TEXT("/api/account/users/lookup"), [this](const FDreamAccountHttpRequest& Request) { return HandleUsersLookup(Request); });
+	RegisterHandler(TEXT("GET"), TEXT("/api/account/bans"), [this](const FDreamAccountHttpRequest& Request) { return HandleBans(Request); });
+	RegisterHandler(TEXT("GET"), TEXT("/api/account/kdf_params"), [this](const FDreamAccountHttpRequest& Request) { return HandleKdfParams(Request); });
+	RegisterHandler(TEXT("POST"), TEXT("/api/account/metrics/latency"), [this](const FDreamAccountHttpRequest& Request) { return HandleLatencyBeacons(Request); });
+	RegisterHandler(TEXT("GET"), TEXT("/api/account/login/queue"), [this](const FDreamAccountHttpRequest& Request) { return HandleLoginQueue(Request); });
+	RegisterHandler(TEXT("POST"), TEXT("/api/account/login/queue/leave"), [this](const FDreamAccountHttpRequest& Request) { return HandleLoginQueueLeave(Request); });
+
+	const FGuid Secret = FGuid::NewGuid();
+	KdfSecret.Append(reinterpret_cast<const uint8*>(&Secret), sizeof(Secret));
+}
+
+void FDreamAccountInProcessServer::RegisterHandler(const FString& Verb, const FString& Path, FHandler Handler)
+{
+	Handlers.Add(MakeHandlerKey(Verb, Path), MoveTemp(Handler));
+}
+
+void FDreamAccountInProcessServer::UnregisterHandler(const FString& Verb, const FString& Path)
+{
+	Handlers.Remove(MakeHandlerKey(Verb, Path));
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleRequest(const FDreamAccountHttpRequest& Request)
+{
+	const FHandler* Handler = Handlers.Find(MakeHandlerKey(Request.Verb, Request.GetPath()));
+	if (!Handler)
+	{
+		return FDreamAccountHttpResponse::MakeError(404, TEXT("NOT_FOUND"));
+	}
+
+	return (*Handler)(Request);
+}
+
+void FDreamAccountInProcessServer::Reset()
+{
+	UsersByID.Empty();
+	UserIDsByName.Empty();
+	UserIDsByToken.Empty();
+	NextUserID = 10000;
+	BannedUserIDs.Empty();
+	BanVersion = 0;
+	BanLog.Empty();
+	LatencyBeaconBatches.Empty();
+	LoginQueueTickets.Empty();
+	LoginQueueAdmissions.Empty();
+	LoginQueueIssued = 0;
+	LoginQueueCursor = FMath::Max(LoginRate, 1.0f);
+	LoginQueueAdvanceTime = FPlatformTime::Seconds();
+}
+
+void FDreamAccountInProcessServer::SeedUsers(int32 Count)
+{
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FString Name = FString::Printf(TEXT("user_%d"), Index);
+		CreateUser(Name, Name);
+	}
+}
+
+TSharedPtr<FJsonObject> FDreamAccountInProcessServer::ParseRequestJson(const FDreamAccountHttpRequest& Request)
+{
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Request.Content);
+	TSharedPtr<FJsonObject> JsonObject;
+	if (FJsonSerializer::Deserialize(Reader, JsonObject))
+	{
+		return JsonObject;
+	}
+	return nullptr;
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::MakeJsonResponse(int32 ResponseCode, const TSharedRef<FJsonObject>& Json)
+{
+	FString Content;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Content);
+	FJsonSerializer::Serialize(Json, Writer);
+
+	return FDreamAccountHttpResponse::MakeJson(ResponseCode, MoveTemp(Content));
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::MakeCacheableJsonResponse(const FDreamAccountHttpRequest& Request, const TSharedRef<FJsonObject>& Json)
+{
+	FDreamAccountHttpResponse Response = MakeJsonResponse(200, Json);
+	const FString ETag = FString::Printf(TEXT("\"%08x\""), FCrc::StrCrc32(*Response.Content));
+
+	const FString* IfNoneMatch = Request.Headers.Find(TEXT("If-None-Match"));
+	if (IfNoneMatch && *IfNoneMatch == ETag)
+	{
+		Response.ResponseCode = 304;
+		Response.Content.Empty();
+	}
+	Response.Headers.Add(TEXT("ETag"), ETag);
+	return Response;
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleRegister(const FDreamAccountHttpRequest& Request)
+{
+	FString Name;
+	FString Password;
+	bool bDerived = false;
+	FDreamAccountHttpResponse Error;
+	if (!ParseCredentials(Request, Name, Password, bDerived, Error))
+	{
+		return Error;
+	}
+
+	FDreamAccountHttpResponse ValidationError;
+	if (!ValidateRegister(Name, Password, bDerived, ValidationError))
+	{
+		return ValidationError;
+	}
+
+	const FUserRecord* User = CreateUser(Name, Password, bDerived);
+	if (!User)
+	{
+		return FDreamAccountHttpResponse::MakeError(409, TEXT("USERNAME_EXISTS"));
+	}
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetObjectField(FIELD_USER, MakeUserJson(*User));
+	return MakeJsonResponse(201, Json);
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleLogin(const FDreamAccountHttpRequest& Request)
+{
+	FString Name;
+	FString Password;
+	bool bDerived = false;
+	FDreamAccountHttpResponse Error;
+	if (!ParseCredentials(Request, Name, Password, bDerived, Error))
+	{
+		return Error;
+	}
+
+	const int32* UserID = UserIDsByName.Find(Name);
+	if (!UserID)
+	{
+		return FDreamAccountHttpResponse::MakeError(404, TEXT("USER_NOT_FOUND"));
+	}
+
+	FUserRecord& User = UsersByID.FindChecked(*UserID);
+	if (!CheckPassword(User, Password, bDerived))
+	{
+		return FDreamAccountHttpResponse::MakeError(401, TEXT("INVALID_CREDENTIALS"));
+	}
+
+	if (BannedUserIDs.Contains(User.UserID))
+	{
+		return FDreamAccountHttpResponse::MakeError(403, TEXT("USER_BANNED"));
+	}
+
+	FDreamAccountHttpResponse Queued;
+	if (!AdmitLogin(Request, Name, Queued))
+	{
+		return Queued;
+	}
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetObjectField(FIELD_USER, MakeUserJson(User));
+	Json->SetStringField(FIELD_TOKEN, IssueToken(User));
+	return MakeJsonResponse(200, Json);
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleRegisterAndLogin(const FDreamAccountHttpRequest& Request)
+{
+	FString Name;
+	FString Password;
+	bool bDerived = false;
+	FDreamAccountHttpResponse Error;
+	if (!ParseCredentials(Request, Name, Password, bDerived, Error))
+	{
+		return Error;
+	}
+
+	FDreamAccountHttpResponse ValidationError;
+	if (!ValidateRegister(Name, Password, bDerived, ValidationError))
+	{
+		return ValidationError;
+	}
+
+	const FUserRecord* User = CreateUser(Name, Password, bDerived);
+	if (!User)
+	{
+		return FDreamAccountHttpResponse::MakeError(409, TEXT("USERNAME_EXISTS"));
+	}
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetObjectField(FIELD_USER, MakeUserJson(*User));
+	Json->SetStringField(FIELD_TOKEN, IssueToken(*User));
+	return MakeJsonResponse(201, Json);
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleAuth(const FDreamAccountHttpRequest& Request)
+{
+	FDreamAccountHttpResponse Error;
+	const FUserRecord* User = FindBearerUser(Request, Error);
+	if (!User)
+	{
+		return Error;
+	}
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetObjectField(FIELD_USER, MakeUserJson(*User));
+	return MakeCacheableJsonResponse(Request, Json);
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleRefresh(const FDreamAccountHttpRequest& Request)
+{
+	FDreamAccountHttpResponse Error;
+	const FUserRecord* User = FindBearerUser(Request, Error);
+	if (!User)
+	{
+		return Error;
+	}
+
+	// 旧令牌作废，换发新令牌
+	UserIDsByToken.Remove(Request.Headers.FindChecked(TEXT("Authorization")).RightChop(7));
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetObjectField(FIELD_USER, MakeUserJson(*User));
+	Json->SetStringField(FIELD_TOKEN, IssueToken(*User));
+	return MakeJsonResponse(200, Json);
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleUsernameAvailable(const FDreamAccountHttpRequest& Request)
+{
+	const FString Name = Request.GetQueryParameter(FIELD_USER_NAME);
+	if (Name.IsEmpty())
+	{
+		return FDreamAccountHttpResponse::MakeError(400, TEXT("MISSING_FIELDS"));
+	}
+
+	// 同时返回所有已被占用的前缀，客户端据此缓存更短的用户名
+	TArray<TSharedPtr<FJsonValue>> TakenPrefixes;
+	for (int32 Length = 1; Length <= Name.Len(); ++Length)
+	{
+		const FString Prefix = Name.Left(Length);
+		if (UserIDsByName.Contains(Prefix))
+		{
+			TakenPrefixes.Add(MakeShared<FJsonValueString>(Prefix));
+		}
+	}
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetBoolField(FIELD_AVAILABLE, !UserIDsByName.Contains(Name));
+	Json->SetArrayField(FIELD_TAKEN_PREFIXES, TakenPrefixes);
+	return MakeJsonResponse(200, Json);
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleValidationRules(const FDreamAccountHttpRequest& Request)
+{
+	return FDreamAccountHttpResponse::MakeJson(200, FDreamAccountValidationRules::GetDefaultRulesJson());
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleKdfParams(const FDreamAccountHttpRequest& Request)
+{
+	const FString Name = Request.GetQueryParameter(FIELD_USER_NAME);
+	if (Name.IsEmpty())
+	{
+		return FDreamAccountHttpResponse::MakeError(400, TEXT("MISSING_FIELDS"));
+	}
+
+	const FDreamAccountKdfParams Params = MakeKdfParams(Name);
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetStringField(FIELD_KDF_ALGORITHM, Params.Algorithm);
+	Json->SetStringField(FIELD_KDF_SALT, FBase64::Encode(Params.Salt));
+	Json->SetNumberField(FIELD_KDF_COST, Params.CostN);
+	Json->SetNumberField(FIELD_KDF_BLOCK_SIZE, Params.BlockSize);
+	Json->SetNumberField(FIELD_KDF_PARALLELISM, Params.Parallelism);
+	Json->SetNumberField(FIELD_KDF_KEY_LENGTH, Params.KeyLength);
+	return MakeJsonResponse(200, Json);
+}
+
+bool FDreamAccountInProcessServer::ParseCredentials(const FDreamAccountHttpRequest& Request, FString& OutName, FString& OutPassword, bool& bOutDerived, FDreamAccountHttpResponse& OutError)
+{
+	TSharedPtr<FJsonObject> Body = ParseRequestJson(Request);
+	if (!Body.IsValid() || !Body->TryGetStringField(FIELD_USER_NAME, OutName) || !Body->TryGetStringField(FIELD_USER_PASSWORD, OutPassword)
+		|| OutName.IsEmpty() || OutPassword.IsEmpty())
+	{
+		OutError = FDreamAccountHttpResponse::MakeError(400, TEXT("MISSING_FIELDS"));
+		return false;
+	}
+
+	FString Kdf;
+	bOutDerived = Body->TryGetStringField(FIELD_PASSWORD_KDF, Kdf) && !Kdf.IsEmpty();
+	if (bOutDerived && Kdf != TEXT("scrypt"))
+	{
+		OutError = FDreamAccountHttpResponse::MakeError(400, TEXT("VALIDATION_ERROR"));
+		return false;
+	}
+
+	return true;
+}
+
+bool FDreamAccountInProcessServer::CheckPassword(FUserRecord& User, const FString& Password, bool bDerived) const
+{
+	if (!bDerived)
+	{
+		return !User.Password.IsEmpty() && User.Password == Password;
+	}
+
+	// 服务器只对派生结果做一次 SHA-256
+	const FString Verifier = MakeKdfVerifier(Password);
+	if (!User.KdfVerifier.IsEmpty())
+	{
+		return User.KdfVerifier == Verifier;
+	}
+
+	// 旧账号只有原始密码，服务器自己派生一次进行比对，成功后升级
+	if (User.Password.IsEmpty() || FDreamAccountKeyDerivation::DeriveToHex(User.Password, MakeKdfParams(User.Name)) != Password)
+	{
+		return false;
+	}
+	User.KdfVerifier = Verifier;
+	User.Password.Empty();
+	return true;
+}
+
+FDreamAccountKdfParams FDreamAccountInProcessServer::MakeKdfParams(const FString& Name) const
+{
+	FDreamAccountKdfParams Params;
+	Params.Salt = FDreamAccountKeyDerivation::HmacSha256(KdfSecret, ToUtf8Bytes(Name));
+	Params.Salt.SetNum(16);
+	Params.CostN = KdfCostN;
+	Params.BlockSize = KdfBlockSize;
+	Params.Parallelism = KdfParallelism;
+	return Params;
+}
+
+bool FDreamAccountInProcessServer::ValidateRegister(const FString& Name, const FString& Password, bool bDerived, FDreamAccountHttpResponse& OutError) const
+{
+	if (!ValidationRules.IsValidUserName(Name))
+	{
+		OutError = FDreamAccountHttpResponse::MakeError(400, TEXT("INVALID_USERNAME"));
+		return false;
+	}
+
+	// 派生后的密码无法检查原始密码的规则，由客户端在派生前检查
+	if (!bDerived && !ValidationRules.IsValidPassword(Password))
+	{
+		OutError = FDreamAccountHttpResponse::MakeError(400, TEXT("INVALID_PASSWORD"));
+		return false;
+	}
+
+	return true;
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleUsersLookup(const FDreamAccountHttpRequest& Request)
+{
+	TSharedPtr<FJsonObject> Body = ParseRequestJson(Request);
+	const TArray<TSharedPtr<FJsonValue>>* UserIDValues;
+	if (!Body.IsValid() || !Body->TryGetArrayField(FIELD_USER_IDS, UserIDValues))
+	{
+		return FDreamAccountHttpResponse::MakeError(400, TEXT("MISSING_FIELDS"));
+	}
+
+	TArray<TSharedPtr<FJsonValue>> UserValues;
+	for (const TSharedPtr<FJsonValue>& UserIDValue : *UserIDValues)
+	{
+		int32 UserID;
+		if (UserIDValue.IsValid() && UserIDValue->TryGetNumber(UserID))
+		{
+			if (const FUserRecord* User = UsersByID.Find(UserID))
+			{
+				UserValues.Add(MakeShared<FJsonValueObject>(MakeUserJson(*User)));
+			}
+		}
+	}
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetArrayField(FIELD_USERS, UserValues);
+	return MakeCacheableJsonResponse(Request, Json);
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleBans(const FDreamAccountHttpRequest& Request)
+{
+	const FString SinceParameter = Request.GetQueryParameter(FIELD_SINCE);
+	const int64 Since = SinceParameter.IsEmpty() ? -1 : FCString::Atoi64(*SinceParameter);
+	const int64 OldestVersion = BanLog.Num() > 0 ? BanLog[0].Get<0>() - 1 : BanVersion;
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetNumberField(FIELD_VERSION, static_cast<double>(BanVersion));
+
+	// 日志已不包含请求的版本时返回完整快照
+	if (Since < OldestVersion || Since > BanVersion)
+	{
+		TArray<TSharedPtr<FJsonValue>> UserIDValues;
+		for (int32 UserID : BannedUserIDs)
+		{
+			UserIDValues.Add(MakeShared<FJsonValueNumber>(UserID));
+		}
+		Json->SetBoolField(FIELD_SNAPSHOT, true);
+		Json->SetArrayField(FIELD_USER_IDS, UserIDValues);
+		return MakeJsonResponse(200, Json);
+	}
+
+	TMap<int32, bool> Latest;
+	for (const TTuple<int64, int32, bool>& Entry : BanLog)
+	{
+		if (Entry.Get<0>() > Since)
+		{
+			Latest.Add(Entry.Get<1>(), Entry.Get<2>());
+		}
+	}
+
+	TArray<TSharedPtr<FJsonValue>> AddedValues;
+	TArray<TSharedPtr<FJsonValue>> RemovedValues;
+	for (const TPair<int32, bool>& Pair : Latest)
+	{
+		if (Pair.Value)
+		{
+			AddedValues.Add(MakeShared<FJsonValueNumber>(Pair.Key));
+		}
+		else
+		{
+			RemovedValues.Add(MakeShared<FJsonValueNumber>(Pair.Key));
+		}
+	}
+	Json->SetBoolField(FIELD_SNAPSHOT, false);
+	Json->SetArrayField(FIELD_ADDED, AddedValues);
+	Json->SetArrayField(FIELD_REMOVED, RemovedValues);
+	return MakeJsonResponse(200, Json);
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleLatencyBeacons(const FDreamAccountHttpRequest& Request)
+{
+	// 请求体为 {"encoding": "zlib", "size": 原始字节数, "data": Base64}
+	TSharedPtr<FJsonObject> Body = ParseRequestJson(Request);
+	FString Encoding;
+	FString Data;
+	int32 RawSize = 0;
+	if (!Body.IsValid() || !Body->TryGetStringField(TEXT("encoding"), Encoding) || Encoding != TEXT("zlib")
+		|| !Body->TryGetStringField(TEXT("data"), Data) || !Body->TryGetNumberField(TEXT("size"), RawSize) || RawSize <= 0)
+	{
+		return FDreamAccountHttpResponse::MakeError(400, TEXT("MISSING_FIELDS"));
+	}
+
+	TArray<uint8> Compressed;
+	TArray<uint8> Raw;
+	Raw.SetNumUninitialized(RawSize);
+	if (!FBase64::Decode(Data, Compressed)
+		|| !FCompression::UncompressMemory(NAME_Zlib, Raw.GetData(), RawSize, Compressed.GetData(), Compressed.Num()))
+	{
+		return FDreamAccountHttpResponse::MakeError(400, TEXT("VALIDATION_ERROR"));
+	}
+
+	const FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Raw.GetData()), Raw.Num());
+	TSharedPtr<FJsonObject> Batch;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(FString(Converter.Length(), Converter.Get()));
+	if (!FJsonSerializer::Deserialize(Reader, Batch) || !Batch.IsValid())
+	{
+		return FDreamAccountHttpResponse::MakeError(400, TEXT("VALIDATION_ERROR"));
+	}
+
+	LatencyBeaconBatches.Add(Batch);
+
+	FDreamAccountHttpResponse Response;
+	Response.bSucceeded = true;
+	Response.ResponseCode = 204;
+	return Response;
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleLoginQueue(const FDreamAccountHttpRequest& Request)
+{
+	// 请求在进程内同步处理，忽略长轮询的 wait 参数
+	const FString Ticket = Request.GetQueryParameter(FIELD_QUEUE_TICKET);
+	const FQueueTicket* Found = LoginQueueTickets.Find(Ticket);
+	if (!Found)
+	{
+		return FDreamAccountHttpResponse::MakeError(404, TEXT("QUEUE_TICKET_NOT_FOUND"));
+	}
+
+	AdvanceLoginQueue();
+	if (Found->Sequence >= LoginQueueCursor)
+	{
+		TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+		Json->SetObjectField(FIELD_QUEUE, MakeQueueJson(Ticket, Found->Sequence));
+		return MakeJsonResponse(200, Json);
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	for (auto It = LoginQueueAdmissions.CreateIterator(); It; ++It)
+	{
+		if (It.Value().ExpireTime <= Now)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	const FString Admission = FGuid::NewGuid().ToString(EGuidFormats::Digits).ToLower();
+	LoginQueueAdmissions.Add(Admission, FQueueAdmission{Found->UserName, Now + QueueAdmissionTimeToLive});
+	LoginQueueTickets.Remove(Ticket);
+
+	TSharedRef<FJsonObject> Queue = MakeShared<FJsonObject>();
+	Queue->SetStringField(FIELD_QUEUE_TICKET, Ticket);
+	Queue->SetStringField(FIELD_QUEUE_STATUS, TEXT("admitted"));
+	Queue->SetStringField(FIELD_QUEUE_ADMISSION, Admission);
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetObjectField(FIELD_QUEUE, Queue);
+	return MakeJsonResponse(200, Json);
+}
+
+FDreamAccountHttpResponse FDreamAccountInProcessServer::HandleLoginQueueLeave(const FDreamAccountHttpRequest& Request)
+{
+	TSharedPtr<FJsonObject> Body = ParseRequestJson(Request);
+	FString Ticket;
+	if (!Body.IsValid() || !Body->TryGetStringField(FIELD_QUEUE_TICKET, Ticket))
+	{
+		return FDreamAccountHttpResponse::MakeError(400, TEXT("MISSING_FIELDS"));
+	}
+
+	LoginQueueTickets.Remove(Ticket);
+	return MakeJsonResponse(200, MakeShared<FJsonObject>());
+}
+
+bool FDreamAccountInProcessServer::AdmitLogin(const FDreamAccountHttpRequest& Request, const FString& Name, FDreamAccountHttpResponse& OutQueued)
+{
+	if (LoginRate <= 0.0f)
+	{
+		return true;
+	}
+
+	// 排队放行后带准入凭证重新登录，凭证只能使用一次
+	if (const FString* Admission = Request.Headers.Find(TEXT("X-Queue-Admission")))
+	{
+		const FQueueAdmission* Found = LoginQueueAdmissions.Find(*Admission);
+		if (Found && Found->UserName == Name && Found->ExpireTime > FPlatformTime::Seconds())
+		{
+			LoginQueueAdmissions.Remove(*Admission);
+			return true;
+		}
+	}
+
+	AdvanceLoginQueue();
+
+	// 同一用户再次登录时沿用原来的票据，不重新排到队尾
+	FString Ticket;
+	int64 Sequence = INDEX_NONE;
+	for (const TPair<FString, FQueueTicket>& Pair : LoginQueueTickets)
+	{
+		if (Pair.Value.UserName == Name)
+		{
+			Ticket = Pair.Key;
+			Sequence = Pair.Value.Sequence;
+			break;
+		}
+	}
+
+	if (Ticket.IsEmpty())
+	{
+		// 所有排队的登录都已放行且还有额度时直接放行
+		if (LoginQueueCursor - LoginQueueIssued >= 1.0)
+		{
+			++LoginQueueIssued;
+			return true;
+		}
+
+		Ticket = FGuid::NewGuid().ToString(EGuidFormats::Digits).ToLower();
+		Sequence = LoginQueueIssued++;
+		LoginQueueTickets.Add(Ticket, FQueueTicket{Name, Sequence});
+	}
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetStringField(TEXT("error"), TEXT("TOO_MANY_REQUESTS"));
+	Json->SetObjectField(FIELD_QUEUE, MakeQueueJson(Ticket, Sequence));
+	OutQueued = MakeJsonResponse(429, Json);
+	return false;
+}
+
+void FDreamAccountInProcessServer::AdvanceLoginQueue()
+{
+	const double Now = FPlatformTime::Seconds();
+
+	// 空闲时最多积累一秒的放行额度，至少一个
+	LoginQueueCursor = FMath::Min(LoginQueueCursor + (Now - LoginQueueAdvanceTime) * LoginRate, static_cast<double>(LoginQueueIssued) + FMath::Max(LoginRate, 1.0f));
+	LoginQueueAdvanceTime = Now;
+}
+
+TSharedRef<FJsonObject> FDreamAccountInProcessServer::MakeQueueJson(const FString& Ticket, int64 Sequence) const
+{
+	const double EtaSeconds = LoginRate > 0.0f ? (Sequence + 1 - LoginQueueCursor) / LoginRate : 0.0;
+
+	TSharedRef<FJsonObject> Queue = MakeShared<FJsonObject>();
+	Queue->SetStringField(FIELD_QUEUE_TICKET, Ticket);
+	Queue->SetStringField(FIELD_QUEUE_STATUS, TEXT("waiting"));
+	Queue->SetNumberField(FIELD_QUEUE_POSITION, static_cast<double>(Sequence - FMath::FloorToInt64(LoginQueueCursor) + 1));
+	Queue->SetNumberField(FIELD_QUEUE_ETA, FMath::CeilToDouble(EtaSeconds));
+
+	// 剩余时间越短查询越频繁，各客户端的查询时间随位置错开
+	Queue->SetNumberField(FIELD_QUEUE_POLL_AFTER, FMath::Clamp(FMath::RoundToDouble(EtaSeconds * 2.5) / 10.0, 1.0, 15.0));
+	return Queue;
+}
+
+void FDreamAccountInProcessServer::SetLoginRate(float LoginsPerSecond)
+{
+	const float NewRate = FMath::Max(LoginsPerSecond, 0.0f);
+
+	// 按原速率结算已经过去的时间，正在排队的登录保持原来的位置；从不限制切换时有一秒的额度
+	if (LoginRate > 0.0f)
+	{
+		AdvanceLoginQueue();
+	}
+	else
+	{
+		LoginQueueCursor = static_cast<double>(LoginQueueIssued) + FMath::Max(NewRate, 1.0f);
+		LoginQueueAdvanceTime = FPlatformTime::Seconds();
+	}
+
+	LoginRate = NewRate;
+}
+
+void FDreamAccountInProcessServer::SetUserBanned(int32 UserID, bool bBanned)
+{
+	if (bBanned)
+	{
+		BannedUserIDs.Add(UserID);
+	}
+	else
+	{
+		BannedUserIDs.Remove(UserID);
+	}
+
+	BanLog.Emplace(++BanVersion, UserID, bBanned);
+	if (BanLog.Num() > BanLogLimit)
+	{
+		BanLog.RemoveAt(0, BanLog.Num() - BanLogLimit);
+	}
+}
+
+const FDreamAccountInProcessServer::FUserRecord* FDreamAccountInProcessServer::FindBearerUser(const FDreamAccountHttpRequest& Request, FDreamAccountHttpResponse& OutError) const
+{
+	const FString* Header = Request.Headers.Find(TEXT("Authorization"));
+	if (!Header)
+	{
+		OutError = FDreamAccountHttpResponse::MakeError(401, TEXT("USER_NOT_AUTHENTICATED"));
+		return nullptr;
+	}
+
+	static const FString BearerPrefix = TEXT("Bearer ");
+	if (!Header->StartsWith(BearerPrefix, ESearchCase::CaseSensitive))
+	{
+		OutError = FDreamAccountHttpResponse::MakeError(401, TEXT("INVALID_AUTH_HEADER"));
+		return nullptr;
+	}
+
+	const int32* UserID = UserIDsByToken.Find(Header->RightChop(BearerPrefix.Len()));
+	const FUserRecord* User = UserID ? UsersByID.Find(*UserID) : nullptr;
+	if (!User)
+	{
+		OutError = FDreamAccountHttpResponse::MakeError(401, TEXT("INVALID_TOKEN"));
+		return nullptr;
+	}
+
+	if (BannedUserIDs.Contains(User->UserID))
+	{
+		OutError = FDreamAccountHttpResponse::MakeError(403, TEXT("USER_BANNED"));
+		return nullptr;
+	}
+
+	return User;
+}
+
+const FDreamAccountInProcessServer::FUserRecord* FDreamAccountInProcessServer::CreateUser(const FString& Name, const FString& Password, bool bDerived)
+{
+	if (UserIDsByName.Contains(Name))
+	{
+		return nullptr;
+	}
+
+	FUserRecord& User = UsersByID.Add(NextUserID);
+	User.UserID = NextUserID++;
+	User.Name = Name;
+	if (bDerived)
+	{
+		User.KdfVerifier = MakeKdfVerifier(Password);
+	}
+	else
+	{
+		User.Password = Password;
+	}
+	UserIDsByName.Add(Name, User.UserID);
+	return &User;
+}
+
+FString FDreamAccountInProcessServer::IssueToken(const FUserRecord& User)
+{
+	FString NewToken = FGuid::NewGuid().ToString(EGuidFormats::Digits).ToLower();
+	UserIDsByToken.Add(NewToken, User.UserID);
+	return NewToken;
+}
+
+TSharedRef<FJsonObject> FDreamAccountInProcessServer::MakeUserJson(const FUserRecord& User)
+{
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetNumberField(FIELD_USER_ID, User.UserID);
+	Json->SetStringField(FIELD_USER_NAME, User.Name);
+	return Json;
+}
@@ -0,0 +1,548 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountKeyDerivation.h"
+
+#include "Async/Async.h"
+#include "DreamAccountModule.h"
+#include "DreamAccountUtil.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Base64.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace DreamAccountKdf
+{
+	static const uint32 Sha256RoundConstants[64] =
+	{
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+	};
+
+	static inline uint32 RotateRight(uint32 Value, uint32 Bits)
+	{
+		return (Value >> Bits) | (Value << (32 - Bits));
+	}
+
+	static inline uint32 RotateLeft(uint32 Value, uint32 Bits)
+	{
+		return (Value << Bits) | (Value >> (32 - Bits));
+	}
+
+	static inline uint32 LoadBigEndian32(const uint8* Bytes)
+	{
+		return (uint32(Bytes[0]) << 24) | (uint32(Bytes[1]) << 16) | (uint32(Bytes[2]) << 8) | uint32(Bytes[3]);
+	}
+
+	static inline void StoreBigEndian32(uint8* Bytes, uint32 Value)
+	{
+		Bytes[0] = uint8(Value >> 24);
+		Bytes[1] = uint8(Value >> 16);
+		Bytes[2] = uint8(Value >> 8);
+		Bytes[3] = uint8(Value);
+	}
+
+	static inline uint32 LoadLittleEndian32(const uint8* Bytes)
+	{
+		return uint32(Bytes[0]) | (uint32(Bytes[1]) << 8) | (uint32(Bytes[2]) << 16) | (uint32(Bytes[3]) << 24);
+	}
+
+	static inline void StoreLittleEndian32(uint8* Bytes, uint32 Value)
+	{
+		Bytes[0] = uint8(Value);
+		Bytes[1] = uint8(Value >> 8);
+		Bytes[2] = uint8(Value >> 16);
+		Bytes[3] = uint8(Value >> 24);
+	}
+
+	/** 增量计算的 SHA-256 */
+	struct FSha256
+	{
+		uint32 State[8];
+		uint8 Buffer[64];
+		uint64 TotalBytes = 0;
+		int32 BufferBytes = 0;
+
+		FSha256()
+		{
+			State[0] = 0x6a09e667;
+			State[1] = 0xbb67ae85;
+			State[2] = 0x3c6ef372;
+			State[3] = 0xa54ff53a;
+			State[4] = 0x510e527f;
+			State[5] = 0x9b05688c;
+			State[6] = 0x1f83d9ab;
+			State[7] = 0x5be0cd19;
+		}
+
+		void Update(const uint8* Data, int64 Length)
+		{
+			TotalBytes += Length;
+			if (BufferBytes > 0)
+			{
+				const int32 Fill = static_cast<int32>(FMath::Min<int64>(64 - BufferBytes, Length));
+				FMemory::Memcpy(Buffer + BufferBytes, Data, Fill);
+				BufferBytes += Fill;
+				Data += Fill;
+				Length -= Fill;
+				if (BufferBytes < 64)
+				{
+					return;
+				}
+				Transform(Buffer);
+				BufferBytes = 0;
+			}
+
+			while (Length >= 64)
+			{
+				Transform(Data);
+				Data += 64;
+				Length -= 64;
+			}
+
+			if (Length > 0)
+			{
+				FMemory::Memcpy(Buffer, Data, Length);
+				BufferBytes = static_cast<int32>(Length);
+			}
+		}
+
+		void Final(uint8 OutDigest[32])
+		{
+			const uint64 TotalBits = TotalBytes * 8;
+			static const uint8 Padding[64] = { 0x80 };
+			Update(Padding, BufferBytes < 56 ? 56 - BufferBytes : 120 - BufferBytes);
+
+			uint8 LengthBytes[8];
+			StoreBigEndian32(LengthBytes, uint32(TotalBits >> 32));
+			StoreBigEndian32(LengthBytes + 4, uint32(TotalBits));
+			Update(LengthBytes, 8);
+
+			for (int32 Index = 0; Index < 8; ++Index)
+			{
+				StoreBigEndian32(OutDigest + Index * 4, State[Index]);
+			}
+		}
+
+		void Transform(const uint8* Block)
+		{
+			uint32 W[64];
+			for (int32 Index = 0; Index < 16; ++Index)
+			{
+				W[Index] = LoadBigEndian32(Block + Index * 4);
+			}
+			for (int32 Index = 16; Index < 64; ++Index)
+			{
+				const uint32 S0 = RotateRight(W[Index - 15], 7) ^ RotateRight(W[Index - 15], 18) ^ (W[Index - 15] >> 3);
+				const uint32 S1 = RotateRight(W[Index - 2], 17) ^ RotateRight(W[Index - 2], 19) ^ (W[Index - 2] >> 10);
+				W[Index] = W[Index - 16] + S0 + W[Index - 7] + S1;
+			}
+
+			uint32 A = State[0], B = State[1], C = State[2], D = State[3];
+			uint32 E = State[4], F = State[5], G = State[6], H = State[7];
+			for (int32 Index = 0; Index < 64; ++Index)
+			{
+				const uint32 S1 = RotateRight(E, 6) ^ RotateRight(E, 11) ^ RotateRight(E, 25);
+				const uint32 Choose = (E & F) ^ (~E & G);
+				const uint32 Temp1 = H + S1 + Choose + Sha256RoundConstants[Index] + W[Index];
+				const uint32 S0 = RotateRight(A, 2) ^ RotateRight(A, 13) ^ RotateRight(A, 22);
+				const uint32 Majority = (A & B) ^ (A & C) ^ (B & C);
+				const uint32 Temp2 = S0 + Majority;
+				H = G;
+				G = F;
+				F = E;
+				E = D + Temp1;
+				D = C;
+				C = B;
+				B = A;
+				A = Temp1 + Temp2;
+			}
+
+			State[0] += A;
+			State[1] += B;
+			State[2] += C;
+			State[3] += D;
+			State[4] += E;
+			State[5] += F;
+			State[6] += G;
+			State[7] += H;
+		}
+	};
+
+	/** 预先计算内外填充状态的 HMAC-SHA256，PBKDF2 的每个块只需复制状态 */
+	struct FHmacSha256
+	{
+		FSha256 Inner;
+		FSha256 Outer;
+
+		FHmacSha256(const uint8* Key, int64 KeyLength)
+		{
+			uint8 KeyBlock[64] = {};
+			if (KeyLength > 64)
+			{
+				FSha256 KeyHash;
+				KeyHash.Update(Key, KeyLength);
+				KeyHash.Final(KeyBlock);
+			}
+			else if (KeyLength > 0)
+			{
+				FMemory::Memcpy(KeyBlock, Key, KeyLength);
+			}
+
+			uint8 Pad[64];
+			for (int32 Index = 0; Index < 64; ++Index)
+			{
+				Pad[Index] = KeyBlock[Index] ^ 0x36;
+			}
+			Inner.Update(Pad, 64);
+			for (int32 Index = 0; Index < 64; ++Index)
+			{
+				Pad[Index] = KeyBlock[Index] ^ 0x5c;
+			}
+			Outer.Update(Pad, 64);
+			FMemory::Memzero(KeyBlock, sizeof(KeyBlock));
+		}
+
+		void Compute(const uint8* Data, int64 Length, const uint8* Suffix, int64 SuffixLength, uint8 OutDigest[32]) const
+		{
+			uint8 InnerDigest[32];
+			FSha256 InnerHash = Inner;
+			InnerHash.Update(Data, Length);
+			InnerHash.Update(Suffix, SuffixLength);
+			InnerHash.Final(InnerDigest);
+
+			FSha256 OuterHash = Outer;
+			OuterHash.Update(InnerDigest, 32);
+			OuterHash.Final(OutDigest);
+		}
+	};
+
+	/** 迭代次数为 1 的 PBKDF2-HMAC-SHA256，scrypt 只用到这种形式 */
+	static void Pbkdf2Sha256(const uint8* Password, int64 PasswordLength, const uint8* Salt, int64 SaltLength, uint8* Out, int64 OutLength)
+	{
+		const FHmacSha256 Hmac(Password, PasswordLength);
+		uint8 Digest[32];
+		uint8 BlockIndex[4];
+		for (uint32 Block = 1; OutLength > 0; ++Block)
+		{
+			StoreBigEndian32(BlockIndex, Block);
+			Hmac.Compute(Salt, SaltLength, BlockIndex, 4, Digest);
+
+			const int64 Count = FMath::Min<int64>(OutLength, 32);
+			FMemory::Memcpy(Out, Digest, Count);
+			Out += Count;
+			OutLength -= Count;
+		}
+	}
+
+	static void Salsa20_8(uint32 B[16])
+	{
+		uint32 X[16];
+		FMemory::Memcpy(X, B, sizeof(X));
+		for (int32 Round = 0; Round < 8; Round += 2)
+		{
+			X[ 4] ^= RotateLeft(X[ 0] + X[12],  7);  X[ 8] ^= RotateLeft(X[ 4] + X[ 0],  9);
+			X[12] ^= RotateLeft(X[ 8] + X[ 4], 13);  X[ 0] ^= RotateLeft(X[12] + X[ 8], 18);
+			X[ 9] ^= RotateLeft(X[ 5] + X[ 1],  7);  X[13] ^= RotateLeft(X[ 9] + X[ 5],  9);
+			X[ 1] ^= RotateLeft(X[13] + X[ 9], 13);  X[ 5] ^= RotateLeft(X[ 1] + X[13], 18);
+			X[14] ^= RotateLeft(X[10] + X[ 6],  7);  X[ 2] ^= RotateLeft(X[14] + X[10],  9);
+			X[ 6] ^= RotateLeft(X[ 2] + X[14], 13);  X[10] ^= RotateLeft(X[ 6] + X[ 2], 18);
+			X[ 3] ^= RotateLeft(X[15] + X[11],  7);  X[ 7] ^= RotateLeft(X[ 3] + X[15],  9);
+			X[11] ^= RotateLeft(X[ 7] + X[ 3], 13);  X[15] ^= RotateLeft(X[11] + X[ 7], 18);
+			X[ 1] ^= RotateLeft(X[ 0] + X[ 3],  7);  X[ 2] ^= RotateLeft(X[ 1] + X[ 0],  9);
+			X[ 3] ^= RotateLeft(X[ 2] + X[ 1], 13);  X[ 0] ^= RotateLeft(X[ 3] + X[ 2], 18);
+			X[ 6] ^= RotateLeft(X[ 5] + X[ 4],  7);  X[ 7] ^= RotateLeft(X[ 6] + X[ 5],  9);
+			X[ 4] ^= RotateLeft(X[ 7] + X[ 6], 13);  X[ 5] ^= RotateLeft(X[ 4] + X[ 7], 18);
+			X[11] ^= RotateLeft(X[10] + X[ 9],  7);  X[ 8] ^= RotateLeft(X[11] + X[10],  9);
+			X[ 9] ^= RotateLeft(X[ 8] + X[11], 13);  X[10] ^= RotateLeft(X[ 9] + X[ 8], 18);
+			X[12] ^= RotateLeft(X[15] + X[14],  7);  X[13] ^= RotateLeft(X[12] + X[15],  9);
+			X[14] ^= RotateLeft(X[13] + X[12], 13);  X[15] ^= RotateLeft(X[14] + X[13], 18);
+		}
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			B[Index] += X[Index];
+		}
+	}
+
+	/** scryptBlockMix：B 为 2r 个 64 字节块，Y 为同样大小的临时空间 */
+	static void BlockMix(uint32* B, uint32* Y, uint32 R)
+	{
+		uint32 X[16];
+		FMemory::Memcpy(X, &B[(2 * R - 1) * 16], 64);
+		for (uint32 Index = 0; Index < 2 * R; ++Index)
+		{
+			for (int32 Word = 0; Word < 16; ++Word)
+			{
+				X[Word] ^= B[Index * 16 + Word];
+			}
+			Salsa20_8(X);
+			FMemory::Memcpy(&Y[Index * 16], X, 64);
+		}
+
+		// 偶数块在前，奇数块在后
+		for (uint32 Index = 0; Index < R; ++Index)
+		{
+			FMemory::Memcpy(&B[Index * 16], &Y[(2 * Index) * 16], 64);
+			FMemory::Memcpy(&B[(R + Index) * 16], &Y[(2 * Index + 1) * 16], 64);
+		}
+	}
+
+	/** scryptROMix：Block 为 128r 字节，V 为 N * 32r 个字，XY 为 64r 个字 */
+	static void ROMix(uint8* Block, uint32 R, uint64 N, uint32* V, uint32* XY)
+	{
+		const uint32 Words = 32 * R;
+		uint32* X = XY;
+		uint32* Y = XY + Words;
+
+		for (uint32 Word = 0; Word < Words; ++Word)
+		{
+			X[Word] = LoadLittleEndian32(Block + Word * 4);
+		}
+
+		for (uint64 Index = 0; Index < N; ++Index)
+		{
+			FMemory::Memcpy(&V[Index * Words], X, Words * sizeof(uint32));
+			BlockMix(X, Y, R);
+		}
+
+		for (uint64 Index = 0; Index < N; ++Index)
+		{
+			const uint64 J = X[(2 * R - 1) * 16] & (N - 1);
+			const uint32* VJ = &V[J * Words];
+			for (uint32 Word = 0; Word < Words; ++Word)
+			{
+				X[Word] ^= VJ[Word];
+			}
+			BlockMix(X, Y, R);
+		}
+
+		for (uint32 Word = 0; Word < Words; ++Word)
+		{
+			StoreLittleEndian32(Block + Word * 4, X[Word]);
+		}
+	}
+
+	/** 完整的 scrypt 计算，B、XY、V 由调用方分配 */
+	static void ScryptWithBuffers(const uint8* Password, int64 PasswordLength, const uint8* Salt, int64 SaltLength,
+		uint64 N, uint32 R, uint32 P, uint8* B, uint32* XY, uint32* V, uint8* Out, int64 OutLength)
+	{
+		const int64 BlockBytes = 128 * int64(R);
+		Pbkdf2Sha256(Password, PasswordLength, Salt, SaltLength, B, BlockBytes * P);
+		for (uint32 Lane = 0; Lane < P; ++Lane)
+		{
+			ROMix(B + Lane * BlockBytes, R, N, V, XY);
+		}
+		Pbkdf2Sha256(Password, PasswordLength, B, BlockBytes * P, Out, OutLength);
+	}
+
+	/** 参数的上限，防止异常的服务器参数耗尽内存 */
+	static constexpr int32 MaxParallelism = 16;
+	static constexpr int32 MaxBlockSize = 64;
+	static constexpr int32 MaxKeyLength = 128;
+
+	static FString ToLowerHex(const TArray<uint8>& Bytes)
+	{
+		return BytesToHex(Bytes.GetData(), Bytes.Num()).ToLower();
+	}
+
+	static TArray<uint8> ToUtf8Bytes(const FString& Text)
+	{
+		const FTCHARToUTF8 Converter(*Text);
+		return TArray<uint8>(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+	}
+
+	static void RunBenchmark(int32 MinLogN, int32 MaxLogN, int32 R, int32 P, int32 Runs)
+	{
+		UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount KDF benchmark: self test %s"), FDreamAccountKeyDerivation::SelfTest() ? TEXT("passed") : TEXT("FAILED"));
+
+		const TArray<uint8> Password = ToUtf8Bytes(TEXT("benchmark-password"));
+		for (int32 LogN = MinLogN; LogN <= MaxLogN; ++LogN)
+		{
+			FDreamAccountKdfParams Params;
+			Params.Salt = ToUtf8Bytes(TEXT("benchmark-salt-0"));
+			Params.CostN = 1 << LogN;
+			Params.BlockSize = R;
+			Params.Parallelism = P;
+
+			TArray<double> Durations;
+			for (int32 Run = 0; Run < Runs; ++Run)
+			{
+				TArray<uint8> Key;
+				const double StartTime = FPlatformTime::Seconds();
+				if (!FDreamAccountKeyDerivation::Scrypt(Password, Params, Key))
+				{
+					break;
+				}
+				Durations.Add((FPlatformTime::Seconds() - StartTime) * 1000.0);
+			}
+
+			if (Durations.Num() == 0)
+			{
+				UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount KDF benchmark: N=2^%d r=%d p=%d failed"), LogN, R, P);
+				continue;
+			}
+
+			Durations.Sort();
+			UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount KDF benchmark: N=2^%-2d r=%d p=%d memory=%6.1fMB median=%8.1fms min=%8.1fms"),
+				LogN, R, P, Params.GetMemoryBytes() / (1024.0 * 1024.0), Durations[Durations.Num() / 2], Durations[0]);
+		}
+	}
+
+	static FAutoConsoleCommand CmdBenchmark(
+		TEXT("DreamAccount.Kdf.Benchmark"),
+		TEXT("在后台线程测量 scrypt 在不同参数下的耗时：DreamAccount.Kdf.Benchmark [MinLog2N=10] [MaxLog2N=17] [r=8] [p=1] [Runs=3]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 MinLogN = FMath::Clamp(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10, 1, 24);
+			const int32 MaxLogN = FMath::Clamp(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 17, MinLogN, 24);
+			const int32 R = FMath::Clamp(Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 8, 1, MaxBlockSize);
+			const int32 P = FMath::Clamp(Args.Num() > 3 ? FCString::Atoi(*Args[3]) : 1, 1, MaxParallelism);
+			const int32 Runs = FMath::Clamp(Args.Num() > 4 ? FCString::Atoi(*Args[4]) : 3, 1, 100);
+
+			Async(EAsyncExecution::ThreadPool, [MinLogN, MaxLogN, R, P, Runs]()
+			{
+				RunBenchmark(MinLogN, MaxLogN, R, P, Runs);
+			});
+		}));
+}
+
+bool FDreamAccountKdfParams::IsValid() const
+{
+	return Algorithm == TEXT("scrypt")
+		&& Salt.Num() > 0
+		&& CostN > 1 && FMath::IsPowerOfTwo(CostN)
+		&& BlockSize >= 1 && BlockSize <= DreamAccountKdf::MaxBlockSize
+		&& Parallelism >= 1 && Parallelism <= DreamAccountKdf::MaxParallelism
+		&& KeyLength >= 16 && KeyLength <= DreamAccountKdf::MaxKeyLength;
+}
+
+uint64 FDreamAccountKdfParams::GetMemoryBytes() const
+{
+	return 128ull * BlockSize * (static_cast<uint64>(CostN) + Parallelism + 2);
+}
+
+bool FDreamAccountKdfParams::LoadFromJson(const FString& JsonString)
+{
+	using namespace FDreamAccountFields;
+
+	TSharedPtr<FJsonObject> Json;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
+	if (!FJsonSerializer::Deserialize(Reader, Json) || !Json.IsValid())
+	{
+		return false;
+	}
+
+	FString SaltBase64;
+	if (!Json->TryGetStringField(FIELD_KDF_ALGORITHM, Algorithm)
+		|| !Json->TryGetStringField(FIELD_KDF_SALT, SaltBase64)
+		|| !Json->TryGetNumberField(FIELD_KDF_COST, CostN)
+		|| !Json->TryGetNumberField(FIELD_KDF_BLOCK_SIZE, BlockSize)
+		|| !Json->TryGetNumberField(FIELD_KDF_PARALLELISM, Parallelism)
+		|| !Json->TryGetNumberField(FIELD_KDF_KEY_LENGTH, KeyLength))
+	{
+		return false;
+	}
+
+	Salt.Reset();
+	return FBase64::Decode(SaltBase64, Salt) && IsValid();
+}
+
+bool FDreamAccountKeyDerivation::Scrypt(const TArray<uint8>& Password, const FDreamAccountKdfParams& Params, TArray<uint8>& OutKey)
+{
+	if (!Params.IsValid())
+	{
+		return false;
+	}
+
+	const uint32 R = static_cast<uint32>(Params.BlockSize);
+	const uint32 P = static_cast<uint32>(Params.Parallelism);
+	const uint64 N = static_cast<uint64>(Params.CostN);
+
+	TArray64<uint8> B;
+	TArray64<uint32> XY;
+	TArray64<uint32> V;
+	B.SetNumUninitialized(128 * int64(R) * P);
+	XY.SetNumUninitialized(64 * int64(R));
+	V.SetNumUninitialized(32 * int64(R) * int64(N));
+
+	OutKey.SetNumUninitialized(Params.KeyLength);
+	DreamAccountKdf::ScryptWithBuffers(Password.GetData(), Password.Num(), Params.Salt.GetData(), Params.Salt.Num(),
+		N, R, P, B.GetData(), XY.GetData(), V.GetData(), OutKey.GetData(), OutKey.Num());
+
+	// 中间状态可以还原出派生结果，释放前清零
+	FMemory::Memzero(B.GetData(), B.Num());
+	FMemory::Memzero(XY.GetData(), XY.Num() * sizeof(uint32));
+	return true;
+}
+
+void FDreamAccountKeyDerivation::DeriveAsync(const FString& Password, const FDreamAccountKdfParams& Params, FDeriveCallback Callback)
+{
+	AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [PasswordBytes = DreamAccountKdf::ToUtf8Bytes(Password), Params, Callback = MoveTemp(Callback)]() mutable
+	{
+		// LLM 标签按线程生效，工作线程上的 scrypt 缓冲区需要单独标记
+		LLM_SCOPE_BYTAG(DreamAccount);
+
+		const double StartTime = FPlatformTime::Seconds();
+		TArray<uint8> Key;
+		const bool bSucceeded = Scrypt(PasswordBytes, Params, Key);
+		FString DerivedKey = bSucceeded ? DreamAccountKdf::ToLowerHex(Key) : FString();
+		FMemory::Memzero(PasswordBytes.GetData(), PasswordBytes.Num());
+		FMemory::Memzero(Key.GetData(), Key.Num());
+
+		UE_LOG(LogDreamAccount, Verbose, TEXT("DreamAccount KDF: N=%d r=%d p=%d took %.1fms"),
+			Params.CostN, Params.BlockSize, Params.Parallelism, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+		AsyncTask(ENamedThreads::GameThread, [Callback = MoveTemp(Callback), bSucceeded, DerivedKey = MoveTemp(DerivedKey)]()
+		{
+			Callback(bSucceeded, DerivedKey);
+		});
+	});
+}
+
+FString FDreamAccountKeyDerivation::DeriveToHex(const FString& Password, const FDreamAccountKdfParams& Params)
+{
+	TArray<uint8> Key;
+	if (!Scrypt(DreamAccountKdf::ToUtf8Bytes(Password), Params, Key))
+	{
+		return FString();
+	}
+	return DreamAccountKdf::ToLowerHex(Key);
+}
+
+TArray<uint8> FDreamAccountKeyDerivation::Sha256(const TArray<uint8>& Data)
+{
+	TArray<uint8> Digest;
+	Digest.SetNumUninitialized(32);
+	DreamAccountKdf::FSha256 Hash;
+	Hash.Update(Data.GetData(), Data.Num());
+	Hash.Final(Digest.GetData());
+	return Digest;
+}
+
+TArray<uint8> FDreamAccountKeyDerivation::HmacSha256(const TArray<uint8>& Key, const TArray<uint8>& Data)
+{
+	TArray<uint8> Digest;
+	Digest.SetNumUninitialized(32);
+	const DreamAccountKdf::FHmacSha256 Hmac(Key.GetData(), Key.Num());
+	Hmac.Compute(Data.GetData(), Data.Num(), nullptr, 0, Digest.GetData());
+	return Digest;
+}
+
+bool FDreamAccountKeyDerivation::SelfTest()
+{
+	// RFC 7914 第 12 节的第二组测试向量
+	FDreamAccountKdfParams Params;
+	Params.Salt = DreamAccountKdf::ToUtf8Bytes(TEXT("NaCl"));
+	Params.CostN = 1024;
+	Params.BlockSize = 8;
+	Params.Parallelism = 16;
+	Params.KeyLength = 64;
+
+	return DeriveToHex(TEXT("password"), Params) == TEXT(
+		"fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b373162"
+		"2eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640");
+}
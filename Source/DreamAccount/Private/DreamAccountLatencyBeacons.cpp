@@ -0,0 +1,350 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountLatencyBeacons.h"
+
+#include "DreamAccountModule.h"
+#include "DreamAccountRequestHedger.h"
+#include "DreamAccountSettings.h"
+#include "DreamAccountUtil.h"
+#include "Dom/JsonObject.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Base64.h"
+#include "Misc/Compression.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace DreamAccountBeacons
+{
+	/** 大致按倍数增长的分桶，覆盖局域网到高延迟移动网络 */
+	static const int32 BucketBoundsMs[] = {10, 25, 50, 100, 200, 400, 800, 1600, 3200, 6400};
+	static constexpr int32 BucketCount = UE_ARRAY_COUNT(BucketBoundsMs) + 1;
+
+	TArray<TSharedPtr<FJsonValue>> MakeCountArray(const int32 (&Counts)[BucketCount])
+	{
+		TArray<TSharedPtr<FJsonValue>> Values;
+		Values.Reserve(BucketCount);
+		for (int32 Value : Counts)
+		{
+			Values.Add(MakeShared<FJsonValueNumber>(Value));
+		}
+		return Values;
+	}
+
+	static FAutoConsoleCommand CmdStats(
+		TEXT("DreamAccount.Beacons.Stats"),
+		TEXT("输出延迟信标的记录数、缓冲区占用与上传统计"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const FDreamAccountLatencyBeaconStats Stats = FDreamAccountLatencyBeacons::Get().GetStats();
+			UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount beacons: Enabled=%d Recorded=%d Overwritten=%d Buffered=%d Uploads=%d Failures=%d LastBatch=%dB->%dB"),
+				FDreamAccountLatencyBeacons::Get().IsEnabled(), Stats.RecordedCount, Stats.OverwrittenCount, Stats.BufferedCount,
+				Stats.UploadCount, Stats.UploadFailureCount, Stats.LastBatchRawBytes, Stats.LastBatchCompressedBytes);
+		}));
+
+	static FAutoConsoleCommand CmdUpload(
+		TEXT("DreamAccount.Beacons.Upload"),
+		TEXT("立即上传缓冲区中的延迟信标"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FDreamAccountLatencyBeacons::Get().UploadNow();
+		}));
+}
+
+FDreamAccountLatencyBeacons& FDreamAccountLatencyBeacons::Get()
+{
+	static FDreamAccountLatencyBeacons Instance;
+	return Instance;
+}
+
+FDreamAccountLatencyBeacons::FDreamAccountLatencyBeacons()
+{
+}
+
+void FDreamAccountLatencyBeacons::Start()
+{
+	Stop();
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	if (!Settings)
+	{
+		return;
+	}
+
+	UploadURL = Settings->LatencyBeaconURL.IsEmpty() ? API_LATENCY_BEACONS : Settings->LatencyBeaconURL;
+	Region = Settings->LatencyBeaconRegion;
+	SampleRate = FMath::Clamp(Settings->LatencyBeaconSampleRate, 0.0f, 1.0f);
+
+	Samples.SetNum(FMath::Max(Settings->LatencyBeaconBufferSize, 16));
+	ResetBatch();
+
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FDreamAccountLatencyBeacons::Tick),
+		FMath::Max(Settings->LatencyBeaconUploadInterval, 5.0f));
+}
+
+void FDreamAccountLatencyBeacons::Stop()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	++UploadSerial;
+	bUploadInProgress = false;
+	ResetBatch();
+	Samples.Empty();
+}
+
+bool FDreamAccountLatencyBeacons::ShouldRecord(const FDreamAccountHttpRequest& Request) const
+{
+	if (!IsEnabled() || Request.URL == UploadURL)
+	{
+		return false;
+	}
+	return SampleRate >= 1.0f || FMath::FRand() < SampleRate;
+}
+
+void FDreamAccountLatencyBeacons::Record(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpResponse& Response)
+{
+	// 被取消的请求（包括对冲中落败的一方）没有完整的耗时
+	if (!IsEnabled() || (Request.Cancellation.IsValid() && Request.Cancellation->IsCancelled()))
+	{
+		return;
+	}
+
+	const FString EndpointKey = FDreamAccountRequestHedger::GetEndpointKey(Request);
+	int32 EndpointIndex;
+	if (const int32* ExistingIndex = EndpointIndices.Find(EndpointKey))
+	{
+		EndpointIndex = *ExistingIndex;
+	}
+	else
+	{
+		EndpointIndex = EndpointKeys.Add(EndpointKey);
+		EndpointIndices.Add(EndpointKey, EndpointIndex);
+	}
+
+	if (Count == Samples.Num())
+	{
+		++OverwrittenCount;
+		++BatchOverwrittenCount;
+	}
+	else
+	{
+		++Count;
+	}
+
+	FSample& Sample = Samples[Head];
+	Sample.EndpointIndex = EndpointIndex;
+	Sample.ResponseCode = Response.ResponseCode;
+	Sample.FirstByteMs = Response.FirstByteSeconds > 0.0 ? static_cast<float>(Response.FirstByteSeconds * 1000.0) : -1.0f;
+	Sample.TotalMs = static_cast<float>(Response.ElapsedSeconds * 1000.0);
+	Sample.bSucceeded = Response.bSucceeded;
+
+	Head = (Head + 1) % Samples.Num();
+	++RecordedCount;
+}
+
+void FDreamAccountLatencyBeacons::UploadNow()
+{
+	if (!IsEnabled() || bUploadInProgress || Count == 0)
+	{
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(DreamAccount);
+
+	const FString Batch = BuildBatch();
+	ResetBatch();
+
+	const FTCHARToUTF8 RawBatch(*Batch);
+	TArray<uint8> Compressed;
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, RawBatch.Length());
+	Compressed.SetNumUninitialized(CompressedSize);
+	if (!FCompression::CompressMemory(NAME_Zlib, Compressed.GetData(), CompressedSize, RawBatch.Get(), RawBatch.Length()))
+	{
+		UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount beacons: failed to compress a batch of %d bytes"), RawBatch.Length());
+		++UploadFailureCount;
+		return;
+	}
+	Compressed.SetNum(CompressedSize, EAllowShrinking::No);
+
+	LastBatchRawBytes = RawBatch.Length();
+	LastBatchCompressedBytes = CompressedSize;
+
+	// 请求体保持为文本，才能经过网络模拟与录制等中间层
+	TSharedRef<FJsonObject> Body = MakeShared<FJsonObject>();
+	Body->SetStringField(TEXT("encoding"), TEXT("zlib"));
+	Body->SetNumberField(TEXT("size"), RawBatch.Length());
+	Body->SetStringField(TEXT("data"), FBase64::Encode(Compressed));
+
+	FDreamAccountHttpRequest Request;
+	Request.URL = UploadURL;
+	Request.Verb = TEXT("POST");
+	Request.Headers.Add(TEXT("Content-Type"), TEXT("application/json;charset=UTF-8"));
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Request.Content);
+	FJsonSerializer::Serialize(Body, Writer);
+
+	bUploadInProgress = true;
+	FDreamAccountUtil::SendHttpRequest(Request, [this, Serial = UploadSerial](const FDreamAccountHttpResponse& Response)
+	{
+		if (Serial == UploadSerial)
+		{
+			HandleUploadResponse(Response);
+		}
+	});
+}
+
+FDreamAccountLatencyBeaconStats FDreamAccountLatencyBeacons::GetStats() const
+{
+	FDreamAccountLatencyBeaconStats Stats;
+	Stats.RecordedCount = RecordedCount;
+	Stats.OverwrittenCount = OverwrittenCount;
+	Stats.BufferedCount = Count;
+	Stats.UploadCount = UploadCount;
+	Stats.UploadFailureCount = UploadFailureCount;
+	Stats.LastBatchRawBytes = LastBatchRawBytes;
+	Stats.LastBatchCompressedBytes = LastBatchCompressedBytes;
+	return Stats;
+}
+
+void FDreamAccountLatencyBeacons::ResetStats()
+{
+	RecordedCount = 0;
+	OverwrittenCount = 0;
+	UploadCount = 0;
+	UploadFailureCount = 0;
+	LastBatchRawBytes = 0;
+	LastBatchCompressedBytes = 0;
+}
+
+TConstArrayView<int32> FDreamAccountLatencyBeacons::GetBucketBoundsMs()
+{
+	return MakeArrayView(DreamAccountBeacons::BucketBoundsMs);
+}
+
+bool FDreamAccountLatencyBeacons::Tick(float DeltaTime)
+{
+	UploadNow();
+	return true;
+}
+
+FString FDreamAccountLatencyBeacons::BuildBatch() const
+{
+	using namespace DreamAccountBeacons;
+
+	struct FEndpointHistogram
+	{
+		int32 RequestCount = 0;
+		int32 FailureCount = 0;
+		int32 ServerErrorCount = 0;
+		int32 FirstByte[BucketCount] = {};
+		int32 Total[BucketCount] = {};
+		double TotalSumMs = 0.0;
+	};
+
+	TArray<FEndpointHistogram> Histograms;
+	Histograms.SetNum(EndpointKeys.Num());
+
+	// 缓冲区未写满时有效记录位于 [0, Count)，写满后整个数组都有效，顺序不影响聚合
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FSample& Sample = Samples[Index];
+		FEndpointHistogram& Histogram = Histograms[Sample.EndpointIndex];
+		++Histogram.RequestCount;
+
+		if (!Sample.bSucceeded)
+		{
+			++Histogram.FailureCount;
+			continue;
+		}
+
+		if (Sample.ResponseCode >= 500)
+		{
+			++Histogram.ServerErrorCount;
+		}
+		if (Sample.FirstByteMs >= 0.0f)
+		{
+			++Histogram.FirstByte[FindBucket(Sample.FirstByteMs)];
+		}
+		++Histogram.Total[FindBucket(Sample.TotalMs)];
+		Histogram.TotalSumMs += Sample.TotalMs;
+	}
+
+	TArray<TSharedPtr<FJsonValue>> Bounds;
+	for (int32 Bound : BucketBoundsMs)
+	{
+		Bounds.Add(MakeShared<FJsonValueNumber>(Bound));
+	}
+
+	TArray<TSharedPtr<FJsonValue>> Endpoints;
+	for (int32 Index = 0; Index < Histograms.Num(); ++Index)
+	{
+		const FEndpointHistogram& Histogram = Histograms[Index];
+		if (Histogram.RequestCount == 0)
+		{
+			continue;
+		}
+
+		TSharedRef<FJsonObject> Endpoint = MakeShared<FJsonObject>();
+		Endpoint->SetStringField(TEXT("endpoint"), EndpointKeys[Index]);
+		Endpoint->SetNumberField(TEXT("count"), Histogram.RequestCount);
+		Endpoint->SetNumberField(TEXT("failures"), Histogram.FailureCount);
+		Endpoint->SetNumberField(TEXT("server_errors"), Histogram.ServerErrorCount);
+		Endpoint->SetArrayField(TEXT("first_byte"), MakeCountArray(Histogram.FirstByte));
+		Endpoint->SetArrayField(TEXT("total"), MakeCountArray(Histogram.Total));
+		Endpoint->SetNumberField(TEXT("total_sum_ms"), FMath::RoundToDouble(Histogram.TotalSumMs * 10.0) / 10.0);
+		Endpoints.Add(MakeShared<FJsonValueObject>(Endpoint));
+	}
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetStringField(TEXT("region"), Region);
+	Json->SetStringField(TEXT("platform"), FPlatformProperties::IniPlatformName());
+	Json->SetNumberField(TEXT("window_seconds"), FMath::RoundToDouble(FPlatformTime::Seconds() - BatchStartTime));
+	Json->SetNumberField(TEXT("overwritten"), BatchOverwrittenCount);
+	Json->SetArrayField(TEXT("bounds_ms"), Bounds);
+	Json->SetArrayField(TEXT("endpoints"), Endpoints);
+
+	FString Content;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Content);
+	FJsonSerializer::Serialize(Json, Writer);
+	return Content;
+}
+
+void FDreamAccountLatencyBeacons::ResetBatch()
+{
+	Head = 0;
+	Count = 0;
+	BatchOverwrittenCount = 0;
+	EndpointKeys.Reset();
+	EndpointIndices.Reset();
+	BatchStartTime = FPlatformTime::Seconds();
+}
+
+void FDreamAccountLatencyBeacons::HandleUploadResponse(const FDreamAccountHttpResponse& Response)
+{
+	bUploadInProgress = false;
+
+	if (Response.bSucceeded && Response.ResponseCode >= 200 && Response.ResponseCode < 300)
+	{
+		++UploadCount;
+		return;
+	}
+
+	++UploadFailureCount;
+	UE_LOG(LogDreamAccount, Verbose, TEXT("DreamAccount beacons: upload failed (%d), batch dropped"), Response.ResponseCode);
+}
+
+int32 FDreamAccountLatencyBeacons::FindBucket(float Milliseconds)
+{
+	using namespace DreamAccountBeacons;
+
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(BucketBoundsMs); ++Index)
+	{
+		if (Milliseconds <= BucketBoundsMs[Index])
+		{
+			return Index;
+		}
+	}
+	return BucketCount - 1;
+}
@@ -3,12 +3,18 @@
 #include "DreamAccountModule.h"
 
 #include "DreamAccountSettings.h"
+#include "DreamAccountTrafficRecorder.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
 #if WITH_EDITOR
 #include "ISettingsModule.h"
 #endif
 
 #define LOCTEXT_NAMESPACE "FDreamAccountModule"
 
+DEFINE_LOG_CATEGORY(LogDreamAccount);
+LLM_DEFINE_TAG(DreamAccount);
+
 void FDreamAccountModule::StartupModule()
 {
 #if WITH_EDITOR
@@ -24,10 +30,30 @@ void FDreamAccountModule::StartupModule()
 		);
 	}
 #endif
+
+	// 命令行参数用于在 CI 中无网络回放录制，或在一次会话中录制真实请求
+	FString TraceFile;
+	if (FParse::Value(FCommandLine::Get(), TEXT("DreamAccountReplay="), TraceFile))
+	{
+		float ReplaySpeed = 1.0f;
+		FParse::Value(FCommandLine::Get(), TEXT("DreamAccountReplaySpeed="), ReplaySpeed);
+		FDreamAccountTrafficRecorder::Get().StartReplay(TraceFile, ReplaySpeed);
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("DreamAccountRecord="), TraceFile))
+	{
+		FDreamAccountTrafficRecorder::Get().StartRecording(TraceFile);
+	}
 }
 
 void FDreamAccountModule::ShutdownModule()
 {
+	FDreamAccountTrafficRecorder& Recorder = FDreamAccountTrafficRecorder::Get();
+	if (Recorder.IsRecording())
+	{
+		Recorder.StopRecording();
+	}
+	Recorder.StopReplay();
+
 #if WITH_EDITOR
 	if (ISettingsModule* SettingsModule = FModuleManager::GetModulePtr<ISettingsModule>("Settings"))
 	{
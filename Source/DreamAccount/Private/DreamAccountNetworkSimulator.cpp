@@ -0,0 +1,377 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountNetworkSimulator.h"
+
+#include "Containers/Ticker.h"
+#include "DreamAccountModule.h"
+#include "DreamAccountUtil.h"
+#include "HAL/IConsoleManager.h"
+
+namespace DreamAccountNetSim
+{
+	static TAutoConsoleVariable<int32> CVarEnable(
+		TEXT("DreamAccount.NetSim.Enable"), -1,
+		TEXT("启用网络模拟。-1 使用项目设置，0 关闭，1 开启"));
+
+	static TAutoConsoleVariable<int32> CVarServeInProcess(
+		TEXT("DreamAccount.NetSim.ServeInProcess"), -1,
+		TEXT("由进程内替身服务器生成响应。-1 使用项目设置，0 关闭，1 开启"));
+
+	static TAutoConsoleVariable<int32> CVarDistribution(
+		TEXT("DreamAccount.NetSim.Distribution"), -1,
+		TEXT("延迟分布。-1 使用项目设置，0 Constant，1 Uniform，2 Normal，3 LogNormal"));
+
+	static TAutoConsoleVariable<float> CVarLatencyMs(
+		TEXT("DreamAccount.NetSim.LatencyMs"), -1.0f,
+		TEXT("往返延迟（毫秒），负数使用项目设置"));
+
+	static TAutoConsoleVariable<float> CVarJitterMs(
+		TEXT("DreamAccount.NetSim.JitterMs"), -1.0f,
+		TEXT("延迟抖动（毫秒），负数使用项目设置"));
+
+	static TAutoConsoleVariable<float> CVarBandwidthKBps(
+		TEXT("DreamAccount.NetSim.BandwidthKBps"), -1.0f,
+		TEXT("带宽上限（KB/s），0 不限制，负数使用项目设置"));
+
+	static TAutoConsoleVariable<float> CVarPacketLoss(
+		TEXT("DreamAccount.NetSim.PacketLoss"), -1.0f,
+		TEXT("每个数据包的丢失概率，负数使用项目设置"));
+
+	static TAutoConsoleVariable<float> CVarTimeoutRate(
+		TEXT("DreamAccount.NetSim.TimeoutRate"), -1.0f,
+		TEXT("请求超时的概率，负数使用项目设置"));
+
+	static TAutoConsoleVariable<float> CVarTooManyRequestsRate(
+		TEXT("DreamAccount.NetSim.TooManyRequestsRate"), -1.0f,
+		TEXT("返回 TOO_MANY_REQUESTS 的概率，负数使用项目设置"));
+
+	static TAutoConsoleVariable<float> CVarInternalErrorRate(
+		TEXT("DreamAccount.NetSim.InternalErrorRate"), -1.0f,
+		TEXT("返回 INTERNAL_ERROR 的概率，负数使用项目设置"));
+
+	static FAutoConsoleCommand CmdSeedUsers(
+		TEXT("DreamAccount.NetSim.SeedUsers"),
+		TEXT("在进程内替身服务器中预置账号：DreamAccount.NetSim.SeedUsers <Count>"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+			FDreamAccountNetworkSimulator::Get().GetInProcessServer().SeedUsers(Count);
+		}));
+
+	static FAutoConsoleCommand CmdBan(
+		TEXT("DreamAccount.NetSim.Ban"),
+		TEXT("在进程内替身服务器中封禁或解封用户：DreamAccount.NetSim.Ban <UserID> [0|1]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			if (Args.Num() > 0)
+			{
+				const bool bBanned = Args.Num() < 2 || FCString::Atoi(*Args[1]) != 0;
+				FDreamAccountNetworkSimulator::Get().GetInProcessServer().SetUserBanned(FCString::Atoi(*Args[0]), bBanned);
+			}
+		}));
+
+	static FAutoConsoleCommand CmdLoginRate(
+		TEXT("DreamAccount.NetSim.LoginRate"),
+		TEXT("限制进程内替身服务器每秒放行的登录数，超出的登录进入排队：DreamAccount.NetSim.LoginRate <PerSecond>，0 表示不限制"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const float LoginsPerSecond = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 0.0f;
+			FDreamAccountNetworkSimulator::Get().GetInProcessServer().SetLoginRate(LoginsPerSecond);
+		}));
+
+	static FAutoConsoleCommand CmdReset(
+		TEXT("DreamAccount.NetSim.Reset"),
+		TEXT("清空进程内替身服务器中的账号数据"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FDreamAccountNetworkSimulator::Get().GetInProcessServer().Reset();
+		}));
+
+	static FAutoConsoleCommand CmdStats(
+		TEXT("DreamAccount.NetSim.Stats"),
+		TEXT("输出网络模拟统计"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const FDreamAccountNetworkSimulator& Simulator = FDreamAccountNetworkSimulator::Get();
+			UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount NetSim: Requests=%llu Timeouts=%llu TooManyRequests=%llu InternalErrors=%llu LostPackets=%llu"),
+				Simulator.GetSimulatedRequestCount(),
+				Simulator.GetInjectedTimeoutCount(),
+				Simulator.GetInjectedTooManyRequestsCount(),
+				Simulator.GetInjectedInternalErrorCount(),
+				Simulator.GetLostPacketCount());
+		}));
+
+	/** 单个数据包的负载大小，用于估算丢包次数 */
+	static constexpr int64 SegmentBytes = 1460;
+
+	/** 重传超时的下限（秒） */
+	static constexpr double MinRetransmitSeconds = 0.2;
+
+	/** 同一数据包的最大重传次数 */
+	static constexpr int32 MaxRetransmits = 6;
+
+	void OverrideFloat(float& Value, const TAutoConsoleVariable<float>& CVar)
+	{
+		const float CVarValue = CVar.GetValueOnGameThread();
+		if (CVarValue >= 0.0f)
+		{
+			Value = CVarValue;
+		}
+	}
+}
+
+FDreamAccountNetworkSimulator& FDreamAccountNetworkSimulator::Get()
+{
+	static FDreamAccountNetworkSimulator Instance;
+	return Instance;
+}
+
+FDreamAccountNetworkSimulator::FDreamAccountNetworkSimulator()
+{
+}
+
+bool FDreamAccountNetworkSimulator::IsEnabled() const
+{
+	const int32 CVarValue = DreamAccountNetSim::CVarEnable.GetValueOnGameThread();
+	if (CVarValue >= 0)
+	{
+		return CVarValue > 0;
+	}
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	return Settings && Settings->NetworkSimulation.bEnabled;
+}
+
+FDreamAccountNetworkSimulationSettings FDreamAccountNetworkSimulator::GetEffectiveSettings() const
+{
+	using namespace DreamAccountNetSim;
+
+	FDreamAccountNetworkSimulationSettings Result;
+	if (const UDreamAccountSettings* Settings = UDreamAccountSettings::Get())
+	{
+		Result = Settings->NetworkSimulation;
+	}
+
+	Result.bEnabled = IsEnabled();
+
+	if (CVarServeInProcess.GetValueOnGameThread() >= 0)
+	{
+		Result.bServeInProcess = CVarServeInProcess.GetValueOnGameThread() > 0;
+	}
+
+	const int32 Distribution = CVarDistribution.GetValueOnGameThread();
+	if (Distribution >= 0 && Distribution <= static_cast<int32>(EDreamAccountLatencyDistribution::LogNormal))
+	{
+		Result.LatencyDistribution = static_cast<EDreamAccountLatencyDistribution>(Distribution);
+	}
+
+	OverrideFloat(Result.LatencyMs, CVarLatencyMs);
+	OverrideFloat(Result.LatencyJitterMs, CVarJitterMs);
+	OverrideFloat(Result.BandwidthKBps, CVarBandwidthKBps);
+	OverrideFloat(Result.PacketLossRate, CVarPacketLoss);
+	OverrideFloat(Result.TimeoutRate, CVarTimeoutRate);
+	OverrideFloat(Result.TooManyRequestsRate, CVarTooManyRequestsRate);
+	OverrideFloat(Result.InternalErrorRate, CVarInternalErrorRate);
+
+	return Result;
+}
+
+void FDreamAccountNetworkSimulator::SendHttpRequest(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& OnComplete)
+{
+	const FDreamAccountNetworkSimulationSettings Settings = GetEffectiveSettings();
+	EnsureSeeded(Settings);
+	++SimulatedRequestCount;
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double TimeoutSeconds = Request.GetEffectiveTimeout();
+
+	if (RandomStream.FRand() < Settings.TimeoutRate)
+	{
+		++InjectedTimeoutCount;
+		CompleteAfter(StartTime, TimeoutSeconds, TimeoutSeconds, TimeoutSeconds, FDreamAccountHttpResponse::MakeFailure(), OnComplete);
+		return;
+	}
+
+	const double RoundTripSeconds = SampleRoundTripSeconds(Settings);
+	const double UpstreamSeconds = RoundTripSeconds * 0.5 + ComputeTransferSeconds(EstimateRequestBytes(Request), RoundTripSeconds, Settings);
+
+	const float ErrorRoll = RandomStream.FRand();
+	if (ErrorRoll < Settings.TooManyRequestsRate + Settings.InternalErrorRate)
+	{
+		FDreamAccountHttpResponse Response;
+		if (ErrorRoll < Settings.TooManyRequestsRate)
+		{
+			++InjectedTooManyRequestsCount;
+			Response = FDreamAccountHttpResponse::MakeError(429, TEXT("TOO_MANY_REQUESTS"));
+		}
+		else
+		{
+			++InjectedInternalErrorCount;
+			Response = FDreamAccountHttpResponse::MakeError(500, TEXT("INTERNAL_ERROR"));
+		}
+
+		const double FirstByteDelaySeconds = UpstreamSeconds + RoundTripSeconds * 0.5;
+		const double DelaySeconds = FirstByteDelaySeconds + ComputeTransferSeconds(EstimateResponseBytes(Response), RoundTripSeconds, Settings);
+		CompleteAfter(StartTime, DelaySeconds, FirstByteDelaySeconds, TimeoutSeconds, MoveTemp(Response), OnComplete);
+		return;
+	}
+
+	if (Settings.bServeInProcess)
+	{
+		FDreamAccountHttpResponse Response = InProcessServer.HandleRequest(Request);
+		const double FirstByteDelaySeconds = UpstreamSeconds + RoundTripSeconds * 0.5;
+		const double DelaySeconds = FirstByteDelaySeconds + ComputeTransferSeconds(EstimateResponseBytes(Response), RoundTripSeconds, Settings);
+		CompleteAfter(StartTime, DelaySeconds, FirstByteDelaySeconds, TimeoutSeconds, MoveTemp(Response), OnComplete);
+		return;
+	}
+
+	// 真实请求：上行延迟后发出，收到响应后再叠加下行延迟
+	ExecuteAfter(UpstreamSeconds, [Request, OnComplete, Settings, StartTime, TimeoutSeconds, RoundTripSeconds]()
+	{
+		FDreamAccountUtil::SendPlatformHttpRequest(Request, [OnComplete, Settings, StartTime, TimeoutSeconds, RoundTripSeconds](const FDreamAccountHttpResponse& Response)
+		{
+			FDreamAccountNetworkSimulator& Simulator = FDreamAccountNetworkSimulator::Get();
+			const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+			const double DownstreamSeconds = Response.bSucceeded
+				? RoundTripSeconds * 0.5 + Simulator.ComputeTransferSeconds(EstimateResponseBytes(Response), RoundTripSeconds, Settings)
+				: 0.0;
+
+			// 真实的首字节时间加上模拟的上行与下行延迟
+			const double RealTransferSeconds = Response.FirstByteSeconds > 0.0 ? Response.ElapsedSeconds - Response.FirstByteSeconds : 0.0;
+			const double FirstByteDelaySeconds = ElapsedSeconds - RealTransferSeconds + RoundTripSeconds * 0.5;
+			CompleteAfter(StartTime, ElapsedSeconds + DownstreamSeconds, FirstByteDelaySeconds, TimeoutSeconds, Response, OnComplete);
+		});
+	});
+}
+
+void FDreamAccountNetworkSimulator::ExecuteAfter(double DelaySeconds, TFunction<void()> Callback)
+{
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Callback = MoveTemp(Callback)](float)
+	{
+		Callback();
+		return false;
+	}), static_cast<float>(FMath::Max(DelaySeconds, 0.0)));
+}
+
+double FDreamAccountNetworkSimulator::SampleRoundTripSeconds(const FDreamAccountNetworkSimulationSettings& Settings)
+{
+	const double Latency = Settings.LatencyMs;
+	const double Jitter = Settings.LatencyJitterMs;
+
+	double SampleMs = Latency;
+	switch (Settings.LatencyDistribution)
+	{
+	case EDreamAccountLatencyDistribution::Uniform:
+		SampleMs = Latency + Jitter * (2.0 * RandomStream.FRand() - 1.0);
+		break;
+
+	case EDreamAccountLatencyDistribution::Normal:
+	case EDreamAccountLatencyDistribution::LogNormal:
+		{
+			// Box-Muller
+			const double U1 = FMath::Max(static_cast<double>(RandomStream.FRand()), UE_SMALL_NUMBER);
+			const double U2 = RandomStream.FRand();
+			const double Z = FMath::Sqrt(-2.0 * FMath::Loge(U1)) * FMath::Cos(2.0 * UE_DOUBLE_PI * U2);
+
+			if (Settings.LatencyDistribution == EDreamAccountLatencyDistribution::Normal)
+			{
+				SampleMs = Latency + Jitter * Z;
+			}
+			else if (Latency > 0.0)
+			{
+				const double Sigma = Jitter / Latency;
+				SampleMs = Latency * FMath::Exp(Sigma * Z);
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	return FMath::Max(SampleMs, 0.0) / 1000.0;
+}
+
+double FDreamAccountNetworkSimulator::ComputeTransferSeconds(int64 Bytes, double RoundTripSeconds, const FDreamAccountNetworkSimulationSettings& Settings)
+{
+	double Seconds = 0.0;
+	if (Settings.BandwidthKBps > 0.0f)
+	{
+		Seconds += static_cast<double>(Bytes) / (Settings.BandwidthKBps * 1024.0);
+	}
+
+	if (Settings.PacketLossRate > 0.0f)
+	{
+		const double RetransmitSeconds = FMath::Max(DreamAccountNetSim::MinRetransmitSeconds, RoundTripSeconds * 2.0);
+		const int64 SegmentCount = 1 + (Bytes + DreamAccountNetSim::SegmentBytes - 1) / DreamAccountNetSim::SegmentBytes;
+		for (int64 Segment = 0; Segment < SegmentCount; ++Segment)
+		{
+			// 每次重传的等待时间指数增长
+			for (int32 Attempt = 0; Attempt < DreamAccountNetSim::MaxRetransmits && RandomStream.FRand() < Settings.PacketLossRate; ++Attempt)
+			{
+				Seconds += RetransmitSeconds * static_cast<double>(1 << Attempt);
+				++LostPacketCount;
+			}
+		}
+	}
+
+	return Seconds;
+}
+
+int64 FDreamAccountNetworkSimulator::EstimateRequestBytes(const FDreamAccountHttpRequest& Request)
+{
+	int64 Bytes = Request.URL.Len() + Request.Verb.Len() + Request.Content.Len();
+	for (const TPair<FString, FString>& Pair : Request.Headers)
+	{
+		Bytes += Pair.Key.Len() + Pair.Value.Len() + 4;
+	}
+	return Bytes;
+}
+
+int64 FDreamAccountNetworkSimulator::EstimateResponseBytes(const FDreamAccountHttpResponse& Response)
+{
+	int64 Bytes = Response.Content.Len();
+	for (const TPair<FString, FString>& Pair : Response.Headers)
+	{
+		Bytes += Pair.Key.Len() + Pair.Value.Len() + 4;
+	}
+	return Bytes;
+}
+
+void FDreamAccountNetworkSimulator::CompleteAfter(double StartTime, double DelaySeconds, double FirstByteDelaySeconds, double TimeoutSeconds, FDreamAccountHttpResponse Response, const FDreamAccountHttpCallback& OnComplete)
+{
+	if (DelaySeconds > TimeoutSeconds)
+	{
+		Response = FDreamAccountHttpResponse::MakeFailure();
+		DelaySeconds = TimeoutSeconds;
+	}
+
+	Response.bSimulated = true;
+
+	const double RemainingSeconds = DelaySeconds - (FPlatformTime::Seconds() - StartTime);
+	ExecuteAfter(RemainingSeconds, [Response = MoveTemp(Response), OnComplete, StartTime, FirstByteDelaySeconds]() mutable
+	{
+		Response.ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+		Response.FirstByteSeconds = Response.bSucceeded ? FMath::Clamp(FirstByteDelaySeconds, 0.0, Response.ElapsedSeconds) : 0.0;
+		OnComplete(Response);
+	});
+}
+
+void FDreamAccountNetworkSimulator::EnsureSeeded(const FDreamAccountNetworkSimulationSettings& Settings)
+{
+	if (bSeeded && SeededWith == Settings.RandomSeed)
+	{
+		return;
+	}
+
+	bSeeded = true;
+	SeededWith = Settings.RandomSeed;
+	if (Settings.RandomSeed != 0)
+	{
+		RandomStream.Initialize(Settings.RandomSeed);
+	}
+	else
+	{
+		RandomStream.GenerateNewSeed();
+	}
+}
@@ -0,0 +1,232 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountPushChannel.h"
+
+#include "DreamAccountModule.h"
+#include "DreamAccountSettings.h"
+#include "Dom/JsonObject.h"
+#include "IWebSocket.h"
+#include "Serialization/JsonSerializer.h"
+#include "WebSocketsModule.h"
+
+FDreamAccountPushChannel::FDreamAccountPushChannel()
+{
+}
+
+FDreamAccountPushChannel::~FDreamAccountPushChannel()
+{
+	OnEvent = nullptr;
+	OnConnectionChanged = nullptr;
+	Disconnect();
+}
+
+void FDreamAccountPushChannel::Connect(const FString& URL, const FString& Token)
+{
+	Disconnect();
+
+	ChannelURL = URL;
+	ChannelToken = Token;
+	bActive = true;
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	ReconnectDelay = Settings ? Settings->PushReconnectMinDelay : 1.0;
+
+	OpenSocket();
+}
+
+void FDreamAccountPushChannel::Disconnect()
+{
+	bActive = false;
+
+	if (ReconnectHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(ReconnectHandle);
+		ReconnectHandle.Reset();
+	}
+
+	CloseSocket();
+	SetConnected(false);
+}
+
+EDreamAccountPushEventType FDreamAccountPushChannel::GetEventTypeFromString(const FString& TypeString)
+{
+	static TMap<FString, EDreamAccountPushEventType> EventTypeMap = {
+		{TEXT("token_revoked"), EDreamAccountPushEventType::TokenRevoked},
+		{TEXT("user_banned"), EDreamAccountPushEventType::UserBanned},
+		{TEXT("force_logout"), EDreamAccountPushEventType::ForcedLogout},
+	};
+
+	if (const EDreamAccountPushEventType* Found = EventTypeMap.Find(TypeString))
+	{
+		return *Found;
+	}
+
+	return EDreamAccountPushEventType::Unknown;
+}
+
+void FDreamAccountPushChannel::OpenSocket()
+{
+	TMap<FString, FString> Headers;
+	Headers.Add(TEXT("Authorization"), FString::Printf(TEXT("Bearer %s"), *ChannelToken));
+
+	Socket = FWebSocketsModule::Get().CreateWebSocket(ChannelURL, FString(), Headers);
+
+	const uint32 Serial = ++SocketSerial;
+	Socket->OnConnected().AddLambda([this, Serial]()
+	{
+		if (Serial == SocketSerial)
+		{
+			HandleConnected();
+		}
+	});
+	Socket->OnConnectionError().AddLambda([this, Serial](const FString& Error)
+	{
+		if (Serial == SocketSerial)
+		{
+			UE_LOG(LogDreamAccount, Verbose, TEXT("DreamAccount push channel connection error: %s"), *Error);
+			HandleConnectionLost();
+		}
+	});
+	Socket->OnClosed().AddLambda([this, Serial](int32 StatusCode, const FString& Reason, bool bWasClean)
+	{
+		if (Serial == SocketSerial)
+		{
+			UE_LOG(LogDreamAccount, Verbose, TEXT("DreamAccount push channel closed: %d %s"), StatusCode, *Reason);
+			HandleConnectionLost();
+		}
+	});
+	Socket->OnMessage().AddLambda([this, Serial](const FString& Message)
+	{
+		if (Serial == SocketSerial)
+		{
+			HandleMessage(Message);
+		}
+	});
+
+	Socket->Connect();
+}
+
+void FDreamAccountPushChannel::CloseSocket()
+{
+	if (!Socket.IsValid())
+	{
+		return;
+	}
+
+	// 先让旧连接的回调失效，再关闭
+	++SocketSerial;
+	TSharedPtr<IWebSocket> OldSocket = MoveTemp(Socket);
+	OldSocket->OnConnected().Clear();
+	OldSocket->OnConnectionError().Clear();
+	OldSocket->OnClosed().Clear();
+	OldSocket->OnMessage().Clear();
+	if (OldSocket->IsConnected())
+	{
+		OldSocket->Close();
+	}
+
+	// 可能正处于该连接的回调中，延迟到下一帧再释放
+	FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([OldSocket](float)
+	{
+		return false;
+	}));
+}
+
+void FDreamAccountPushChannel::ScheduleReconnect()
+{
+	if (!bActive || ReconnectHandle.IsValid())
+	{
+		return;
+	}
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	const double MinDelay = Settings ? Settings->PushReconnectMinDelay : 1.0;
+	const double MaxDelay = Settings ? FMath::Max(Settings->PushReconnectMaxDelay, Settings->PushReconnectMinDelay) : 60.0;
+
+	// 抖动避免大量客户端在服务器重启后同时重连
+	const double Delay = FMath::Clamp(ReconnectDelay, MinDelay, MaxDelay) * FMath::FRandRange(0.5, 1.0);
+	ReconnectDelay = FMath::Min(ReconnectDelay * 2.0, MaxDelay);
+
+	ReconnectHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this](float)
+	{
+		ReconnectHandle.Reset();
+		if (bActive)
+		{
+			OpenSocket();
+		}
+		return false;
+	}), static_cast<float>(Delay));
+}
+
+void FDreamAccountPushChannel::HandleConnected()
+{
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	ReconnectDelay = Settings ? Settings->PushReconnectMinDelay : 1.0;
+
+	SetConnected(true);
+}
+
+void FDreamAccountPushChannel::HandleConnectionLost()
+{
+	CloseSocket();
+	SetConnected(false);
+	ScheduleReconnect();
+}
+
+void FDreamAccountPushChannel::HandleMessage(const FString& Message)
+{
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Message);
+	TSharedPtr<FJsonObject> Json;
+	if (!FJsonSerializer::Deserialize(Reader, Json) || !Json.IsValid())
+	{
+		UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount push channel received invalid message: %s"), *Message);
+		return;
+	}
+
+	const FString Type = Json->GetStringField(TEXT("type"));
+	if (Type == TEXT("ping"))
+	{
+		if (Socket.IsValid())
+		{
+			Socket->Send(TEXT("{\"type\":\"pong\"}"));
+		}
+		return;
+	}
+
+	FDreamAccountPushEvent Event;
+	Event.EventType = GetEventTypeFromString(Type);
+	Json->TryGetStringField(TEXT("reason"), Event.Reason);
+
+	switch (Event.EventType)
+	{
+	case EDreamAccountPushEventType::TokenRevoked:
+	case EDreamAccountPushEventType::ForcedLogout:
+		Event.ErrorType = EDreamAccountErrorType::NETWORK_INVALID_TOKEN;
+		break;
+	case EDreamAccountPushEventType::UserBanned:
+		Event.ErrorType = EDreamAccountErrorType::NETWORK_USER_BANNED;
+		break;
+	default:
+		Event.ErrorType = EDreamAccountErrorType::UNKNOWN;
+		break;
+	}
+
+	if (OnEvent)
+	{
+		OnEvent(Event);
+	}
+}
+
+void FDreamAccountPushChannel::SetConnected(bool bNewConnected)
+{
+	if (bConnected == bNewConnected)
+	{
+		return;
+	}
+
+	bConnected = bNewConnected;
+	if (OnConnectionChanged)
+	{
+		OnConnectionChanged(bConnected);
+	}
+}
@@ -0,0 +1,335 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountRequestHedger.h"
+
+#include "DreamAccountModule.h"
+#include "DreamAccountSettings.h"
+#include "DreamAccountTrafficRecorder.h"
+#include "DreamAccountUtil.h"
+#include "HAL/IConsoleManager.h"
+
+namespace DreamAccountHedging
+{
+	static FAutoConsoleCommand CmdStats(
+		TEXT("DreamAccount.Hedging.Stats"),
+		TEXT("输出各接口的对冲率、学习到的对冲等待时间与尾延迟"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			for (const FDreamAccountHedgeStats& Endpoint : FDreamAccountRequestHedger::Get().GetStats())
+			{
+				UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount hedging %s: Requests=%d Hedged=%d (%.1f%%) Wins=%d Denied=%d Delay=%.1fms p50=%.1fms p95=%.1fms p99=%.1fms Saved~%.0fms"),
+					*Endpoint.Endpoint, Endpoint.RequestCount, Endpoint.HedgeCount, Endpoint.HedgeRate * 100.0f,
+					Endpoint.HedgeWinCount, Endpoint.BudgetDeniedCount, Endpoint.HedgeDelayMs,
+					Endpoint.P50LatencyMs, Endpoint.P95LatencyMs, Endpoint.P99LatencyMs, Endpoint.EstimatedSavedMs);
+			}
+		}));
+
+	static FAutoConsoleCommand CmdReset(
+		TEXT("DreamAccount.Hedging.Reset"),
+		TEXT("清空对冲的延迟样本与统计"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FDreamAccountRequestHedger::Get().ResetStats();
+		}));
+}
+
+FDreamAccountRequestHedger& FDreamAccountRequestHedger::Get()
+{
+	static FDreamAccountRequestHedger Instance;
+	return Instance;
+}
+
+FDreamAccountRequestHedger::FDreamAccountRequestHedger()
+{
+}
+
+bool FDreamAccountRequestHedger::IsEnabled() const
+{
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	return Settings && Settings->bEnableRequestHedging && !FDreamAccountTrafficRecorder::Get().IsReplaying();
+}
+
+void FDreamAccountRequestHedger::SendHttpRequest(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& OnComplete)
+{
+	TSharedRef<FHedgedRequest> State = MakeShared<FHedgedRequest>();
+	State->Request = Request;
+	State->Request.bHedgeable = false;
+	State->Request.Cancellation.Reset();
+	State->OnComplete = OnComplete;
+	State->EndpointKey = GetEndpointKey(Request);
+	State->StartTime = FPlatformTime::Seconds();
+
+	FEndpointState& Endpoint = Endpoints.FindOrAdd(State->EndpointKey);
+	++Endpoint.RequestCount;
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	BudgetTokens = FMath::Min(BudgetTokens + (Settings ? Settings->HedgeBudgetRatio : 0.0f), MaxBudgetTokens);
+
+	// 外部取消时同时取消两个请求
+	if (Request.Cancellation.IsValid())
+	{
+		Request.Cancellation->SetAbortHandler([this, State]()
+		{
+			if (!State->bCompleted)
+			{
+				Finish(State, INDEX_NONE, FDreamAccountHttpResponse());
+			}
+		});
+	}
+
+	LaunchAttempt(State, 0);
+
+	const double Delay = GetHedgeDelay(State->EndpointKey);
+	if (Delay >= 0.0 && Delay < Request.GetEffectiveTimeout() && !State->bCompleted)
+	{
+		TWeakPtr<FHedgedRequest> WeakState = State;
+		State->HedgeTimerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this, WeakState](float)
+		{
+			if (TSharedPtr<FHedgedRequest> PinnedState = WeakState.Pin())
+			{
+				PinnedState->HedgeTimerHandle.Reset();
+				LaunchHedge(PinnedState.ToSharedRef());
+			}
+			return false;
+		}), static_cast<float>(Delay));
+	}
+}
+
+double FDreamAccountRequestHedger::GetHedgeDelay(const FString& EndpointKey) const
+{
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	const FEndpointState* Endpoint = Endpoints.Find(EndpointKey);
+	if (!Settings || !Endpoint || Endpoint->Samples.Num() < Settings->HedgeMinSamples)
+	{
+		return -1.0;
+	}
+
+	return FMath::Max(Endpoint->GetPercentile(Settings->HedgePercentile), static_cast<double>(Settings->HedgeMinDelay));
+}
+
+TArray<FDreamAccountHedgeStats> FDreamAccountRequestHedger::GetStats() const
+{
+	TArray<FDreamAccountHedgeStats> Result;
+	for (const TPair<FString, FEndpointState>& Pair : Endpoints)
+	{
+		const FEndpointState& Endpoint = Pair.Value;
+		FDreamAccountHedgeStats& Stats = Result.AddDefaulted_GetRef();
+		Stats.Endpoint = Pair.Key;
+		Stats.RequestCount = Endpoint.RequestCount;
+		Stats.HedgeCount = Endpoint.HedgeCount;
+		Stats.HedgeWinCount = Endpoint.HedgeWinCount;
+		Stats.BudgetDeniedCount = Endpoint.BudgetDeniedCount;
+		Stats.HedgeRate = Endpoint.RequestCount > 0 ? static_cast<float>(Endpoint.HedgeCount) / Endpoint.RequestCount : 0.0f;
+
+		const double Delay = GetHedgeDelay(Pair.Key);
+		Stats.HedgeDelayMs = Delay >= 0.0 ? static_cast<float>(Delay * 1000.0) : 0.0f;
+		Stats.P50LatencyMs = static_cast<float>(Endpoint.GetPercentile(0.50) * 1000.0);
+		Stats.P95LatencyMs = static_cast<float>(Endpoint.GetPercentile(0.95) * 1000.0);
+		Stats.P99LatencyMs = static_cast<float>(Endpoint.GetPercentile(0.99) * 1000.0);
+		Stats.EstimatedSavedMs = static_cast<float>(Endpoint.EstimatedSavedSeconds * 1000.0);
+	}
+	return Result;
+}
+
+void FDreamAccountRequestHedger::ResetStats()
+{
+	Endpoints.Empty();
+	BudgetTokens = MaxBudgetTokens;
+}
+
+FString FDreamAccountRequestHedger::GetEndpointKey(const FDreamAccountHttpRequest& Request)
+{
+	FString Key;
+	if (!Request.URL.Split(TEXT("?"), &Key, nullptr))
+	{
+		Key = Request.URL;
+	}
+	return Request.Verb + TEXT(" ") + Key;
+}
+
+void FDreamAccountRequestHedger::LaunchAttempt(const TSharedRef<FHedgedRequest>& State, int32 AttemptIndex)
+{
+	FDreamAccountHttpRequest AttemptRequest = State->Request;
+	if (AttemptIndex == 1)
+	{
+		AttemptRequest.URL = GetAlternateURL(AttemptRequest.URL);
+	}
+	AttemptRequest.Cancellation = MakeShared<FDreamAccountHttpCancellation>();
+	State->Attempts[AttemptIndex] = AttemptRequest.Cancellation;
+	++State->PendingCount;
+
+	FDreamAccountUtil::SendHttpRequest(AttemptRequest, [this, State, AttemptIndex](const FDreamAccountHttpResponse& Response)
+	{
+		HandleAttemptComplete(State, AttemptIndex, Response);
+	});
+}
+
+void FDreamAccountRequestHedger::LaunchHedge(const TSharedRef<FHedgedRequest>& State)
+{
+	if (State->bCompleted || State->bHedged)
+	{
+		return;
+	}
+
+	FEndpointState& Endpoint = Endpoints.FindOrAdd(State->EndpointKey);
+	if (!TryConsumeBudget(Endpoint))
+	{
+		return;
+	}
+
+	State->bHedged = true;
+	++Endpoint.HedgeCount;
+	LaunchAttempt(State, 1);
+}
+
+void FDreamAccountRequestHedger::HandleAttemptComplete(const TSharedRef<FHedgedRequest>& State, int32 AttemptIndex, const FDreamAccountHttpResponse& Response)
+{
+	State->Attempts[AttemptIndex].Reset();
+	--State->PendingCount;
+	if (State->bCompleted)
+	{
+		return;
+	}
+
+	// 另一个请求仍在进行时，失败的响应先暂存，等待另一个结果
+	if (!IsUsableResponse(Response) && State->PendingCount > 0)
+	{
+		State->HeldResponse = Response;
+		return;
+	}
+
+	// 主请求在对冲发出前失败时直接结束，不再等待对冲
+	Finish(State, AttemptIndex, Response);
+}
+
+void FDreamAccountRequestHedger::Finish(const TSharedRef<FHedgedRequest>& State, int32 WinnerIndex, const FDreamAccountHttpResponse& Response)
+{
+	State->bCompleted = true;
+
+	if (State->HedgeTimerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(State->HedgeTimerHandle);
+		State->HedgeTimerHandle.Reset();
+	}
+
+	for (TSharedPtr<FDreamAccountHttpCancellation>& Attempt : State->Attempts)
+	{
+		if (Attempt.IsValid())
+		{
+			Attempt->Cancel();
+			Attempt.Reset();
+		}
+	}
+
+	// 外部取消
+	if (WinnerIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	const double Elapsed = FPlatformTime::Seconds() - State->StartTime;
+	FEndpointState& Endpoint = Endpoints.FindOrAdd(State->EndpointKey);
+	if (WinnerIndex == 0)
+	{
+		// 只记录主请求成功时的延迟，对冲请求的耗时从发出对冲时开始，不能代表接口延迟
+		if (IsUsableResponse(Response))
+		{
+			Endpoint.AddSample(Elapsed);
+		}
+	}
+	else
+	{
+		++Endpoint.HedgeWinCount;
+		Endpoint.EstimatedSavedSeconds += FMath::Max(Endpoint.GetTailMean(Elapsed, State->Request.GetEffectiveTimeout()) - Elapsed, 0.0);
+	}
+
+	FDreamAccountHttpResponse FinalResponse = IsUsableResponse(Response) || !State->HeldResponse.IsSet() ? Response : State->HeldResponse.GetValue();
+	FinalResponse.ElapsedSeconds = Elapsed;
+	State->OnComplete(FinalResponse);
+}
+
+FString FDreamAccountRequestHedger::GetAlternateURL(const FString& URL)
+{
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	if (Settings)
+	{
+		for (const TPair<FString, FString>& Pair : Settings->HedgeAlternateEndpoints)
+		{
+			if (!Pair.Key.IsEmpty() && URL.StartsWith(Pair.Key))
+			{
+				return Pair.Value + URL.RightChop(Pair.Key.Len());
+			}
+		}
+	}
+	return URL;
+}
+
+bool FDreamAccountRequestHedger::IsUsableResponse(const FDreamAccountHttpResponse& Response)
+{
+	return Response.bSucceeded && Response.ResponseCode < 500;
+}
+
+bool FDreamAccountRequestHedger::TryConsumeBudget(FEndpointState& Endpoint)
+{
+	if (BudgetTokens < 1.0)
+	{
+		++Endpoint.BudgetDeniedCount;
+		return false;
+	}
+
+	BudgetTokens -= 1.0;
+	return true;
+}
+
+void FDreamAccountRequestHedger::FEndpointState::AddSample(double Seconds)
+{
+	if (Samples.Num() < MaxSamples)
+	{
+		Samples.Add(static_cast<float>(Seconds));
+	}
+	else
+	{
+		Samples[NextSample] = static_cast<float>(Seconds);
+		NextSample = (NextSample + 1) % MaxSamples;
+	}
+	++SamplesSinceSort;
+}
+
+const TArray<float>& FDreamAccountRequestHedger::FEndpointState::GetSortedSamples() const
+{
+	// 分位数变化缓慢，每 16 个新样本排序一次即可
+	if (SamplesSinceSort >= 16 || SortedSamples.Num() != Samples.Num())
+	{
+		SortedSamples = Samples;
+		SortedSamples.Sort();
+		SamplesSinceSort = 0;
+	}
+	return SortedSamples;
+}
+
+double FDreamAccountRequestHedger::FEndpointState::GetPercentile(double Percentile) const
+{
+	const TArray<float>& Sorted = GetSortedSamples();
+	if (Sorted.IsEmpty())
+	{
+		return 0.0;
+	}
+
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+	return Sorted[Index];
+}
+
+double FDreamAccountRequestHedger::FEndpointState::GetTailMean(double Seconds, double DefaultSeconds) const
+{
+	double Total = 0.0;
+	int32 Count = 0;
+	for (float Sample : Samples)
+	{
+		if (Sample > Seconds)
+		{
+			Total += Sample;
+			++Count;
+		}
+	}
+	return Count > 0 ? Total / Count : DefaultSeconds;
+}
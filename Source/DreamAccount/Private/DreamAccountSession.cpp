@@ -0,0 +1,301 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountSession.h"
+
+#include "Async/Async.h"
+#include "DreamAccountModule.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeRWLock.h"
+
+namespace DreamAccountSession
+{
+	/** 风险指针槽位数，超出的读取线程退回读锁 */
+	static constexpr int32 MaxHazardSlots = 128;
+
+	struct FHazardSlot
+	{
+		/** 该线程正在转换为共享引用的快照 */
+		std::atomic<const FDreamAccountSession*> Pointer{nullptr};
+		std::atomic<bool> bClaimed{false};
+	};
+
+	static FHazardSlot HazardSlots[MaxHazardSlots];
+
+	/** 线程退出时归还槽位 */
+	struct FThreadHazardSlot
+	{
+		FHazardSlot* Slot = nullptr;
+		bool bClaimAttempted = false;
+
+		~FThreadHazardSlot()
+		{
+			if (Slot)
+			{
+				Slot->Pointer.store(nullptr);
+				Slot->bClaimed.store(false);
+			}
+		}
+	};
+
+	/** 获取当前线程的风险指针槽位，首次调用时领取，槽位用完时返回 nullptr */
+	static FHazardSlot* GetThreadHazardSlot()
+	{
+		thread_local FThreadHazardSlot ThreadSlot;
+		if (!ThreadSlot.bClaimAttempted)
+		{
+			ThreadSlot.bClaimAttempted = true;
+			for (FHazardSlot& Slot : HazardSlots)
+			{
+				bool bExpected = false;
+				if (Slot.bClaimed.compare_exchange_strong(bExpected, true))
+				{
+					ThreadSlot.Slot = &Slot;
+					break;
+				}
+			}
+		}
+		return ThreadSlot.Slot;
+	}
+
+	static bool IsHazardous(const FDreamAccountSession* Session)
+	{
+		for (const FHazardSlot& Slot : HazardSlots)
+		{
+			if (Slot.Pointer.load() == Session)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+#if !UE_BUILD_SHIPPING
+	/** 压力测试中发布新快照的最高频率（次/秒） */
+	static constexpr double StressPublishRate = 10000.0;
+
+	/** 是否有压力测试正在运行 */
+	static std::atomic<bool> bStressTestRunning(false);
+
+	/**
+	 * 并发压力测试：多个工作线程持续读取快照并校验一致性，同时另一个工作线程按固定频率发布新快照。
+	 * 快照中的令牌、用户ID与代数互相对应，读到不一致的组合说明发布不是原子的。
+	 * 测试使用独立的存储，不影响全局会话。
+	 */
+	static void RunStressTest(int32 ReaderCount, double DurationSeconds)
+	{
+		FDreamAccountSessionStore Store;
+
+		std::atomic<bool> bStop(false);
+		std::atomic<uint64> ReadCount(0);
+		std::atomic<uint64> ErrorCount(0);
+
+		TArray<TFuture<void>> Readers;
+		for (int32 Index = 0; Index < ReaderCount; ++Index)
+		{
+			Readers.Add(Async(EAsyncExecution::Thread, [&Store, &bStop, &ReadCount, &ErrorCount]()
+			{
+				uint64 LastGeneration = 0;
+				while (!bStop.load(std::memory_order_relaxed))
+				{
+					const FDreamAccountSessionRef Session = Store.Acquire();
+					if (Session->Generation < LastGeneration)
+					{
+						ErrorCount.fetch_add(1, std::memory_order_relaxed);
+					}
+					LastGeneration = Session->Generation;
+
+					if (Session->Token.StartsWith(TEXT("stress-")))
+					{
+						const int32 ExpectedUserID = FCString::Atoi(*Session->Token.RightChop(7));
+						if (Session->User.UserID != ExpectedUserID || Session->User.UserInfo.Name != Session->Token)
+						{
+							ErrorCount.fetch_add(1, std::memory_order_relaxed);
+						}
+					}
+					ReadCount.fetch_add(1, std::memory_order_relaxed);
+				}
+			}));
+		}
+
+		uint64 PublishCount = 0;
+		const double StartTime = FPlatformTime::Seconds();
+		const double EndTime = StartTime + DurationSeconds;
+		for (double Now = StartTime; Now < EndTime; Now = FPlatformTime::Seconds())
+		{
+			// 超前于限定频率时让出时间片，读取端有机会读到每一个快照
+			if (PublishCount >= (Now - StartTime) * StressPublishRate)
+			{
+				FPlatformProcess::Sleep(0.0f);
+				continue;
+			}
+
+			const int32 Value = static_cast<int32>(PublishCount++ % 100000);
+			FDreamAccountUser User;
+			User.UserID = Value;
+			User.UserInfo.Name = FString::Printf(TEXT("stress-%d"), Value);
+			Store.Publish(User.UserInfo.Name, User, FDateTime::MaxValue());
+		}
+
+		bStop.store(true);
+		for (TFuture<void>& Reader : Readers)
+		{
+			Reader.Wait();
+		}
+
+		UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount session stress test: readers=%d publishes=%llu reads=%llu errors=%llu -> %s"),
+			ReaderCount, PublishCount, ReadCount.load(), ErrorCount.load(), ErrorCount.load() == 0 ? TEXT("PASSED") : TEXT("FAILED"));
+	}
+
+	static FAutoConsoleCommand CmdStressTest(
+		TEXT("DreamAccount.Session.StressTest"),
+		TEXT("会话快照并发压力测试：DreamAccount.Session.StressTest [Readers=8] [Seconds=5]。使用独立的存储在工作线程中运行，结束后输出结果"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			if (bStressTestRunning.exchange(true))
+			{
+				UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount session stress test is already running"));
+				return;
+			}
+
+			const int32 ReaderCount = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 8;
+			const double Seconds = Args.Num() > 1 ? FMath::Max(FCString::Atod(*Args[1]), 0.1) : 5.0;
+			Async(EAsyncExecution::Thread, [ReaderCount, Seconds]()
+			{
+				RunStressTest(ReaderCount, Seconds);
+				bStressTestRunning.store(false);
+			});
+		}));
+#endif
+}
+
+FDreamAccountSessionEventBus& FDreamAccountSessionEventBus::Get()
+{
+	static FDreamAccountSessionEventBus Instance;
+	return Instance;
+}
+
+FDreamAccountSessionEventHandle FDreamAccountSessionEventBus::Subscribe(FListener Listener, uint32 TypeMask)
+{
+	check(IsInGameThread());
+
+	FDreamAccountSessionEventHandle Handle;
+	Handle.Serial = NextSerial++;
+	Handle.Index = Subscribers.Add({MakeShared<const FListener>(MoveTemp(Listener)), TypeMask, Handle.Serial, EventSequence});
+	return Handle;
+}
+
+bool FDreamAccountSessionEventBus::Unsubscribe(FDreamAccountSessionEventHandle& Handle)
+{
+	check(IsInGameThread());
+
+	const bool bValid = Handle.IsValid() && Subscribers.IsValidIndex(Handle.Index) && Subscribers[Handle.Index].Serial == Handle.Serial;
+	if (bValid)
+	{
+		Subscribers.RemoveAt(Handle.Index);
+	}
+	Handle.Reset();
+	return bValid;
+}
+
+void FDreamAccountSessionEventBus::Broadcast(const FDreamAccountSessionEvent& Event)
+{
+	check(IsInGameThread());
+
+	const uint64 Sequence = ++EventSequence;
+	const uint32 TypeBit = EventTypeBit(Event.Type);
+
+	// 回调中可能增删订阅，按下标遍历并每次重新检查槽位
+	for (int32 Index = 0; Index < Subscribers.GetMaxIndex(); ++Index)
+	{
+		if (!Subscribers.IsAllocated(Index))
+		{
+			continue;
+		}
+
+		const FSubscriber& Subscriber = Subscribers[Index];
+		if (Subscriber.SubscribedAt >= Sequence || (Subscriber.TypeMask & TypeBit) == 0)
+		{
+			continue;
+		}
+
+		const TSharedRef<const FListener> Listener = Subscriber.Listener;
+		(*Listener)(Event);
+	}
+}
+
+FDreamAccountSessionStore& FDreamAccountSessionStore::Get()
+{
+	static FDreamAccountSessionStore Instance;
+	return Instance;
+}
+
+FDreamAccountSessionStore::FDreamAccountSessionStore()
+	: Current(MakeShared<const FDreamAccountSession, ESPMode::ThreadSafe>()), Generation(0)
+{
+	CurrentPtr.store(&Current.Get());
+}
+
+FDreamAccountSessionRef FDreamAccountSessionStore::Acquire() const
+{
+	using namespace DreamAccountSession;
+
+	FHazardSlot* Slot = GetThreadHazardSlot();
+	if (!Slot)
+	{
+		FReadScopeLock Lock(CurrentLock);
+		return Current;
+	}
+
+	// 先声明风险指针再确认它仍是当前快照：确认成功后写入端回收时一定能看到该声明，快照不会在转换期间被释放
+	const FDreamAccountSession* Session = CurrentPtr.load();
+	for (;;)
+	{
+		Slot->Pointer.store(Session);
+		const FDreamAccountSession* Latest = CurrentPtr.load();
+		if (Latest == Session)
+		{
+			break;
+		}
+		Session = Latest;
+	}
+
+	FDreamAccountSessionRef Result = Session->AsShared();
+	Slot->Pointer.store(nullptr);
+	return Result;
+}
+
+FDreamAccountSessionRef FDreamAccountSessionStore::Publish(FString Token, FDreamAccountUser User, FDateTime ExpiresAt)
+{
+	TSharedPtr<const FDreamAccountSession, ESPMode::ThreadSafe> NewSession;
+	TArray<FDreamAccountSessionRef> Reclaimed;
+	{
+		FWriteScopeLock Lock(CurrentLock);
+
+		// 代数在写锁内确定，与发布顺序一致
+		const uint64 NewGeneration = Generation.load(std::memory_order_relaxed) + 1;
+		NewSession = MakeShared<const FDreamAccountSession, ESPMode::ThreadSafe>(MoveTemp(Token), MoveTemp(User), ExpiresAt, NewGeneration);
+
+		Retired.Add(Current);
+		Current = NewSession.ToSharedRef();
+		CurrentPtr.store(NewSession.Get());
+		Generation.store(NewGeneration, std::memory_order_release);
+
+		ReclaimRetired(Reclaimed);
+	}
+
+	// 旧快照在锁外释放，没有其他持有者时在这里销毁
+	Reclaimed.Reset();
+	return NewSession.ToSharedRef();
+}
+
+void FDreamAccountSessionStore::ReclaimRetired(TArray<FDreamAccountSessionRef>& Reclaimed)
+{
+	for (int32 Index = Retired.Num() - 1; Index >= 0; --Index)
+	{
+		if (!DreamAccountSession::IsHazardous(&Retired[Index].Get()))
+		{
+			Reclaimed.Add(Retired[Index]);
+			Retired.RemoveAtSwap(Index);
+		}
+	}
+}
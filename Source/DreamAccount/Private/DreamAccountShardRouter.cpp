@@ -0,0 +1,327 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountShardRouter.h"
+
+#include "Algo/LowerBound.h"
+#include "DreamAccountModule.h"
+#include "DreamAccountSettings.h"
+#include "DreamAccountUtil.h"
+#include "Hash/CityHash.h"
+#include "HAL/IConsoleManager.h"
+
+namespace DreamAccountShards
+{
+	/** 近期延迟的平滑系数 */
+	static constexpr double RecentLatencyAlpha = 0.2;
+
+	uint64 HashString(const FString& Value)
+	{
+		const FTCHARToUTF8 Utf8(*Value);
+		const uint64 Hash = CityHash64(Utf8.Get(), Utf8.Length());
+
+		// 0 保留为“不分片”
+		return Hash != 0 ? Hash : 1;
+	}
+
+	static FAutoConsoleCommand CmdSet(
+		TEXT("DreamAccount.Shards.Set"),
+		TEXT("替换账号服务器分片列表：DreamAccount.Shards.Set <URL> [URL...]，不带参数时恢复项目设置"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			FDreamAccountShardRouter& Router = FDreamAccountShardRouter::Get();
+			if (Args.IsEmpty())
+			{
+				Router.ApplySettings();
+			}
+			else
+			{
+				const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+				Router.SetShards(Args,
+					Settings ? Settings->ShardVirtualNodes : 160,
+					Settings ? Settings->ShardRebalanceWindow : 30.0);
+			}
+			UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount shards: %s"), *FString::Join(Router.GetShards(), TEXT(", ")));
+		}));
+
+	static FAutoConsoleCommand CmdStats(
+		TEXT("DreamAccount.Shards.Stats"),
+		TEXT("输出各账号服务器分片的请求、错误和延迟统计"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			for (const FDreamAccountShardStats& Shard : FDreamAccountShardRouter::Get().GetStats())
+			{
+				UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount shard %s%s: Share=%.1f%% Requests=%d Errors=%d Fallbacks=%d Avg=%.1fms Recent=%.1fms Max=%.1fms"),
+					*Shard.Endpoint, Shard.bActive ? TEXT("") : TEXT(" (removed)"),
+					Shard.KeyShare * 100.0f, Shard.RequestCount, Shard.ErrorCount, Shard.FallbackCount,
+					Shard.AverageLatencyMs, Shard.RecentLatencyMs, Shard.MaxLatencyMs);
+			}
+		}));
+
+	static FAutoConsoleCommand CmdResolve(
+		TEXT("DreamAccount.Shards.Resolve"),
+		TEXT("查看路由结果：DreamAccount.Shards.Resolve <UserName> 或 DreamAccount.Shards.Resolve #<UserID>"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			if (Args.IsEmpty())
+			{
+				return;
+			}
+
+			const uint64 KeyHash = Args[0].StartsWith(TEXT("#"))
+				? FDreamAccountShardRouter::HashUserID(FCString::Atoi(*Args[0].RightChop(1)))
+				: FDreamAccountShardRouter::HashUserName(Args[0]);
+			UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount shard for %s: %s"), *Args[0], *FDreamAccountShardRouter::Get().ResolveBaseURL(KeyHash));
+		}));
+}
+
+FDreamAccountShardRouter& FDreamAccountShardRouter::Get()
+{
+	static FDreamAccountShardRouter Instance;
+	return Instance;
+}
+
+FDreamAccountShardRouter::FDreamAccountShardRouter()
+{
+}
+
+uint64 FDreamAccountShardRouter::HashUserName(const FString& UserName)
+{
+	return UserName.IsEmpty() ? 0 : DreamAccountShards::HashString(TEXT("name:") + UserName);
+}
+
+uint64 FDreamAccountShardRouter::HashUserID(int32 UserID)
+{
+	return DreamAccountShards::HashString(FString::Printf(TEXT("id:%d"), UserID));
+}
+
+void FDreamAccountShardRouter::SetShards(const TArray<FString>& Endpoints, int32 VirtualNodesPerShard, double RebalanceWindowSeconds)
+{
+	TArray<FString> NewEndpoints;
+	for (const FString& Endpoint : Endpoints)
+	{
+		FString Trimmed = Endpoint.TrimStartAndEnd();
+		Trimmed.RemoveFromEnd(TEXT("/"));
+		if (!Trimmed.IsEmpty())
+		{
+			NewEndpoints.AddUnique(Trimmed);
+		}
+	}
+
+	if (NewEndpoints == Current.Endpoints)
+	{
+		return;
+	}
+
+	Previous = MoveTemp(Current);
+	Current = FRing::Build(NewEndpoints, FMath::Max(VirtualNodesPerShard, 1));
+	RebalanceDeadline = FPlatformTime::Seconds() + RebalanceWindowSeconds;
+
+	UE_LOG(LogDreamAccount, Log, TEXT("DreamAccount shard membership changed: %d -> %d shards"), Previous.Endpoints.Num(), Current.Endpoints.Num());
+}
+
+void FDreamAccountShardRouter::ApplySettings()
+{
+	if (const UDreamAccountSettings* Settings = UDreamAccountSettings::Get())
+	{
+		SetShards(Settings->ShardEndpoints, Settings->ShardVirtualNodes, Settings->ShardRebalanceWindow);
+	}
+}
+
+FString FDreamAccountShardRouter::ResolveBaseURL(uint64 KeyHash) const
+{
+	const int32 ShardIndex = KeyHash != 0 ? Current.FindShard(KeyHash) : INDEX_NONE;
+	return ShardIndex != INDEX_NONE ? Current.Endpoints[ShardIndex] : API_SERVER_URL;
+}
+
+FString FDreamAccountShardRouter::RouteURL(const FString& URL, uint64 KeyHash) const
+{
+	const FString BaseURL = API_SERVER_URL;
+	if (KeyHash == 0 || !IsEnabled() || !URL.StartsWith(BaseURL))
+	{
+		return URL;
+	}
+
+	return ResolveBaseURL(KeyHash) + URL.RightChop(BaseURL.Len());
+}
+
+void FDreamAccountShardRouter::SendHttpRequest(uint64 KeyHash, const FString& URL, const FString& Verb, const FString& Content, const TMap<FString, FString>& Headers, const FDreamAccountHttpCallback& OnComplete)
+{
+	FDreamAccountHttpRequest Request;
+	Request.URL = URL;
+	Request.Verb = Verb;
+	Request.Content = Content;
+	Request.Headers = Headers;
+
+	SendHttpRequest(KeyHash, Request, OnComplete);
+}
+
+void FDreamAccountShardRouter::SendHttpRequest(uint64 KeyHash, const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& OnComplete)
+{
+	const FString BaseURL = API_SERVER_URL;
+	const int32 ShardIndex = KeyHash != 0 ? Current.FindShard(KeyHash) : INDEX_NONE;
+	if (ShardIndex == INDEX_NONE || !Request.URL.StartsWith(BaseURL))
+	{
+		FDreamAccountUtil::SendHttpRequest(Request, OnComplete);
+		return;
+	}
+
+	const FString Path = Request.URL.RightChop(BaseURL.Len());
+	const FString Endpoint = Current.Endpoints[ShardIndex];
+
+	// 迁移窗口内归属发生变化时，记下原分片用于回退
+	FString FallbackEndpoint;
+	if (FPlatformTime::Seconds() < RebalanceDeadline && CanFallback(Request))
+	{
+		const int32 PreviousIndex = Previous.FindShard(KeyHash);
+		if (PreviousIndex != INDEX_NONE && Previous.Endpoints[PreviousIndex] != Endpoint)
+		{
+			FallbackEndpoint = Previous.Endpoints[PreviousIndex];
+		}
+	}
+
+	FDreamAccountHttpRequest RoutedRequest = Request;
+	RoutedRequest.URL = Endpoint + Path;
+
+	FDreamAccountUtil::SendHttpRequest(RoutedRequest, [this, Request, Path, Endpoint, FallbackEndpoint, OnComplete](const FDreamAccountHttpResponse& Response)
+	{
+		RecordResponse(Endpoint, Response, false);
+
+		const bool bCancelled = Request.Cancellation.IsValid() && Request.Cancellation->IsCancelled();
+		if (FallbackEndpoint.IsEmpty() || bCancelled || !ShouldFallback(Response))
+		{
+			OnComplete(Response);
+			return;
+		}
+
+		FDreamAccountHttpRequest FallbackRequest = Request;
+		FallbackRequest.URL = FallbackEndpoint + Path;
+		FDreamAccountUtil::SendHttpRequest(FallbackRequest, [this, FallbackEndpoint, OnComplete](const FDreamAccountHttpResponse& FallbackResponse)
+		{
+			RecordResponse(FallbackEndpoint, FallbackResponse, true);
+			OnComplete(FallbackResponse);
+		});
+	});
+}
+
+TArray<FDreamAccountShardStats> FDreamAccountShardRouter::GetStats() const
+{
+	TArray<FDreamAccountShardStats> Result;
+	const TArray<float> KeyShares = Current.ComputeKeyShares();
+
+	TSet<FString> Endpoints(Current.Endpoints);
+	for (const TPair<FString, FEndpointStats>& Pair : Stats)
+	{
+		Endpoints.Add(Pair.Key);
+	}
+
+	for (const FString& Endpoint : Endpoints)
+	{
+		FDreamAccountShardStats& Shard = Result.AddDefaulted_GetRef();
+		Shard.Endpoint = Endpoint;
+
+		const int32 ShardIndex = Current.Endpoints.IndexOfByKey(Endpoint);
+		Shard.bActive = ShardIndex != INDEX_NONE;
+		Shard.KeyShare = Shard.bActive ? KeyShares[ShardIndex] : 0.0f;
+
+		if (const FEndpointStats* EndpointStats = Stats.Find(Endpoint))
+		{
+			Shard.RequestCount = EndpointStats->RequestCount;
+			Shard.ErrorCount = EndpointStats->ErrorCount;
+			Shard.FallbackCount = EndpointStats->FallbackCount;
+			Shard.AverageLatencyMs = EndpointStats->RequestCount > 0 ? static_cast<float>(EndpointStats->TotalLatencySeconds * 1000.0 / EndpointStats->RequestCount) : 0.0f;
+			Shard.RecentLatencyMs = static_cast<float>(EndpointStats->RecentLatencySeconds * 1000.0);
+			Shard.MaxLatencyMs = static_cast<float>(EndpointStats->MaxLatencySeconds * 1000.0);
+		}
+	}
+
+	return Result;
+}
+
+void FDreamAccountShardRouter::ResetStats()
+{
+	Stats.Empty();
+}
+
+bool FDreamAccountShardRouter::CanFallback(const FDreamAccountHttpRequest& Request)
+{
+	return Request.Verb.Equals(TEXT("GET"), ESearchCase::IgnoreCase) || Request.bHedgeable || Request.bShardFallback;
+}
+
+bool FDreamAccountShardRouter::ShouldFallback(const FDreamAccountHttpResponse& Response)
+{
+	// 网络错误时请求可能已经在新分片上生效，401 等是新分片的确定结果，都不能改发
+	return Response.bSucceeded && (Response.ResponseCode == 404 || Response.ResponseCode == 421);
+}
+
+void FDreamAccountShardRouter::RecordResponse(const FString& Endpoint, const FDreamAccountHttpResponse& Response, bool bFallback)
+{
+	FEndpointStats& EndpointStats = Stats.FindOrAdd(Endpoint);
+	++EndpointStats.RequestCount;
+	if (bFallback)
+	{
+		++EndpointStats.FallbackCount;
+	}
+	if (!Response.bSucceeded || Response.ResponseCode >= 500)
+	{
+		++EndpointStats.ErrorCount;
+	}
+
+	EndpointStats.TotalLatencySeconds += Response.ElapsedSeconds;
+	EndpointStats.MaxLatencySeconds = FMath::Max(EndpointStats.MaxLatencySeconds, Response.ElapsedSeconds);
+	EndpointStats.RecentLatencySeconds = EndpointStats.RequestCount == 1
+		? Response.ElapsedSeconds
+		: FMath::Lerp(EndpointStats.RecentLatencySeconds, Response.ElapsedSeconds, DreamAccountShards::RecentLatencyAlpha);
+}
+
+int32 FDreamAccountShardRouter::FRing::FindShard(uint64 KeyHash) const
+{
+	if (Points.IsEmpty())
+	{
+		return INDEX_NONE;
+	}
+
+	int32 Index = Algo::LowerBoundBy(Points, KeyHash, [](const TPair<uint64, int32>& Point) { return Point.Key; });
+	if (Index == Points.Num())
+	{
+		Index = 0;
+	}
+	return Points[Index].Value;
+}
+
+TArray<float> FDreamAccountShardRouter::FRing::ComputeKeyShares() const
+{
+	TArray<float> Shares;
+	Shares.SetNumZeroed(Endpoints.Num());
+
+	// 每个虚拟节点拥有从上一个节点（不含）到自身的区间
+	for (int32 Index = 0; Index < Points.Num(); ++Index)
+	{
+		const uint64 PreviousHash = Index > 0 ? Points[Index - 1].Key : Points.Last().Key;
+		const uint64 Span = Points[Index].Key - PreviousHash;
+		Shares[Points[Index].Value] += static_cast<float>(static_cast<double>(Span) / 18446744073709551616.0);
+	}
+
+	if (Points.Num() == 1)
+	{
+		Shares[Points[0].Value] = 1.0f;
+	}
+	return Shares;
+}
+
+FDreamAccountShardRouter::FRing FDreamAccountShardRouter::FRing::Build(const TArray<FString>& Endpoints, int32 VirtualNodesPerShard)
+{
+	FRing Ring;
+	Ring.Endpoints = Endpoints;
+	Ring.Points.Reserve(Endpoints.Num() * VirtualNodesPerShard);
+
+	for (int32 ShardIndex = 0; ShardIndex < Endpoints.Num(); ++ShardIndex)
+	{
+		for (int32 Node = 0; Node < VirtualNodesPerShard; ++Node)
+		{
+			Ring.Points.Emplace(DreamAccountShards::HashString(FString::Printf(TEXT("%s#%d"), *Endpoints[ShardIndex], Node)), ShardIndex);
+		}
+	}
+
+	Ring.Points.Sort([](const TPair<uint64, int32>& A, const TPair<uint64, int32>& B) { return A.Key < B.Key; });
+	return Ring;
+}
@@ -3,30 +3,282 @@
 
 #include "DreamAccountSubsystem.h"
 
+#include "DreamAccountAdmission.h"
+#include "DreamAccountBanList.h"
+#include "DreamAccountCallbackDispatcher.h"
+#include "DreamAccountLatencyBeacons.h"
+#include "DreamAccountModule.h"
+#include "DreamAccountRequestHedger.h"
 #include "DreamAccountSettings.h"
+#include "DreamAccountShardRouter.h"
+#include "DreamAccountTimeoutEstimator.h"
+#include "DreamAccountTracing.h"
 #include "DreamAccountUtil.h"
-#include "Interfaces/IHttpRequest.h"
-#include "Interfaces/IHttpResponse.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "HAL/IConsoleManager.h"
+#include "Hash/CityHash.h"
+#include "Serialization/JsonSerializer.h"
 
 using namespace FDreamAccountAPI;
 using namespace FDreamAccountFields;
 
+namespace DreamAccountSubsystem
+{
+	/** 账号请求共用的 JSON 请求头，只构造一次 */
+	static const TMap<FString, FString>& GetJsonHeaders()
+	{
+		static const TMap<FString, FString> Headers = {
+			{TEXT("Content-Type"), TEXT("application/json;charset=UTF-8")}
+		};
+		return Headers;
+	}
+
+	/** 生成 Authorization 请求头的值，一次分配到位 */
+	static FString MakeBearer(const FString& Token)
+	{
+		static const TCHAR Prefix[] = TEXT("Bearer ");
+		FString Value;
+		Value.Reserve(UE_ARRAY_COUNT(Prefix) - 1 + Token.Len());
+		Value += Prefix;
+		Value += Token;
+		return Value;
+	}
+
+	/** 请求链上下文池的容量，超过该数量的并发认证请求使用临时分配的上下文 */
+	static constexpr int32 MaxPooledCredentialContexts = 8;
+
+#if !UE_BUILD_SHIPPING
+	/** 预热阶段的登录次数，让上下文池、HTTP 模块和各类缓存先进入稳定状态 */
+	static constexpr int32 MemoryCheckWarmupLogins = 3;
+
+	/** 一次内存检查的进度，逐个登录完成后再发起下一次 */
+	struct FMemoryCheckRun
+	{
+		FString UserName;
+		FString Password;
+		int32 Count = 0;
+		int32 Completed = 0;
+		int32 Failed = 0;
+		int64 BaselineTagBytes = INDEX_NONE;
+		uint64 BaselineAllocations = 0;
+	};
+
+	/** 插件 LLM 标签当前占用的字节数，未启用 LLM 时为 INDEX_NONE */
+	static int64 GetTagBytes()
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		if (FLowLevelMemTracker::IsEnabled())
+		{
+			return FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default, LLM_TAG_NAME(DreamAccount), ELLMTagSet::None);
+		}
+#endif
+		return INDEX_NONE;
+	}
+
+	static void RunMemoryCheckLogin(TWeakObjectPtr<UDreamAccountSubsystem> WeakSubsystem, const TSharedRef<FMemoryCheckRun>& Run)
+	{
+		UDreamAccountSubsystem* Subsystem = WeakSubsystem.Get();
+		if (!Subsystem)
+		{
+			return;
+		}
+
+		FDreamAccountInfo User;
+		User.Name = Run->UserName;
+		User.Password = Run->Password;
+		Subsystem->UserLogin_Internal(MoveTemp(User), [WeakSubsystem, Run](const FDreamAccountResult& Result)
+		{
+			if (Run->Completed >= MemoryCheckWarmupLogins && Result.ErrorType != EDreamAccountErrorType::NORMAL)
+			{
+				++Run->Failed;
+			}
+			++Run->Completed;
+
+			// 在下一帧发起下一次登录，这时上一条请求链已经释放了上下文
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([WeakSubsystem, Run](float)
+			{
+				UDreamAccountSubsystem* Subsystem = WeakSubsystem.Get();
+				if (!Subsystem)
+				{
+					return false;
+				}
+
+				if (Run->Completed == MemoryCheckWarmupLogins)
+				{
+					Run->BaselineTagBytes = GetTagBytes();
+					Run->BaselineAllocations = Subsystem->GetCredentialContextAllocations();
+				}
+
+				if (Run->Completed < MemoryCheckWarmupLogins + Run->Count)
+				{
+					RunMemoryCheckLogin(WeakSubsystem, Run);
+					return false;
+				}
+
+				const uint64 Allocations = Subsystem->GetCredentialContextAllocations() - Run->BaselineAllocations;
+				const int64 TagBytes = GetTagBytes();
+				if (TagBytes == INDEX_NONE || Run->BaselineTagBytes == INDEX_NONE)
+				{
+					UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount MemoryCheck: Logins=%d Failed=%d ContextAllocations=%llu (LLM disabled, start with -llm to measure tag growth)"),
+						Run->Count, Run->Failed, Allocations);
+				}
+				else
+				{
+					const int64 Growth = TagBytes - Run->BaselineTagBytes;
+					UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount MemoryCheck: Logins=%d Failed=%d ContextAllocations=%llu LLMGrowth=%lld bytes (%.1f bytes/login)"),
+						Run->Count, Run->Failed, Allocations, Growth, static_cast<double>(Growth) / Run->Count);
+				}
+				return false;
+			}));
+		});
+	}
+
+	static FAutoConsoleCommand CmdMemoryCheck(
+		TEXT("DreamAccount.Auth.MemoryCheck"),
+		TEXT("预热后连续登录若干次，输出请求链上下文的新分配次数与插件 LLM 标签的增长：DreamAccount.Auth.MemoryCheck <UserName> <Password> [Count]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			UDreamAccountSubsystem* Subsystem = GEngine ? GEngine->GetEngineSubsystem<UDreamAccountSubsystem>() : nullptr;
+			if (!Subsystem || Args.Num() < 2)
+			{
+				UE_LOG(LogDreamAccount, Warning, TEXT("Usage: DreamAccount.Auth.MemoryCheck <UserName> <Password> [Count]"));
+				return;
+			}
+
+			const TSharedRef<FMemoryCheckRun> Run = MakeShared<FMemoryCheckRun>();
+			Run->UserName = Args[0];
+			Run->Password = Args[1];
+			Run->Count = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 20;
+			RunMemoryCheckLogin(Subsystem, Run);
+		}));
+#endif
+}
+
+void UDreamAccountSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FDreamAccountShardRouter::Get().ApplySettings();
+
+	if (const UDreamAccountSettings* Settings = UDreamAccountSettings::Get())
+	{
+		// 先于其他组件启动，启动时发出的请求也带有追踪头
+		if (Settings->bEnableTracing && !IsRunningCommandlet())
+		{
+			FDreamAccountTracer::Get().Start();
+		}
+
+		UserCache.Configure(
+			Settings->UserCacheMaxEntries,
+			static_cast<int64>(Settings->UserCacheMaxMemoryKB) * 1024,
+			Settings->UserCacheTimeToLive);
+
+		ConditionalCache.Configure(Settings->ConditionalCacheMaxEntries);
+
+		UsernameChecker.Configure(
+			Settings->UsernameCheckDebounce,
+			Settings->UsernameTakenCacheTTL,
+			Settings->UsernameAvailableCacheTTL);
+
+		if (Settings->bDownloadValidationRules && !IsRunningCommandlet())
+		{
+			RefreshValidationRules();
+		}
+
+		FDreamAccountAdmissionController::Get().Configure(
+			Settings->AdmissionMaxInFlight,
+			Settings->AdmissionMaxQueueLength,
+			Settings->AdmissionQueueTimeout,
+			Settings->AdmissionResultCacheTTL);
+
+		if (Settings->bEnableBanListSync && !IsRunningCommandlet()
+			&& (IsRunningDedicatedServer() || !Settings->bBanListSyncOnlyOnDedicatedServer))
+		{
+			FDreamAccountBanList::Get().Start(Settings->BanListSyncInterval);
+		}
+
+		if (Settings->bEnableLatencyBeacons && !IsRunningCommandlet())
+		{
+			FDreamAccountLatencyBeacons::Get().Start();
+		}
+	}
+
+	FDreamAccountAdmissionController::Get().SetValidator([this](const FString& Token, const FString& UserName, FDreamAccountResultCallback Callback)
+	{
+		ValidateToken_Internal(Token, UserName, MoveTemp(Callback));
+	});
+
+	BlueprintSessionEventHandle = FDreamAccountSessionEventBus::Get().Subscribe([this](const FDreamAccountSessionEvent& Event)
+	{
+		BroadcastBlueprintSessionEvent(Event);
+	});
+
+	PushChannel = MakeUnique<FDreamAccountPushChannel>();
+	PushChannel->OnEvent = [this](const FDreamAccountPushEvent& Event)
+	{
+		HandlePushEvent(Event);
+	};
+	PushChannel->OnConnectionChanged = [this](bool bConnected)
+	{
+		OnPushChannelStateChanged.Broadcast(bConnected);
+	};
+
+	if (const UDreamAccountSettings* Settings = UDreamAccountSettings::Get())
+	{
+		if (Settings->AuthPollingInterval > 0.0f)
+		{
+			AuthPollingHandle = FTSTicker::GetCoreTicker().AddTicker(
+				FTickerDelegate::CreateUObject(this, &UDreamAccountSubsystem::TickAuthPolling),
+				Settings->AuthPollingInterval);
+		}
+	}
+}
+
+
+void UDreamAccountSubsystem::Deinitialize()
+{
+	if (AuthPollingHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(AuthPollingHandle);
+		AuthPollingHandle.Reset();
+	}
+
+	FDreamAccountSessionEventBus::Get().Unsubscribe(BlueprintSessionEventHandle);
+
+	PushChannel.Reset();
+	CancelLoginQueue();
+	CredentialContextPool.Empty();
+	UsernameChecker.CancelAll();
+	FDreamAccountBanList::Get().Stop();
+	FDreamAccountLatencyBeacons::Get().Stop();
+	FDreamAccountTracer::Get().Stop();
+	FDreamAccountAdmissionController::Get().CancelAll();
+	FDreamAccountAdmissionController::Get().SetValidator(nullptr);
+	FDreamAccountCallbackDispatcher::Get().Reset();
+
+	Super::Deinitialize();
+}
+
 void UDreamAccountSubsystem::UserRegister(FDreamAccountInfo User, FOnAccountResult OnResult)
 {
 	auto Callback = [OnResult](const FDreamAccountResult& Result)
 	{
-		if (OnResult.IsBound())
+		FDreamAccountCallbackDispatcher::Get().Dispatch(EDreamAccountDispatchPriority::Interactive, [OnResult, Result]()
 		{
-			OnResult.Execute(Result);
-		}
+			OnResult.ExecuteIfBound(Result);
+		});
 	};
 
-	UserRegister_Internal(User, Callback);
+	UserRegister_Internal(MoveTemp(User), MoveTemp(Callback));
 }
 
 
 void UDreamAccountSubsystem::UserRegister_Internal(FDreamAccountInfo User, FDreamAccountResultCallback Callback)
 {
+	LLM_SCOPE_BYTAG(DreamAccount);
+
 	if (User.Name.IsEmpty() || User.Password.IsEmpty())
 	{
 		Callback(FDreamAccountResult(
@@ -46,32 +298,42 @@ void UDreamAccountSubsystem::UserRegister_Internal(FDreamAccountInfo User, FDrea
 		return;
 	}
 
-	TMap<FString, FString> Headers;
-	Headers.Add(TEXT("Content-Type"), TEXT("application/json;charset=UTF-8"));
+	const EDreamAccountErrorType ValidationError = ValidationRules.ValidateRegister(User);
+	if (ValidationError != EDreamAccountErrorType::NORMAL)
+	{
+		Callback(FDreamAccountResult(EDreamAccountResultType::Register, ValidationError, FDreamAccountUser()));
+		return;
+	}
 
-	FDreamAccountUtil::SendHttpRequest(
-		API_REGISTER,
-		TEXT("POST"),
-		User.Serialize(),
-		Headers,
-		[Callback](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+	// 账号信息和回调放在同一个可复用的上下文中，失败路径与响应路径共用
+	const FCredentialContextRef Context = AcquireCredentialContext(MoveTemp(User), MoveTemp(Callback));
+
+	SendCredentialRequest(Context, API_REGISTER, EDreamAccountResultType::Register,
+		[this, Context](const FDreamAccountHttpResponse& Response)
 		{
-			if (!bWasSuccessful || !Response.IsValid())
+			const FDreamAccountResultCallback ResultCallback = Context->Release();
+			if (!Response.bSucceeded)
 			{
-				Callback(FDreamAccountResult(EDreamAccountResultType::Register, EDreamAccountErrorType::NETWORK_ERROR, FDreamAccountUser()));
+				ResultCallback(FDreamAccountResult(EDreamAccountResultType::Register, EDreamAccountErrorType::NETWORK_ERROR, FDreamAccountUser()));
 				return;
 			}
 
-			if (Response->GetResponseCode() != 200 && Response->GetResponseCode() != 201)
+			if (Response.ResponseCode != 200 && Response.ResponseCode != 201)
 			{
-				FDreamAccountUtil::HandleCommonErrorResponse(Response, EDreamAccountResultType::Register, Callback);
+				if (FDreamAccountUtil::ParseErrorTypeFromResponse(Response) == EDreamAccountErrorType::NETWORK_USERNAME_EXISTS)
+				{
+					UsernameChecker.MarkTaken(Context->User.Name);
+				}
+				FDreamAccountUtil::HandleCommonErrorResponse(Response, EDreamAccountResultType::Register, ResultCallback);
 				return;
 			}
 
+			UsernameChecker.MarkTaken(Context->User.Name);
+
 			TSharedPtr<FJsonObject> Json = FDreamAccountUtil::ParseJsonFromResponse(Response);
 			FDreamAccountUser ResultUser = FDreamAccountUtil::ParseAccountUserFromJson(Json);
 
-			Callback(FDreamAccountResult(EDreamAccountResultType::Register, EDreamAccountErrorType::NORMAL, ResultUser));
+			ResultCallback(FDreamAccountResult(EDreamAccountResultType::Register, EDreamAccountErrorType::NORMAL, MoveTemp(ResultUser)));
 		});
 }
 
@@ -80,148 +342,1295 @@ void UDreamAccountSubsystem::UserLogin(FDreamAccountInfo User, FOnAccountResult
 {
 	auto Callback = [OnResult](const FDreamAccountResult& Result)
 	{
-		if (OnResult.IsBound())
+		FDreamAccountCallbackDispatcher::Get().Dispatch(EDreamAccountDispatchPriority::Interactive, [OnResult, Result]()
 		{
-			OnResult.Execute(Result);
-		}
+			OnResult.ExecuteIfBound(Result);
+		});
 	};
 
-	UserLogin_Internal(User, Callback);
+	UserLogin_Internal(MoveTemp(User), MoveTemp(Callback));
 }
 
 
-void UDreamAccountSubsystem::UserLogin_Internal(FDreamAccountInfo User, FDreamAccountResultCallback Callback)
+TSharedPtr<FDreamAccountWaitingRoom> UDreamAccountSubsystem::UserLogin_Internal(FDreamAccountInfo User, FDreamAccountResultCallback Callback, FDreamAccountQueueCallback OnQueueUpdate)
 {
+	LLM_SCOPE_BYTAG(DreamAccount);
+
 	if (User.Name.IsEmpty() || User.Password.IsEmpty())
 	{
 		Callback(FDreamAccountResult(EDreamAccountResultType::Login, EDreamAccountErrorType::LOCAL_INPUT_DATA_NOT_VALID, FDreamAccountUser()));
-		return;
+		return nullptr;
 	}
 
 	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
 	if (!Settings)
 	{
 		Callback(FDreamAccountResult(EDreamAccountResultType::Login, EDreamAccountErrorType::LOCAL_INPUT_DATA_NOT_VALID, FDreamAccountUser()));
-		return;
+		return nullptr;
 	}
 
-	TMap<FString, FString> Headers;
-	Headers.Add(TEXT("Content-Type"), TEXT("application/json;charset=UTF-8"));
+	const EDreamAccountErrorType ValidationError = ValidationRules.ValidateLogin(User);
+	if (ValidationError != EDreamAccountErrorType::NORMAL)
+	{
+		Callback(FDreamAccountResult(EDreamAccountResultType::Login, ValidationError, FDreamAccountUser()));
+		return nullptr;
+	}
 
-	FDreamAccountUtil::SendHttpRequest(
-		API_LOGIN,
-		TEXT("POST"),
-		User.Serialize(),
-		Headers,
-		[this, Callback](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+	TSharedPtr<FDreamAccountWaitingRoom> WaitingRoom;
+	if (Settings->bEnableWaitingRoom)
+	{
+		WaitingRoom = MakeShared<FDreamAccountWaitingRoom>(FDreamAccountShardRouter::HashUserName(User.Name), MoveTemp(OnQueueUpdate));
+
+		// 登录有了最终结果后不再跟踪该排队过程
+		Callback = [WeakThis = TWeakObjectPtr<UDreamAccountSubsystem>(this), WeakRoom = TWeakPtr<FDreamAccountWaitingRoom>(WaitingRoom), Callback = MoveTemp(Callback)](const FDreamAccountResult& Result)
+		{
+			if (UDreamAccountSubsystem* Subsystem = WeakThis.Get())
+			{
+				Subsystem->WaitingRooms.RemoveSingleSwap(WeakRoom.Pin());
+			}
+			Callback(Result);
+		};
+	}
+
+	SendLoginRequest(AcquireCredentialContext(MoveTemp(User), MoveTemp(Callback)), WaitingRoom, FString());
+	return WaitingRoom;
+}
+
+
+void UDreamAccountSubsystem::SendLoginRequest(const FCredentialContextRef& Context,
+	TSharedPtr<FDreamAccountWaitingRoom> WaitingRoom, const FString& QueueAdmission)
+{
+	SendCredentialRequest(Context, API_LOGIN, EDreamAccountResultType::Login,
+		[this, Context, WaitingRoom](const FDreamAccountHttpResponse& Response)
 		{
-			if (!bWasSuccessful || !Response.IsValid())
+			// 进入排队时请求链还没有结束，账号信息和回调继续留在上下文中
+			FDreamAccountQueueStatus QueueStatus;
+			double PollAfter = -1.0;
+			if (Response.bSucceeded && WaitingRoom.IsValid() && FDreamAccountWaitingRoom::ParseQueueResponse(Response, QueueStatus, PollAfter))
+			{
+				EnterLoginQueue(Context, WaitingRoom.ToSharedRef(), QueueStatus, PollAfter);
+				return;
+			}
+
+			const FDreamAccountResultCallback ResultCallback = Context->Release();
+			if (!Response.bSucceeded)
 			{
-				Callback(FDreamAccountResult(EDreamAccountResultType::Login, EDreamAccountErrorType::NETWORK_ERROR, FDreamAccountUser()));
+				ResultCallback(FDreamAccountResult(EDreamAccountResultType::Login, EDreamAccountErrorType::NETWORK_ERROR, FDreamAccountUser()));
 				return;
 			}
 
-			if (Response->GetResponseCode() != 200 && Response->GetResponseCode() != 201)
+			if (Response.ResponseCode != 200 && Response.ResponseCode != 201)
 			{
-				FDreamAccountUtil::HandleCommonErrorResponse(Response, EDreamAccountResultType::Login, Callback);
+				FDreamAccountUtil::HandleCommonErrorResponse(Response, EDreamAccountResultType::Login, ResultCallback);
 				return;
 			}
 
 			TSharedPtr<FJsonObject> Json = FDreamAccountUtil::ParseJsonFromResponse(Response);
 
 			FDreamAccountUser LoggedInUser = FDreamAccountUtil::ParseAccountUserFromJson(Json);
-			FString Token = FDreamAccountUtil::ParseTokenFromJson(Json);
+			FString NewToken = FDreamAccountUtil::ParseTokenFromJson(Json);
 
-			if (!Token.IsEmpty())
+			if (!NewToken.IsEmpty())
 			{
-				SetToken(Token);
+				SetSession(NewToken, LoggedInUser, FDreamAccountUtil::ParseTokenExpiryFromJson(Json));
 			}
 
-			Callback(FDreamAccountResult(EDreamAccountResultType::Login, EDreamAccountErrorType::NORMAL, LoggedInUser, Token));
-		});
+			ResultCallback(FDreamAccountResult(EDreamAccountResultType::Login, EDreamAccountErrorType::NORMAL, MoveTemp(LoggedInUser), MoveTemp(NewToken)));
+		}, QueueAdmission);
 }
 
 
-void UDreamAccountSubsystem::AuthenticationToken(FOnAccountResult OnResult)
+void UDreamAccountSubsystem::EnterLoginQueue(const FCredentialContextRef& Context,
+	const TSharedRef<FDreamAccountWaitingRoom>& WaitingRoom, const FDreamAccountQueueStatus& QueueStatus, double PollAfter)
 {
-	auto Callback = [OnResult](const FDreamAccountResult& Result)
+	WaitingRooms.AddUnique(WaitingRoom);
+
+	TWeakObjectPtr<UDreamAccountSubsystem> WeakThis(this);
+	TWeakPtr<FDreamAccountWaitingRoom> WeakRoom = WaitingRoom;
+	WaitingRoom->Wait(QueueStatus, PollAfter, [WeakThis, WeakRoom, Context](EDreamAccountErrorType ErrorType, const FString& Admission)
 	{
-		if (OnResult.IsBound())
+		UDreamAccountSubsystem* Subsystem = WeakThis.Get();
+		TSharedPtr<FDreamAccountWaitingRoom> Room = WeakRoom.Pin();
+		if (!Subsystem || !Room.IsValid())
+		{
+			Context->Release()(FDreamAccountResult(EDreamAccountResultType::Login, EDreamAccountErrorType::LOCAL_REQUEST_CANCELLED, FDreamAccountUser()));
+			return;
+		}
+
+		if (ErrorType != EDreamAccountErrorType::NORMAL)
 		{
-			OnResult.Execute(Result);
+			Context->Release()(FDreamAccountResult(EDreamAccountResultType::Login, ErrorType, FDreamAccountUser()));
+			return;
 		}
+
+		// 放行后重新登录；票据失效时 Admission 为空，服务器会重新安排排队
+		Subsystem->SendLoginRequest(Context, Room, Admission);
+	});
+}
+
+
+void UDreamAccountSubsystem::CancelLoginQueue()
+{
+	TArray<TSharedPtr<FDreamAccountWaitingRoom>> Rooms = MoveTemp(WaitingRooms);
+	WaitingRooms.Reset();
+	for (const TSharedPtr<FDreamAccountWaitingRoom>& Room : Rooms)
+	{
+		Room->Cancel();
+	}
+}
+
+
+void UDreamAccountSubsystem::CancelWaitingRoom(const TSharedPtr<FDreamAccountWaitingRoom>& WaitingRoom)
+{
+	if (!WaitingRoom.IsValid())
+	{
+		return;
+	}
+
+	WaitingRooms.RemoveSingleSwap(WaitingRoom);
+	WaitingRoom->Cancel();
+}
+
+
+bool UDreamAccountSubsystem::IsInLoginQueue() const
+{
+	return WaitingRooms.ContainsByPredicate([](const TSharedPtr<FDreamAccountWaitingRoom>& Room)
+	{
+		return Room->IsWaiting();
+	});
+}
+
+
+void UDreamAccountSubsystem::UserRegisterAndLogin(FDreamAccountInfo User, FOnAccountResult OnResult)
+{
+	auto Callback = [OnResult](const FDreamAccountResult& Result)
+	{
+		FDreamAccountCallbackDispatcher::Get().Dispatch(EDreamAccountDispatchPriority::Interactive, [OnResult, Result]()
+		{
+			OnResult.ExecuteIfBound(Result);
+		});
 	};
 
-	AuthenticationToken_Internal(Callback);
+	UserRegisterAndLogin_Internal(MoveTemp(User), MoveTemp(Callback));
 }
 
 
-void UDreamAccountSubsystem::AuthenticationToken_Internal(FDreamAccountResultCallback Callback)
+void UDreamAccountSubsystem::UserRegisterAndLogin_Internal(FDreamAccountInfo User, FDreamAccountResultCallback Callback)
 {
-	if (Token.IsEmpty())
+	LLM_SCOPE_BYTAG(DreamAccount);
+
+	if (User.Name.IsEmpty() || User.Password.IsEmpty())
 	{
-		Callback(FDreamAccountResult(
-			EDreamAccountResultType::Auth,
-			EDreamAccountErrorType::LOCAL_TOKEN_NOT_VALID,
-			FDreamAccountUser()));
+		Callback(FDreamAccountResult(EDreamAccountResultType::RegisterAndLogin, EDreamAccountErrorType::LOCAL_INPUT_DATA_NOT_VALID, FDreamAccountUser()));
 		return;
 	}
 
 	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
 	if (!Settings)
 	{
-		Callback(FDreamAccountResult(
-			EDreamAccountResultType::Auth,
-			EDreamAccountErrorType::LOCAL_TOKEN_NOT_VALID,
-			FDreamAccountUser()));
+		Callback(FDreamAccountResult(EDreamAccountResultType::RegisterAndLogin, EDreamAccountErrorType::LOCAL_INPUT_DATA_NOT_VALID, FDreamAccountUser()));
 		return;
 	}
 
-	TMap<FString, FString> Headers;
-	Headers.Add(TEXT("Authorization"), FString::Printf(TEXT("Bearer %s"), *Token));
+	const EDreamAccountErrorType ValidationError = ValidationRules.ValidateRegister(User);
+	if (ValidationError != EDreamAccountErrorType::NORMAL)
+	{
+		Callback(FDreamAccountResult(EDreamAccountResultType::RegisterAndLogin, ValidationError, FDreamAccountUser()));
+		return;
+	}
 
-	FDreamAccountUtil::SendHttpRequest(
-		API_AUTH,
-		TEXT("GET"),
-		Headers,
-		[Callback](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+	if (bRegisterAndLoginUnsupported)
+	{
+		UserRegisterThenLogin(User, Callback);
+		return;
+	}
+
+	// 账号信息和回调放在同一个可复用的上下文中，失败路径与响应路径共用
+	const FCredentialContextRef Context = AcquireCredentialContext(MoveTemp(User), MoveTemp(Callback));
+
+	SendCredentialRequest(Context, API_REGISTER_LOGIN, EDreamAccountResultType::RegisterAndLogin,
+		[this, Context](const FDreamAccountHttpResponse& Response)
 		{
-			if (!bWasSuccessful || !Response.IsValid())
+			// 旧版服务器没有该接口，记住后直接走两步流程，账号信息先移出再结束本条请求链
+			if (Response.bSucceeded && (Response.ResponseCode == 404 || Response.ResponseCode == 405 || Response.ResponseCode == 501))
 			{
-				Callback(FDreamAccountResult(EDreamAccountResultType::Auth, EDreamAccountErrorType::NETWORK_ERROR, FDreamAccountUser()));
+				bRegisterAndLoginUnsupported = true;
+				FDreamAccountInfo FallbackUser = MoveTemp(Context->User);
+				UserRegisterThenLogin(MoveTemp(FallbackUser), Context->Release());
 				return;
 			}
 
-			if (Response->GetResponseCode() != 200 && Response->GetResponseCode() != 201)
+			const FDreamAccountResultCallback ResultCallback = Context->Release();
+			if (!Response.bSucceeded)
 			{
-				FDreamAccountUtil::HandleCommonErrorResponse(Response, EDreamAccountResultType::Auth, Callback);
+				ResultCallback(FDreamAccountResult(EDreamAccountResultType::RegisterAndLogin, EDreamAccountErrorType::NETWORK_ERROR, FDreamAccountUser()));
+				return;
+			}
+
+			if (Response.ResponseCode != 200 && Response.ResponseCode != 201)
+			{
+				if (FDreamAccountUtil::ParseErrorTypeFromResponse(Response) == EDreamAccountErrorType::NETWORK_USERNAME_EXISTS)
+				{
+					UsernameChecker.MarkTaken(Context->User.Name);
+				}
+				FDreamAccountUtil::HandleCommonErrorResponse(Response, EDreamAccountResultType::RegisterAndLogin, ResultCallback);
 				return;
 			}
 
+			UsernameChecker.MarkTaken(Context->User.Name);
+
 			TSharedPtr<FJsonObject> Json = FDreamAccountUtil::ParseJsonFromResponse(Response);
 
-			FDreamAccountUser AuthUser = FDreamAccountUtil::ParseAccountUserFromJson(Json);
+			FDreamAccountUser RegisteredUser = FDreamAccountUtil::ParseAccountUserFromJson(Json);
+			FString NewToken = FDreamAccountUtil::ParseTokenFromJson(Json);
 
-			Callback(FDreamAccountResult(EDreamAccountResultType::Auth, EDreamAccountErrorType::NORMAL, AuthUser));
+			if (!NewToken.IsEmpty())
+			{
+				SetSession(NewToken, RegisteredUser, FDreamAccountUtil::ParseTokenExpiryFromJson(Json));
+			}
+
+			ResultCallback(FDreamAccountResult(EDreamAccountResultType::RegisterAndLogin, EDreamAccountErrorType::NORMAL, MoveTemp(RegisteredUser), MoveTemp(NewToken)));
 		});
 }
 
 
-void UDreamAccountSubsystem::UserLogout()
+void UDreamAccountSubsystem::UserRegisterThenLogin(FDreamAccountInfo User, FDreamAccountResultCallback Callback)
 {
-	ClearToken();
+	UserRegister_Internal(User, [this, User, Callback](const FDreamAccountResult& RegisterResult)
+	{
+		if (RegisterResult.ErrorType != EDreamAccountErrorType::NORMAL)
+		{
+			FDreamAccountResult Result = RegisterResult;
+			Result.ResultType = EDreamAccountResultType::RegisterAndLogin;
+			Callback(Result);
+			return;
+		}
+
+		UserLogin_Internal(User, [Callback](const FDreamAccountResult& LoginResult)
+		{
+			FDreamAccountResult Result = LoginResult;
+			Result.ResultType = EDreamAccountResultType::RegisterAndLogin;
+			Callback(Result);
+		});
+	});
 }
 
 
-void UDreamAccountSubsystem::ClearToken()
+void UDreamAccountSubsystem::SendCredentialRequest(const FCredentialContextRef& Context, const FString& URL, EDreamAccountResultType ResultType,
+	FDreamAccountHttpCallback OnResponse, const FString& QueueAdmission)
 {
-	SetToken(FString());
+	LLM_SCOPE_BYTAG(DreamAccount);
+
+	const uint64 KeyHash = FDreamAccountShardRouter::HashUserName(Context->User.Name);
+
+	FDreamAccountHttpRequest Request;
+	Request.URL = URL;
+	Request.Verb = TEXT("POST");
+	Request.Headers = DreamAccountSubsystem::GetJsonHeaders();
+
+	// 只有排队放行后的登录需要额外的请求头
+	if (!QueueAdmission.IsEmpty())
+	{
+		Request.Headers.Add(TEXT("X-Queue-Admission"), QueueAdmission);
+	}
+
+	// 登录不产生副作用，分片迁移期间新分片找不到用户时可以改发原分片；注册类请求不能重发
+	Request.bShardFallback = ResultType == EDreamAccountResultType::Login;
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	if (!Settings || !Settings->bEnableClientKeyDerivation || bKeyDerivationUnsupported)
+	{
+		Context->User.SerializeTo(Request.Content);
+		FDreamAccountShardRouter::Get().SendHttpRequest(KeyHash, Request, OnResponse);
+		FDreamAccountUtil::ScrubString(Request.Content);
+		return;
+	}
+
+	DeriveCredential(Context, [Context, ResultType, OnResponse = MoveTemp(OnResponse), KeyHash, Request = MoveTemp(Request)](EDreamAccountErrorType ErrorType, const FString& DerivedKey) mutable
+	{
+		if (ErrorType != EDreamAccountErrorType::NORMAL)
+		{
+			Context->Release()(FDreamAccountResult(ResultType, ErrorType, FDreamAccountUser()));
+			return;
+		}
+
+		// 服务器不支持密钥派生时 DerivedKey 为空，退回发送原始密码
+		if (DerivedKey.IsEmpty())
+		{
+			Context->User.SerializeTo(Request.Content);
+		}
+		else
+		{
+			Context->User.SerializeTo(Request.Content, &DerivedKey, TEXT("scrypt"));
+		}
+
+		// 发送时已复制到 HTTP 请求中，本地的明文请求体立即清除
+		FDreamAccountShardRouter::Get().SendHttpRequest(KeyHash, Request, OnResponse);
+		FDreamAccountUtil::ScrubString(Request.Content);
+	});
 }
 
 
-void UDreamAccountSubsystem::SetToken(FString NewToken)
+void UDreamAccountSubsystem::DeriveCredential(const FCredentialContextRef& Context, TFunction<void(EDreamAccountErrorType ErrorType, const FString& DerivedKey)> Callback)
 {
-	Token = NewToken;
+	FDreamAccountHttpRequest Request;
+	Request.URL = FString::Printf(TEXT("%s?%s=%s"), *API_KDF_PARAMS, *FDreamAccountFields::FIELD_USER_NAME, *FGenericPlatformHttp::UrlEncode(Context->User.Name));
+	Request.Verb = TEXT("GET");
+	Request.bHedgeable = true;
+
+	TWeakObjectPtr<UDreamAccountSubsystem> WeakThis(this);
+	FDreamAccountShardRouter::Get().SendHttpRequest(FDreamAccountShardRouter::HashUserName(Context->User.Name), Request,
+		[WeakThis, Context, Callback = MoveTemp(Callback)](const FDreamAccountHttpResponse& Response)
+		{
+			UDreamAccountSubsystem* Subsystem = WeakThis.Get();
+			if (!Subsystem)
+			{
+				Callback(EDreamAccountErrorType::LOCAL_REQUEST_CANCELLED, FString());
+				return;
+			}
+
+			if (!Response.bSucceeded)
+			{
+				Callback(EDreamAccountErrorType::NETWORK_ERROR, FString());
+				return;
+			}
+
+			// 旧版服务器没有该接口，记住后直接发送原始密码
+			if (Response.ResponseCode == 404 || Response.ResponseCode == 405 || Response.ResponseCode == 501)
+			{
+				UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount: server does not support client key derivation (HTTP %d), sending passwords directly"), Response.ResponseCode);
+				Subsystem->bKeyDerivationUnsupported = true;
+				Callback(EDreamAccountErrorType::NORMAL, FString());
+				return;
+			}
+
+			if (Response.ResponseCode != 200)
+			{
+				Callback(FDreamAccountUtil::ParseErrorTypeFromResponse(Response), FString());
+				return;
+			}
+
+			FDreamAccountKdfParams Params;
+			const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+			const uint64 MaxMemoryBytes = static_cast<uint64>(Settings ? Settings->KeyDerivationMaxMemoryMB : 64) * 1024 * 1024;
+			if (!Params.LoadFromJson(Response.Content) || Params.GetMemoryBytes() > MaxMemoryBytes)
+			{
+				UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount: rejected key derivation params (N=%d r=%d p=%d, %.1fMB)"),
+					Params.CostN, Params.BlockSize, Params.Parallelism, Params.GetMemoryBytes() / (1024.0 * 1024.0));
+				Callback(EDreamAccountErrorType::LOCAL_KEY_DERIVATION_FAILED, FString());
+				return;
+			}
+
+			const FDreamAccountInfo& User = Context->User;
+			const FTCHARToUTF8 PasswordUtf8(*User.Password);
+			const TArray<uint8> PasswordHash = FDreamAccountKeyDerivation::Sha256(
+				TArray<uint8>(reinterpret_cast<const uint8*>(PasswordUtf8.Get()), PasswordUtf8.Length()));
+
+			const FDerivedCredential& Last = Subsystem->LastDerivedCredential;
+			if (Last.UserName == User.Name && Last.PasswordHash == PasswordHash && Last.Params.Salt == Params.Salt
+				&& Last.Params.CostN == Params.CostN && Last.Params.BlockSize == Params.BlockSize
+				&& Last.Params.Parallelism == Params.Parallelism && Last.Params.KeyLength == Params.KeyLength)
+			{
+				Callback(EDreamAccountErrorType::NORMAL, Last.DerivedKey);
+				return;
+			}
 
-	OnTokenChanged.Broadcast();
+			FDreamAccountKeyDerivation::DeriveAsync(User.Password, Params, [WeakThis, UserName = User.Name, PasswordHash, Params, Callback](bool bSucceeded, const FString& DerivedKey)
+			{
+				if (!bSucceeded)
+				{
+					Callback(EDreamAccountErrorType::LOCAL_KEY_DERIVATION_FAILED, FString());
+					return;
+				}
+
+				if (UDreamAccountSubsystem* DerivedSubsystem = WeakThis.Get())
+				{
+					DerivedSubsystem->LastDerivedCredential = {UserName, PasswordHash, Params, DerivedKey};
+				}
+				Callback(EDreamAccountErrorType::NORMAL, DerivedKey);
+			});
+		});
+}
+
+
+FDreamAccountResultCallback UDreamAccountSubsystem::FCredentialContext::Release()
+{
+	FDreamAccountUtil::ScrubString(User.Password);
+	FDreamAccountResultCallback Result = MoveTemp(Callback);
+	Callback = nullptr;
+	return Result;
+}
+
+
+UDreamAccountSubsystem::FCredentialContextRef UDreamAccountSubsystem::AcquireCredentialContext(FDreamAccountInfo&& User, FDreamAccountResultCallback&& Callback)
+{
+	// 只有池本身持有引用的上下文才是空闲的，引用计数是线程安全的，后台线程上的闭包释放后这里立即可见
+	for (const FCredentialContextRef& Context : CredentialContextPool)
+	{
+		if (Context.GetSharedReferenceCount() == 1)
+		{
+			// 请求链被整体丢弃时不会调用 Release，复用前再清一次密码
+			FDreamAccountUtil::ScrubString(Context->User.Password);
+			Context->User = MoveTemp(User);
+			Context->Callback = MoveTemp(Callback);
+			return Context;
+		}
+	}
+
+	++CredentialContextAllocations;
+	FCredentialContextRef Context = MakeShared<FCredentialContext>();
+	Context->User = MoveTemp(User);
+	Context->Callback = MoveTemp(Callback);
+	if (CredentialContextPool.Num() < DreamAccountSubsystem::MaxPooledCredentialContexts)
+	{
+		CredentialContextPool.Add(Context);
+	}
+	return Context;
+}
+
+
+void UDreamAccountSubsystem::CheckUsernameAvailability(FName FieldKey, const FString& UserName, FOnUsernameCheckResult OnResult)
+{
+	auto Callback = [OnResult](const FDreamAccountUsernameCheckResult& Result)
+	{
+		FDreamAccountCallbackDispatcher::Get().Dispatch(EDreamAccountDispatchPriority::Interactive, [OnResult, Result]()
+		{
+			OnResult.ExecuteIfBound(Result);
+		});
+	};
+
+	CheckUsernameAvailability_Internal(FieldKey, UserName, Callback);
+}
+
+
+void UDreamAccountSubsystem::CheckUsernameAvailability_Internal(FName FieldKey, const FString& UserName, FDreamAccountUsernameCheckCallback Callback)
+{
+	// 不符合规则的用户名无需询问服务器，同时取代该输入框之前的检查
+	if (!UserName.IsEmpty() && !ValidationRules.IsValidUserName(UserName))
+	{
+		UsernameChecker.Cancel(FieldKey);
+		Callback(FDreamAccountUsernameCheckResult(EDreamAccountErrorType::NETWORK_INVALID_USERNAME, UserName));
+		return;
+	}
+
+	UsernameChecker.Check(FieldKey, UserName, MoveTemp(Callback));
+}
+
+
+void UDreamAccountSubsystem::RefreshValidationRules()
+{
+	FDreamAccountUtil::SendHttpRequest(
+		API_VALIDATION_RULES,
+		TEXT("GET"),
+		TMap<FString, FString>(),
+		[this](const FDreamAccountHttpResponse& Response)
+		{
+			if (!Response.bSucceeded || Response.ResponseCode != 200)
+			{
+				UE_LOG(LogDreamAccount, Verbose, TEXT("DreamAccount validation rules unavailable (%d), keeping %s rules"),
+					Response.ResponseCode, ValidationRules.IsFromServer() ? TEXT("server") : TEXT("default"));
+				return;
+			}
+
+			FString Error;
+			if (!ValidationRules.LoadFromJson(Response.Content, &Error))
+			{
+				UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount failed to load validation rules from server: %s"), *Error);
+				return;
+			}
+
+			ValidationRules.SetFromServer(true);
+		});
+}
+
+
+void UDreamAccountSubsystem::CancelUsernameCheck(FName FieldKey)
+{
+	UsernameChecker.Cancel(FieldKey);
+}
+
+
+void UDreamAccountSubsystem::AuthenticationToken(FOnAccountResult OnResult)
+{
+	auto Callback = [OnResult](const FDreamAccountResult& Result)
+	{
+		FDreamAccountCallbackDispatcher::Get().Dispatch(EDreamAccountDispatchPriority::Interactive, [OnResult, Result]()
+		{
+			OnResult.ExecuteIfBound(Result);
+		});
+	};
+
+	AuthenticationToken_Internal(MoveTemp(Callback));
+}
+
+
+void UDreamAccountSubsystem::AuthenticationToken_Internal(FDreamAccountResultCallback Callback)
+{
+	const FDreamAccountSessionRef Session = GetSession();
+	if (!Session->IsLoggedIn())
+	{
+		Callback(FDreamAccountResult(
+			EDreamAccountResultType::Auth,
+			EDreamAccountErrorType::LOCAL_TOKEN_NOT_VALID,
+			FDreamAccountUser()));
+		return;
+	}
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	if (!Settings)
+	{
+		Callback(FDreamAccountResult(
+			EDreamAccountResultType::Auth,
+			EDreamAccountErrorType::LOCAL_TOKEN_NOT_VALID,
+			FDreamAccountUser()));
+		return;
+	}
+
+	ValidateToken_Internal(Session->Token, Session->User.UserInfo.Name, MoveTemp(Callback));
+}
+
+
+void UDreamAccountSubsystem::ValidateToken_Internal(const FString& Token, const FString& UserName, FDreamAccountResultCallback Callback)
+{
+	LLM_SCOPE_BYTAG(DreamAccount);
+
+	FDreamAccountHttpRequest Request;
+	Request.URL = API_AUTH;
+	Request.Verb = TEXT("GET");
+	Request.Headers.Add(TEXT("Authorization"), DreamAccountSubsystem::MakeBearer(Token));
+	Request.bHedgeable = true;
+
+	// 按令牌区分条目，缓存键中只保存令牌的哈希
+	FString CacheKey = FString::Printf(TEXT("GET %s#%016llx"), *Request.GetPath(), CityHash64(reinterpret_cast<const char*>(*Token), Token.Len() * sizeof(TCHAR)));
+	ConditionalCache.ApplyValidators(CacheKey, Request);
+
+	FDreamAccountShardRouter::Get().SendHttpRequest(
+		FDreamAccountShardRouter::HashUserName(UserName),
+		Request,
+		[this, Token, UserName, CacheKey = MoveTemp(CacheKey), Callback = MoveTemp(Callback)](const FDreamAccountHttpResponse& Response) mutable
+		{
+			if (!Response.bSucceeded)
+			{
+				Callback(FDreamAccountResult(EDreamAccountResultType::Auth, EDreamAccountErrorType::NETWORK_ERROR, FDreamAccountUser()));
+				return;
+			}
+
+			if (Response.ResponseCode == 304)
+			{
+				const TArray<FDreamAccountUser>* CachedUsers = ConditionalCache.HandleNotModified(CacheKey, Response);
+				if (CachedUsers && CachedUsers->Num() == 1)
+				{
+					// 回调可能修改缓存，先复制出结果
+					FDreamAccountUser AuthUser = (*CachedUsers)[0];
+					Callback(FDreamAccountResult(EDreamAccountResultType::Auth, EDreamAccountErrorType::NORMAL, MoveTemp(AuthUser)));
+					return;
+				}
+
+				// 条目在请求期间被淘汰，不带校验器重新请求
+				ConditionalCache.Remove(CacheKey);
+				ValidateToken_Internal(Token, UserName, MoveTemp(Callback));
+				return;
+			}
+
+			if (Response.ResponseCode != 200 && Response.ResponseCode != 201)
+			{
+				ConditionalCache.Remove(CacheKey);
+				FDreamAccountUtil::HandleCommonErrorResponse(Response, EDreamAccountResultType::Auth, Callback);
+				return;
+			}
+
+			const double ParseStartTime = FPlatformTime::Seconds();
+			TSharedPtr<FJsonObject> Json = FDreamAccountUtil::ParseJsonFromResponse(Response);
+			FDreamAccountUser AuthUser = FDreamAccountUtil::ParseAccountUserFromJson(Json);
+			ConditionalCache.Store(CacheKey, Response, {AuthUser}, FPlatformTime::Seconds() - ParseStartTime);
+
+			Callback(FDreamAccountResult(EDreamAccountResultType::Auth, EDreamAccountErrorType::NORMAL, MoveTemp(AuthUser)));
+		});
+}
+
+
+void UDreamAccountSubsystem::RefreshToken(FOnAccountResult OnResult)
+{
+	auto Callback = [OnResult](const FDreamAccountResult& Result)
+	{
+		FDreamAccountCallbackDispatcher::Get().Dispatch(EDreamAccountDispatchPriority::Interactive, [OnResult, Result]()
+		{
+			OnResult.ExecuteIfBound(Result);
+		});
+	};
+
+	RefreshToken_Internal(MoveTemp(Callback));
+}
+
+
+void UDreamAccountSubsystem::RefreshToken_Internal(FDreamAccountResultCallback Callback)
+{
+	LLM_SCOPE_BYTAG(DreamAccount);
+
+	const FDreamAccountSessionRef Session = GetSession();
+	if (!Session->IsLoggedIn())
+	{
+		Callback(FDreamAccountResult(EDreamAccountResultType::Refresh, EDreamAccountErrorType::LOCAL_TOKEN_NOT_VALID, FDreamAccountUser()));
+		return;
+	}
+
+	TMap<FString, FString> Headers;
+	Headers.Add(TEXT("Authorization"), DreamAccountSubsystem::MakeBearer(Session->Token));
+
+	FDreamAccountShardRouter::Get().SendHttpRequest(
+		FDreamAccountShardRouter::HashUserName(Session->User.UserInfo.Name),
+		API_REFRESH,
+		TEXT("POST"),
+		FString(),
+		Headers,
+		[this, Callback = MoveTemp(Callback)](const FDreamAccountHttpResponse& Response)
+		{
+			if (!Response.bSucceeded)
+			{
+				Callback(FDreamAccountResult(EDreamAccountResultType::Refresh, EDreamAccountErrorType::NETWORK_ERROR, FDreamAccountUser()));
+				return;
+			}
+
+			if (Response.ResponseCode != 200 && Response.ResponseCode != 201)
+			{
+				FDreamAccountUtil::HandleCommonErrorResponse(Response, EDreamAccountResultType::Refresh, Callback);
+				return;
+			}
+
+			TSharedPtr<FJsonObject> Json = FDreamAccountUtil::ParseJsonFromResponse(Response);
+
+			FDreamAccountUser RefreshedUser = FDreamAccountUtil::ParseAccountUserFromJson(Json);
+			FString NewToken = FDreamAccountUtil::ParseTokenFromJson(Json);
+
+			if (NewToken.IsEmpty())
+			{
+				Callback(FDreamAccountResult(EDreamAccountResultType::Refresh, EDreamAccountErrorType::NETWORK_INVALID_TOKEN, FDreamAccountUser()));
+				return;
+			}
+
+			SetSession(NewToken, RefreshedUser, FDreamAccountUtil::ParseTokenExpiryFromJson(Json));
+
+			Callback(FDreamAccountResult(EDreamAccountResultType::Refresh, EDreamAccountErrorType::NORMAL, MoveTemp(RefreshedUser), MoveTemp(NewToken)));
+		});
+}
+
+
+void UDreamAccountSubsystem::SendAuthenticatedRequest(const FDreamAccountHttpRequest& Request, FDreamAccountHttpCallback Callback)
+{
+	// 正在刷新时直接排队，避免用已知失效的令牌再发一次
+	if (bTokenRefreshInProgress)
+	{
+		PendingAuthenticatedRequests.Add({Request, MoveTemp(Callback), FDreamAccountHttpResponse::MakeError(401, TEXT("INVALID_TOKEN"))});
+		return;
+	}
+
+	SendAuthenticatedRequestAttempt(Request, MoveTemp(Callback), false);
+}
+
+
+void UDreamAccountSubsystem::SetTokenRefreshHandler(FTokenRefreshHandler Handler)
+{
+	TokenRefreshHandler = MoveTemp(Handler);
+}
+
+
+void UDreamAccountSubsystem::SendAuthenticatedRequestAttempt(FDreamAccountHttpRequest Request, FDreamAccountHttpCallback Callback, bool bIsReplay)
+{
+	const FDreamAccountSessionRef Session = GetSession();
+	if (!Session->IsLoggedIn())
+	{
+		Callback(FDreamAccountHttpResponse::MakeError(401, TEXT("USER_NOT_AUTHENTICATED")));
+		return;
+	}
+
+	Request.Headers.Add(TEXT("Authorization"), DreamAccountSubsystem::MakeBearer(Session->Token));
+
+	const uint64 SentGeneration = Session->Generation;
+	FDreamAccountUtil::SendHttpRequest(
+		Request,
+		[this, Request, Callback = MoveTemp(Callback), bIsReplay, SentGeneration](const FDreamAccountHttpResponse& Response)
+		{
+			if (bIsReplay || !IsTokenRejected(Response))
+			{
+				Callback(Response);
+				return;
+			}
+
+			// 发送后令牌已经被换过（其他请求触发的刷新已完成），直接用新令牌重发
+			if (!bTokenRefreshInProgress && FDreamAccountSessionStore::Get().GetGeneration() != SentGeneration)
+			{
+				SendAuthenticatedRequestAttempt(Request, Callback, true);
+				return;
+			}
+
+			PendingAuthenticatedRequests.Add({Request, Callback, Response});
+			BeginTokenRefresh();
+		});
+}
+
+
+void UDreamAccountSubsystem::BeginTokenRefresh()
+{
+	if (bTokenRefreshInProgress)
+	{
+		return;
+	}
+	bTokenRefreshInProgress = true;
+
+	UE_LOG(LogDreamAccount, Log, TEXT("DreamAccount token rejected, refreshing (%d requests waiting)"), PendingAuthenticatedRequests.Num());
+
+	auto OnRefreshed = [this](const FDreamAccountResult& Result)
+	{
+		FinishTokenRefresh(Result);
+	};
+
+	if (TokenRefreshHandler)
+	{
+		TokenRefreshHandler(OnRefreshed);
+	}
+	else
+	{
+		RefreshToken_Internal(OnRefreshed);
+	}
+}
+
+
+void UDreamAccountSubsystem::FinishTokenRefresh(const FDreamAccountResult& Result)
+{
+	bTokenRefreshInProgress = false;
+
+	TArray<FPendingAuthenticatedRequest> Pending = MoveTemp(PendingAuthenticatedRequests);
+	PendingAuthenticatedRequests.Reset();
+
+	const bool bRefreshed = Result.ErrorType == EDreamAccountErrorType::NORMAL && GetSession()->IsLoggedIn();
+	if (!bRefreshed)
+	{
+		UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount token refresh failed (%s), failing %d requests"),
+			*UEnum::GetValueAsString(Result.ErrorType), Pending.Num());
+
+		// 令牌已被服务器确认失效，清除本地会话
+		ClearSessionOnAuthError(Result.ErrorType);
+
+		for (const FPendingAuthenticatedRequest& Entry : Pending)
+		{
+			Entry.Callback(Entry.RejectedResponse);
+		}
+		return;
+	}
+
+	for (FPendingAuthenticatedRequest& Entry : Pending)
+	{
+		SendAuthenticatedRequestAttempt(MoveTemp(Entry.Request), MoveTemp(Entry.Callback), true);
+	}
+}
+
+
+bool UDreamAccountSubsystem::IsTokenRejected(const FDreamAccountHttpResponse& Response)
+{
+	if (!Response.bSucceeded)
+	{
+		return false;
+	}
+
+	return Response.ResponseCode == 401
+		|| (Response.ResponseCode >= 400 && FDreamAccountUtil::ParseErrorTypeFromResponse(Response) == EDreamAccountErrorType::NETWORK_INVALID_TOKEN);
+}
+
+
+void UDreamAccountSubsystem::LookupUsers(const TArray<int32>& UserIDs, FOnUserLookupResult OnResult)
+{
+	auto Callback = [OnResult](const FDreamAccountUserLookupResult& Result)
+	{
+		FDreamAccountCallbackDispatcher::Get().Dispatch(EDreamAccountDispatchPriority::Background, [OnResult, Result]()
+		{
+			OnResult.ExecuteIfBound(Result);
+		});
+	};
+
+	LookupUsers_Internal(UserIDs, MoveTemp(Callback));
+}
+
+
+void UDreamAccountSubsystem::LookupUsers_Internal(const TArray<int32>& UserIDs, FDreamAccountUserLookupCallback Callback)
+{
+	LLM_SCOPE_BYTAG(DreamAccount);
+
+	if (UserIDs.IsEmpty())
+	{
+		Callback(FDreamAccountUserLookupResult(EDreamAccountErrorType::LOCAL_INPUT_DATA_NOT_VALID));
+		return;
+	}
+
+	TSharedRef<FPendingUserLookup> Pending = MakeShared<FPendingUserLookup>();
+	Pending->Callback = MoveTemp(Callback);
+	Pending->UserIDs.Reserve(UserIDs.Num());
+
+	// 去重用集合判断，大批量查询（好友列表、排行榜）保持线性时间
+	TSet<int32> SeenUserIDs;
+	SeenUserIDs.Reserve(UserIDs.Num());
+
+	TArray<int32> UserIDsToFetch;
+	for (int32 UserID : UserIDs)
+	{
+		bool bAlreadySeen = false;
+		SeenUserIDs.Add(UserID, &bAlreadySeen);
+		if (bAlreadySeen)
+		{
+			continue;
+		}
+		Pending->UserIDs.Add(UserID);
+
+		FDreamAccountUser CachedUser;
+		if (UserCache.Find(UserID, CachedUser))
+		{
+			Pending->ResolvedUsers.Add(UserID, CachedUser);
+			++Pending->CacheHitCount;
+			continue;
+		}
+
+		// 已在请求中的 UserID 只挂接等待，不重复请求
+		if (TArray<TSharedRef<FPendingUserLookup>>* Waiters = InFlightUserLookups.Find(UserID))
+		{
+			Waiters->Add(Pending);
+		}
+		else
+		{
+			InFlightUserLookups.Add(UserID).Add(Pending);
+			UserIDsToFetch.Add(UserID);
+		}
+		++Pending->OutstandingCount;
+	}
+
+	if (Pending->OutstandingCount == 0)
+	{
+		FinishUserLookup(Pending);
+		return;
+	}
+
+	if (UserIDsToFetch.IsEmpty())
+	{
+		return;
+	}
+
+	// 启用分片时按 UserID 所属分片拆分请求，每个分片一个请求
+	FDreamAccountShardRouter& ShardRouter = FDreamAccountShardRouter::Get();
+	TMap<FString, TArray<int32>> UserIDsByShard;
+	for (int32 UserID : UserIDsToFetch)
+	{
+		UserIDsByShard.FindOrAdd(ShardRouter.ResolveBaseURL(FDreamAccountShardRouter::HashUserID(UserID))).Add(UserID);
+	}
+
+	for (TPair<FString, TArray<int32>>& Shard : UserIDsByShard)
+	{
+		SendUserLookupRequest(MoveTemp(Shard.Value));
+	}
+}
+
+
+void UDreamAccountSubsystem::SendUserLookupRequest(TArray<int32> UserIDsToFetch)
+{
+	// 排序后同一组用户总是生成相同的请求体，条件请求才能命中
+	UserIDsToFetch.Sort();
+
+	TSharedPtr<FJsonObject> RequestJson = MakeShareable(new FJsonObject);
+	TArray<TSharedPtr<FJsonValue>> UserIDValues;
+	UserIDValues.Reserve(UserIDsToFetch.Num());
+	for (int32 UserID : UserIDsToFetch)
+	{
+		UserIDValues.Add(MakeShareable(new FJsonValueNumber(UserID)));
+	}
+	RequestJson->SetArrayField(FIELD_USER_IDS, UserIDValues);
+
+	FString Content;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Content);
+	FJsonSerializer::Serialize(RequestJson.ToSharedRef(), Writer);
+
+	FDreamAccountHttpRequest Request;
+	Request.URL = API_USERS_LOOKUP;
+	Request.Verb = TEXT("POST");
+	Request.Content = MoveTemp(Content);
+	Request.Headers.Add(TEXT("Content-Type"), TEXT("application/json;charset=UTF-8"));
+	const FDreamAccountSessionRef Session = GetSession();
+	if (Session->IsLoggedIn())
+	{
+		Request.Headers.Add(TEXT("Authorization"), DreamAccountSubsystem::MakeBearer(Session->Token));
+	}
+
+	// 查询不修改数据，可以对冲
+	Request.bHedgeable = true;
+
+	FString CacheKey = FString::Printf(TEXT("POST %s#%s"), *Request.GetPath(), *Request.Content);
+	ConditionalCache.ApplyValidators(CacheKey, Request);
+
+	FDreamAccountShardRouter::Get().SendHttpRequest(
+		FDreamAccountShardRouter::HashUserID(UserIDsToFetch[0]),
+		Request,
+		[this, UserIDsToFetch, CacheKey = MoveTemp(CacheKey)](const FDreamAccountHttpResponse& Response)
+		{
+			if (!Response.bSucceeded)
+			{
+				CompleteUserLookupRequest(UserIDsToFetch, TArray<FDreamAccountUser>(), EDreamAccountErrorType::NETWORK_ERROR);
+				return;
+			}
+
+			if (Response.ResponseCode == 304)
+			{
+				if (const TArray<FDreamAccountUser>* CachedUsers = ConditionalCache.HandleNotModified(CacheKey, Response))
+				{
+					// 回调可能修改缓存，先复制出结果
+					const TArray<FDreamAccountUser> Users = *CachedUsers;
+					CompleteUserLookupRequest(UserIDsToFetch, Users, EDreamAccountErrorType::NORMAL);
+					return;
+				}
+
+				// 条目在请求期间被淘汰，不带校验器重新请求
+				ConditionalCache.Remove(CacheKey);
+				SendUserLookupRequest(UserIDsToFetch);
+				return;
+			}
+
+			if (Response.ResponseCode != 200)
+			{
+				ConditionalCache.Remove(CacheKey);
+				CompleteUserLookupRequest(UserIDsToFetch, TArray<FDreamAccountUser>(), FDreamAccountUtil::ParseErrorTypeFromResponse(Response));
+				return;
+			}
+
+			const double ParseStartTime = FPlatformTime::Seconds();
+			TSharedPtr<FJsonObject> Json = FDreamAccountUtil::ParseJsonFromResponse(Response);
+			const TArray<FDreamAccountUser> Users = FDreamAccountUtil::ParseAccountUsersFromJson(Json);
+			ConditionalCache.Store(CacheKey, Response, Users, FPlatformTime::Seconds() - ParseStartTime);
+
+			CompleteUserLookupRequest(UserIDsToFetch, Users, EDreamAccountErrorType::NORMAL);
+		});
+}
+
+
+TArray<FDreamAccountShardStats> UDreamAccountSubsystem::GetShardStats()
+{
+	return FDreamAccountShardRouter::Get().GetStats();
+}
+
+
+TArray<FDreamAccountHedgeStats> UDreamAccountSubsystem::GetHedgeStats()
+{
+	return FDreamAccountRequestHedger::Get().GetStats();
+}
+
+
+TArray<FDreamAccountTimeoutStats> UDreamAccountSubsystem::GetTimeoutStats()
+{
+	return FDreamAccountTimeoutEstimator::Get().GetStats();
+}
+
+
+FDreamAccountDispatchStats UDreamAccountSubsystem::GetDispatchStats()
+{
+	return FDreamAccountCallbackDispatcher::Get().GetStats();
+}
+
+
+FDreamAccountLatencyBeaconStats UDreamAccountSubsystem::GetLatencyBeaconStats()
+{
+	return FDreamAccountLatencyBeacons::Get().GetStats();
+}
+
+
+FDreamAccountTracingStats UDreamAccountSubsystem::GetTracingStats()
+{
+	return FDreamAccountTracer::Get().GetStats();
+}
+
+
+FDreamAccountAdmissionStats UDreamAccountSubsystem::GetAdmissionStats()
+{
+	return FDreamAccountAdmissionController::Get().GetStats();
+}
+
+
+bool UDreamAccountSubsystem::IsUserBanned(int32 UserID)
+{
+	return FDreamAccountBanList::Get().IsBanned(UserID);
+}
+
+
+FDreamAccountBanListStats UDreamAccountSubsystem::GetBanListStats()
+{
+	return FDreamAccountBanList::Get().GetStats();
+}
+
+
+void UDreamAccountSubsystem::ClearUserCache()
+{
+	UserCache.Empty();
+	ConditionalCache.Empty();
+}
+
+
+FDreamAccountConditionalStats UDreamAccountSubsystem::GetConditionalStats() const
+{
+	return ConditionalCache.GetStats();
+}
+
+
+void UDreamAccountSubsystem::CompleteUserLookupRequest(const TArray<int32>& RequestedUserIDs, const TArray<FDreamAccountUser>& Users, EDreamAccountErrorType ErrorType)
+{
+	TMap<int32, const FDreamAccountUser*> UsersByID;
+	UsersByID.Reserve(Users.Num());
+	for (const FDreamAccountUser& User : Users)
+	{
+		UserCache.Add(User);
+		UsersByID.Add(User.UserID, &User);
+	}
+
+	TArray<TSharedRef<FPendingUserLookup>> Finished;
+	for (int32 UserID : RequestedUserIDs)
+	{
+		TArray<TSharedRef<FPendingUserLookup>> Waiters;
+		if (!InFlightUserLookups.RemoveAndCopyValue(UserID, Waiters))
+		{
+			continue;
+		}
+
+		const FDreamAccountUser* const* FoundUser = UsersByID.Find(UserID);
+		for (const TSharedRef<FPendingUserLookup>& Pending : Waiters)
+		{
+			if (FoundUser)
+			{
+				Pending->ResolvedUsers.Add(UserID, **FoundUser);
+			}
+			else if (ErrorType == EDreamAccountErrorType::NORMAL)
+			{
+				Pending->MissingUserIDs.Add(UserID);
+			}
+			else
+			{
+				Pending->ErrorType = ErrorType;
+			}
+
+			if (--Pending->OutstandingCount == 0)
+			{
+				Finished.Add(Pending);
+			}
+		}
+	}
+
+	for (const TSharedRef<FPendingUserLookup>& Pending : Finished)
+	{
+		FinishUserLookup(Pending);
+	}
+}
+
+
+void UDreamAccountSubsystem::FinishUserLookup(const TSharedRef<FPendingUserLookup>& Pending)
+{
+	FDreamAccountUserLookupResult Result(Pending->ErrorType);
+	Result.CacheHitCount = Pending->CacheHitCount;
+	Result.MissingUserIDs = MoveTemp(Pending->MissingUserIDs);
+	Result.Users.Reserve(Pending->ResolvedUsers.Num());
+	for (int32 UserID : Pending->UserIDs)
+	{
+		if (const FDreamAccountUser* User = Pending->ResolvedUsers.Find(UserID))
+		{
+			Result.Users.Add(*User);
+		}
+	}
+
+	Pending->Callback(Result);
+}
+
+
+void UDreamAccountSubsystem::ConnectPushChannel()
+{
+	const FDreamAccountSessionRef Session = GetSession();
+	if (!PushChannel.IsValid() || !Session->IsLoggedIn())
+	{
+		return;
+	}
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	FString URL = Settings ? Settings->PushChannelURL : FString();
+	if (URL.IsEmpty())
+	{
+		URL = FDreamAccountShardRouter::Get().RouteURL(API_PUSH, FDreamAccountShardRouter::HashUserName(Session->User.UserInfo.Name));
+		URL.ReplaceInline(TEXT("https://"), TEXT("wss://"));
+		URL.ReplaceInline(TEXT("http://"), TEXT("ws://"));
+	}
+
+	PushChannel->Connect(URL, Session->Token);
+}
+
+
+void UDreamAccountSubsystem::DisconnectPushChannel()
+{
+	if (PushChannel.IsValid())
+	{
+		PushChannel->Disconnect();
+	}
+}
+
+
+bool UDreamAccountSubsystem::IsPushChannelConnected() const
+{
+	return PushChannel.IsValid() && PushChannel->IsConnected();
+}
+
+
+void UDreamAccountSubsystem::HandlePushEvent(const FDreamAccountPushEvent& Event)
+{
+	if (Event.EventType == EDreamAccountPushEventType::Unknown)
+	{
+		return;
+	}
+
+	switch (Event.EventType)
+	{
+	case EDreamAccountPushEventType::UserBanned:
+		ClearSession(EDreamAccountSessionEventType::Banned);
+		break;
+	case EDreamAccountPushEventType::TokenRevoked:
+		ClearSession(EDreamAccountSessionEventType::Expired);
+		break;
+	default:
+		ClearSession(EDreamAccountSessionEventType::LoggedOut);
+		break;
+	}
+
+	OnPushEvent.Broadcast(Event);
+}
+
+
+bool UDreamAccountSubsystem::TickAuthPolling(float DeltaTime)
+{
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	if (!GetSession()->IsLoggedIn() || (Settings && Settings->bSuspendAuthPollingWhilePushConnected && IsPushChannelConnected()))
+	{
+		return true;
+	}
+
+	AuthenticationToken_Internal([this](const FDreamAccountResult& Result)
+	{
+		ClearSessionOnAuthError(Result.ErrorType);
+	});
+
+	return true;
+}
+
+
+void UDreamAccountSubsystem::UserLogout()
+{
+	LastDerivedCredential = FDerivedCredential();
+	ConditionalCache.Empty();
+	ClearToken();
+}
+
+
+void UDreamAccountSubsystem::ClearToken()
+{
+	ClearSession(EDreamAccountSessionEventType::LoggedOut);
+}
+
+
+void UDreamAccountSubsystem::ClearSession(EDreamAccountSessionEventType Reason)
+{
+	SetSession(FString(), FDreamAccountUser(), FDateTime::MaxValue(), Reason);
+}
+
+
+bool UDreamAccountSubsystem::ClearSessionOnAuthError(EDreamAccountErrorType ErrorType)
+{
+	switch (ErrorType)
+	{
+	case EDreamAccountErrorType::NETWORK_USER_BANNED:
+		ClearSession(EDreamAccountSessionEventType::Banned);
+		return true;
+	case EDreamAccountErrorType::NETWORK_INVALID_TOKEN:
+	case EDreamAccountErrorType::NETWORK_USER_NOT_FOUND:
+		ClearSession(EDreamAccountSessionEventType::Expired);
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+void UDreamAccountSubsystem::SetToken(FString NewToken)
+{
+	// 令牌未变化时保留已有的用户信息和过期时间
+	const FDreamAccountSessionRef Session = GetSession();
+	if (NewToken == Session->Token)
+	{
+		SetSession(MoveTemp(NewToken), Session->User, Session->ExpiresAt);
+	}
+	else
+	{
+		SetSession(MoveTemp(NewToken), FDreamAccountUser(), FDateTime::MaxValue());
+	}
+}
+
+
+void UDreamAccountSubsystem::SetSession(FString NewToken, FDreamAccountUser NewUser, FDateTime ExpiresAt, EDreamAccountSessionEventType ClearReason)
+{
+	const bool bLoggedIn = !NewToken.IsEmpty();
+	if (!bLoggedIn)
+	{
+		NewUser = FDreamAccountUser();
+		ExpiresAt = FDateTime::MaxValue();
+	}
+
+	// 没有任何变化时不发布，订阅者不会收到无意义的事件
+	const FDreamAccountSessionRef Previous = GetSession();
+	if (Previous->Token.Equals(NewToken, ESearchCase::CaseSensitive) && Previous->ExpiresAt == ExpiresAt
+		&& Previous->User.UserID == NewUser.UserID && Previous->User.UserInfo.Name == NewUser.UserInfo.Name)
+	{
+		return;
+	}
+
+	EDreamAccountSessionEventType EventType = ClearReason;
+	if (bLoggedIn)
+	{
+		EventType = Previous->IsLoggedIn() && Previous->User.UserID == NewUser.UserID
+			? EDreamAccountSessionEventType::Refreshed
+			: EDreamAccountSessionEventType::LoggedIn;
+	}
+
+	const FDreamAccountSessionRef Current = FDreamAccountSessionStore::Get().Publish(MoveTemp(NewToken), MoveTemp(NewUser), ExpiresAt);
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	if (Settings && Settings->bEnablePushChannel)
+	{
+		if (!bLoggedIn)
+		{
+			DisconnectPushChannel();
+		}
+		else
+		{
+			ConnectPushChannel();
+		}
+	}
+
+	FDreamAccountSessionEventBus::Get().Broadcast({EventType, Previous, Current});
+}
+
+
+void UDreamAccountSubsystem::BroadcastBlueprintSessionEvent(const FDreamAccountSessionEvent& Event)
+{
+	// 动态委托广播需要经过反射，没有蓝图绑定时直接跳过
+	if (OnSessionEvent.IsBound())
+	{
+		FDreamAccountSessionChange Change;
+		Change.EventType = Event.Type;
+		Change.PreviousUser = Event.Previous->User;
+		Change.CurrentUser = Event.Current->User;
+		Change.bIsLoggedIn = Event.Current->IsLoggedIn();
+		Change.bTokenChanged = Event.IsTokenChanged();
+		Change.ExpiresAt = Event.Current->ExpiresAt;
+		Change.Generation = static_cast<int64>(Event.Current->Generation);
+		OnSessionEvent.Broadcast(Change);
+	}
+
+	if (OnTokenChanged.IsBound())
+	{
+		OnTokenChanged.Broadcast();
+	}
 }
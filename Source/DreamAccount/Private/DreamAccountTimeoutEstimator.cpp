@@ -0,0 +1,150 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountTimeoutEstimator.h"
+
+#include "DreamAccountModule.h"
+#include "DreamAccountRequestHedger.h"
+#include "DreamAccountSettings.h"
+#include "DreamAccountTrafficRecorder.h"
+#include "HAL/IConsoleManager.h"
+
+namespace DreamAccountTimeouts
+{
+	/** 传输失败的耗时达到超时时间的该比例时视为超时 */
+	static constexpr double TimeoutDetectionRatio = 0.9;
+
+	static FAutoConsoleCommand CmdStats(
+		TEXT("DreamAccount.Timeouts.Stats"),
+		TEXT("输出各接口的平滑延迟、延迟偏差与当前使用的超时时间"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			for (const FDreamAccountTimeoutStats& Endpoint : FDreamAccountTimeoutEstimator::Get().GetStats())
+			{
+				UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount timeouts %s: Samples=%d Timeouts=%d SRTT=%.1fms RTTVAR=%.1fms Backoff=%d Timeout=%.1fms"),
+					*Endpoint.Endpoint, Endpoint.SampleCount, Endpoint.TimeoutCount, Endpoint.SmoothedLatencyMs,
+					Endpoint.LatencyVariationMs, Endpoint.BackoffCount, Endpoint.TimeoutMs);
+			}
+		}));
+
+	static FAutoConsoleCommand CmdReset(
+		TEXT("DreamAccount.Timeouts.Reset"),
+		TEXT("清空自适应超时的估计，恢复使用 TimeoutTime"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FDreamAccountTimeoutEstimator::Get().ResetStats();
+		}));
+}
+
+FDreamAccountTimeoutEstimator& FDreamAccountTimeoutEstimator::Get()
+{
+	static FDreamAccountTimeoutEstimator Instance;
+	return Instance;
+}
+
+FDreamAccountTimeoutEstimator::FDreamAccountTimeoutEstimator()
+{
+}
+
+bool FDreamAccountTimeoutEstimator::IsEnabled() const
+{
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	return Settings && Settings->bEnableAdaptiveTimeouts && !FDreamAccountTrafficRecorder::Get().IsReplaying();
+}
+
+double FDreamAccountTimeoutEstimator::GetTimeout(const FString& EndpointKey) const
+{
+	return ComputeTimeout(Endpoints.Find(EndpointKey));
+}
+
+void FDreamAccountTimeoutEstimator::HandleResponse(const FDreamAccountHttpRequest& Request, double TimeoutSeconds, const FDreamAccountHttpResponse& Response)
+{
+	// 被取消的请求（包括对冲中落败的一方）不反映接口的延迟
+	if (Request.Cancellation.IsValid() && Request.Cancellation->IsCancelled())
+	{
+		return;
+	}
+
+	if (Response.bSucceeded)
+	{
+		FEndpointState& Endpoint = Endpoints.FindOrAdd(FDreamAccountRequestHedger::GetEndpointKey(Request));
+		Endpoint.AddSample(Response.ElapsedSeconds);
+		return;
+	}
+
+	// 连接被拒绝等很快失败的请求不说明超时时间过短，只有等满超时时间的失败才退避
+	if (Response.ElapsedSeconds >= TimeoutSeconds * DreamAccountTimeouts::TimeoutDetectionRatio)
+	{
+		FEndpointState& Endpoint = Endpoints.FindOrAdd(FDreamAccountRequestHedger::GetEndpointKey(Request));
+		++Endpoint.TimeoutCount;
+		Endpoint.BackoffCount = FMath::Min(Endpoint.BackoffCount + 1, MaxBackoffCount);
+
+		UE_LOG(LogDreamAccount, Verbose, TEXT("DreamAccount timeouts: %s timed out after %.1fms, next timeout %.1fms"),
+			*Request.URL, Response.ElapsedSeconds * 1000.0, ComputeTimeout(&Endpoint) * 1000.0);
+	}
+}
+
+TArray<FDreamAccountTimeoutStats> FDreamAccountTimeoutEstimator::GetStats() const
+{
+	TArray<FDreamAccountTimeoutStats> Result;
+	for (const TPair<FString, FEndpointState>& Pair : Endpoints)
+	{
+		const FEndpointState& Endpoint = Pair.Value;
+		FDreamAccountTimeoutStats& Stats = Result.AddDefaulted_GetRef();
+		Stats.Endpoint = Pair.Key;
+		Stats.SampleCount = Endpoint.SampleCount;
+		Stats.TimeoutCount = Endpoint.TimeoutCount;
+		Stats.BackoffCount = Endpoint.BackoffCount;
+		Stats.SmoothedLatencyMs = static_cast<float>(Endpoint.SmoothedSeconds * 1000.0);
+		Stats.LatencyVariationMs = static_cast<float>(Endpoint.VariationSeconds * 1000.0);
+		Stats.TimeoutMs = static_cast<float>(ComputeTimeout(&Endpoint) * 1000.0);
+	}
+	return Result;
+}
+
+void FDreamAccountTimeoutEstimator::ResetStats()
+{
+	Endpoints.Empty();
+}
+
+double FDreamAccountTimeoutEstimator::ComputeTimeout(const FEndpointState* Endpoint)
+{
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	const double DefaultTimeout = Settings ? Settings->TimeoutTime : 5.0;
+	if (!Settings)
+	{
+		return DefaultTimeout;
+	}
+
+	const double MaxTimeout = FMath::Max(Settings->AdaptiveTimeoutMax, Settings->AdaptiveTimeoutMin);
+	double Timeout = DefaultTimeout;
+	if (Endpoint && Endpoint->SampleCount >= Settings->AdaptiveTimeoutMinSamples)
+	{
+		Timeout = Endpoint->SmoothedSeconds + FMath::Max(VarianceFactor * Endpoint->VariationSeconds, MinVarianceTerm);
+	}
+	Timeout = FMath::Clamp(Timeout, static_cast<double>(Settings->AdaptiveTimeoutMin), MaxTimeout);
+
+	if (Endpoint && Endpoint->BackoffCount > 0)
+	{
+		Timeout = FMath::Min(Timeout * static_cast<double>(1 << Endpoint->BackoffCount), MaxTimeout);
+	}
+	return Timeout;
+}
+
+void FDreamAccountTimeoutEstimator::FEndpointState::AddSample(double Seconds)
+{
+	Seconds = FMath::Max(Seconds, 0.0);
+	if (SampleCount == 0)
+	{
+		SmoothedSeconds = Seconds;
+		VariationSeconds = Seconds * 0.5;
+	}
+	else
+	{
+		// 先用旧的平滑延迟更新偏差，再更新平滑延迟（RFC 6298 2.3）
+		VariationSeconds = (1.0 - Beta) * VariationSeconds + Beta * FMath::Abs(SmoothedSeconds - Seconds);
+		SmoothedSeconds = (1.0 - Alpha) * SmoothedSeconds + Alpha * Seconds;
+	}
+
+	++SampleCount;
+	BackoffCount = 0;
+}
@@ -0,0 +1,470 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountTracing.h"
+
+#include "DreamAccountModule.h"
+#include "DreamAccountSettings.h"
+#include "DreamAccountUtil.h"
+#include "Async/Async.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace DreamAccountTracing
+{
+	/** OTLP 的 STATUS_CODE_ERROR */
+	static constexpr int32 StatusCodeError = 2;
+
+	TSharedRef<FJsonObject> MakeAttribute(const FString& Key, TSharedRef<FJsonObject> Value)
+	{
+		TSharedRef<FJsonObject> Attribute = MakeShared<FJsonObject>();
+		Attribute->SetStringField(TEXT("key"), Key);
+		Attribute->SetObjectField(TEXT("value"), Value);
+		return Attribute;
+	}
+
+	TSharedRef<FJsonObject> MakeStringAttribute(const FString& Key, const FString& Value)
+	{
+		TSharedRef<FJsonObject> JsonValue = MakeShared<FJsonObject>();
+		JsonValue->SetStringField(TEXT("stringValue"), Value);
+		return MakeAttribute(Key, JsonValue);
+	}
+
+	TSharedRef<FJsonObject> MakeIntAttribute(const FString& Key, int64 Value)
+	{
+		// OTLP JSON 中的 64 位整数以字符串表示
+		TSharedRef<FJsonObject> JsonValue = MakeShared<FJsonObject>();
+		JsonValue->SetStringField(TEXT("intValue"), LexToString(Value));
+		return MakeAttribute(Key, JsonValue);
+	}
+
+	static FAutoConsoleCommand CmdStats(
+		TEXT("DreamAccount.Tracing.Stats"),
+		TEXT("输出追踪的采样数、记录与导出的 span 数"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const FDreamAccountTracingStats Stats = FDreamAccountTracer::Get().GetStats();
+			UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount tracing: Enabled=%d Traces=%d Sampled=%d Spans=%d Dropped=%d Exported=%d ExportFailures=%d"),
+				FDreamAccountTracer::Get().IsEnabled(), Stats.StartedTraceCount, Stats.SampledTraceCount, Stats.RecordedSpanCount,
+				Stats.DroppedSpanCount, Stats.ExportedSpanCount, Stats.ExportFailureCount);
+		}));
+
+	static FAutoConsoleCommand CmdFlush(
+		TEXT("DreamAccount.Tracing.Flush"),
+		TEXT("立即导出缓冲区中的 span"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FDreamAccountTracer::Get().Flush();
+		}));
+}
+
+FDreamAccountTraceContext FDreamAccountTracer::CurrentContext;
+
+void FDreamAccountSpan::SetAttribute(const FString& Key, const FString& Value)
+{
+	if (Context.bSampled)
+	{
+		StringAttributes.Emplace(Key, Value);
+	}
+}
+
+void FDreamAccountSpan::SetAttribute(const FString& Key, int64 Value)
+{
+	if (Context.bSampled)
+	{
+		IntAttributes.Emplace(Key, Value);
+	}
+}
+
+FDreamAccountTracer& FDreamAccountTracer::Get()
+{
+	static FDreamAccountTracer Instance;
+	return Instance;
+}
+
+FDreamAccountTracer::FDreamAccountTracer()
+{
+}
+
+void FDreamAccountTracer::Start()
+{
+	Stop();
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	if (!Settings || !Settings->bEnableTracing)
+	{
+		return;
+	}
+
+	bEnabled = true;
+	SampleRate = FMath::Clamp(Settings->TraceSampleRate, 0.0f, 1.0f);
+	MaxBufferedSpans = FMath::Max(Settings->TraceMaxBufferedSpans, 16);
+	CollectorURL = Settings->TraceCollectorURL;
+
+	ExportFilePath = Settings->TraceExportFile;
+	if (!ExportFilePath.IsEmpty() && FPaths::IsRelative(ExportFilePath))
+	{
+		ExportFilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("DreamAccount"), TEXT("Spans"), ExportFilePath);
+	}
+
+	UnixTimeOffset = (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalSeconds() - FPlatformTime::Seconds();
+
+	if (!ExportFilePath.IsEmpty() || !CollectorURL.IsEmpty())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FDreamAccountTracer::Tick),
+			FMath::Max(Settings->TraceExportInterval, 1.0f));
+	}
+}
+
+void FDreamAccountTracer::Stop()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	Flush();
+	WriteExportFile(true);
+	PendingSpans.Empty();
+	bEnabled = false;
+}
+
+const FDreamAccountTraceContext& FDreamAccountTracer::GetCurrentContext()
+{
+	static const FDreamAccountTraceContext Empty;
+	return IsInGameThread() ? CurrentContext : Empty;
+}
+
+FDreamAccountTraceContext FDreamAccountTracer::StartTrace()
+{
+	const FDreamAccountTraceContext& Current = GetCurrentContext();
+	if (Current.IsValid())
+	{
+		return Current;
+	}
+
+	FDreamAccountTraceContext Context;
+	Context.TraceId = NewTraceId();
+	Context.bSampled = SampleRate > 0.0f && (SampleRate >= 1.0f || FMath::FRand() < SampleRate);
+
+	++StartedTraceCount;
+	if (Context.bSampled)
+	{
+		++SampledTraceCount;
+	}
+	return Context;
+}
+
+FDreamAccountSpan FDreamAccountTracer::BeginSpan(const FString& Name, const FDreamAccountTraceContext& Parent, int32 Kind)
+{
+	FDreamAccountSpan Span;
+	if (Parent.IsValid())
+	{
+		Span.Context.TraceId = Parent.TraceId;
+		Span.Context.bSampled = Parent.bSampled;
+		Span.ParentSpanId = Parent.SpanId;
+	}
+	else
+	{
+		FDreamAccountTraceScope RootScope(FDreamAccountTraceContext{});
+		Span.Context = StartTrace();
+	}
+	Span.Context.SpanId = NewSpanId();
+
+	// 未被采样的 span 只需要 ID 用于传播
+	if (Span.Context.bSampled)
+	{
+		Span.Name = Name;
+		Span.Kind = Kind;
+		Span.StartTime = FPlatformTime::Seconds();
+	}
+	return Span;
+}
+
+void FDreamAccountTracer::EndSpan(FDreamAccountSpan& Span)
+{
+	if (!Span.Context.bSampled || !bEnabled)
+	{
+		return;
+	}
+
+	if (Span.EndTime <= 0.0)
+	{
+		Span.EndTime = FPlatformTime::Seconds();
+	}
+
+	if (PendingSpans.Num() >= MaxBufferedSpans)
+	{
+		++DroppedSpanCount;
+		return;
+	}
+
+	++RecordedSpanCount;
+	PendingSpans.Add(MoveTemp(Span));
+}
+
+void FDreamAccountTracer::RecordSpan(const FString& Name, const FDreamAccountTraceContext& Parent, double StartTime, double EndTime)
+{
+	if (!Parent.bSampled || !bEnabled)
+	{
+		return;
+	}
+
+	FDreamAccountSpan Span = BeginSpan(Name, Parent);
+	Span.StartTime = StartTime;
+	Span.EndTime = EndTime;
+	EndSpan(Span);
+}
+
+void FDreamAccountTracer::Flush()
+{
+	if (PendingSpans.Num() == 0)
+	{
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(DreamAccount);
+
+	TArray<FDreamAccountSpan> Spans = MoveTemp(PendingSpans);
+	PendingSpans.Reset();
+
+	const FString ExportRequest = BuildExportRequest(Spans);
+	ExportedSpanCount += Spans.Num();
+
+	if (!ExportFilePath.IsEmpty())
+	{
+		// OTLP JSON 文件格式：每行一个 ExportTraceServiceRequest
+		PendingFileContent += ExportRequest;
+		PendingFileContent += TEXT("\n");
+		WriteExportFile(false);
+	}
+
+	if (!CollectorURL.IsEmpty())
+	{
+		FDreamAccountHttpRequest Request;
+		Request.URL = CollectorURL;
+		Request.Verb = TEXT("POST");
+		Request.Content = ExportRequest;
+		Request.Headers.Add(TEXT("Content-Type"), TEXT("application/json"));
+
+		// 直接发送，导出本身不产生追踪，也不经过网络模拟
+		FDreamAccountUtil::SendPlatformHttpRequest(Request, [](const FDreamAccountHttpResponse& Response)
+		{
+			if (!Response.bSucceeded || Response.ResponseCode < 200 || Response.ResponseCode >= 300)
+			{
+				++FDreamAccountTracer::Get().ExportFailureCount;
+				UE_LOG(LogDreamAccount, Verbose, TEXT("DreamAccount tracing: collector rejected spans (%d)"), Response.ResponseCode);
+			}
+		});
+	}
+}
+
+FDreamAccountTracingStats FDreamAccountTracer::GetStats() const
+{
+	FDreamAccountTracingStats Stats;
+	Stats.StartedTraceCount = StartedTraceCount;
+	Stats.SampledTraceCount = SampledTraceCount;
+	Stats.RecordedSpanCount = RecordedSpanCount;
+	Stats.DroppedSpanCount = DroppedSpanCount;
+	Stats.ExportedSpanCount = ExportedSpanCount;
+	Stats.ExportFailureCount = ExportFailureCount;
+	return Stats;
+}
+
+void FDreamAccountTracer::ResetStats()
+{
+	StartedTraceCount = 0;
+	SampledTraceCount = 0;
+	RecordedSpanCount = 0;
+	DroppedSpanCount = 0;
+	ExportedSpanCount = 0;
+	ExportFailureCount = 0;
+}
+
+bool FDreamAccountTracer::Tick(float DeltaTime)
+{
+	Flush();
+
+	// 上一次写文件未完成时积累的内容在这里补写
+	WriteExportFile(false);
+	return true;
+}
+
+void FDreamAccountTracer::WriteExportFile(bool bWait)
+{
+	if (FileWrite.IsValid())
+	{
+		if (!bWait && !FileWrite.IsReady())
+		{
+			return;
+		}
+
+		if (!FileWrite.Get())
+		{
+			++ExportFailureCount;
+			UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount tracing: failed to write spans to %s"), *ExportFilePath);
+		}
+		FileWrite.Reset();
+	}
+
+	if (PendingFileContent.IsEmpty())
+	{
+		return;
+	}
+
+	FileWrite = Async(EAsyncExecution::ThreadPool, [FilePath = ExportFilePath, Content = MoveTemp(PendingFileContent)]()
+	{
+		return FFileHelper::SaveStringToFile(Content, *FilePath,
+			FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append);
+	});
+	PendingFileContent.Reset();
+
+	if (bWait)
+	{
+		WriteExportFile(true);
+	}
+}
+
+FString FDreamAccountTracer::BuildExportRequest(const TArray<FDreamAccountSpan>& Spans) const
+{
+	using namespace DreamAccountTracing;
+
+	TArray<TSharedPtr<FJsonValue>> SpanValues;
+	SpanValues.Reserve(Spans.Num());
+	for (const FDreamAccountSpan& Span : Spans)
+	{
+		TSharedRef<FJsonObject> SpanJson = MakeShared<FJsonObject>();
+		SpanJson->SetStringField(TEXT("traceId"), Span.Context.TraceId);
+		SpanJson->SetStringField(TEXT("spanId"), Span.Context.SpanId);
+		if (!Span.ParentSpanId.IsEmpty())
+		{
+			SpanJson->SetStringField(TEXT("parentSpanId"), Span.ParentSpanId);
+		}
+		SpanJson->SetStringField(TEXT("name"), Span.Name);
+		SpanJson->SetNumberField(TEXT("kind"), Span.Kind);
+		SpanJson->SetStringField(TEXT("startTimeUnixNano"), ToUnixNanos(Span.StartTime));
+		SpanJson->SetStringField(TEXT("endTimeUnixNano"), ToUnixNanos(Span.EndTime));
+
+		TArray<TSharedPtr<FJsonValue>> Attributes;
+		for (const TPair<FString, FString>& Attribute : Span.StringAttributes)
+		{
+			Attributes.Add(MakeShared<FJsonValueObject>(MakeStringAttribute(Attribute.Key, Attribute.Value)));
+		}
+		for (const TPair<FString, int64>& Attribute : Span.IntAttributes)
+		{
+			Attributes.Add(MakeShared<FJsonValueObject>(MakeIntAttribute(Attribute.Key, Attribute.Value)));
+		}
+		if (Attributes.Num() > 0)
+		{
+			SpanJson->SetArrayField(TEXT("attributes"), Attributes);
+		}
+
+		if (Span.bError)
+		{
+			TSharedRef<FJsonObject> Status = MakeShared<FJsonObject>();
+			Status->SetNumberField(TEXT("code"), StatusCodeError);
+			SpanJson->SetObjectField(TEXT("status"), Status);
+		}
+
+		SpanValues.Add(MakeShared<FJsonValueObject>(SpanJson));
+	}
+
+	TSharedRef<FJsonObject> Scope = MakeShared<FJsonObject>();
+	Scope->SetStringField(TEXT("name"), TEXT("DreamAccount"));
+
+	TSharedRef<FJsonObject> ScopeSpans = MakeShared<FJsonObject>();
+	ScopeSpans->SetObjectField(TEXT("scope"), Scope);
+	ScopeSpans->SetArrayField(TEXT("spans"), SpanValues);
+
+	TArray<TSharedPtr<FJsonValue>> ResourceAttributes;
+	ResourceAttributes.Add(MakeShared<FJsonValueObject>(MakeStringAttribute(TEXT("service.name"), FApp::GetProjectName())));
+	ResourceAttributes.Add(MakeShared<FJsonValueObject>(MakeStringAttribute(TEXT("os.type"), FPlatformProperties::IniPlatformName())));
+
+	TSharedRef<FJsonObject> Resource = MakeShared<FJsonObject>();
+	Resource->SetArrayField(TEXT("attributes"), ResourceAttributes);
+
+	TArray<TSharedPtr<FJsonValue>> ScopeSpansValues;
+	ScopeSpansValues.Add(MakeShared<FJsonValueObject>(ScopeSpans));
+
+	TSharedRef<FJsonObject> ResourceSpans = MakeShared<FJsonObject>();
+	ResourceSpans->SetObjectField(TEXT("resource"), Resource);
+	ResourceSpans->SetArrayField(TEXT("scopeSpans"), ScopeSpansValues);
+
+	TArray<TSharedPtr<FJsonValue>> ResourceSpansValues;
+	ResourceSpansValues.Add(MakeShared<FJsonValueObject>(ResourceSpans));
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetArrayField(TEXT("resourceSpans"), ResourceSpansValues);
+
+	FString Content;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Content);
+	FJsonSerializer::Serialize(Json, Writer);
+	return Content;
+}
+
+FString FDreamAccountTracer::ToUnixNanos(double PlatformSeconds) const
+{
+	const double UnixSeconds = PlatformSeconds + UnixTimeOffset;
+	const int64 WholeSeconds = FMath::FloorToInt64(UnixSeconds);
+	const int64 Nanos = WholeSeconds * 1000000000LL + FMath::RoundToInt64((UnixSeconds - WholeSeconds) * 1.0e9);
+	return LexToString(Nanos);
+}
+
+FString FDreamAccountTracer::NewTraceId()
+{
+	return FGuid::NewGuid().ToString(EGuidFormats::Digits).ToLower();
+}
+
+FString FDreamAccountTracer::NewSpanId()
+{
+	const FGuid Guid = FGuid::NewGuid();
+	return FString::Printf(TEXT("%08x%08x"), Guid.A, Guid.B);
+}
+
+FDreamAccountTraceScope::FDreamAccountTraceScope(const FDreamAccountTraceContext& Context)
+	: bActive(IsInGameThread())
+{
+	if (bActive)
+	{
+		Previous = MoveTemp(FDreamAccountTracer::CurrentContext);
+		FDreamAccountTracer::CurrentContext = Context;
+	}
+}
+
+FDreamAccountTraceScope::~FDreamAccountTraceScope()
+{
+	if (bActive)
+	{
+		FDreamAccountTracer::CurrentContext = MoveTemp(Previous);
+	}
+}
+
+FDreamAccountScopedSpan::FDreamAccountScopedSpan(const TCHAR* Name)
+	: FDreamAccountScopedSpan(Name, FDreamAccountTracer::GetCurrentContext())
+{
+}
+
+FDreamAccountScopedSpan::FDreamAccountScopedSpan(const TCHAR* Name, const FDreamAccountTraceContext& Parent)
+{
+	FDreamAccountTracer& Tracer = FDreamAccountTracer::Get();
+	if (Parent.bSampled && Tracer.IsEnabled() && IsInGameThread())
+	{
+		Span.Emplace(Tracer.BeginSpan(Name, Parent));
+		Scope.Emplace(Span->Context);
+	}
+}
+
+FDreamAccountScopedSpan::~FDreamAccountScopedSpan()
+{
+	Scope.Reset();
+	if (Span.IsSet())
+	{
+		FDreamAccountTracer::Get().EndSpan(Span.GetValue());
+	}
+}
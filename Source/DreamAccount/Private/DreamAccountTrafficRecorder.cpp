@@ -0,0 +1,359 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountTrafficRecorder.h"
+
+#include "DreamAccountModule.h"
+#include "DreamAccountNetworkSimulator.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace DreamAccountTrace
+{
+	/** 文件头标识 "DATR" */
+	static constexpr uint32 Magic = 0x52544144;
+	static constexpr uint32 Version = 1;
+
+	static FAutoConsoleCommand CmdRecord(
+		TEXT("DreamAccount.Trace.Record"),
+		TEXT("开始录制账号请求：DreamAccount.Trace.Record <File>"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const FString FileName = Args.Num() > 0 ? Args[0] : FDateTime::Now().ToString() + TEXT(".datrace");
+			FDreamAccountTrafficRecorder::Get().StartRecording(FileName);
+		}));
+
+	static FAutoConsoleCommand CmdReplay(
+		TEXT("DreamAccount.Trace.Replay"),
+		TEXT("回放账号请求录制：DreamAccount.Trace.Replay <File> [Speed]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			if (Args.Num() == 0)
+			{
+				UE_LOG(LogDreamAccount, Warning, TEXT("Usage: DreamAccount.Trace.Replay <File> [Speed]"));
+				return;
+			}
+			FDreamAccountTrafficRecorder::Get().StartReplay(Args[0], Args.Num() > 1 ? FCString::Atof(*Args[1]) : 1.0f);
+		}));
+
+	static FAutoConsoleCommand CmdStop(
+		TEXT("DreamAccount.Trace.Stop"),
+		TEXT("停止录制（写入文件）或回放"),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			FDreamAccountTrafficRecorder& Recorder = FDreamAccountTrafficRecorder::Get();
+			if (Recorder.IsRecording())
+			{
+				Recorder.StopRecording();
+			}
+			if (Recorder.IsReplaying())
+			{
+				Recorder.StopReplay();
+			}
+		}));
+}
+
+FArchive& operator<<(FArchive& Ar, FDreamAccountTraceEntry& Entry)
+{
+	uint8 bSucceeded = Entry.bSucceeded ? 1 : 0;
+	int16 ResponseCode = static_cast<int16>(Entry.ResponseCode);
+
+	Ar << Entry.StartOffsetSeconds;
+	Ar << Entry.ElapsedSeconds;
+	Ar << Entry.Verb;
+	Ar << Entry.Path;
+	Ar << Entry.RequestContentCrc;
+	Ar << bSucceeded;
+	Ar << ResponseCode;
+	Ar << Entry.ResponseContent;
+	Ar << Entry.ResponseHeaders;
+
+	if (Ar.IsLoading())
+	{
+		Entry.bSucceeded = bSucceeded != 0;
+		Entry.ResponseCode = ResponseCode;
+	}
+
+	return Ar;
+}
+
+FDreamAccountTrafficRecorder& FDreamAccountTrafficRecorder::Get()
+{
+	static FDreamAccountTrafficRecorder Instance;
+	return Instance;
+}
+
+void FDreamAccountTrafficRecorder::StartRecording(const FString& FilePath)
+{
+	if (bRecording)
+	{
+		StopRecording();
+	}
+	StopReplay();
+
+	bRecording = true;
+	RecordingPath = ResolveTracePath(FilePath);
+	RecordingStartTime = FPlatformTime::Seconds();
+	RecordedEntries.Reset();
+
+	UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount trace recording started: %s"), *RecordingPath);
+}
+
+bool FDreamAccountTrafficRecorder::StopRecording()
+{
+	if (!bRecording)
+	{
+		return false;
+	}
+
+	bRecording = false;
+	const bool bSaved = SaveTrace(RecordingPath, RecordedEntries);
+
+	UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount trace recording stopped: %d requests -> %s (%s)"),
+		RecordedEntries.Num(), *RecordingPath, bSaved ? TEXT("saved") : TEXT("failed"));
+
+	RecordedEntries.Empty();
+	return bSaved;
+}
+
+bool FDreamAccountTrafficRecorder::StartReplay(const FString& FilePath, float Speed)
+{
+	if (bRecording)
+	{
+		StopRecording();
+	}
+	StopReplay();
+
+	const FString ResolvedPath = ResolveTracePath(FilePath);
+	if (!LoadTrace(ResolvedPath, ReplayEntries))
+	{
+		UE_LOG(LogDreamAccount, Error, TEXT("DreamAccount trace replay failed to load: %s"), *ResolvedPath);
+		return false;
+	}
+
+	for (int32 Index = 0; Index < ReplayEntries.Num(); ++Index)
+	{
+		const FDreamAccountTraceEntry& Entry = ReplayEntries[Index];
+		ReplayQueues.FindOrAdd(MakeMatchKey(Entry.Verb, Entry.Path)).EntryIndices.Add(Index);
+	}
+	ConsumedEntries.Init(false, ReplayEntries.Num());
+
+	bReplaying = true;
+	ReplaySpeed = FMath::Max(Speed, 0.0f);
+
+	UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount trace replay started: %d requests from %s at %.2fx"),
+		ReplayEntries.Num(), *ResolvedPath, ReplaySpeed);
+	return true;
+}
+
+void FDreamAccountTrafficRecorder::StopReplay()
+{
+	if (bReplaying)
+	{
+		UE_LOG(LogDreamAccount, Display, TEXT("DreamAccount trace replay stopped: replayed=%d unmatched=%d remaining=%d"),
+			ReplayedCount, UnmatchedCount, GetRemainingCount());
+	}
+
+	bReplaying = false;
+	ReplayEntries.Empty();
+	ReplayQueues.Empty();
+	ConsumedEntries.Empty();
+	ReplayedCount = 0;
+	UnmatchedCount = 0;
+}
+
+void FDreamAccountTrafficRecorder::RecordExchange(const FDreamAccountHttpRequest& Request, double StartTime, const FDreamAccountHttpResponse& Response)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+
+	FDreamAccountTraceEntry& Entry = RecordedEntries.AddDefaulted_GetRef();
+	Entry.StartOffsetSeconds = StartTime - RecordingStartTime;
+	Entry.ElapsedSeconds = static_cast<float>(Response.ElapsedSeconds);
+	Entry.Verb = Request.Verb;
+	Entry.Path = Request.GetPath();
+	Entry.RequestContentCrc = FCrc::StrCrc32(*Request.Content);
+	Entry.bSucceeded = Response.bSucceeded;
+	Entry.ResponseCode = Response.ResponseCode;
+	Entry.ResponseContent = Response.Content;
+	Entry.ResponseHeaders = Response.Headers;
+}
+
+void FDreamAccountTrafficRecorder::ReplayRequest(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& OnComplete)
+{
+	FReplayQueue* Queue = ReplayQueues.Find(MakeMatchKey(Request.Verb, Request.GetPath()));
+	const uint32 ContentCrc = FCrc::StrCrc32(*Request.Content);
+
+	// 优先取请求体相同的最早一条，交错进行的不同用户的请求各自拿到自己的响应；没有时按录制顺序取下一条
+	int32 EntryIndex = INDEX_NONE;
+	bool bContentMatched = false;
+	if (Queue)
+	{
+		for (int32 Slot = Queue->Cursor; Slot < Queue->EntryIndices.Num(); ++Slot)
+		{
+			const int32 Candidate = Queue->EntryIndices[Slot];
+			if (ConsumedEntries[Candidate])
+			{
+				continue;
+			}
+
+			if (EntryIndex == INDEX_NONE)
+			{
+				EntryIndex = Candidate;
+			}
+
+			if (ReplayEntries[Candidate].RequestContentCrc == ContentCrc)
+			{
+				EntryIndex = Candidate;
+				bContentMatched = true;
+				break;
+			}
+		}
+	}
+
+	if (EntryIndex == INDEX_NONE)
+	{
+		++UnmatchedCount;
+		UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount trace replay has no recorded response for %s %s"), *Request.Verb, *Request.URL);
+
+		FDreamAccountNetworkSimulator::ExecuteAfter(0.0, [OnComplete]()
+		{
+			OnComplete(FDreamAccountHttpResponse::MakeFailure());
+		});
+		return;
+	}
+
+	ConsumedEntries[EntryIndex] = true;
+	while (Queue->Cursor < Queue->EntryIndices.Num() && ConsumedEntries[Queue->EntryIndices[Queue->Cursor]])
+	{
+		++Queue->Cursor;
+	}
+
+	if (!bContentMatched)
+	{
+		++UnmatchedCount;
+		UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount trace replay has no recorded request with the same body for %s %s, replaying the next one in order"),
+			*Request.Verb, *Request.URL);
+	}
+
+	const FDreamAccountTraceEntry& Entry = ReplayEntries[EntryIndex];
+	++ReplayedCount;
+
+	FDreamAccountHttpResponse Response;
+	Response.bSucceeded = Entry.bSucceeded;
+	Response.ResponseCode = Entry.ResponseCode;
+	Response.Content = Entry.ResponseContent;
+	Response.Headers = Entry.ResponseHeaders;
+	Response.ElapsedSeconds = Entry.ElapsedSeconds;
+
+	const double DelaySeconds = ReplaySpeed > 0.0f ? Entry.ElapsedSeconds / ReplaySpeed : 0.0;
+	FDreamAccountNetworkSimulator::ExecuteAfter(DelaySeconds, [Response = MoveTemp(Response), OnComplete]()
+	{
+		OnComplete(Response);
+	});
+}
+
+int32 FDreamAccountTrafficRecorder::GetRemainingCount() const
+{
+	return ConsumedEntries.Num() - ConsumedEntries.CountSetBits();
+}
+
+bool FDreamAccountTrafficRecorder::SaveTrace(const FString& FilePath, const TArray<FDreamAccountTraceEntry>& Entries)
+{
+	TArray<uint8> Payload;
+	FMemoryWriter PayloadWriter(Payload);
+	int32 Count = Entries.Num();
+	PayloadWriter << Count;
+	for (const FDreamAccountTraceEntry& Entry : Entries)
+	{
+		PayloadWriter << const_cast<FDreamAccountTraceEntry&>(Entry);
+	}
+
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Payload.Num());
+	TArray<uint8> Compressed;
+	Compressed.SetNumUninitialized(CompressedSize);
+	if (!FCompression::CompressMemory(NAME_Zlib, Compressed.GetData(), CompressedSize, Payload.GetData(), Payload.Num()))
+	{
+		return false;
+	}
+	Compressed.SetNum(CompressedSize);
+
+	TArray<uint8> FileData;
+	FMemoryWriter FileWriter(FileData);
+	uint32 Magic = DreamAccountTrace::Magic;
+	uint32 Version = DreamAccountTrace::Version;
+	int32 UncompressedSize = Payload.Num();
+	FileWriter << Magic;
+	FileWriter << Version;
+	FileWriter << UncompressedSize;
+	FileWriter.Serialize(Compressed.GetData(), Compressed.Num());
+
+	return FFileHelper::SaveArrayToFile(FileData, *FilePath);
+}
+
+bool FDreamAccountTrafficRecorder::LoadTrace(const FString& FilePath, TArray<FDreamAccountTraceEntry>& OutEntries)
+{
+	OutEntries.Reset();
+
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath))
+	{
+		return false;
+	}
+
+	FMemoryReader FileReader(FileData);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 UncompressedSize = 0;
+	FileReader << Magic;
+	FileReader << Version;
+	FileReader << UncompressedSize;
+
+	if (FileReader.IsError() || Magic != DreamAccountTrace::Magic || Version != DreamAccountTrace::Version || UncompressedSize < 0)
+	{
+		return false;
+	}
+
+	const int64 HeaderSize = FileReader.Tell();
+	TArray<uint8> Payload;
+	Payload.SetNumUninitialized(UncompressedSize);
+	if (!FCompression::UncompressMemory(NAME_Zlib, Payload.GetData(), UncompressedSize, FileData.GetData() + HeaderSize, static_cast<int32>(FileData.Num() - HeaderSize)))
+	{
+		return false;
+	}
+
+	FMemoryReader PayloadReader(Payload);
+	int32 Count = 0;
+	PayloadReader << Count;
+	if (Count < 0)
+	{
+		return false;
+	}
+
+	OutEntries.SetNum(Count);
+	for (FDreamAccountTraceEntry& Entry : OutEntries)
+	{
+		PayloadReader << Entry;
+	}
+
+	return !PayloadReader.IsError();
+}
+
+FString FDreamAccountTrafficRecorder::ResolveTracePath(const FString& FilePath)
+{
+	if (FPaths::IsRelative(FilePath))
+	{
+		return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("DreamAccount"), TEXT("Traces"), FilePath);
+	}
+	return FilePath;
+}
+
+FString FDreamAccountTrafficRecorder::MakeMatchKey(const FString& Verb, const FString& Path)
+{
+	return Verb.ToUpper() + TEXT(" ") + Path;
+}
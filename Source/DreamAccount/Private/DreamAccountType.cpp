@@ -2,20 +2,34 @@
 
 #include "DreamAccountTypes.h"
 #include "DreamAccountUtil.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
 
 FString FDreamAccountInfo::Serialize() const
 {
-	TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject);
-	JsonObject->SetStringField(FDreamAccountFields::FIELD_USER_NAME, Name);
-	JsonObject->SetStringField(FDreamAccountFields::FIELD_USER_PASSWORD, Password);
-
 	FString JsonString;
-	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
-	FJsonSerializer::Serialize(JsonObject.ToSharedRef(), Writer);
-
+	SerializeTo(JsonString);
 	return JsonString;
 }
 
+void FDreamAccountInfo::SerializeTo(FString& OutJsonString, const FString* PasswordOverride, const TCHAR* KdfAlgorithm) const
+{
+	const FString& PasswordValue = PasswordOverride ? *PasswordOverride : Password;
+
+	// 直接写出字段，不构造中间的 FJsonObject；预留转义前的长度，通常只需一次分配
+	OutJsonString.Reset(Name.Len() + PasswordValue.Len() + 64);
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&OutJsonString);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(FDreamAccountFields::FIELD_USER_NAME, Name);
+	Writer->WriteValue(FDreamAccountFields::FIELD_USER_PASSWORD, PasswordValue);
+	if (KdfAlgorithm)
+	{
+		Writer->WriteValue(FDreamAccountFields::FIELD_PASSWORD_KDF, FString(KdfAlgorithm));
+	}
+	Writer->WriteObjectEnd();
+	Writer->Close();
+}
+
 FDreamAccountUser::FDreamAccountUser(const TSharedRef<FJsonObject>& InUserJsonObject)
 {
 	FString JsonUserName;
@@ -0,0 +1,160 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountUserCache.h"
+
+FDreamAccountUserCache::FDreamAccountUserCache()
+{
+}
+
+FDreamAccountUserCache::~FDreamAccountUserCache()
+{
+	Empty();
+}
+
+void FDreamAccountUserCache::Configure(int32 InMaxEntries, int64 InMaxMemoryBytes, double InTimeToLiveSeconds)
+{
+	MaxEntries = InMaxEntries;
+	MaxMemoryBytes = InMaxMemoryBytes;
+	TimeToLiveSeconds = InTimeToLiveSeconds;
+
+	EvictToLimits();
+}
+
+bool FDreamAccountUserCache::Find(int32 UserID, FDreamAccountUser& OutUser)
+{
+	TUniquePtr<FEntry>* Found = Entries.Find(UserID);
+	if (!Found)
+	{
+		++MissCount;
+		return false;
+	}
+
+	FEntry* Entry = Found->Get();
+	if (TimeToLiveSeconds > 0.0 && FPlatformTime::Seconds() >= Entry->ExpireTime)
+	{
+		RemoveEntry(Entry);
+		++MissCount;
+		return false;
+	}
+
+	Unlink(Entry);
+	LinkHead(Entry);
+
+	OutUser = Entry->User;
+	++HitCount;
+	return true;
+}
+
+void FDreamAccountUserCache::Add(const FDreamAccountUser& User)
+{
+	if (MaxEntries <= 0)
+	{
+		return;
+	}
+
+	FEntry* Entry;
+	if (TUniquePtr<FEntry>* Found = Entries.Find(User.UserID))
+	{
+		Entry = Found->Get();
+		Unlink(Entry);
+		MemoryBytes -= Entry->Bytes;
+	}
+	else
+	{
+		Entry = Entries.Add(User.UserID, MakeUnique<FEntry>()).Get();
+	}
+
+	Entry->User = User;
+	Entry->ExpireTime = FPlatformTime::Seconds() + TimeToLiveSeconds;
+	Entry->Bytes = EstimateBytes(User);
+	MemoryBytes += Entry->Bytes;
+	LinkHead(Entry);
+
+	EvictToLimits();
+}
+
+void FDreamAccountUserCache::Remove(int32 UserID)
+{
+	if (TUniquePtr<FEntry>* Found = Entries.Find(UserID))
+	{
+		RemoveEntry(Found->Get());
+	}
+}
+
+void FDreamAccountUserCache::Empty()
+{
+	Entries.Empty();
+	Head = nullptr;
+	Tail = nullptr;
+	MemoryBytes = 0;
+}
+
+int64 FDreamAccountUserCache::EstimateBytes(const FDreamAccountUser& User)
+{
+	// 条目本体 + Map 槽位 + 字符串堆内存
+	return sizeof(FEntry)
+		+ sizeof(TPair<int32, TUniquePtr<FEntry>>)
+		+ User.UserInfo.Name.GetAllocatedSize()
+		+ User.UserInfo.Password.GetAllocatedSize();
+}
+
+void FDreamAccountUserCache::LinkHead(FEntry* Entry)
+{
+	Entry->Prev = nullptr;
+	Entry->Next = Head;
+	if (Head)
+	{
+		Head->Prev = Entry;
+	}
+	Head = Entry;
+	if (!Tail)
+	{
+		Tail = Entry;
+	}
+}
+
+void FDreamAccountUserCache::Unlink(FEntry* Entry)
+{
+	if (Entry->Prev)
+	{
+		Entry->Prev->Next = Entry->Next;
+	}
+	else
+	{
+		Head = Entry->Next;
+	}
+
+	if (Entry->Next)
+	{
+		Entry->Next->Prev = Entry->Prev;
+	}
+	else
+	{
+		Tail = Entry->Prev;
+	}
+
+	Entry->Prev = nullptr;
+	Entry->Next = nullptr;
+}
+
+void FDreamAccountUserCache::RemoveEntry(FEntry* Entry)
+{
+	Unlink(Entry);
+	MemoryBytes -= Entry->Bytes;
+	Entries.Remove(Entry->User.UserID);
+}
+
+void FDreamAccountUserCache::EvictToLimits()
+{
+	if (MaxEntries <= 0)
+	{
+		Empty();
+		return;
+	}
+
+	while (Tail && (Entries.Num() > MaxEntries || (MaxMemoryBytes > 0 && MemoryBytes > MaxMemoryBytes)))
+	{
+		RemoveEntry(Tail);
+		++EvictionCount;
+	}
+}
@@ -0,0 +1,284 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountUsernameChecker.h"
+
+#include "DreamAccountShardRouter.h"
+#include "DreamAccountUtil.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+
+using namespace FDreamAccountFields;
+
+FDreamAccountUsernameChecker::FDreamAccountUsernameChecker()
+{
+}
+
+FDreamAccountUsernameChecker::~FDreamAccountUsernameChecker()
+{
+	CancelAll();
+}
+
+void FDreamAccountUsernameChecker::Configure(double InDebounceSeconds, double InTakenTimeToLive, double InAvailableTimeToLive)
+{
+	DebounceSeconds = InDebounceSeconds;
+	TakenTimeToLive = InTakenTimeToLive;
+	AvailableTimeToLive = InAvailableTimeToLive;
+}
+
+void FDreamAccountUsernameChecker::Check(FName FieldKey, const FString& UserName, FDreamAccountUsernameCheckCallback Callback)
+{
+	FFieldState& State = Fields.FindOrAdd(FieldKey);
+	FDreamAccountUsernameCheckCallback Superseded = TakePending(State);
+	const FString SupersededName = State.UserName;
+
+	// 结果可以立即给出时不进入防抖
+	FDreamAccountUsernameCheckResult ImmediateResult;
+	bool bCachedAvailable = false;
+	if (UserName.IsEmpty())
+	{
+		ImmediateResult = FDreamAccountUsernameCheckResult(EDreamAccountErrorType::LOCAL_INPUT_DATA_NOT_VALID, UserName);
+	}
+	else if (FindCached(UserName, bCachedAvailable))
+	{
+		++CacheHitCount;
+		ImmediateResult = FDreamAccountUsernameCheckResult(EDreamAccountErrorType::NORMAL, UserName);
+		ImmediateResult.bAvailable = bCachedAvailable;
+		ImmediateResult.bFromCache = true;
+	}
+	else
+	{
+		State.UserName = UserName;
+		State.Callback = MoveTemp(Callback);
+
+		const uint32 Serial = State.Serial;
+		if (DebounceSeconds > 0.0)
+		{
+			State.DebounceHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this, FieldKey, Serial](float)
+			{
+				SendCheck(FieldKey, Serial);
+				return false;
+			}), static_cast<float>(DebounceSeconds));
+		}
+		else
+		{
+			SendCheck(FieldKey, Serial);
+		}
+	}
+
+	// 回调放在最后，回调中再次调用 Check 也不会影响上面的状态
+	if (Superseded)
+	{
+		Superseded(FDreamAccountUsernameCheckResult(EDreamAccountErrorType::LOCAL_REQUEST_CANCELLED, SupersededName));
+	}
+
+	if (ImmediateResult.bIsValidResult)
+	{
+		Callback(ImmediateResult);
+	}
+}
+
+void FDreamAccountUsernameChecker::Cancel(FName FieldKey)
+{
+	FFieldState* State = Fields.Find(FieldKey);
+	if (!State)
+	{
+		return;
+	}
+
+	const FString UserName = State->UserName;
+	FDreamAccountUsernameCheckCallback Superseded = TakePending(*State);
+	if (Superseded)
+	{
+		Superseded(FDreamAccountUsernameCheckResult(EDreamAccountErrorType::LOCAL_REQUEST_CANCELLED, UserName));
+	}
+}
+
+void FDreamAccountUsernameChecker::CancelAll()
+{
+	TArray<FName> FieldKeys;
+	Fields.GetKeys(FieldKeys);
+	for (const FName& FieldKey : FieldKeys)
+	{
+		Cancel(FieldKey);
+	}
+	Fields.Empty();
+}
+
+bool FDreamAccountUsernameChecker::FindCached(const FString& UserName, bool& bOutAvailable) const
+{
+	const FCacheEntry* Entry = Cache.Find(UserName);
+	if (!Entry || FPlatformTime::Seconds() >= Entry->ExpireTime)
+	{
+		return false;
+	}
+
+	bOutAvailable = Entry->bAvailable;
+	return true;
+}
+
+void FDreamAccountUsernameChecker::MarkTaken(const FString& UserName)
+{
+	if (!UserName.IsEmpty())
+	{
+		AddCacheEntry(UserName, false, FPlatformTime::Seconds());
+	}
+}
+
+void FDreamAccountUsernameChecker::Empty()
+{
+	Cache.Empty();
+}
+
+FDreamAccountUsernameCheckCallback FDreamAccountUsernameChecker::TakePending(FFieldState& State)
+{
+	++State.Serial;
+
+	if (State.DebounceHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(State.DebounceHandle);
+		State.DebounceHandle.Reset();
+	}
+
+	if (State.Cancellation.IsValid())
+	{
+		State.Cancellation->Cancel();
+		State.Cancellation.Reset();
+	}
+
+	FDreamAccountUsernameCheckCallback Callback = MoveTemp(State.Callback);
+	State.Callback = nullptr;
+	if (Callback)
+	{
+		++SupersededCount;
+	}
+	return Callback;
+}
+
+void FDreamAccountUsernameChecker::SendCheck(FName FieldKey, uint32 Serial)
+{
+	FFieldState* State = Fields.Find(FieldKey);
+	if (!State || State->Serial != Serial)
+	{
+		return;
+	}
+	State->DebounceHandle.Reset();
+
+	// 防抖期间其他输入框可能已经查询过同一个用户名
+	bool bCachedAvailable = false;
+	if (FindCached(State->UserName, bCachedAvailable))
+	{
+		++CacheHitCount;
+		FDreamAccountUsernameCheckResult Result(EDreamAccountErrorType::NORMAL, State->UserName);
+		Result.bAvailable = bCachedAvailable;
+		Result.bFromCache = true;
+
+		FDreamAccountUsernameCheckCallback Callback = MoveTemp(State->Callback);
+		State->Callback = nullptr;
+		Callback(Result);
+		return;
+	}
+
+	++RequestCount;
+
+	FDreamAccountHttpRequest Request;
+	Request.URL = FString::Printf(TEXT("%s?%s=%s"), *API_USERNAME_AVAILABLE, *FIELD_USER_NAME, *FGenericPlatformHttp::UrlEncode(State->UserName));
+	Request.Verb = TEXT("GET");
+	Request.Cancellation = MakeShared<FDreamAccountHttpCancellation>();
+	Request.bHedgeable = true;
+	State->Cancellation = Request.Cancellation;
+
+	FDreamAccountShardRouter::Get().SendHttpRequest(FDreamAccountShardRouter::HashUserName(State->UserName), Request, [this, FieldKey, Serial](const FDreamAccountHttpResponse& Response)
+	{
+		HandleResponse(FieldKey, Serial, Response);
+	});
+}
+
+void FDreamAccountUsernameChecker::HandleResponse(FName FieldKey, uint32 Serial, const FDreamAccountHttpResponse& Response)
+{
+	FFieldState* State = Fields.Find(FieldKey);
+	if (!State || State->Serial != Serial)
+	{
+		return;
+	}
+
+	const FString UserName = State->UserName;
+	FDreamAccountUsernameCheckCallback Callback = MoveTemp(State->Callback);
+	State->Callback = nullptr;
+	State->Cancellation.Reset();
+
+	if (!Response.bSucceeded)
+	{
+		Callback(FDreamAccountUsernameCheckResult(EDreamAccountErrorType::NETWORK_ERROR, UserName));
+		return;
+	}
+
+	if (Response.ResponseCode != 200)
+	{
+		Callback(FDreamAccountUsernameCheckResult(FDreamAccountUtil::ParseErrorTypeFromResponse(Response), UserName));
+		return;
+	}
+
+	TSharedPtr<FJsonObject> Json = FDreamAccountUtil::ParseJsonFromResponse(Response);
+	bool bAvailable = false;
+	if (!Json.IsValid() || !Json->TryGetBoolField(FIELD_AVAILABLE, bAvailable))
+	{
+		Callback(FDreamAccountUsernameCheckResult(EDreamAccountErrorType::UNKNOWN, UserName));
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	const TArray<TSharedPtr<FJsonValue>>* TakenPrefixValues;
+	if (Json->TryGetArrayField(FIELD_TAKEN_PREFIXES, TakenPrefixValues))
+	{
+		TSet<FString> TakenPrefixes;
+		for (const TSharedPtr<FJsonValue>& Value : *TakenPrefixValues)
+		{
+			FString Prefix;
+			if (Value.IsValid() && Value->TryGetString(Prefix))
+			{
+				TakenPrefixes.Add(MoveTemp(Prefix));
+			}
+		}
+
+		for (int32 Length = 1; Length < UserName.Len(); ++Length)
+		{
+			const FString Prefix = UserName.Left(Length);
+			AddCacheEntry(Prefix, !TakenPrefixes.Contains(Prefix), Now);
+		}
+	}
+	AddCacheEntry(UserName, bAvailable, Now);
+
+	FDreamAccountUsernameCheckResult Result(EDreamAccountErrorType::NORMAL, UserName);
+	Result.bAvailable = bAvailable;
+	Callback(Result);
+}
+
+void FDreamAccountUsernameChecker::AddCacheEntry(const FString& UserName, bool bAvailable, double Now)
+{
+	const double TimeToLive = bAvailable ? AvailableTimeToLive : TakenTimeToLive;
+	if (TimeToLive <= 0.0)
+	{
+		Cache.Remove(UserName);
+		return;
+	}
+
+	if (Cache.Num() >= MaxCacheEntries && !Cache.Contains(UserName))
+	{
+		for (auto It = Cache.CreateIterator(); It; ++It)
+		{
+			if (Now >= It.Value().ExpireTime)
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		// 全部未过期时整体清空，缓存只用于减少请求，丢失不影响正确性
+		if (Cache.Num() >= MaxCacheEntries)
+		{
+			Cache.Reset();
+		}
+	}
+
+	FCacheEntry& Entry = Cache.FindOrAdd(UserName);
+	Entry.bAvailable = bAvailable;
+	Entry.ExpireTime = Now + TimeToLive;
+}
@@ -2,38 +2,246 @@
 
 #include "DreamAccountUtil.h"
 
+#include "DreamAccountLatencyBeacons.h"
+#include "DreamAccountModule.h"
+#include "DreamAccountNetworkSimulator.h"
+#include "DreamAccountRequestHedger.h"
 #include "DreamAccountSettings.h"
+#include "DreamAccountTimeoutEstimator.h"
+#include "DreamAccountTracing.h"
+#include "DreamAccountTrafficRecorder.h"
 #include "HttpModule.h"
 #include "Http.h"
 
-void FDreamAccountUtil::SendHttpRequest(const FString& URL, const FString& Verb, const FString& Content, const TMap<FString, FString>& Headers, const TFunction<void(FHttpRequestPtr, FHttpResponsePtr, bool)>& OnComplete)
+void FDreamAccountUtil::SendHttpRequest(const FString& URL, const FString& Verb, const FString& Content, const TMap<FString, FString>& Headers, const FDreamAccountHttpCallback& OnComplete)
 {
+	FDreamAccountHttpRequest Request;
+	Request.URL = URL;
+	Request.Verb = Verb;
+	Request.Content = Content;
+	Request.Headers = Headers;
+
+	SendHttpRequest(Request, OnComplete);
+}
+
+void FDreamAccountUtil::SendHttpRequest(const FString& URL, const FString& Verb, const TMap<FString, FString>& Headers, const FDreamAccountHttpCallback& OnComplete)
+{
+	SendHttpRequest(URL, Verb, TEXT(""), Headers, OnComplete);
+}
+
+void FDreamAccountUtil::SendHttpRequest(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& InOnComplete)
+{
+	LLM_SCOPE_BYTAG(DreamAccount);
+
+	// 在发起时确定所属的追踪，对冲等稍后发出的副本仍归入同一个追踪
+	FDreamAccountTracer& Tracer = FDreamAccountTracer::Get();
+	if (Tracer.IsEnabled() && !Request.Trace.IsValid())
+	{
+		FDreamAccountHttpRequest TracedRequest = Request;
+		TracedRequest.Trace = Tracer.StartTrace();
+		SendHttpRequest(TracedRequest, InOnComplete);
+		return;
+	}
+
+	FDreamAccountHttpCallback OnComplete = InOnComplete;
+	if (Request.Cancellation.IsValid())
+	{
+		if (Request.Cancellation->IsCancelled())
+		{
+			return;
+		}
+
+		// 已取消的请求不再回调，无论它由哪一层完成
+		OnComplete = [Cancellation = Request.Cancellation, InOnComplete](const FDreamAccountHttpResponse& Response)
+		{
+			if (!Cancellation->IsCancelled())
+			{
+				InOnComplete(Response);
+			}
+		};
+	}
+
+	// 对冲器以不可对冲的副本重新进入这里，每个副本分别录制和模拟
+	FDreamAccountRequestHedger& Hedger = FDreamAccountRequestHedger::Get();
+	if (Request.bHedgeable && Hedger.IsEnabled())
+	{
+		Hedger.SendHttpRequest(Request, OnComplete);
+		return;
+	}
+
+	FDreamAccountTrafficRecorder& Recorder = FDreamAccountTrafficRecorder::Get();
+	if (Recorder.IsReplaying())
+	{
+		Recorder.ReplayRequest(Request, OnComplete);
+		return;
+	}
+
+	FDreamAccountHttpCallback OnTransportComplete = OnComplete;
+
+	if (FDreamAccountLatencyBeacons::Get().ShouldRecord(Request))
+	{
+		OnTransportComplete = [Request, OnComplete](const FDreamAccountHttpResponse& Response)
+		{
+			FDreamAccountLatencyBeacons::Get().Record(Request, Response);
+			OnComplete(Response);
+		};
+	}
+
+	// 只有使用估计值的请求参与采样，显式指定超时的请求超时后不应让接口退避
+	if (Request.Timeout <= 0.0f && FDreamAccountTimeoutEstimator::Get().IsEnabled())
+	{
+		const double TimeoutSeconds = Request.GetEffectiveTimeout();
+		OnTransportComplete = [Request, TimeoutSeconds, OnTransportComplete](const FDreamAccountHttpResponse& Response)
+		{
+			FDreamAccountTimeoutEstimator::Get().HandleResponse(Request, TimeoutSeconds, Response);
+			OnTransportComplete(Response);
+		};
+	}
+
+	if (Recorder.IsRecording())
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		OnTransportComplete = [Request, StartTime, OnTransportComplete](const FDreamAccountHttpResponse& Response)
+		{
+			FDreamAccountTrafficRecorder::Get().RecordExchange(Request, StartTime, Response);
+			OnTransportComplete(Response);
+		};
+	}
+
+	if (Tracer.IsEnabled() && Request.Trace.IsValid())
+	{
+		// 每次实际发送（包括对冲的每个副本）是一个客户端 span，请求头中的父级即为该 span
+		FDreamAccountSpan Span = Tracer.BeginSpan(TEXT("network"), Request.Trace, 3);
+		Span.SetAttribute(TEXT("http.request.method"), Request.Verb);
+		Span.SetAttribute(TEXT("url.path"), Request.GetPath());
+
+		FDreamAccountHttpRequest TracedRequest = Request;
+		TracedRequest.Headers.Add(TEXT("traceparent"), Span.Context.ToTraceParent());
+		const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+		if (Settings && !Settings->TraceState.IsEmpty())
+		{
+			TracedRequest.Headers.Add(TEXT("tracestate"), Settings->TraceState);
+		}
+
+		OnTransportComplete = [Span = MoveTemp(Span), OnTransportComplete](const FDreamAccountHttpResponse& Response) mutable
+		{
+			const FDreamAccountTraceContext Context = Span.Context;
+			Span.SetAttribute(TEXT("http.response.status_code"), static_cast<int64>(Response.ResponseCode));
+			Span.bError = !Response.bSucceeded || Response.ResponseCode >= 500;
+			FDreamAccountTracer::Get().EndSpan(Span);
+
+			if (!Response.bSucceeded || Response.ResponseCode >= 500)
+			{
+				UE_LOG(LogDreamAccount, Verbose, TEXT("DreamAccount trace %s: request failed (%d)"), *Context.TraceId, Response.ResponseCode);
+			}
+
+			// 解析响应、分发回调以及在回调中发出的请求都归入该 span
+			FDreamAccountTraceScope Scope(Context);
+			OnTransportComplete(Response);
+		};
+
+		SendTransportRequest(TracedRequest, OnTransportComplete);
+		return;
+	}
+
+	SendTransportRequest(Request, OnTransportComplete);
+}
+
+void FDreamAccountUtil::SendTransportRequest(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& OnComplete)
+{
+	FDreamAccountNetworkSimulator& Simulator = FDreamAccountNetworkSimulator::Get();
+	if (Simulator.IsEnabled())
+	{
+		Simulator.SendHttpRequest(Request, OnComplete);
+		return;
+	}
+
+	SendPlatformHttpRequest(Request, OnComplete);
+}
+
+void FDreamAccountUtil::SendPlatformHttpRequest(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& OnComplete)
+{
+	LLM_SCOPE_BYTAG(DreamAccount);
+
 	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRequest = FHttpModule::Get().CreateRequest();
-	HttpRequest->SetURL(URL);
-	HttpRequest->SetVerb(Verb);
-	HttpRequest->SetContentAsString(Content);
-	HttpRequest->SetTimeout(UDreamAccountSettings::Get()->TimeoutTime); // 30秒超时
+	HttpRequest->SetURL(Request.URL);
+	HttpRequest->SetVerb(Request.Verb);
+	HttpRequest->SetContentAsString(Request.Content);
+	HttpRequest->SetTimeout(Request.GetEffectiveTimeout());
 
 	// 设置所有Header
-	for (const TPair<FString, FString>& Pair : Headers)
+	for (const TPair<FString, FString>& Pair : Request.Headers)
 	{
 		HttpRequest->SetHeader(Pair.Key, Pair.Value);
 	}
 
-	HttpRequest->OnProcessRequestComplete().BindLambda(OnComplete);
+	const double StartTime = FPlatformTime::Seconds();
+
+	// 引擎的 HTTP 模块不提供 DNS、连接与 TLS 的耗时，以收到第一个响应头的时间作为首字节时间
+	TSharedRef<double, ESPMode::ThreadSafe> FirstByteTime = MakeShared<double, ESPMode::ThreadSafe>(0.0);
+	HttpRequest->OnHeaderReceived().BindLambda(
+		[FirstByteTime](FHttpRequestPtr, const FString&, const FString&)
+		{
+			if (*FirstByteTime == 0.0)
+			{
+				*FirstByteTime = FPlatformTime::Seconds();
+			}
+		});
+
+	HttpRequest->OnProcessRequestComplete().BindLambda(
+		[OnComplete, StartTime, FirstByteTime](FHttpRequestPtr, FHttpResponsePtr HttpResponse, bool bWasSuccessful)
+		{
+			LLM_SCOPE_BYTAG(DreamAccount);
+
+			FDreamAccountHttpResponse Response;
+			Response.ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+			if (*FirstByteTime > 0.0)
+			{
+				Response.FirstByteSeconds = FMath::Min(*FirstByteTime - StartTime, Response.ElapsedSeconds);
+			}
+
+			if (bWasSuccessful && HttpResponse.IsValid())
+			{
+				Response.bSucceeded = true;
+				Response.ResponseCode = HttpResponse->GetResponseCode();
+				Response.Content = HttpResponse->GetContentAsString();
+
+				const TArray<FString> HeaderLines = HttpResponse->GetAllHeaders();
+				Response.Headers.Reserve(HeaderLines.Num());
+				for (const FString& HeaderLine : HeaderLines)
+				{
+					FString Key;
+					FString Value;
+					if (HeaderLine.Split(TEXT(":"), &Key, &Value))
+					{
+						Response.Headers.Add(Key.TrimStartAndEnd(), Value.TrimStartAndEnd());
+					}
+				}
+			}
+
+			OnComplete(Response);
+		});
+
+	if (Request.Cancellation.IsValid())
+	{
+		TWeakPtr<IHttpRequest, ESPMode::ThreadSafe> WeakRequest = HttpRequest;
+		Request.Cancellation->SetAbortHandler([WeakRequest]()
+		{
+			if (TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> PinnedRequest = WeakRequest.Pin())
+			{
+				PinnedRequest->CancelRequest();
+			}
+		});
+	}
 
 	HttpRequest->ProcessRequest();
 }
 
-void FDreamAccountUtil::SendHttpRequest(const FString& URL, const FString& Verb, const TMap<FString, FString>& Headers, const TFunction<void(FHttpRequestPtr, FHttpResponsePtr, bool)>& OnComplete)
+TSharedPtr<FJsonObject> FDreamAccountUtil::ParseJsonFromResponse(const FDreamAccountHttpResponse& Response)
 {
-	SendHttpRequest(URL, Verb, TEXT(""), Headers, OnComplete);
-}
+	FDreamAccountScopedSpan Span(TEXT("decode"));
 
-TSharedPtr<FJsonObject> FDreamAccountUtil::ParseJsonFromResponse(FHttpResponsePtr Response)
-{
-	FString Content = Response->GetContentAsString();
-	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Content);
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response.Content);
 	TSharedPtr<FJsonObject> JsonObject;
 	if (FJsonSerializer::Deserialize(Reader, JsonObject))
 	{
@@ -42,15 +250,13 @@ TSharedPtr<FJsonObject> FDreamAccountUtil::ParseJsonFromResponse(FHttpResponsePt
 	return nullptr;
 }
 
-FDreamAccountUser FDreamAccountUtil::ParseAccountUserFromJson(TSharedPtr<FJsonObject> JsonObject)
+FDreamAccountUser FDreamAccountUtil::ParseAccountUserFromJson(const TSharedPtr<FJsonObject>& JsonObject)
 {
 	FDreamAccountUser AuthUser;
 
-	if (JsonObject.IsValid())
+	const TSharedPtr<FJsonObject>* UserObject = nullptr;
+	if (JsonObject.IsValid() && JsonObject->TryGetObjectField(FDreamAccountFields::FIELD_USER, UserObject) && UserObject->IsValid())
 	{
-		const TSharedPtr<FJsonObject>* UserObject;
-		JsonObject->TryGetObjectField(TEXT("user"), UserObject);
-
 		UserObject->Get()->TryGetStringField(FDreamAccountFields::FIELD_USER_NAME, AuthUser.UserInfo.Name);
 		UserObject->Get()->TryGetNumberField(FDreamAccountFields::FIELD_USER_ID, AuthUser.UserID);
 	}
@@ -58,7 +264,30 @@ FDreamAccountUser FDreamAccountUtil::ParseAccountUserFromJson(TSharedPtr<FJsonOb
 	return AuthUser;
 }
 
-FString FDreamAccountUtil::ParseTokenFromJson(TSharedPtr<FJsonObject> JsonObject)
+TArray<FDreamAccountUser> FDreamAccountUtil::ParseAccountUsersFromJson(const TSharedPtr<FJsonObject>& JsonObject)
+{
+	TArray<FDreamAccountUser> Users;
+
+	const TArray<TSharedPtr<FJsonValue>>* UserValues;
+	if (JsonObject.IsValid() && JsonObject->TryGetArrayField(FDreamAccountFields::FIELD_USERS, UserValues))
+	{
+		Users.Reserve(UserValues->Num());
+		for (const TSharedPtr<FJsonValue>& UserValue : *UserValues)
+		{
+			// 没有 user_id 的条目会以默认 UserID 缓存，顶替该 UserID 的真实用户，直接跳过
+			const TSharedPtr<FJsonObject>* UserObject;
+			if (UserValue.IsValid() && UserValue->TryGetObject(UserObject) && UserObject->IsValid()
+				&& (*UserObject)->HasTypedField<EJson::Number>(FDreamAccountFields::FIELD_USER_ID))
+			{
+				Users.Emplace(UserObject);
+			}
+		}
+	}
+
+	return Users;
+}
+
+FString FDreamAccountUtil::ParseTokenFromJson(const TSharedPtr<FJsonObject>& JsonObject)
 {
 	FString Token;
 
@@ -70,12 +299,28 @@ FString FDreamAccountUtil::ParseTokenFromJson(TSharedPtr<FJsonObject> JsonObject
 	return Token;
 }
 
-void FDreamAccountUtil::HandleCommonErrorResponse(FHttpResponsePtr Response, EDreamAccountResultType Type, const FDreamAccountResultCallback& OnResult)
+FDateTime FDreamAccountUtil::ParseTokenExpiryFromJson(const TSharedPtr<FJsonObject>& JsonObject)
+{
+	double ExpiresIn = 0.0;
+	if (JsonObject.IsValid() && JsonObject->TryGetNumberField(FDreamAccountFields::FIELD_EXPIRES_IN, ExpiresIn) && ExpiresIn > 0.0)
+	{
+		return FDateTime::UtcNow() + FTimespan::FromSeconds(ExpiresIn);
+	}
+
+	return FDateTime::MaxValue();
+}
+
+void FDreamAccountUtil::HandleCommonErrorResponse(const FDreamAccountHttpResponse& Response, EDreamAccountResultType Type, const FDreamAccountResultCallback& OnResult)
+{
+	OnResult(FDreamAccountResult(Type, ParseErrorTypeFromResponse(Response), FDreamAccountUser()));
+}
+
+EDreamAccountErrorType FDreamAccountUtil::ParseErrorTypeFromResponse(const FDreamAccountHttpResponse& Response)
 {
 	TSharedPtr<FJsonObject> Json = ParseJsonFromResponse(Response);
 	FString Error = Json.IsValid() ? Json->GetStringField(TEXT("error")) : TEXT("UNKNOWN_ERROR");
 
-	OnResult(FDreamAccountResult(Type, GetErrorTypeFromString(Error), FDreamAccountUser()));
+	return GetErrorTypeFromString(Error);
 }
 
 EDreamAccountErrorType FDreamAccountUtil::GetErrorTypeFromString(const FString& ErrorString)
@@ -111,3 +356,13 @@ EDreamAccountErrorType FDreamAccountUtil::GetErrorTypeFromString(const FString&
 
 	return EDreamAccountErrorType::UNKNOWN;
 }
+
+void FDreamAccountUtil::ScrubString(FString& Value)
+{
+	TArray<TCHAR, FString::AllocatorType>& CharArray = Value.GetCharArray();
+	if (CharArray.Num() > 0)
+	{
+		FMemory::Memzero(CharArray.GetData(), CharArray.Num() * sizeof(TCHAR));
+	}
+	Value.Empty();
+}
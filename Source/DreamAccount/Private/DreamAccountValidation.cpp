@@ -0,0 +1,203 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountValidation.h"
+
+#include "DreamAccountUtil.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+
+using namespace FDreamAccountFields;
+
+FDreamAccountValidationRules::FDreamAccountValidationRules()
+{
+	verify(LoadFromJson(GetDefaultRulesJson()));
+}
+
+const TCHAR* FDreamAccountValidationRules::GetDefaultRulesJson()
+{
+	return TEXT(R"({
+	"user_name": {"min_length": 1, "max_length": 0, "charset": "", "pattern": "", "check_on_login": false},
+	"user_password": {"min_length": 1, "max_length": 0, "charset": "", "pattern": "", "check_on_login": false}
+})");
+}
+
+bool FDreamAccountValidationRules::LoadFromJson(const FString& Json, FString* OutError)
+{
+	FString Error;
+
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+	TSharedPtr<FJsonObject> JsonObject;
+	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+	{
+		Error = TEXT("invalid json");
+	}
+
+	FFieldRule NewUserNameRule;
+	FFieldRule NewPasswordRule;
+	if (Error.IsEmpty())
+	{
+		const TSharedPtr<FJsonObject>* UserNameJson;
+		const TSharedPtr<FJsonObject>* PasswordJson;
+		if (!JsonObject->TryGetObjectField(FIELD_USER_NAME, UserNameJson) || !JsonObject->TryGetObjectField(FIELD_USER_PASSWORD, PasswordJson))
+		{
+			Error = TEXT("missing field rules");
+		}
+		else if (CompileField(*UserNameJson, true, NewUserNameRule, Error))
+		{
+			CompileField(*PasswordJson, false, NewPasswordRule, Error);
+		}
+	}
+
+	if (!Error.IsEmpty())
+	{
+		if (OutError)
+		{
+			*OutError = Error;
+		}
+		return false;
+	}
+
+	UserNameRule = MoveTemp(NewUserNameRule);
+	PasswordRule = MoveTemp(NewPasswordRule);
+	return true;
+}
+
+EDreamAccountErrorType FDreamAccountValidationRules::ValidateRegister(const FDreamAccountInfo& Info) const
+{
+	if (!UserNameRule.Matches(Info.Name))
+	{
+		return EDreamAccountErrorType::NETWORK_INVALID_USERNAME;
+	}
+
+	if (!PasswordRule.Matches(Info.Password))
+	{
+		return EDreamAccountErrorType::NETWORK_INVALID_PASSWORD;
+	}
+
+	return EDreamAccountErrorType::NORMAL;
+}
+
+EDreamAccountErrorType FDreamAccountValidationRules::ValidateLogin(const FDreamAccountInfo& Info) const
+{
+	if (UserNameRule.bCheckOnLogin && !UserNameRule.Matches(Info.Name))
+	{
+		return EDreamAccountErrorType::NETWORK_INVALID_USERNAME;
+	}
+
+	if (PasswordRule.bCheckOnLogin && !PasswordRule.Matches(Info.Password))
+	{
+		return EDreamAccountErrorType::NETWORK_INVALID_PASSWORD;
+	}
+
+	return EDreamAccountErrorType::NORMAL;
+}
+
+bool FDreamAccountValidationRules::FFieldRule::Matches(const FString& Value) const
+{
+	const int32 Length = Value.Len();
+	if (Length < MinLength || (MaxLength > 0 && Length > MaxLength))
+	{
+		return false;
+	}
+
+	if (bHasCharset)
+	{
+		for (TCHAR Char : Value)
+		{
+			if (!IsAllowedChar(Char))
+			{
+				return false;
+			}
+		}
+	}
+
+	if (Pattern.IsSet())
+	{
+		FRegexMatcher Matcher(Pattern.GetValue(), Value);
+		if (!Matcher.FindNext() || Matcher.GetMatchBeginning() != 0 || Matcher.GetMatchEnding() != Length)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FDreamAccountValidationRules::FFieldRule::IsAllowedChar(TCHAR Char) const
+{
+	const uint32 Code = static_cast<uint32>(Char);
+	if (Code < 128)
+	{
+		return (AsciiMask[Code >> 6] & (1ull << (Code & 63))) != 0;
+	}
+
+	for (const TPair<TCHAR, TCHAR>& Range : Ranges)
+	{
+		if (Char >= Range.Key && Char <= Range.Value)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FDreamAccountValidationRules::CompileField(const TSharedPtr<FJsonObject>& Json, bool bDefaultCheckOnLogin, FFieldRule& OutRule, FString& OutError)
+{
+	Json->TryGetNumberField(TEXT("min_length"), OutRule.MinLength);
+	Json->TryGetNumberField(TEXT("max_length"), OutRule.MaxLength);
+	if (OutRule.MinLength < 0 || OutRule.MaxLength < 0 || (OutRule.MaxLength > 0 && OutRule.MaxLength < OutRule.MinLength))
+	{
+		OutError = TEXT("invalid length range");
+		return false;
+	}
+
+	FString Charset;
+	if (Json->TryGetStringField(TEXT("charset"), Charset) && !Charset.IsEmpty() && !CompileCharset(Charset, OutRule))
+	{
+		OutError = FString::Printf(TEXT("invalid charset '%s'"), *Charset);
+		return false;
+	}
+
+	FString Pattern;
+	if (Json->TryGetStringField(TEXT("pattern"), Pattern) && !Pattern.IsEmpty())
+	{
+		OutRule.Pattern.Emplace(Pattern);
+	}
+
+	OutRule.bCheckOnLogin = bDefaultCheckOnLogin;
+	Json->TryGetBoolField(TEXT("check_on_login"), OutRule.bCheckOnLogin);
+	return true;
+}
+
+bool FDreamAccountValidationRules::CompileCharset(const FString& Charset, FFieldRule& OutRule)
+{
+	OutRule.bHasCharset = true;
+
+	for (int32 Index = 0; Index < Charset.Len(); ++Index)
+	{
+		const TCHAR Low = Charset[Index];
+		TCHAR High = Low;
+		if (Index + 2 < Charset.Len() && Charset[Index + 1] == TEXT('-'))
+		{
+			High = Charset[Index + 2];
+			Index += 2;
+		}
+
+		if (High < Low)
+		{
+			return false;
+		}
+
+		for (uint32 Code = static_cast<uint32>(Low); Code <= static_cast<uint32>(High) && Code < 128; ++Code)
+		{
+			OutRule.AsciiMask[Code >> 6] |= 1ull << (Code & 63);
+		}
+
+		if (static_cast<uint32>(High) >= 128)
+		{
+			OutRule.Ranges.Emplace(Low, High);
+		}
+	}
+
+	return true;
+}
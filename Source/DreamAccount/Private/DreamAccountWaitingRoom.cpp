@@ -0,0 +1,328 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#include "DreamAccountWaitingRoom.h"
+
+#include "DreamAccountModule.h"
+#include "DreamAccountSettings.h"
+#include "DreamAccountShardRouter.h"
+#include "DreamAccountUtil.h"
+#include "Dom/JsonObject.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "Serialization/JsonSerializer.h"
+
+using namespace FDreamAccountFields;
+
+namespace DreamAccountWaitingRoom
+{
+	static const FString StatusAdmitted = TEXT("admitted");
+
+	/** 从排队对象中读取状态，返回服务器建议的轮询间隔，没有建议时为负数 */
+	double ReadQueue(const FJsonObject& Queue, FDreamAccountQueueStatus& Status)
+	{
+		FString Ticket;
+		if (Queue.TryGetStringField(FIELD_QUEUE_TICKET, Ticket) && !Ticket.IsEmpty())
+		{
+			Status.Ticket = MoveTemp(Ticket);
+		}
+
+		int32 Position = 0;
+		if (Queue.TryGetNumberField(FIELD_QUEUE_POSITION, Position))
+		{
+			Status.Position = FMath::Max(Position, 0);
+		}
+
+		double EtaSeconds = -1.0;
+		Status.EtaSeconds = Queue.TryGetNumberField(FIELD_QUEUE_ETA, EtaSeconds) ? static_cast<float>(EtaSeconds) : -1.0f;
+
+		double PollAfter = -1.0;
+		return Queue.TryGetNumberField(FIELD_QUEUE_POLL_AFTER, PollAfter) ? PollAfter : -1.0;
+	}
+}
+
+FDreamAccountWaitingRoom::FDreamAccountWaitingRoom(uint64 InKeyHash, FDreamAccountQueueCallback InOnUpdate)
+	: KeyHash(InKeyHash)
+	, OnUpdate(MoveTemp(InOnUpdate))
+{
+}
+
+FDreamAccountWaitingRoom::~FDreamAccountWaitingRoom()
+{
+	if (PollHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PollHandle);
+	}
+	if (PollCancellation.IsValid())
+	{
+		PollCancellation->Cancel();
+	}
+}
+
+bool FDreamAccountWaitingRoom::ParseQueueResponse(const FDreamAccountHttpResponse& Response, FDreamAccountQueueStatus& OutStatus, double& OutPollAfter)
+{
+	if (!Response.bSucceeded || (Response.ResponseCode != 429 && Response.ResponseCode != 503))
+	{
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Json = FDreamAccountUtil::ParseJsonFromResponse(Response);
+	const TSharedPtr<FJsonObject>* Queue = nullptr;
+	if (!Json.IsValid() || !Json->TryGetObjectField(FIELD_QUEUE, Queue) || !Queue->IsValid())
+	{
+		return false;
+	}
+
+	OutStatus = FDreamAccountQueueStatus();
+	OutPollAfter = DreamAccountWaitingRoom::ReadQueue(**Queue, OutStatus);
+	if (OutStatus.Ticket.IsEmpty())
+	{
+		return false;
+	}
+
+	// 没有 poll_after 时使用 Retry-After（只支持秒数形式）
+	const FString RetryAfter = Response.GetHeader(TEXT("Retry-After"));
+	if (OutPollAfter < 0.0 && !RetryAfter.IsEmpty() && RetryAfter.IsNumeric())
+	{
+		OutPollAfter = FCString::Atod(*RetryAfter);
+	}
+	return true;
+}
+
+void FDreamAccountWaitingRoom::Wait(const FDreamAccountQueueStatus& InStatus, double PollAfter, FOnFinished InOnFinished)
+{
+	if (EnterTime <= 0.0)
+	{
+		EnterTime = FPlatformTime::Seconds();
+	}
+
+	Status = InStatus;
+	Status.bAdmitted = false;
+	OnFinished = MoveTemp(InOnFinished);
+	ConsecutiveFailures = 0;
+	StallCount = 0;
+
+	UE_LOG(LogDreamAccount, Log, TEXT("DreamAccount: login queued at position %d (ETA %.0fs)"), Status.Position, Status.EtaSeconds);
+
+	NotifyUpdate();
+	SchedulePoll(PollAfter);
+}
+
+void FDreamAccountWaitingRoom::Cancel()
+{
+	if (!IsWaiting())
+	{
+		return;
+	}
+
+	Leave();
+	Finish(EDreamAccountErrorType::LOCAL_REQUEST_CANCELLED);
+}
+
+void FDreamAccountWaitingRoom::SchedulePoll(double PollAfter)
+{
+	if (PollHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PollHandle);
+	}
+
+	PollHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateSP(this, &FDreamAccountWaitingRoom::HandlePollTimer),
+		static_cast<float>(ComputePollDelay(PollAfter)));
+}
+
+double FDreamAccountWaitingRoom::ComputePollDelay(double PollAfter) const
+{
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	const double MinInterval = Settings ? Settings->WaitingRoomMinPollInterval : 2.0;
+	const double MaxInterval = FMath::Max<double>(Settings ? Settings->WaitingRoomMaxPollInterval : 30.0, MinInterval);
+
+	double Delay = 0.0;
+	if (PollAfter >= 0.0)
+	{
+		// 服务器按放行速率错开各客户端的查询时间，抖动只向后推迟
+		Delay = FMath::Max(PollAfter, MinInterval) * FMath::FRandRange(1.0, 1.2);
+	}
+	else
+	{
+		// 每次等待剩余时间的四分之一，位置停滞时逐渐放慢
+		const double Estimate = Status.EtaSeconds > 0.0f ? Status.EtaSeconds * 0.25 : MinInterval;
+		Delay = FMath::Clamp(Estimate * FMath::Pow(StallBackoff, StallCount), MinInterval, MaxInterval) * FMath::FRandRange(0.8, 1.2);
+	}
+
+	const double MaxWait = Settings ? Settings->WaitingRoomMaxWait : 0.0;
+	if (MaxWait > 0.0)
+	{
+		const double Remaining = EnterTime + MaxWait - FPlatformTime::Seconds();
+		Delay = FMath::Min(Delay, FMath::Max(Remaining, 0.0));
+	}
+	return Delay;
+}
+
+bool FDreamAccountWaitingRoom::HandlePollTimer(float DeltaTime)
+{
+	PollHandle.Reset();
+
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	const double MaxWait = Settings ? Settings->WaitingRoomMaxWait : 0.0;
+	if (MaxWait > 0.0 && FPlatformTime::Seconds() - EnterTime >= MaxWait)
+	{
+		UE_LOG(LogDreamAccount, Warning, TEXT("DreamAccount: left the login queue after %.0fs at position %d"), MaxWait, Status.Position);
+		Leave();
+		Finish(EDreamAccountErrorType::LOCAL_SERVER_BUSY);
+		return false;
+	}
+
+	Poll();
+	return false;
+}
+
+void FDreamAccountWaitingRoom::Poll()
+{
+	const UDreamAccountSettings* Settings = UDreamAccountSettings::Get();
+	const float LongPollSeconds = Settings ? Settings->WaitingRoomLongPollSeconds : 0.0f;
+
+	FDreamAccountHttpRequest Request;
+	Request.URL = FString::Printf(TEXT("%s?%s=%s"), *API_LOGIN_QUEUE, *FIELD_QUEUE_TICKET, *FGenericPlatformHttp::UrlEncode(Status.Ticket));
+	Request.Verb = TEXT("GET");
+	if (LongPollSeconds > 0.0f)
+	{
+		Request.URL += FString::Printf(TEXT("&%s=%d"), *FIELD_QUEUE_WAIT, FMath::CeilToInt(LongPollSeconds));
+
+		// 服务器挂起的时间不计入超时
+		Request.Timeout = LongPollSeconds + (Settings ? Settings->TimeoutTime : 5.0f);
+	}
+
+	PollCancellation = MakeShared<FDreamAccountHttpCancellation>();
+	Request.Cancellation = PollCancellation;
+
+	TWeakPtr<FDreamAccountWaitingRoom> WeakThis = AsShared();
+	FDreamAccountShardRouter::Get().SendHttpRequest(KeyHash, Request, [WeakThis](const FDreamAccountHttpResponse& Response)
+	{
+		if (TSharedPtr<FDreamAccountWaitingRoom> This = WeakThis.Pin())
+		{
+			This->HandlePollResponse(Response);
+		}
+	});
+}
+
+void FDreamAccountWaitingRoom::HandlePollResponse(const FDreamAccountHttpResponse& Response)
+{
+	PollCancellation.Reset();
+	if (!IsWaiting())
+	{
+		return;
+	}
+
+	// 网络错误与服务器错误稍后重试，排队位置由服务器保留
+	if (!Response.bSucceeded || Response.ResponseCode >= 500)
+	{
+		if (++ConsecutiveFailures >= MaxConsecutiveFailures)
+		{
+			Finish(Response.bSucceeded ? FDreamAccountUtil::ParseErrorTypeFromResponse(Response) : EDreamAccountErrorType::NETWORK_ERROR);
+			return;
+		}
+
+		StallCount = FMath::Min(StallCount + 1, 16);
+		SchedulePoll(-1.0);
+		return;
+	}
+	ConsecutiveFailures = 0;
+
+	// 票据过期或服务器重启后丢失，重新登录以重新排队
+	if (Response.ResponseCode == 404 || Response.ResponseCode == 410)
+	{
+		UE_LOG(LogDreamAccount, Log, TEXT("DreamAccount: login queue ticket is no longer valid (HTTP %d), logging in again"), Response.ResponseCode);
+		Finish(EDreamAccountErrorType::NORMAL);
+		return;
+	}
+
+	if (Response.ResponseCode != 200)
+	{
+		Finish(FDreamAccountUtil::ParseErrorTypeFromResponse(Response));
+		return;
+	}
+
+	TSharedPtr<FJsonObject> Json = FDreamAccountUtil::ParseJsonFromResponse(Response);
+	const TSharedPtr<FJsonObject>* Queue = nullptr;
+	if (!Json.IsValid() || !Json->TryGetObjectField(FIELD_QUEUE, Queue) || !Queue->IsValid())
+	{
+		Finish(EDreamAccountErrorType::UNKNOWN);
+		return;
+	}
+
+	const int32 PreviousPosition = Status.Position;
+	const double PollAfter = DreamAccountWaitingRoom::ReadQueue(**Queue, Status);
+
+	FString QueueStatus;
+	FString Admission;
+	(*Queue)->TryGetStringField(FIELD_QUEUE_STATUS, QueueStatus);
+	(*Queue)->TryGetStringField(FIELD_QUEUE_ADMISSION, Admission);
+	if (QueueStatus == DreamAccountWaitingRoom::StatusAdmitted)
+	{
+		Status.bAdmitted = true;
+		Status.Position = 0;
+		Status.EtaSeconds = 0.0f;
+		NotifyUpdate();
+
+		UE_LOG(LogDreamAccount, Log, TEXT("DreamAccount: admitted from the login queue after %.1fs"), Status.WaitedSeconds);
+		Finish(EDreamAccountErrorType::NORMAL, Admission);
+		return;
+	}
+
+	StallCount = Status.Position < PreviousPosition ? 0 : FMath::Min(StallCount + 1, 16);
+	NotifyUpdate();
+	SchedulePoll(PollAfter);
+}
+
+void FDreamAccountWaitingRoom::Leave()
+{
+	if (Status.Ticket.IsEmpty())
+	{
+		return;
+	}
+
+	TSharedRef<FJsonObject> Json = MakeShared<FJsonObject>();
+	Json->SetStringField(FIELD_QUEUE_TICKET, Status.Ticket);
+
+	FString Content;
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Content);
+	FJsonSerializer::Serialize(Json, Writer);
+
+	static const TMap<FString, FString> Headers = {
+		{TEXT("Content-Type"), TEXT("application/json;charset=UTF-8")}
+	};
+	FDreamAccountShardRouter::Get().SendHttpRequest(KeyHash, API_LOGIN_QUEUE_LEAVE, TEXT("POST"), Content, Headers,
+		[](const FDreamAccountHttpResponse&)
+		{
+		});
+}
+
+void FDreamAccountWaitingRoom::Finish(EDreamAccountErrorType ErrorType, const FString& Admission)
+{
+	if (PollHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PollHandle);
+		PollHandle.Reset();
+	}
+	if (PollCancellation.IsValid())
+	{
+		PollCancellation->Cancel();
+		PollCancellation.Reset();
+	}
+
+	// 回调中可能再次调用 Wait
+	FOnFinished Callback = MoveTemp(OnFinished);
+	OnFinished = nullptr;
+	if (Callback)
+	{
+		Callback(ErrorType, Admission);
+	}
+}
+
+void FDreamAccountWaitingRoom::NotifyUpdate()
+{
+	Status.WaitedSeconds = static_cast<float>(FPlatformTime::Seconds() - EnterTime);
+	if (OnUpdate)
+	{
+		OnUpdate(Status);
+	}
+}
@@ -3,8 +3,11 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "DreamAccountCallbackDispatcher.h"
 #include "DreamAccountSubsystem.h"
 #include "DreamAccountTypes.h"
+#include "Engine/CancellableAsyncAction.h"
 #include "Kismet/BlueprintAsyncActionBase.h"
 #include "DreamAccountAsyncAction.generated.h"
 
@@ -15,50 +18,194 @@
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FDreamAccountActionUserCallback, FDreamAccountResult, Result);
 
 /**
- * 用户注册
- * 该类继承自UBlueprintAsyncActionBase，用于在蓝图中异步执行用户注册操作。
+ * 委托声明：用于登录排队状态变化的回调
+ * @param Status 排队状态，包含排队位置与预计等待时间
  */
-UCLASS()
-class DREAMACCOUNT_API UDreamAccountAsyncAction_UserRegister : public UBlueprintAsyncActionBase
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FDreamAccountActionQueueCallback, FDreamAccountQueueStatus, Status);
+
+/**
+ * 委托声明：用于没有参数的节点事件，例如取消与超时
+ */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FDreamAccountActionEvent);
+
+/**
+ * 账号操作节点基类
+ * 该类继承自UCancellableAsyncAction，为账号操作的蓝图异步节点提供取消与超时。
+ * 每次调用都创建新的节点，节点结束后不会再用于其他调用，保存下来的节点稍后调用 Cancel 不会影响其他操作。
+ * 节点不做对象池：蓝图图表在节点结束后仍持有它（临时变量与 Async Action 引脚），并且事件绑定留在节点上，
+ * 复用会让旧图表收到新调用的事件、取消新调用，而引擎无法得知图表何时释放节点。
+ * 新的账号操作继承该类（返回 FDreamAccountResult 时继承 UDreamAccountAsyncAction_AccountResult），
+ * 在工厂函数中调用 AcquireNode，在 Execute 中把 MakeCallback 生成的回调交给子系统即可。
+ */
+UCLASS(Abstract)
+class DREAMACCOUNT_API UDreamAccountAsyncActionBase : public UCancellableAsyncAction
 {
 	GENERATED_BODY()
 
 public:
+	virtual void Activate() override;
+
 	/**
-	 * 用户注册
+	 * 取消节点，触发 OnCancelled 后不再触发其他事件
+	 * 已经发出的请求仍会完成，结果被丢弃。
+	 */
+	virtual void Cancel() override;
+
+	virtual bool IsActive() const override;
+
+	/** 调用 Cancel 取消的回调事件 */
+	UPROPERTY(BlueprintAssignable)
+	FDreamAccountActionEvent OnCancelled;
+
+	/** 超过 Timeout 秒仍未完成的回调事件，之后不再触发其他事件 */
+	UPROPERTY(BlueprintAssignable)
+	FDreamAccountActionEvent OnTimeout;
+
+protected:
+	/**
+	 * 创建节点，并注册到游戏实例
 	 * @param WorldContextObject 世界上下文对象
-	 * @param User 用户信息结构体，包含注册所需的数据
-	 * @return 返回一个异步操作实例，用于监听注册结果
+	 * @param InTimeout 超时时间（秒），0 表示不限制
+	 * @return 返回可以设置调用参数的节点
 	 */
-	UFUNCTION(BlueprintCallable, Category = "Dream Account", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true"))
-	static UDreamAccountAsyncAction_UserRegister* UserRegister(UObject* WorldContextObject, FDreamAccountInfo User);
+	template <typename NodeType>
+	static NodeType* AcquireNode(UObject* WorldContextObject, float InTimeout)
+	{
+		return CastChecked<NodeType>(CreateNode(NodeType::StaticClass(), WorldContextObject, InTimeout));
+	}
 
-	virtual void Activate() override;
+	static UDreamAccountAsyncActionBase* CreateNode(UClass* NodeClass, UObject* WorldContextObject, float InTimeout);
+
+	/**
+	 * 生成交给子系统的回调
+	 * 结果经回调分发器交给 Handler，节点已经结束（取消、超时）或已被垃圾回收时丢弃。
+	 * @param Handler 广播结果的成员函数
+	 * @param bFinish 为 true 时 Handler 返回后节点结束，进度类回调传 false
+	 * @param Priority 回调分发优先级
+	 */
+	template <typename NodeType, typename ValueType>
+	TFunction<void(const ValueType&)> MakeCallback(void (NodeType::*Handler)(const ValueType&), bool bFinish = true,
+		EDreamAccountDispatchPriority Priority = EDreamAccountDispatchPriority::Interactive)
+	{
+		TWeakObjectPtr<NodeType> WeakNode(CastChecked<NodeType>(this));
+		return [WeakNode, Handler, bFinish, Priority](const ValueType& Value)
+		{
+			FDreamAccountCallbackDispatcher::Get().Dispatch(Priority, [WeakNode, Handler, bFinish, Value]()
+			{
+				NodeType* Node = WeakNode.Get();
+				UDreamAccountAsyncActionBase* Base = Node;
+				if (!Base || !Base->bActive)
+				{
+					return;
+				}
+
+				// 先标记为结束，蓝图在事件中调用 Cancel 时不会重复结束
+				if (bFinish)
+				{
+					Base->bActive = false;
+				}
+
+				(Node->*Handler)(Value);
+
+				if (bFinish)
+				{
+					Base->Finish();
+				}
+			});
+		};
+	}
+
+	/** 发起账号操作，调用时 Subsystem 有效 */
+	virtual void Execute() PURE_VIRTUAL(UDreamAccountAsyncActionBase::Execute, );
+
+	/** 子系统不可用时广播失败事件 */
+	virtual void BroadcastUnavailable() PURE_VIRTUAL(UDreamAccountAsyncActionBase::BroadcastUnavailable, );
+
+	/** 取消或超时时停止仍在进行的操作，默认什么也不做 */
+	virtual void CancelOperation() {}
+
+	/** 子系统引用，用于与账户系统交互 */
+	UPROPERTY()
+	UDreamAccountSubsystem* Subsystem = nullptr;
+
+	/** 超时时间（秒），0 表示不限制 */
+	UPROPERTY()
+	float TimeoutSeconds = 0.0f;
+
+private:
+	bool HandleTimeout(float DeltaTime);
+
+	/** 结束节点：停止超时计时并注销游戏实例的引用 */
+	void Finish();
+
+	FTSTicker::FDelegateHandle TimeoutHandle;
 
-	/** 注册成功的回调事件 */
+	/** 节点是否在等待结果，结束后不再变为 true，迟到的结果因此被丢弃 */
+	bool bActive = false;
+
+	/** 节点是否已经结束，结束后再次 Activate 不会重新发起操作 */
+	bool bFinished = false;
+};
+
+/**
+ * 账号结果节点基类
+ * 该类继承自UDreamAccountAsyncActionBase，按 FDreamAccountResult 的错误类型触发 OnSuccess 或 OnFailure。
+ */
+UCLASS(Abstract)
+class DREAMACCOUNT_API UDreamAccountAsyncAction_AccountResult : public UDreamAccountAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	/** 操作成功的回调事件 */
 	UPROPERTY(BlueprintAssignable)
 	FDreamAccountActionUserCallback OnSuccess;
 
-	/** 注册失败的回调事件 */
+	/** 操作失败的回调事件 */
 	UPROPERTY(BlueprintAssignable)
 	FDreamAccountActionUserCallback OnFailure;
 
 protected:
-	/** 子系统引用，用于与账户系统交互 */
-	UPROPERTY()
-	UDreamAccountSubsystem* Subsystem;
+	virtual void BroadcastUnavailable() override;
 
-	/** 存储用户注册信息 */
+	/** 按错误类型广播成功或失败事件 */
+	void BroadcastResult(const FDreamAccountResult& Result);
+};
+
+/**
+ * 用户注册
+ * 该类继承自UDreamAccountAsyncAction_AccountResult，用于在蓝图中异步执行用户注册操作。
+ */
+UCLASS()
+class DREAMACCOUNT_API UDreamAccountAsyncAction_UserRegister : public UDreamAccountAsyncAction_AccountResult
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * 用户注册
+	 * @param WorldContextObject 世界上下文对象
+	 * @param User 用户信息结构体，包含注册所需的数据
+	 * @param Timeout 超时时间（秒），超时触发 OnTimeout，0 表示不限制
+	 * @return 返回一个异步操作实例，用于监听注册结果
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Dream Account", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true", AdvancedDisplay = "Timeout"))
+	static UDreamAccountAsyncAction_UserRegister* UserRegister(UObject* WorldContextObject, FDreamAccountInfo User, float Timeout = 0.0f);
+
+protected:
+	virtual void Execute() override;
+
+	/** 存储用户注册信息，发起操作时移交给子系统，节点不再保留密码 */
 	UPROPERTY()
 	FDreamAccountInfo Info;
 };
 
 /**
  * 用户登录
- * 该类继承自UBlueprintAsyncActionBase，用于在蓝图中异步执行用户登录操作。
+ * 该类继承自UDreamAccountAsyncAction_AccountResult，用于在蓝图中异步执行用户登录操作。
  */
 UCLASS()
-class DREAMACCOUNT_API UDreamAccountAsyncAction_UserLogin : public UBlueprintAsyncActionBase
+class DREAMACCOUNT_API UDreamAccountAsyncAction_UserLogin : public UDreamAccountAsyncAction_AccountResult
 {
 	GENERATED_BODY()
 
@@ -67,37 +214,93 @@ public:
 	 * 用户登录
 	 * @param WorldContextObject 世界上下文对象
 	 * @param User 用户信息结构体，包含登录所需的凭证数据
+	 * @param Timeout 超时时间（秒），超时触发 OnTimeout，0 表示不限制
 	 * @return 返回一个异步操作实例，用于监听登录结果
 	 */
-	UFUNCTION(BlueprintCallable, Category = "Dream Account", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true"))
-	static UDreamAccountAsyncAction_UserLogin* UserLogin(UObject* WorldContextObject, FDreamAccountInfo User);
+	UFUNCTION(BlueprintCallable, Category = "Dream Account", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true", AdvancedDisplay = "Timeout"))
+	static UDreamAccountAsyncAction_UserLogin* UserLogin(UObject* WorldContextObject, FDreamAccountInfo User, float Timeout = 0.0f);
 
-	virtual void Activate() override;
+protected:
+	virtual void Execute() override;
 
-	/** 登录成功的回调事件 */
-	UPROPERTY(BlueprintAssignable)
-	FDreamAccountActionUserCallback OnSuccess;
+	/** 存储用户登录信息，发起操作时移交给子系统，节点不再保留密码 */
+	UPROPERTY()
+	FDreamAccountInfo Info;
+};
 
-	/** 登录失败的回调事件 */
+/**
+ * 排队登录
+ * 该类继承自UDreamAccountAsyncAction_AccountResult，用于在蓝图中执行登录，并在服务器限流时显示排队位置与预计等待时间。
+ * 排队超时以 LOCAL_SERVER_BUSY 触发 OnFailure；取消节点或节点超时会离开排队。
+ */
+UCLASS()
+class DREAMACCOUNT_API UDreamAccountAsyncAction_UserLoginWithQueue : public UDreamAccountAsyncAction_AccountResult
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * 排队登录
+	 * @param WorldContextObject 世界上下文对象
+	 * @param User 用户信息结构体，包含登录所需的凭证数据
+	 * @param Timeout 超时时间（秒），包含排队时间，超时触发 OnTimeout，0 表示不限制
+	 * @return 返回一个异步操作实例，用于监听排队状态和登录结果
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Dream Account", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true", AdvancedDisplay = "Timeout"))
+	static UDreamAccountAsyncAction_UserLoginWithQueue* UserLoginWithQueue(UObject* WorldContextObject, FDreamAccountInfo User, float Timeout = 0.0f);
+
+	/** 进入排队以及排队位置变化的回调事件，放行时 bAdmitted 为 true，随后自动重新登录 */
 	UPROPERTY(BlueprintAssignable)
-	FDreamAccountActionUserCallback OnFailure;
+	FDreamAccountActionQueueCallback OnQueueUpdate;
 
 protected:
-	/** 子系统引用，用于与账户系统交互 */
+	virtual void Execute() override;
+	virtual void CancelOperation() override;
+
+	void BroadcastQueueUpdate(const FDreamAccountQueueStatus& Status);
+
+	/** 存储用户登录信息，发起操作时移交给子系统，节点不再保留密码 */
 	UPROPERTY()
-	UDreamAccountSubsystem* Subsystem;
+	FDreamAccountInfo Info;
+
+	/** 本节点发起的登录的排队过程，取消时只离开这一个排队 */
+	TSharedPtr<FDreamAccountWaitingRoom> WaitingRoom;
+};
 
-	/** 存储用户登录信息 */
+/**
+ * 注册并登录
+ * 该类继承自UDreamAccountAsyncAction_AccountResult，用于在蓝图中以一次请求完成注册并获取令牌。
+ */
+UCLASS()
+class DREAMACCOUNT_API UDreamAccountAsyncAction_UserRegisterAndLogin : public UDreamAccountAsyncAction_AccountResult
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * 注册并登录
+	 * @param WorldContextObject 世界上下文对象
+	 * @param User 用户信息结构体，包含注册所需的数据
+	 * @param Timeout 超时时间（秒），超时触发 OnTimeout，0 表示不限制
+	 * @return 返回一个异步操作实例，用于监听结果
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Dream Account", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true", AdvancedDisplay = "Timeout"))
+	static UDreamAccountAsyncAction_UserRegisterAndLogin* UserRegisterAndLogin(UObject* WorldContextObject, FDreamAccountInfo User, float Timeout = 0.0f);
+
+protected:
+	virtual void Execute() override;
+
+	/** 存储用户注册信息，发起操作时移交给子系统，节点不再保留密码 */
 	UPROPERTY()
 	FDreamAccountInfo Info;
 };
 
 /**
  * 用户身份验证
- * 该类继承自UBlueprintAsyncActionBase，用于在蓝图中异步执行用户身份验证操作。
+ * 该类继承自UDreamAccountAsyncAction_AccountResult，用于在蓝图中异步执行用户身份验证操作。
  */
 UCLASS()
-class DREAMACCOUNT_API UDreamAccountAsyncAction_UserAuthentication : public UBlueprintAsyncActionBase
+class DREAMACCOUNT_API UDreamAccountAsyncAction_UserAuthentication : public UDreamAccountAsyncAction_AccountResult
 {
 	GENERATED_BODY()
 
@@ -105,25 +308,114 @@ public:
 	/**
 	 * 用户身份验证
 	 * @param WorldContextObject 世界上下文对象
+	 * @param Timeout 超时时间（秒），超时触发 OnTimeout，0 表示不限制
 	 * @return 返回一个异步操作实例，用于监听验证结果
 	 */
-	UFUNCTION(BlueprintCallable, Category = "Dream Account", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true"))
-	static UDreamAccountAsyncAction_UserAuthentication* UserAuthentication(UObject* WorldContextObject);
+	UFUNCTION(BlueprintCallable, Category = "Dream Account", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true", AdvancedDisplay = "Timeout"))
+	static UDreamAccountAsyncAction_UserAuthentication* UserAuthentication(UObject* WorldContextObject, float Timeout = 0.0f);
 
-	virtual void Activate() override;
+protected:
+	virtual void Execute() override;
+};
+
+/**
+ * 委托声明：用于批量用户查询完成后的回调
+ * @param Result 查询结果，包含用户信息和未找到的用户ID
+ */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FDreamAccountActionUserLookupCallback, FDreamAccountUserLookupResult, Result);
 
-	/** 验证成功的回调事件 */
+/**
+ * 批量用户查询
+ * 该类继承自UDreamAccountAsyncActionBase，用于在蓝图中按 UserID 异步批量查询用户信息。
+ */
+UCLASS()
+class DREAMACCOUNT_API UDreamAccountAsyncAction_LookupUsers : public UDreamAccountAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * 批量用户查询
+	 * @param WorldContextObject 世界上下文对象
+	 * @param UserIDs 需要查询的用户ID列表
+	 * @param Timeout 超时时间（秒），超时触发 OnTimeout，0 表示不限制
+	 * @return 返回一个异步操作实例，用于监听查询结果
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Dream Account", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true", AdvancedDisplay = "Timeout"))
+	static UDreamAccountAsyncAction_LookupUsers* LookupUsers(UObject* WorldContextObject, const TArray<int32>& UserIDs, float Timeout = 0.0f);
+
+	/** 查询成功的回调事件 */
 	UPROPERTY(BlueprintAssignable)
-	FDreamAccountActionUserCallback OnSuccess;
+	FDreamAccountActionUserLookupCallback OnSuccess;
 
-	/** 验证失败的回调事件 */
+	/** 查询失败的回调事件 */
 	UPROPERTY(BlueprintAssignable)
-	FDreamAccountActionUserCallback OnFailure;
+	FDreamAccountActionUserLookupCallback OnFailure;
 
 protected:
-	/** 子系统引用，用于与账户系统交互 */
+	virtual void Execute() override;
+	virtual void BroadcastUnavailable() override;
+
+	void BroadcastResult(const FDreamAccountUserLookupResult& Result);
+
+	/** 存储需要查询的用户ID */
+	UPROPERTY()
+	TArray<int32> UserIDs;
+};
+
+/**
+ * 委托声明：用于用户名可用性检查完成后的回调
+ * @param Result 检查结果
+ */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FDreamAccountActionUsernameCheckCallback, FDreamAccountUsernameCheckResult, Result);
+
+/**
+ * 用户名可用性检查
+ * 该类继承自UDreamAccountAsyncActionBase，用于在注册界面输入时检查用户名是否可用。
+ * 同一输入框的连续调用会被防抖，被新调用取代的节点不会触发任何输出。
+ */
+UCLASS()
+class DREAMACCOUNT_API UDreamAccountAsyncAction_CheckUsername : public UDreamAccountAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * 用户名可用性检查
+	 * @param WorldContextObject 世界上下文对象
+	 * @param FieldKey 输入框标识，同一输入框的新检查会取代旧检查
+	 * @param UserName 需要检查的用户名
+	 * @param Timeout 超时时间（秒），超时触发 OnTimeout，0 表示不限制
+	 * @return 返回一个异步操作实例，用于监听检查结果
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Dream Account", meta = (WorldContext = "WorldContextObject", BlueprintInternalUseOnly = "true", AdvancedDisplay = "Timeout"))
+	static UDreamAccountAsyncAction_CheckUsername* CheckUsernameAvailability(UObject* WorldContextObject, FName FieldKey, const FString& UserName, float Timeout = 0.0f);
+
+	/** 用户名可用的回调事件 */
+	UPROPERTY(BlueprintAssignable)
+	FDreamAccountActionUsernameCheckCallback OnAvailable;
+
+	/** 用户名已被占用的回调事件 */
+	UPROPERTY(BlueprintAssignable)
+	FDreamAccountActionUsernameCheckCallback OnTaken;
+
+	/** 检查失败的回调事件 */
+	UPROPERTY(BlueprintAssignable)
+	FDreamAccountActionUsernameCheckCallback OnFailure;
+
+protected:
+	virtual void Execute() override;
+	virtual void BroadcastUnavailable() override;
+
+	void BroadcastResult(const FDreamAccountUsernameCheckResult& Result);
+
+	/** 输入框标识 */
+	UPROPERTY()
+	FName FieldKey;
+
+	/** 需要检查的用户名 */
 	UPROPERTY()
-	UDreamAccountSubsystem* Subsystem;
+	FString UserName;
 };
 
 /**
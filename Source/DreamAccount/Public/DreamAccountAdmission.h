@@ -0,0 +1,147 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @class FDreamAccountAdmissionController
+ * @brief 专用服务器上玩家加入时的令牌校验准入控制。
+ *
+ * 同时进行的校验请求数不超过上限，其余按到达顺序排队；同一令牌的并发校验合并为一次请求，
+ * 近期的校验结果在有效期内直接复用。服务器重启后整个大厅同时重连时，账号服务器收到的请求速率保持平稳。
+ * 启用本地封禁列表时，已封禁的用户即使令牌有效也会被拒绝。仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountAdmissionController
+{
+public:
+	/** 校验令牌的函数，UserName 仅用于分片路由，可以为空 */
+	using FValidator = TFunction<void(const FString& Token, const FString& UserName, FDreamAccountResultCallback Callback)>;
+
+	static FDreamAccountAdmissionController& Get();
+
+	/**
+	 * @brief 设置准入参数。
+	 *
+	 * @param InMaxInFlight 同时进行的校验请求上限。
+	 * @param InMaxQueueLength 排队上限，0 表示不限制。
+	 * @param InQueueTimeout 排队超时（秒），超过后直接拒绝，0 表示不限制。
+	 * @param InResultTimeToLive 校验结果的复用时间（秒），0 表示不复用。
+	 */
+	void Configure(int32 InMaxInFlight, int32 InMaxQueueLength, double InQueueTimeout, double InResultTimeToLive);
+
+	/** 设置校验函数，由 UDreamAccountSubsystem 在初始化时设置 */
+	void SetValidator(FValidator InValidator) { Validator = MoveTemp(InValidator); }
+
+	/**
+	 * @brief 校验加入玩家的令牌。
+	 *
+	 * @param Token 玩家的令牌。
+	 * @param UserName 玩家的用户名，用于分片路由，可以为空。
+	 * @param Callback 校验完成后的回调，结果中包含排队与校验耗时。
+	 */
+	void Admit(const FString& Token, const FString& UserName, FDreamAccountAdmissionCallback Callback);
+
+	/**
+	 * @brief 取消所有排队和进行中的校验，回调以 LOCAL_REQUEST_CANCELLED 结束。
+	 */
+	void CancelAll();
+
+	/** 清空复用的校验结果 */
+	void EmptyCache() { Cache.Empty(); }
+
+	/** 获取准入统计 */
+	FDreamAccountAdmissionStats GetStats() const;
+
+	/** 清空统计 */
+	void ResetStats();
+
+private:
+	FDreamAccountAdmissionController();
+
+	struct FWaiter
+	{
+		FDreamAccountAdmissionCallback Callback;
+		double EnqueueTime = 0.0;
+	};
+
+	struct FPendingToken
+	{
+		FString UserName;
+		TArray<FWaiter> Waiters;
+		double EnqueueTime = 0.0;
+		double DispatchTime = 0.0;
+		bool bInFlight = false;
+	};
+
+	struct FCacheEntry
+	{
+		EDreamAccountErrorType ErrorType = EDreamAccountErrorType::UNKNOWN;
+		FDreamAccountUser User;
+		double ExpireTime = 0.0;
+	};
+
+	/** 在上限内从队首开始发出校验请求 */
+	void Pump();
+
+	/** 以 LOCAL_SERVER_BUSY 拒绝排队超过 QueueTimeout 的令牌，校验请求卡住时排队者也能按时得到结果 */
+	void ExpireQueued(double Now);
+
+	/** 排队超时检查的定时器，有人排队时才运行 */
+	bool HandleExpireTimer(float DeltaTime);
+
+	/** 排队中的令牌数 */
+	int32 GetQueueLength() const { return Queue.Num() - QueueHead; }
+
+	/** 取出队首的令牌 */
+	FString PopQueue();
+
+	/**
+	 * @brief 校验请求完成。
+	 *
+	 * @param Generation 发出请求时的 CancelGeneration，CancelAll 之前发出的请求的结果被丢弃。
+	 */
+	void HandleValidated(const FString& Token, uint32 Generation, const FDreamAccountResult& Result);
+
+	/** 按到达顺序回调同一令牌的所有等待者 */
+	void Deliver(TArray<FWaiter> Waiters, EDreamAccountErrorType ErrorType, const FDreamAccountUser& User, double DispatchTime, bool bFromCache);
+
+	/** 是否为可以复用的确定结果（网络错误、服务器错误不复用） */
+	static bool IsCacheable(EDreamAccountErrorType ErrorType);
+
+	FValidator Validator;
+
+	int32 MaxInFlight = 8;
+	int32 MaxQueueLength = 0;
+	double QueueTimeout = 0.0;
+	double ResultTimeToLive = 0.0;
+
+	TMap<FString, FPendingToken> Pending;
+
+	/** 等待发出请求的令牌，按到达顺序；出队只移动 QueueHead，已出队的部分积累到一定数量后整体移除 */
+	TArray<FString> Queue;
+	int32 QueueHead = 0;
+	int32 InFlightCount = 0;
+
+	/** 每次 CancelAll 递增，取消后同一令牌重新排队时，旧请求迟到的结果不会被当作新请求的结果 */
+	uint32 CancelGeneration = 0;
+
+	FTSTicker::FDelegateHandle ExpireHandle;
+
+	TMap<FString, FCacheEntry> Cache;
+
+	/** 复用结果的条目上限，超出时清理过期条目 */
+	static constexpr int32 MaxCacheEntries = 4096;
+
+	int32 AdmittedCount = 0;
+	int32 RejectedCount = 0;
+	int32 BusyCount = 0;
+	int32 CacheHitCount = 0;
+	int32 ValidationCount = 0;
+	int32 PeakQueueLength = 0;
+	double TotalWaitSeconds = 0.0;
+	double MaxWaitSeconds = 0.0;
+	int32 WaitSampleCount = 0;
+};
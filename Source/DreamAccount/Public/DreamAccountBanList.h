@@ -0,0 +1,135 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "DreamAccountTypes.h"
+#include <atomic>
+
+struct FDreamAccountHttpResponse;
+
+/**
+ * @class FDreamAccountBanSet
+ * @brief 不可变的封禁 UserID 集合。
+ *
+ * 基础部分是开放寻址哈希表（线性探测，装载率不超过 50%，每个 UserID 约 8 字节），
+ * 增量部分是新增和移除两个小集合，查询都是常数时间。应用增量时共享基础表，
+ * 只复制增量集合；增量积累到基础表的一定比例后整体重建。
+ */
+class DREAMACCOUNT_API FDreamAccountBanSet
+{
+public:
+	using FRef = TSharedRef<const FDreamAccountBanSet, ESPMode::ThreadSafe>;
+
+	/** 由完整快照构造 */
+	static FRef MakeSnapshot(int64 InVersion, const TArray<int32>& UserIDs);
+
+	/** 应用增量，返回新的集合 */
+	FRef ApplyDelta(int64 NewVersion, const TArray<int32>& AddedUserIDs, const TArray<int32>& RemovedUserIDs) const;
+
+	/** 是否包含该 UserID，可在任意线程调用 */
+	bool Contains(int32 UserID) const;
+
+	/** 封禁的用户数 */
+	int32 Num() const { return Count; }
+
+	/** 服务器上的封禁列表版本 */
+	int64 GetVersion() const { return Version; }
+
+	/** 增量集合中的条目数 */
+	int32 GetOverlayNum() const { return Added.Num() + Removed.Num(); }
+
+	/** 占用的内存（字节），基础表被多个版本共享时按完整大小计算 */
+	int64 GetAllocatedSize() const;
+
+private:
+	struct FTable
+	{
+		/** 空槽位为 INDEX_NONE，UserID 均为非负数 */
+		TArray<int32> Slots;
+		uint32 Mask = 0;
+		int32 Num = 0;
+
+		explicit FTable(const TArray<int32>& UserIDs);
+		bool Contains(int32 UserID) const;
+	};
+
+	TSharedPtr<const FTable, ESPMode::ThreadSafe> Base;
+	TSet<int32> Added;
+	TSet<int32> Removed;
+	int32 Count = 0;
+	int64 Version = 0;
+};
+
+/**
+ * @class FDreamAccountBanList
+ * @brief 专用服务器上的本地封禁列表副本。
+ *
+ * 首次同步下载完整快照，之后按版本号定期拉取增量，服务器无法提供增量时会返回完整快照。
+ * 快照解析和集合重建在后台线程进行，完成后在游戏线程替换当前集合；
+ * IsBanned 是一次哈希查找，可以在任意线程调用：游戏线程上不加锁，其他线程在读锁内查找，读取端之间不互相阻塞。
+ */
+class DREAMACCOUNT_API FDreamAccountBanList
+{
+public:
+	static FDreamAccountBanList& Get();
+
+	/**
+	 * @brief 开始定期同步。
+	 *
+	 * @param IntervalSeconds 同步间隔（秒）。
+	 */
+	void Start(double IntervalSeconds);
+
+	/**
+	 * @brief 停止同步，已同步的列表保留。
+	 */
+	void Stop();
+
+	/**
+	 * @brief 立即同步一次，已有同步在进行时忽略。
+	 */
+	void SyncNow();
+
+	/** 是否已完成至少一次同步 */
+	bool IsReady() const { return Version.load(std::memory_order_acquire) >= 0; }
+
+	/** 用户是否被封禁，尚未同步时返回 false，可在任意线程调用 */
+	bool IsBanned(int32 UserID) const;
+
+	/** 获取同步统计 */
+	FDreamAccountBanListStats GetStats() const;
+
+private:
+	FDreamAccountBanList();
+
+	void HandleResponse(uint32 SyncSerial, double RequestTime, const FDreamAccountHttpResponse& Response);
+	void Publish(FDreamAccountBanSet::FRef NewSet, bool bSnapshot, double RequestTime);
+	void FinishSync(bool bSucceeded);
+
+	/** 获取当前集合，可在任意线程调用 */
+	FDreamAccountBanSet::FRef GetCurrent() const;
+
+	/** 保护 Current 不被其他线程读到替换中途的状态：发布（仅游戏线程）在替换指针时持有写锁，其他线程查询时持有读锁 */
+	mutable FRWLock CurrentLock;
+
+	/** 当前集合，旧集合在最后一个持有者释放时销毁 */
+	FDreamAccountBanSet::FRef Current;
+
+	std::atomic<int64> Version;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+	double IntervalSeconds = 0.0;
+	bool bSyncInProgress = false;
+
+	/** 每次 Stop 递增，丢弃停止前发出的请求的结果 */
+	uint32 SyncSerial = 0;
+
+	/** 最近一次成功同步时发出请求的时间，服务器数据至少与该时刻一样新 */
+	double LastSyncRequestTime = 0.0;
+	double LastSyncDurationSeconds = 0.0;
+	int32 SnapshotCount = 0;
+	int32 DeltaCount = 0;
+	int32 FailureCount = 0;
+};
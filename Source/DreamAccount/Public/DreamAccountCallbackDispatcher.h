@@ -0,0 +1,123 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @brief 结果回调的分发优先级
+ */
+enum class EDreamAccountDispatchPriority : uint8
+{
+	/** 玩家正在等待的操作：注册、登录、认证、用户名检查等 */
+	Interactive,
+
+	/** 批量用户查询、玩家加入校验、延迟测试等 */
+	Background,
+
+	Count
+};
+
+/**
+ * @class FDreamAccountCallbackDispatcher
+ * @brief 在游戏线程上按每帧时间预算分发账号操作的结果回调。
+ *
+ * 本帧预算还有剩余且没有排队的回调时直接执行；同一帧内完成的操作较多时（批量查询、玩家集中加入、
+ * 重新认证后的重放），超出预算的回调排队到后续帧执行，交互操作优先于后台操作，避免一帧内执行过多蓝图逻辑造成卡顿。
+ * 每帧至少执行一个回调，保证队列总能排空。
+ *
+ * 预算由 UDreamAccountSettings::DispatchFrameBudgetMs 配置，设置为 0 时所有回调立即执行。
+ */
+class DREAMACCOUNT_API FDreamAccountCallbackDispatcher
+{
+public:
+	static FDreamAccountCallbackDispatcher& Get();
+
+	/**
+	 * @brief 分发一个结果回调，可以在任意线程调用，回调总在游戏线程执行。
+	 *
+	 * @param Priority 分发优先级。
+	 * @param Callback 回调，捕获的对象需要自行判断是否仍然有效。
+	 */
+	void Dispatch(EDreamAccountDispatchPriority Priority, TFunction<void()> Callback);
+
+	/** 立即执行所有排队的回调 */
+	void Flush();
+
+	/** 丢弃所有排队的回调并停止每帧的分发 */
+	void Reset();
+
+	/** 排队中的回调数 */
+	int32 Num() const;
+
+	/**
+	 * @brief 获取排队延迟与预算使用统计。
+	 */
+	FDreamAccountDispatchStats GetStats() const;
+
+	/**
+	 * @brief 清空统计。
+	 */
+	void ResetStats();
+
+private:
+	FDreamAccountCallbackDispatcher();
+
+	struct FQueuedCallback
+	{
+		TFunction<void()> Callback;
+		double EnqueueTime = 0.0;
+
+		/** 分发时的追踪上下文，回调执行期间恢复 */
+		FDreamAccountTraceContext Trace;
+	};
+
+	/** 先进先出队列，已执行的元素在排空或积累较多时统一移除 */
+	struct FQueue
+	{
+		TArray<FQueuedCallback> Items;
+		int32 Head = 0;
+
+		int32 Num() const { return Items.Num() - Head; }
+		void Push(FQueuedCallback&& Item) { Items.Add(MoveTemp(Item)); }
+		FQueuedCallback Pop();
+	};
+
+	bool Tick(float DeltaTime);
+
+	/** 新的一帧开始时重置已用预算 */
+	void BeginFrame();
+
+	/** 执行一个回调并计入本帧已用预算 */
+	void Execute(TFunction<void()>& Callback, const FDreamAccountTraceContext& Trace);
+
+	/** 按优先级取出下一个回调，没有排队的回调时返回 false */
+	bool PopNext(FQueuedCallback& OutItem, EDreamAccountDispatchPriority& OutPriority);
+
+	void EnsureTicker();
+
+	static double GetFrameBudgetSeconds();
+
+	FQueue Queues[static_cast<int32>(EDreamAccountDispatchPriority::Count)];
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	uint64 BudgetFrame = 0;
+	double FrameSpentSeconds = 0.0;
+
+	/** 正在执行回调，期间新分发的回调一律排队，避免嵌套执行重复计时 */
+	bool bExecuting = false;
+
+	int64 DispatchedCount = 0;
+	int64 DeferredCount = 0;
+	int32 PeakQueueLength = 0;
+	int32 BudgetExceededFrameCount = 0;
+	int32 SlowCallbackCount = 0;
+	double LongestCallbackSeconds = 0.0;
+	double MaxQueueLatencySeconds = 0.0;
+	double TotalQueueLatencySeconds[static_cast<int32>(EDreamAccountDispatchPriority::Count)] = {};
+	int64 QueueLatencySampleCount[static_cast<int32>(EDreamAccountDispatchPriority::Count)] = {};
+};
@@ -0,0 +1,86 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @class FDreamAccountConditionalCache
+ * @brief 保存响应的校验器（ETag / Last-Modified）与解析后的用户信息，用于条件请求。
+ *
+ * 令牌认证与批量用户查询的结果大多与上次相同。响应带有校验器时，缓存解析后的用户信息；
+ * 下次同样的请求附带 If-None-Match / If-Modified-Since，服务器返回 304 时直接复用缓存，
+ * 不再下载与解析 JSON。条目按最近使用淘汰，仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountConditionalCache
+{
+public:
+	/**
+	 * @brief 配置最大条目数，小于等于 0 时禁用条件请求。
+	 */
+	void Configure(int32 InMaxEntries);
+
+	/**
+	 * @brief 为请求附加已保存的校验器。
+	 *
+	 * @param Key 请求的缓存键，同一个键对应的响应内容应当只取决于请求本身。
+	 * @return 是否附加了校验器（即请求是否为条件请求）。
+	 */
+	bool ApplyValidators(const FString& Key, FDreamAccountHttpRequest& Request);
+
+	/**
+	 * @brief 处理 304 响应，返回缓存的用户信息。
+	 *
+	 * @return 响应不是 304 或没有对应条目时返回 nullptr。
+	 */
+	const TArray<FDreamAccountUser>* HandleNotModified(const FString& Key, const FDreamAccountHttpResponse& Response);
+
+	/**
+	 * @brief 保存 200 响应的校验器与解析结果，响应没有校验器时移除旧条目。
+	 *
+	 * @param ParseSeconds 解析响应所用的时间，304 时计入节省的解析时间。
+	 */
+	void Store(const FString& Key, const FDreamAccountHttpResponse& Response, const TArray<FDreamAccountUser>& Users, double ParseSeconds);
+
+	/** 移除一个条目 */
+	void Remove(const FString& Key);
+
+	/** 清空所有条目 */
+	void Empty();
+
+	/**
+	 * @brief 获取条件请求统计。
+	 */
+	FDreamAccountConditionalStats GetStats() const;
+
+	/** 清空统计 */
+	void ResetStats();
+
+private:
+	struct FEntry
+	{
+		FString ETag;
+		FString LastModified;
+		TArray<FDreamAccountUser> Users;
+
+		/** 原始响应体的字节数 */
+		int64 ContentBytes = 0;
+
+		/** 解析原始响应所用的时间（秒） */
+		double ParseSeconds = 0.0;
+
+		double LastUsedTime = 0.0;
+	};
+
+	void EvictLeastRecentlyUsed();
+
+	TMap<FString, FEntry> Entries;
+	int32 MaxEntries = 0;
+
+	int32 ConditionalRequestCount = 0;
+	int32 NotModifiedCount = 0;
+	int64 BytesSaved = 0;
+	double ParseSecondsSaved = 0.0;
+};
@@ -0,0 +1,78 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DreamAccountTypes.h"
+#include "GameFramework/GameModeBase.h"
+#include "DreamAccountGameModeBase.generated.h"
+
+/**
+ * @class ADreamAccountGameModeBase
+ * @brief 在异步 PreLogin 中校验加入玩家账号令牌的 GameMode 基类。
+ *
+ * 客户端在连接地址中附带 MakeLoginOptions() 返回的选项，服务器在 PreLoginAsync 中通过
+ * FDreamAccountAdmissionController 排队校验令牌，不阻塞游戏线程；校验通过后可以用 GetPlayerAccount 获取玩家的账号信息。
+ */
+UCLASS()
+class DREAMACCOUNT_API ADreamAccountGameModeBase : public AGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+	/** 连接地址中携带令牌的选项名 */
+	static const TCHAR* TokenOptionName;
+
+	/** 连接地址中携带用户名的选项名，仅用于分片路由 */
+	static const TCHAR* UserNameOptionName;
+
+	/**
+	 * @brief 生成客户端连接服务器时需要附加的地址选项，例如 "?DreamToken=...?DreamUser=..."。
+	 *
+	 * 令牌和用户名经过 URL 编码，服务器端解码后使用。连接地址会出现在引擎的连接与切换关卡日志中，
+	 * 发布版本应关闭或过滤这些日志。未登录时返回空字符串。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Admission")
+	static FString MakeLoginOptions();
+
+	/**
+	 * @brief 获取已通过校验的玩家的账号信息。
+	 *
+	 * @return 该玩家是否通过了账号校验。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Admission")
+	bool GetPlayerAccount(APlayerController* PlayerController, FDreamAccountUser& OutUser) const;
+
+	virtual void PreLoginAsync(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, const FOnPreLoginCompleteDelegate& OnComplete) override;
+	virtual FString InitNewPlayer(APlayerController* NewPlayerController, const FUniqueNetIdRepl& UniqueId, const FString& Options, const FString& Portal = TEXT("")) override;
+	virtual void Logout(AController* Exiting) override;
+
+protected:
+	/** 没有携带令牌的玩家是否拒绝加入 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "DreamAccount")
+	bool bRequireAccountToken = true;
+
+	/**
+	 * @brief 玩家通过账号校验后调用，可以在这里拒绝加入（返回非空错误信息）。
+	 */
+	UFUNCTION(BlueprintNativeEvent, Category = "DreamAccount|Admission")
+	FString OnPlayerAdmitted(const FDreamAccountAdmissionResult& Result);
+
+	/** 拒绝加入时返回给客户端的错误信息 */
+	static FString MakeErrorMessage(EDreamAccountErrorType ErrorType);
+
+private:
+	/** 通过 PreLogin 但尚未创建 PlayerController 的玩家，按令牌索引 */
+	struct FAdmittedPlayer
+	{
+		FDreamAccountUser User;
+		double AdmitTime = 0.0;
+	};
+
+	/** 清理连接已断开、不会再进入 InitNewPlayer 的记录 */
+	void PruneAdmittedPlayers(double Now);
+
+	TMap<FString, FAdmittedPlayer> AdmittedPlayers;
+
+	TMap<TWeakObjectPtr<APlayerController>, FDreamAccountUser> PlayerAccounts;
+};
@@ -0,0 +1,141 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FDreamAccountHttpResponse;
+
+using FDreamAccountHttpCallback = TFunction<void(const FDreamAccountHttpResponse&)>;
+
+/**
+ * @brief HTTP 请求的取消句柄
+ *
+ * 取消后请求的完成回调不会再被调用；经由引擎 HTTP 模块发送的请求会被中止。仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountHttpCancellation
+{
+public:
+	/** 取消请求 */
+	void Cancel();
+
+	/** 是否已取消 */
+	bool IsCancelled() const { return bCancelled; }
+
+	/** 由传输层注册中止函数，已取消时立即调用 */
+	void SetAbortHandler(TFunction<void()> Handler);
+
+private:
+	TFunction<void()> AbortHandler;
+	bool bCancelled = false;
+};
+
+/**
+ * @brief W3C Trace Context 中的追踪上下文
+ */
+struct DREAMACCOUNT_API FDreamAccountTraceContext
+{
+	/** 32 位小写十六进制的 trace-id */
+	FString TraceId;
+
+	/** 16 位小写十六进制的 span-id，追踪的根尚未创建任何 span 时为空 */
+	FString SpanId;
+
+	/** 是否采样（记录并导出 span） */
+	bool bSampled = false;
+
+	bool IsValid() const { return !TraceId.IsEmpty(); }
+
+	/** 生成 traceparent 请求头的值 */
+	FString ToTraceParent() const;
+};
+
+/**
+ * @brief 插件内部使用的 HTTP 请求描述
+ *
+ * 与具体传输方式无关，既可以交给引擎的 HTTP 模块发送，
+ * 也可以由网络模拟器在进程内处理。
+ */
+struct DREAMACCOUNT_API FDreamAccountHttpRequest
+{
+	/** 请求的目标URL地址 */
+	FString URL;
+
+	/** HTTP请求方法（如GET、POST等） */
+	FString Verb;
+
+	/** 请求体内容 */
+	FString Content;
+
+	/** HTTP请求头信息映射表 */
+	TMap<FString, FString> Headers;
+
+	/** 超时时间（秒），小于等于 0 时使用 UDreamAccountSettings::TimeoutTime，启用自适应超时时使用该接口的估计值 */
+	float Timeout = 0.0f;
+
+	/** 可选的取消句柄 */
+	TSharedPtr<FDreamAccountHttpCancellation> Cancellation;
+
+	/** 请求是否幂等、允许对冲（重复发送），只有启用 bEnableRequestHedging 时生效 */
+	bool bHedgeable = false;
+
+	/**
+	 * 分片迁移窗口内，新分片回答不归它所有（404/421）时是否允许改发到原分片。
+	 * GET 与 bHedgeable 请求总是允许；其他请求需要确认重发不会重复产生副作用时才设置，例如登录。
+	 */
+	bool bShardFallback = false;
+
+	/** 所属的追踪上下文，启用追踪时由 SendHttpRequest 在发起请求时填充 */
+	FDreamAccountTraceContext Trace;
+
+	/** 获取去掉协议、主机和查询参数后的路径，例如 /api/account/login */
+	FString GetPath() const;
+
+	/** 获取查询参数的值，不存在时返回空字符串 */
+	FString GetQueryParameter(const FString& Name) const;
+
+	/** 获取实际使用的超时时间 */
+	float GetEffectiveTimeout() const;
+};
+
+/**
+ * @brief 插件内部使用的 HTTP 响应
+ *
+ * 所有账号请求的完成回调都接收该结构，而不是引擎的 IHttpResponse，
+ * 这样网络模拟器等中间层可以在没有真实连接的情况下构造响应。
+ */
+struct DREAMACCOUNT_API FDreamAccountHttpResponse
+{
+	/** 传输层是否成功（连接失败、超时时为 false） */
+	bool bSucceeded = false;
+
+	/** HTTP状态码，传输失败时为 0 */
+	int32 ResponseCode = 0;
+
+	/** 响应体内容 */
+	FString Content;
+
+	/** 响应头信息映射表 */
+	TMap<FString, FString> Headers;
+
+	/** 从发出请求到完成的耗时（秒） */
+	double ElapsedSeconds = 0.0;
+
+	/** 从发出请求到收到第一个响应头的耗时（秒），0 表示未知 */
+	double FirstByteSeconds = 0.0;
+
+	/** 是否由网络模拟器生成或修改 */
+	bool bSimulated = false;
+
+	/** 获取响应头的值（不区分大小写），不存在时返回空字符串 */
+	FString GetHeader(const FString& Name) const;
+
+	/** 构造一个传输失败的响应 */
+	static FDreamAccountHttpResponse MakeFailure(double InElapsedSeconds = 0.0);
+
+	/** 构造一个 JSON 响应 */
+	static FDreamAccountHttpResponse MakeJson(int32 InResponseCode, FString InContent);
+
+	/** 构造一个 {"error": "..."} 格式的错误响应 */
+	static FDreamAccountHttpResponse MakeError(int32 InResponseCode, const FString& ErrorCode);
+};
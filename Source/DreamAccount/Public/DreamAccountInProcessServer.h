@@ -0,0 +1,194 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountKeyDerivation.h"
+#include "DreamAccountValidation.h"
+
+class FJsonObject;
+
+/**
+ * @class FDreamAccountInProcessServer
+ * @brief 进程内的账号服务器替身。
+ *
+ * 与 Tools/StandInServer 中的替身服务器行为一致，数据保存在内存中，
+ * 由网络模拟器在 bServeInProcess 模式下调用，使插件在没有任何服务器时也能完整运行。
+ * 可以通过 RegisterHandler 覆盖或扩展接口。仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountInProcessServer
+{
+public:
+	using FHandler = TFunction<FDreamAccountHttpResponse(const FDreamAccountHttpRequest&)>;
+
+	FDreamAccountInProcessServer();
+
+	/**
+	 * @brief 注册或替换一个接口处理函数。
+	 *
+	 * @param Verb HTTP请求方法。
+	 * @param Path 请求路径，例如 /api/account/login。
+	 * @param Handler 处理函数。
+	 */
+	void RegisterHandler(const FString& Verb, const FString& Path, FHandler Handler);
+
+	/**
+	 * @brief 移除一个接口处理函数。
+	 */
+	void UnregisterHandler(const FString& Verb, const FString& Path);
+
+	/**
+	 * @brief 处理请求并同步返回响应，未注册的接口返回 404。
+	 */
+	FDreamAccountHttpResponse HandleRequest(const FDreamAccountHttpRequest& Request);
+
+	/**
+	 * @brief 清空内存中的账号数据。
+	 */
+	void Reset();
+
+	/**
+	 * @brief 预先创建账号，用户名和密码均为 user_0 ... user_{Count-1}。
+	 */
+	void SeedUsers(int32 Count);
+
+	/**
+	 * @brief 修改用户的封禁状态，并记入供 /api/account/bans 返回增量的变更日志。
+	 */
+	void SetUserBanned(int32 UserID, bool bBanned);
+
+	/**
+	 * @brief 限制每秒放行的登录数，超出的登录收到排队票据，0 表示不限制。
+	 */
+	void SetLoginRate(float LoginsPerSecond);
+
+	/**
+	 * @brief 获取 /api/account/metrics/latency 收到的延迟信标批次（已解压的 JSON）。
+	 */
+	const TArray<TSharedPtr<FJsonObject>>& GetLatencyBeaconBatches() const { return LatencyBeaconBatches; }
+
+public:
+	/** 解析请求体中的 JSON 对象 */
+	static TSharedPtr<FJsonObject> ParseRequestJson(const FDreamAccountHttpRequest& Request);
+
+	/** 将 JSON 对象序列化为响应 */
+	static FDreamAccountHttpResponse MakeJsonResponse(int32 ResponseCode, const TSharedRef<FJsonObject>& Json);
+
+	/**
+	 * @brief 将 JSON 对象序列化为带 ETag 的 200 响应，请求的 If-None-Match 与内容一致时返回 304。
+	 */
+	static FDreamAccountHttpResponse MakeCacheableJsonResponse(const FDreamAccountHttpRequest& Request, const TSharedRef<FJsonObject>& Json);
+
+protected:
+	struct FUserRecord
+	{
+		int32 UserID = 0;
+		FString Name;
+		FString Password;
+
+		/** 客户端派生密码的 SHA-256（小写十六进制），为空表示只有原始密码 */
+		FString KdfVerifier;
+	};
+
+	FDreamAccountHttpResponse HandleRegister(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleLogin(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleRegisterAndLogin(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleAuth(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleRefresh(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleUsernameAvailable(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleValidationRules(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleKdfParams(const FDreamAccountHttpRequest& Request);
+
+	/** 读取请求中的用户名和密码，密码经过客户端派生时 bOutDerived 为 true */
+	static bool ParseCredentials(const FDreamAccountHttpRequest& Request, FString& OutName, FString& OutPassword, bool& bOutDerived, FDreamAccountHttpResponse& OutError);
+
+	/** 校验密码，客户端派生的密码与只有原始密码的旧账号比对成功时升级为派生校验值 */
+	bool CheckPassword(FUserRecord& User, const FString& Password, bool bDerived) const;
+
+	/** 按用户名生成固定的派生参数，不存在的用户名也返回参数，不泄露账号是否存在 */
+	FDreamAccountKdfParams MakeKdfParams(const FString& Name) const;
+
+	/** 按校验规则检查注册信息，不符合时返回 400 错误响应；派生后的密码只检查用户名 */
+	bool ValidateRegister(const FString& Name, const FString& Password, bool bDerived, FDreamAccountHttpResponse& OutError) const;
+	FDreamAccountHttpResponse HandleUsersLookup(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleBans(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleLatencyBeacons(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleLoginQueue(const FDreamAccountHttpRequest& Request);
+	FDreamAccountHttpResponse HandleLoginQueueLeave(const FDreamAccountHttpRequest& Request);
+
+	/** 检查登录是否可以放行，需要排队时填充带排队票据的 429 响应并返回 false */
+	bool AdmitLogin(const FDreamAccountHttpRequest& Request, const FString& Name, FDreamAccountHttpResponse& OutQueued);
+
+	/** 按放行速率推进放行游标 */
+	void AdvanceLoginQueue();
+
+	/** 生成等待中的排队对象 */
+	TSharedRef<FJsonObject> MakeQueueJson(const FString& Ticket, int64 Sequence) const;
+
+	/** 校验 Bearer 令牌，失败时填充 OutError 并返回 nullptr */
+	const FUserRecord* FindBearerUser(const FDreamAccountHttpRequest& Request, FDreamAccountHttpResponse& OutError) const;
+
+	const FUserRecord* CreateUser(const FString& Name, const FString& Password, bool bDerived = false);
+	FString IssueToken(const FUserRecord& User);
+
+	static TSharedRef<FJsonObject> MakeUserJson(const FUserRecord& User);
+
+	TMap<FString, FHandler> Handlers;
+
+	TMap<int32, FUserRecord> UsersByID;
+	TMap<FString, int32> UserIDsByName;
+	TMap<FString, int32> UserIDsByToken;
+	int32 NextUserID = 10000;
+
+	/** 封禁变更日志保留的条数，更早的客户端需要重新下载快照 */
+	static constexpr int32 BanLogLimit = 1024;
+
+	TSet<int32> BannedUserIDs;
+	int64 BanVersion = 0;
+
+	/** 封禁变更日志：版本、UserID、是否封禁 */
+	TArray<TTuple<int64, int32, bool>> BanLog;
+
+	/** 生成派生盐的密钥，每次启动随机生成 */
+	TArray<uint8> KdfSecret;
+
+	/** 下发给客户端的 scrypt 参数 */
+	int32 KdfCostN = 16384;
+	int32 KdfBlockSize = 8;
+	int32 KdfParallelism = 1;
+
+	/** 收到的延迟信标批次 */
+	TArray<TSharedPtr<FJsonObject>> LatencyBeaconBatches;
+
+	struct FQueueTicket
+	{
+		FString UserName;
+		int64 Sequence = 0;
+	};
+
+	struct FQueueAdmission
+	{
+		FString UserName;
+		double ExpireTime = 0.0;
+	};
+
+	/** 准入凭证的有效期（秒） */
+	static constexpr double QueueAdmissionTimeToLive = 30.0;
+
+	/** 每秒放行的登录数，0 表示不限制 */
+	float LoginRate = 0.0f;
+
+	/** 序号小于该值的登录已被放行，按 LoginRate 匀速增长 */
+	double LoginQueueCursor = 0.0;
+
+	/** 已分配的登录序号数，直接放行的登录也占用一个序号 */
+	int64 LoginQueueIssued = 0;
+	double LoginQueueAdvanceTime = 0.0;
+
+	TMap<FString, FQueueTicket> LoginQueueTickets;
+	TMap<FString, FQueueAdmission> LoginQueueAdmissions;
+
+	/** 服务器端校验规则，与客户端内置的默认规则相同 */
+	FDreamAccountValidationRules ValidationRules;
+};
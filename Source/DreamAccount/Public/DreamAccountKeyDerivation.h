@@ -0,0 +1,78 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @struct FDreamAccountKdfParams
+ * @brief 服务器下发的密钥派生参数（scrypt）。
+ */
+struct DREAMACCOUNT_API FDreamAccountKdfParams
+{
+	/** 算法名，目前只支持 scrypt */
+	FString Algorithm = TEXT("scrypt");
+
+	/** 盐，由服务器按用户名生成 */
+	TArray<uint8> Salt;
+
+	/** CPU/内存开销 N，必须是 2 的幂 */
+	int32 CostN = 16384;
+
+	/** 块大小 r */
+	int32 BlockSize = 8;
+
+	/** 并行度 p */
+	int32 Parallelism = 1;
+
+	/** 派生密钥的字节数 */
+	int32 KeyLength = 32;
+
+	/** 参数是否合法 */
+	bool IsValid() const;
+
+	/** 计算一次所需的内存（字节），约为 128 * r * N */
+	uint64 GetMemoryBytes() const;
+
+	/** 从 /api/account/kdf_params 的响应中解析 */
+	bool LoadFromJson(const FString& JsonString);
+};
+
+/**
+ * @class FDreamAccountKeyDerivation
+ * @brief 客户端密码密钥派生（scrypt，RFC 7914）。
+ *
+ * 启用后客户端先用服务器下发的盐和参数对密码做内存困难的派生，再把派生结果发给服务器，
+ * 服务器只需对派生结果做一次廉价的哈希，登录与注册的主要计算开销转移到客户端。
+ * 派生在任务图的后台工作线程上进行，不会卡住游戏线程。
+ */
+class DREAMACCOUNT_API FDreamAccountKeyDerivation
+{
+public:
+	/** 派生完成回调，在游戏线程调用，DerivedKey 为小写十六进制 */
+	using FDeriveCallback = TFunction<void(bool bSucceeded, const FString& DerivedKey)>;
+
+	/**
+	 * @brief 同步计算 scrypt，耗时较长，不要在游戏线程调用。
+	 *
+	 * @return 参数不合法或内存不足时返回 false。
+	 */
+	static bool Scrypt(const TArray<uint8>& Password, const FDreamAccountKdfParams& Params, TArray<uint8>& OutKey);
+
+	/**
+	 * @brief 在后台工作线程派生密码，完成后在游戏线程回调。
+	 */
+	static void DeriveAsync(const FString& Password, const FDreamAccountKdfParams& Params, FDeriveCallback Callback);
+
+	/** 同步派生密码并返回小写十六进制结果，失败时返回空字符串 */
+	static FString DeriveToHex(const FString& Password, const FDreamAccountKdfParams& Params);
+
+	/** 计算 SHA-256 */
+	static TArray<uint8> Sha256(const TArray<uint8>& Data);
+
+	/** 计算 HMAC-SHA256 */
+	static TArray<uint8> HmacSha256(const TArray<uint8>& Key, const TArray<uint8>& Data);
+
+	/** 按 RFC 7914 的测试向量检查实现是否正确 */
+	static bool SelfTest();
+};
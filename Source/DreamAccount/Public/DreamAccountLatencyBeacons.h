@@ -0,0 +1,117 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @class FDreamAccountLatencyBeacons
+ * @brief 采集玩家实际感受到的请求延迟，定期按批上传到指标接口。
+ *
+ * 每个完成的请求按采样率记录首字节时间与总耗时，保存在固定容量的环形缓冲区中，两次上传之间超出容量时覆盖最旧的记录。
+ * 上传时按接口（请求方法 + 地址，包含分片主机）聚合为固定分桶的直方图，整批 JSON 经 zlib 压缩后以 Base64 放入请求体，
+ * 请求仍经过网络模拟与录制等中间层。上传失败的批次直接丢弃，不占用后续批次的带宽。仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountLatencyBeacons
+{
+public:
+	static FDreamAccountLatencyBeacons& Get();
+
+	/**
+	 * @brief 按当前设置分配缓冲区并开始定期上传。
+	 */
+	void Start();
+
+	/**
+	 * @brief 停止上传并丢弃尚未上传的记录。
+	 */
+	void Stop();
+
+	/** 是否正在采集 */
+	bool IsEnabled() const { return TickerHandle.IsValid(); }
+
+	/**
+	 * @brief 决定是否记录该请求：未启用、信标自身的上传请求或未被采样时返回 false。
+	 */
+	bool ShouldRecord(const FDreamAccountHttpRequest& Request) const;
+
+	/**
+	 * @brief 记录一个请求的耗时，被取消的请求忽略。
+	 */
+	void Record(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpResponse& Response);
+
+	/**
+	 * @brief 立即上传缓冲区中的记录，已有上传在进行或缓冲区为空时忽略。
+	 */
+	void UploadNow();
+
+	/**
+	 * @brief 获取采集与上传统计。
+	 */
+	FDreamAccountLatencyBeaconStats GetStats() const;
+
+	/**
+	 * @brief 清空统计。
+	 */
+	void ResetStats();
+
+	/** 直方图各桶的上界（毫秒），超过最后一个上界的耗时计入额外的溢出桶 */
+	static TConstArrayView<int32> GetBucketBoundsMs();
+
+private:
+	FDreamAccountLatencyBeacons();
+
+	struct FSample
+	{
+		int32 EndpointIndex = INDEX_NONE;
+		int32 ResponseCode = 0;
+
+		/** 首字节时间（毫秒），小于 0 表示未知 */
+		float FirstByteMs = -1.0f;
+		float TotalMs = 0.0f;
+		bool bSucceeded = false;
+	};
+
+	bool Tick(float DeltaTime);
+
+	/** 将缓冲区中的记录聚合为一批 JSON */
+	FString BuildBatch() const;
+
+	/** 清空缓冲区与接口表，开始新的一批 */
+	void ResetBatch();
+
+	void HandleUploadResponse(const FDreamAccountHttpResponse& Response);
+
+	static int32 FindBucket(float Milliseconds);
+
+	/** 固定容量的环形缓冲区，Head 为下一个写入位置 */
+	TArray<FSample> Samples;
+	int32 Head = 0;
+	int32 Count = 0;
+
+	/** 本批出现过的接口，记录中只保存下标 */
+	TArray<FString> EndpointKeys;
+	TMap<FString, int32> EndpointIndices;
+
+	FString UploadURL;
+	FString Region;
+	float SampleRate = 1.0f;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+	double BatchStartTime = 0.0;
+	bool bUploadInProgress = false;
+
+	/** 每次 Stop 递增，丢弃停止前发出的上传的结果 */
+	uint32 UploadSerial = 0;
+
+	int32 RecordedCount = 0;
+	int32 OverwrittenCount = 0;
+	int32 BatchOverwrittenCount = 0;
+	int32 UploadCount = 0;
+	int32 UploadFailureCount = 0;
+	int32 LastBatchRawBytes = 0;
+	int32 LastBatchCompressedBytes = 0;
+};
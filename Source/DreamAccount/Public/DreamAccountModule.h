@@ -3,8 +3,14 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
 #include "Modules/ModuleManager.h"
 
+DREAMACCOUNT_API DECLARE_LOG_CATEGORY_EXTERN(LogDreamAccount, Log, All);
+
+/** 插件内存分配的 LLM 标签，请求、响应解析与结果回调都在该标签下分配，可通过 -llm 与 stat LLM 查看 */
+LLM_DECLARE_TAG_API(DreamAccount, DREAMACCOUNT_API);
+
 class FDreamAccountModule : public IModuleInterface
 {
 public:
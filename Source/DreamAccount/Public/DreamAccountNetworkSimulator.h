@@ -0,0 +1,87 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountInProcessServer.h"
+#include "DreamAccountSettings.h"
+#include "Math/RandomStream.h"
+
+/**
+ * @class FDreamAccountNetworkSimulator
+ * @brief 位于 FDreamAccountUtil::SendHttpRequest 与真实 HTTP 模块之间的网络模拟层。
+ *
+ * 根据 UDreamAccountSettings::NetworkSimulation 以及 DreamAccount.NetSim.* 控制台变量，
+ * 为请求注入延迟、带宽限制、丢包重传、超时和错误响应，
+ * 也可以完全由进程内替身服务器生成响应，不需要任何网络。仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountNetworkSimulator
+{
+public:
+	static FDreamAccountNetworkSimulator& Get();
+
+	/**
+	 * @brief 当前是否启用网络模拟（控制台变量优先于项目设置）。
+	 */
+	bool IsEnabled() const;
+
+	/**
+	 * @brief 获取叠加控制台变量覆盖后的模拟参数。
+	 */
+	FDreamAccountNetworkSimulationSettings GetEffectiveSettings() const;
+
+	/**
+	 * @brief 以模拟网络条件发送请求。
+	 *
+	 * @param Request 请求描述。
+	 * @param OnComplete 请求完成后的回调函数。
+	 */
+	void SendHttpRequest(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& OnComplete);
+
+	/**
+	 * @brief 获取进程内替身服务器，可用于注册自定义接口或预置账号。
+	 */
+	FDreamAccountInProcessServer& GetInProcessServer() { return InProcessServer; }
+
+	/** 模拟统计 */
+	uint64 GetSimulatedRequestCount() const { return SimulatedRequestCount; }
+	uint64 GetInjectedTimeoutCount() const { return InjectedTimeoutCount; }
+	uint64 GetInjectedTooManyRequestsCount() const { return InjectedTooManyRequestsCount; }
+	uint64 GetInjectedInternalErrorCount() const { return InjectedInternalErrorCount; }
+	uint64 GetLostPacketCount() const { return LostPacketCount; }
+
+	/**
+	 * @brief 在指定秒数后于游戏线程执行回调。
+	 */
+	static void ExecuteAfter(double DelaySeconds, TFunction<void()> Callback);
+
+private:
+	FDreamAccountNetworkSimulator();
+
+	/** 采样一次往返延迟（秒） */
+	double SampleRoundTripSeconds(const FDreamAccountNetworkSimulationSettings& Settings);
+
+	/** 计算传输指定字节数所需的时间（秒），包含带宽限制和丢包重传 */
+	double ComputeTransferSeconds(int64 Bytes, double RoundTripSeconds, const FDreamAccountNetworkSimulationSettings& Settings);
+
+	static int64 EstimateRequestBytes(const FDreamAccountHttpRequest& Request);
+	static int64 EstimateResponseBytes(const FDreamAccountHttpResponse& Response);
+
+	/** 在总耗时超过超时时间时改为超时失败，否则按耗时完成；FirstByteDelaySeconds 为模拟的首字节时间 */
+	static void CompleteAfter(double StartTime, double DelaySeconds, double FirstByteDelaySeconds, double TimeoutSeconds, FDreamAccountHttpResponse Response, const FDreamAccountHttpCallback& OnComplete);
+
+	void EnsureSeeded(const FDreamAccountNetworkSimulationSettings& Settings);
+
+	FDreamAccountInProcessServer InProcessServer;
+
+	FRandomStream RandomStream;
+	int32 SeededWith = 0;
+	bool bSeeded = false;
+
+	uint64 SimulatedRequestCount = 0;
+	uint64 InjectedTimeoutCount = 0;
+	uint64 InjectedTooManyRequestsCount = 0;
+	uint64 InjectedInternalErrorCount = 0;
+	uint64 LostPacketCount = 0;
+};
@@ -0,0 +1,83 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "DreamAccountTypes.h"
+
+class IWebSocket;
+
+/**
+ * @class FDreamAccountPushChannel
+ * @brief 账号服务器推送通道（WebSocket 长连接）。
+ *
+ * 使用当前令牌建立连接，接收令牌吊销、封禁和强制登出事件。
+ * 连接断开后按指数退避（带随机抖动）自动重连，直到调用 Disconnect。仅在游戏线程使用。
+ *
+ * 服务器消息格式：{"type": "token_revoked" | "user_banned" | "force_logout" | "ping", "reason": "..."}
+ */
+class DREAMACCOUNT_API FDreamAccountPushChannel
+{
+public:
+	using FOnEvent = TFunction<void(const FDreamAccountPushEvent&)>;
+	using FOnConnectionChanged = TFunction<void(bool)>;
+
+	FDreamAccountPushChannel();
+	~FDreamAccountPushChannel();
+
+	FDreamAccountPushChannel(const FDreamAccountPushChannel&) = delete;
+	FDreamAccountPushChannel& operator=(const FDreamAccountPushChannel&) = delete;
+
+	/**
+	 * @brief 建立连接，已有连接会先被关闭。
+	 *
+	 * @param URL 推送通道地址。
+	 * @param Token 用于认证的令牌。
+	 */
+	void Connect(const FString& URL, const FString& Token);
+
+	/**
+	 * @brief 关闭连接并停止重连。
+	 */
+	void Disconnect();
+
+	/** 当前是否已连接 */
+	bool IsConnected() const { return bConnected; }
+
+	/** 是否处于连接或等待重连状态 */
+	bool IsActive() const { return bActive; }
+
+	/** 收到事件时调用 */
+	FOnEvent OnEvent;
+
+	/** 连接状态变化时调用 */
+	FOnConnectionChanged OnConnectionChanged;
+
+	/** 将服务器的事件类型字符串转换为枚举 */
+	static EDreamAccountPushEventType GetEventTypeFromString(const FString& TypeString);
+
+private:
+	void OpenSocket();
+	void CloseSocket();
+	void ScheduleReconnect();
+	void HandleConnected();
+	void HandleConnectionLost();
+	void HandleMessage(const FString& Message);
+	void SetConnected(bool bNewConnected);
+
+	TSharedPtr<IWebSocket> Socket;
+	FTSTicker::FDelegateHandle ReconnectHandle;
+
+	FString ChannelURL;
+	FString ChannelToken;
+
+	/** 下一次重连前的等待时间（秒） */
+	double ReconnectDelay = 0.0;
+
+	bool bActive = false;
+	bool bConnected = false;
+
+	/** 用于忽略已关闭的旧连接产生的回调 */
+	uint32 SocketSerial = 0;
+};
@@ -0,0 +1,121 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @class FDreamAccountRequestHedger
+ * @brief 对幂等请求进行对冲，降低长尾延迟。
+ *
+ * 标记了 bHedgeable 的请求发出后，若在该接口学习到的延迟分位数（默认 p95）内仍未收到响应，
+ * 会再发送一个相同的请求（可以发往 HedgeAlternateEndpoints 中配置的备用地址），
+ * 采用先到的响应并取消另一个。对冲请求消耗预算，预算按普通请求数的比例积累，避免放大服务器负载。
+ *
+ * 由 FDreamAccountUtil::SendHttpRequest 自动调用，仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountRequestHedger
+{
+public:
+	static FDreamAccountRequestHedger& Get();
+
+	/** 是否启用对冲（回放录制时总是关闭，保证回放结果确定） */
+	bool IsEnabled() const;
+
+	/**
+	 * @brief 发送可对冲的请求。
+	 *
+	 * @param Request 请求描述，取消句柄对主请求和对冲请求同时生效。
+	 * @param OnComplete 收到第一个有效响应后调用一次。
+	 */
+	void SendHttpRequest(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& OnComplete);
+
+	/**
+	 * @brief 获取接口当前的对冲等待时间（秒），样本不足时返回负数，表示暂不对冲。
+	 */
+	double GetHedgeDelay(const FString& EndpointKey) const;
+
+	/**
+	 * @brief 获取各接口的对冲统计。
+	 */
+	TArray<FDreamAccountHedgeStats> GetStats() const;
+
+	/**
+	 * @brief 清空延迟样本与统计。
+	 */
+	void ResetStats();
+
+	/** 统计与学习延迟使用的接口标识：去掉查询参数后的 URL */
+	static FString GetEndpointKey(const FDreamAccountHttpRequest& Request);
+
+private:
+	FDreamAccountRequestHedger();
+
+	/** 每个接口保留的延迟样本数 */
+	static constexpr int32 MaxSamples = 256;
+
+	/** 对冲预算的上限（可连续对冲的次数） */
+	static constexpr double MaxBudgetTokens = 10.0;
+
+	struct FEndpointState
+	{
+		/** 环形缓冲区中的延迟样本（秒） */
+		TArray<float> Samples;
+		int32 NextSample = 0;
+
+		/** 排序后的样本，新增样本较多时才重新排序 */
+		mutable TArray<float> SortedSamples;
+		mutable int32 SamplesSinceSort = 0;
+
+		int32 RequestCount = 0;
+		int32 HedgeCount = 0;
+		int32 HedgeWinCount = 0;
+		int32 BudgetDeniedCount = 0;
+		double EstimatedSavedSeconds = 0.0;
+
+		void AddSample(double Seconds);
+		const TArray<float>& GetSortedSamples() const;
+		double GetPercentile(double Percentile) const;
+
+		/** 超过 Seconds 的样本均值，用于估算被取消的主请求本来需要的时间 */
+		double GetTailMean(double Seconds, double DefaultSeconds) const;
+	};
+
+	struct FHedgedRequest
+	{
+		FDreamAccountHttpRequest Request;
+		FDreamAccountHttpCallback OnComplete;
+		FString EndpointKey;
+		double StartTime = 0.0;
+
+		/** 0 为主请求，1 为对冲请求 */
+		TSharedPtr<FDreamAccountHttpCancellation> Attempts[2];
+		int32 PendingCount = 0;
+		bool bHedged = false;
+		bool bCompleted = false;
+
+		/** 一个请求失败而另一个仍在进行时，暂存失败的响应 */
+		TOptional<FDreamAccountHttpResponse> HeldResponse;
+
+		FTSTicker::FDelegateHandle HedgeTimerHandle;
+	};
+
+	void LaunchAttempt(const TSharedRef<FHedgedRequest>& State, int32 AttemptIndex);
+	void LaunchHedge(const TSharedRef<FHedgedRequest>& State);
+	void HandleAttemptComplete(const TSharedRef<FHedgedRequest>& State, int32 AttemptIndex, const FDreamAccountHttpResponse& Response);
+	void Finish(const TSharedRef<FHedgedRequest>& State, int32 WinnerIndex, const FDreamAccountHttpResponse& Response);
+
+	/** 主请求的备用地址，未配置时返回原地址 */
+	static FString GetAlternateURL(const FString& URL);
+
+	/** 响应是否可以直接采用（传输成功且不是 5xx） */
+	static bool IsUsableResponse(const FDreamAccountHttpResponse& Response);
+
+	bool TryConsumeBudget(FEndpointState& Endpoint);
+
+	TMap<FString, FEndpointState> Endpoints;
+	double BudgetTokens = MaxBudgetTokens;
+};
@@ -0,0 +1,187 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DreamAccountTypes.h"
+#include <atomic>
+
+/**
+ * @brief 不可变的会话快照
+ *
+ * 包含令牌、用户信息、过期时间和代数。发布后不会再被修改，
+ * 因此任意线程拿到引用后都可以直接读取，不需要加锁或拷贝字符串。
+ */
+struct DREAMACCOUNT_API FDreamAccountSession : public TSharedFromThis<FDreamAccountSession, ESPMode::ThreadSafe>
+{
+	FDreamAccountSession() = default;
+
+	FDreamAccountSession(FString InToken, FDreamAccountUser InUser, FDateTime InExpiresAt, uint64 InGeneration)
+		: Token(MoveTemp(InToken)), User(MoveTemp(InUser)), ExpiresAt(InExpiresAt), Generation(InGeneration)
+	{
+	}
+
+	/** 认证令牌，未登录时为空 */
+	const FString Token;
+
+	/** 当前用户信息 */
+	const FDreamAccountUser User;
+
+	/** 令牌过期时间（UTC），服务器未提供时为 FDateTime::MaxValue() */
+	const FDateTime ExpiresAt = FDateTime::MaxValue();
+
+	/** 会话代数，每次发布新快照时递增 */
+	const uint64 Generation = 0;
+
+	/** 是否已登录 */
+	bool IsLoggedIn() const { return !Token.IsEmpty(); }
+
+	/** 令牌是否已过期 */
+	bool IsExpired() const { return IsLoggedIn() && FDateTime::UtcNow() >= ExpiresAt; }
+};
+
+using FDreamAccountSessionRef = TSharedRef<const FDreamAccountSession, ESPMode::ThreadSafe>;
+
+/**
+ * @class FDreamAccountSessionStore
+ * @brief 发布会话快照的存储。
+ *
+ * 读取端（任意线程）不加锁：用风险指针（hazard pointer）声明正在读取的快照，再把它转换为共享引用，只有一次引用计数递增。
+ * 写入端在写锁内原子地替换当前快照，旧快照放入待回收列表，没有任何风险指针指向它时才释放存储持有的引用，
+ * 因此读取端不会拿到已释放的对象。风险指针槽位按线程分配，槽位用完的线程退回在读锁内复制共享指针。
+ * 待回收的快照数量不超过槽位数。
+ */
+class DREAMACCOUNT_API FDreamAccountSessionStore
+{
+public:
+	/** 插件使用的全局存储 */
+	static FDreamAccountSessionStore& Get();
+
+	/** 创建独立的存储，例如压力测试使用，不影响全局会话 */
+	FDreamAccountSessionStore();
+
+	FDreamAccountSessionStore(const FDreamAccountSessionStore&) = delete;
+	FDreamAccountSessionStore& operator=(const FDreamAccountSessionStore&) = delete;
+
+	/**
+	 * @brief 获取当前会话快照，可在任意线程调用。
+	 */
+	FDreamAccountSessionRef Acquire() const;
+
+	/**
+	 * @brief 获取当前会话代数，可在任意线程调用，用于低成本地检测会话是否变化。
+	 */
+	uint64 GetGeneration() const { return Generation.load(std::memory_order_acquire); }
+
+	/**
+	 * @brief 发布新的会话快照。
+	 *
+	 * @return 新发布的快照。
+	 */
+	FDreamAccountSessionRef Publish(FString Token, FDreamAccountUser User, FDateTime ExpiresAt);
+
+private:
+	/** 释放没有风险指针指向的旧快照，调用时持有写锁；释放的引用移入 Reclaimed，在锁外销毁 */
+	void ReclaimRetired(TArray<FDreamAccountSessionRef>& Reclaimed);
+
+	/** 写入端互斥；没有风险指针槽位的读取端在读锁内复制 Current */
+	mutable FRWLock CurrentLock;
+
+	/** 当前快照，存储持有的引用 */
+	FDreamAccountSessionRef Current;
+
+	/** 当前快照的地址，读取端不加锁读取 */
+	std::atomic<const FDreamAccountSession*> CurrentPtr;
+
+	/** 已被替换、可能仍有读取端正在转换为共享引用的快照 */
+	TArray<FDreamAccountSessionRef> Retired;
+
+	std::atomic<uint64> Generation;
+};
+
+/**
+ * @brief 会话事件：变化类型与变化前后的快照
+ */
+struct FDreamAccountSessionEvent
+{
+	EDreamAccountSessionEventType Type;
+	FDreamAccountSessionRef Previous;
+	FDreamAccountSessionRef Current;
+
+	/** 令牌是否发生变化 */
+	bool IsTokenChanged() const { return !Previous->Token.Equals(Current->Token, ESearchCase::CaseSensitive); }
+};
+
+/**
+ * @brief 会话事件订阅句柄，用于取消订阅
+ */
+struct FDreamAccountSessionEventHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Reset() { Index = INDEX_NONE; Serial = 0; }
+};
+
+/**
+ * @class FDreamAccountSessionEventBus
+ * @brief 带类型和载荷的会话事件流。
+ *
+ * 每次会话发布时广播一次事件，订阅者拿到变化类型以及变化前后的不可变快照，不需要每帧比较令牌。
+ * 订阅和取消订阅都是常数时间，可以在回调中进行：回调中取消的订阅不再收到后续事件，
+ * 回调中新增的订阅从下一个事件开始接收。仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountSessionEventBus
+{
+public:
+	using FListener = TFunction<void(const FDreamAccountSessionEvent&)>;
+
+	/** 订阅全部事件类型 */
+	static constexpr uint32 AllEventTypes = ~0u;
+
+	/** 事件类型对应的掩码位 */
+	static constexpr uint32 EventTypeBit(EDreamAccountSessionEventType Type) { return 1u << static_cast<uint32>(Type); }
+
+	static FDreamAccountSessionEventBus& Get();
+
+	/**
+	 * @brief 订阅会话事件。
+	 *
+	 * @param Listener 事件回调。
+	 * @param TypeMask 关心的事件类型，由 EventTypeBit 组合，默认全部。
+	 * @return 用于取消订阅的句柄。
+	 */
+	FDreamAccountSessionEventHandle Subscribe(FListener Listener, uint32 TypeMask = AllEventTypes);
+
+	/**
+	 * @brief 取消订阅，句柄随后被重置。
+	 *
+	 * @return 句柄是否仍然有效。
+	 */
+	bool Unsubscribe(FDreamAccountSessionEventHandle& Handle);
+
+	/** 广播事件，由 UDreamAccountSubsystem 在发布会话后调用 */
+	void Broadcast(const FDreamAccountSessionEvent& Event);
+
+	/** 当前订阅数 */
+	int32 Num() const { return Subscribers.Num(); }
+
+private:
+	FDreamAccountSessionEventBus() = default;
+
+	struct FSubscriber
+	{
+		/** 广播时先复制引用，回调中取消订阅也不会释放正在执行的函数 */
+		TSharedRef<const FListener> Listener;
+		uint32 TypeMask = AllEventTypes;
+		uint32 Serial = 0;
+
+		/** 订阅时的事件序号，只接收之后的事件 */
+		uint64 SubscribedAt = 0;
+	};
+
+	TSparseArray<FSubscriber> Subscribers;
+	uint32 NextSerial = 1;
+	uint64 EventSequence = 0;
+};
@@ -6,6 +6,75 @@
 #include "Engine/DeveloperSettings.h"
 #include "DreamAccountSettings.generated.h"
 
+/**
+ * @brief 网络模拟的延迟分布类型
+ */
+UENUM(BlueprintType)
+enum class EDreamAccountLatencyDistribution : uint8
+{
+	Constant, // 固定延迟
+	Uniform, // 在 [Latency - Jitter, Latency + Jitter] 内均匀分布
+	Normal, // 均值为 Latency、标准差为 Jitter 的正态分布
+	LogNormal, // 中位数为 Latency 的对数正态分布，长尾
+};
+
+/**
+ * @brief 网络模拟参数
+ *
+ * 启用后所有经过 FDreamAccountUtil::SendHttpRequest 的请求都会被注入延迟、带宽限制、
+ * 丢包、超时和错误响应。每一项都可以通过 DreamAccount.NetSim.* 控制台变量临时覆盖。
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountNetworkSimulationSettings
+{
+	GENERATED_BODY()
+
+public:
+	/** 是否启用网络模拟 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bEnabled = false;
+
+	/** 由进程内替身服务器直接生成响应，不发出任何真实请求 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bServeInProcess = false;
+
+	/** 往返延迟的分布类型 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EDreamAccountLatencyDistribution LatencyDistribution = EDreamAccountLatencyDistribution::Constant;
+
+	/** 往返延迟（毫秒），作为分布的均值或中位数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float LatencyMs = 100.0f;
+
+	/** 延迟抖动（毫秒），作为分布的半宽或标准差 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float LatencyJitterMs = 30.0f;
+
+	/** 带宽上限（KB/s），0 表示不限制 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float BandwidthKBps = 0.0f;
+
+	/** 每个数据包的丢失概率，丢包会带来重传延迟 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", ClampMax = "1"))
+	float PacketLossRate = 0.0f;
+
+	/** 请求直接超时的概率 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", ClampMax = "1"))
+	float TimeoutRate = 0.0f;
+
+	/** 返回 TOO_MANY_REQUESTS (429) 的概率 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", ClampMax = "1"))
+	float TooManyRequestsRate = 0.0f;
+
+	/** 返回 INTERNAL_ERROR (500) 的概率 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", ClampMax = "1"))
+	float InternalErrorRate = 0.0f;
+
+	/** 随机种子，0 表示每次启动使用不同的种子 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 RandomSeed = 0;
+};
+
 /**
  * 
  */
@@ -33,4 +102,326 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config)
 	float TimeoutTime = 5.0f;
+
+	/**
+	 * UserCacheMaxEntries - 用户信息缓存的最大条目数
+	 *
+	 * 批量查询到的用户信息按 UserID 缓存，超出后淘汰最久未使用的条目。
+	 * 设置为 0 时禁用缓存。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "User Cache", meta = (ClampMin = "0"))
+	int32 UserCacheMaxEntries = 2048;
+
+	/** UserCacheMaxMemoryKB - 用户信息缓存的最大内存占用（KB），0 表示不限制 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "User Cache", meta = (ClampMin = "0"))
+	int32 UserCacheMaxMemoryKB = 512;
+
+	/** UserCacheTimeToLive - 用户信息缓存条目的存活时间（秒），0 表示永不过期 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "User Cache", meta = (ClampMin = "0"))
+	float UserCacheTimeToLive = 300.0f;
+
+	/**
+	 * ConditionalCacheMaxEntries - 条件请求缓存的最大条目数
+	 *
+	 * 令牌认证与批量用户查询的响应带有 ETag 或 Last-Modified 时保存解析结果，
+	 * 下次请求附带 If-None-Match / If-Modified-Since，服务器返回 304 时直接复用。设置为 0 时禁用条件请求。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "User Cache", meta = (ClampMin = "0"))
+	int32 ConditionalCacheMaxEntries = 256;
+
+	/**
+	 * bDownloadValidationRules - 启动时从服务器下载用户名和密码的校验规则
+	 *
+	 * 注册和登录前在本地按规则校验，不符合时直接返回错误而不发送请求。
+	 * 下载失败或关闭时使用插件内置的默认规则。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Validation")
+	bool bDownloadValidationRules = true;
+
+	/**
+	 * UsernameCheckDebounce - 用户名可用性检查的防抖时间（秒）
+	 *
+	 * 同一输入框在该时间内连续输入时只发送最后一次检查。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Username Check", meta = (ClampMin = "0"))
+	float UsernameCheckDebounce = 0.3f;
+
+	/** UsernameTakenCacheTTL - 已占用用户名的缓存时间（秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Username Check", meta = (ClampMin = "0"))
+	float UsernameTakenCacheTTL = 120.0f;
+
+	/** UsernameAvailableCacheTTL - 可用用户名的缓存时间（秒），可用状态随时可能被他人注册，应设置较短 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Username Check", meta = (ClampMin = "0"))
+	float UsernameAvailableCacheTTL = 10.0f;
+
+	/**
+	 * bEnablePushChannel - 是否在登录后建立推送通道
+	 *
+	 * 推送通道是一条 WebSocket 长连接，服务器通过它实时下发令牌吊销、封禁和强制登出事件，
+	 * 从而不再需要频繁轮询认证接口。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Push Channel")
+	bool bEnablePushChannel = false;
+
+	/** PushChannelURL - 推送通道地址，留空时由 AccountServerURL 推导（http -> ws，https -> wss） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Push Channel")
+	FString PushChannelURL;
+
+	/** PushReconnectMinDelay - 断线重连的初始等待时间（秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Push Channel", meta = (ClampMin = "0.1"))
+	float PushReconnectMinDelay = 1.0f;
+
+	/** PushReconnectMaxDelay - 断线重连的最大等待时间（秒），每次失败等待时间翻倍 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Push Channel", meta = (ClampMin = "0.1"))
+	float PushReconnectMaxDelay = 60.0f;
+
+	/**
+	 * AuthPollingInterval - 定期认证轮询间隔（秒），0 表示不轮询
+	 *
+	 * 轮询发现令牌失效或账号被封禁时会清除本地令牌。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Push Channel", meta = (ClampMin = "0"))
+	float AuthPollingInterval = 0.0f;
+
+	/** bSuspendAuthPollingWhilePushConnected - 推送通道连接期间暂停认证轮询 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Push Channel")
+	bool bSuspendAuthPollingWhilePushConnected = true;
+
+	/**
+	 * ShardEndpoints - 账号服务器分片地址列表
+	 *
+	 * 非空时按用户名或 UserID 的一致性哈希把请求路由到对应分片（替换请求地址中的 AccountServerURL 部分），
+	 * 为空时所有请求都发往 AccountServerURL。运行时可以通过 DreamAccount.Shards.Set 修改。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Sharding")
+	TArray<FString> ShardEndpoints;
+
+	/** ShardVirtualNodes - 每个分片在哈希环上的虚拟节点数，越多分布越均匀 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Sharding", meta = (ClampMin = "1"))
+	int32 ShardVirtualNodes = 160;
+
+	/**
+	 * ShardRebalanceWindow - 分片变更后的迁移窗口（秒）
+	 *
+	 * 窗口内归属发生变化的请求在新分片失败（传输失败、401、404、5xx）时会回退到原分片重试一次，
+	 * 给服务端迁移数据留出时间。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Sharding", meta = (ClampMin = "0"))
+	float ShardRebalanceWindow = 30.0f;
+
+	/**
+	 * bEnableBanListSync - 是否在本地同步封禁列表
+	 *
+	 * 启用后专用服务器定期从 /api/account/bans 同步封禁列表，玩家加入时可以直接在本地判断是否被封禁，
+	 * 不必为每个玩家请求一次认证。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Ban List")
+	bool bEnableBanListSync = false;
+
+	/** bBanListSyncOnlyOnDedicatedServer - 只在专用服务器上同步封禁列表 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Ban List")
+	bool bBanListSyncOnlyOnDedicatedServer = true;
+
+	/** BanListSyncInterval - 封禁列表增量同步间隔（秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Ban List", meta = (ClampMin = "1"))
+	float BanListSyncInterval = 10.0f;
+
+	/**
+	 * bEnableClientKeyDerivation - 是否在客户端对密码做密钥派生
+	 *
+	 * 启用后注册和登录前先从 /api/account/kdf_params 获取盐和 scrypt 参数，在后台线程派生密码，
+	 * 服务器只需对派生结果做一次廉价的哈希。需要服务器支持，服务器没有该接口时退回发送原始密码。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Key Derivation")
+	bool bEnableClientKeyDerivation = false;
+
+	/** KeyDerivationMaxMemoryMB - 接受的派生参数所需内存上限（MB），超出时以 LOCAL_KEY_DERIVATION_FAILED 失败 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Key Derivation", meta = (ClampMin = "1"))
+	int32 KeyDerivationMaxMemoryMB = 64;
+
+	/**
+	 * AdmissionMaxInFlight - 玩家加入时同时进行的令牌校验请求上限
+	 *
+	 * 用于 ADreamAccountGameModeBase 的异步 PreLogin，超出的校验按到达顺序排队。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Admission", meta = (ClampMin = "1"))
+	int32 AdmissionMaxInFlight = 8;
+
+	/** AdmissionMaxQueueLength - 排队上限，超出时以 LOCAL_SERVER_BUSY 拒绝，0 表示不限制 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Admission", meta = (ClampMin = "0"))
+	int32 AdmissionMaxQueueLength = 512;
+
+	/** AdmissionQueueTimeout - 排队超时（秒），超过后以 LOCAL_SERVER_BUSY 拒绝，0 表示不限制 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Admission", meta = (ClampMin = "0"))
+	float AdmissionQueueTimeout = 30.0f;
+
+	/** AdmissionResultCacheTTL - 令牌校验结果的复用时间（秒），玩家短时间内重连不再重复校验 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Admission", meta = (ClampMin = "0"))
+	float AdmissionResultCacheTTL = 30.0f;
+
+	/**
+	 * bEnableWaitingRoom - 登录被限流时是否进入排队
+	 *
+	 * 服务器在 TOO_MANY_REQUESTS 响应中下发排队票据时，登录不立即失败，而是轮询排队状态，放行后自动重新登录。
+	 * 响应中没有排队票据时仍以 NETWORK_TOO_MANY_REQUESTS 失败。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Waiting Room")
+	bool bEnableWaitingRoom = true;
+
+	/** WaitingRoomMinPollInterval - 排队状态轮询间隔的下限（秒），服务器建议的间隔更短时也不低于该值 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Waiting Room", meta = (ClampMin = "0.5"))
+	float WaitingRoomMinPollInterval = 2.0f;
+
+	/** WaitingRoomMaxPollInterval - 服务器没有建议间隔时，按预计等待时间估算的轮询间隔上限（秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Waiting Room", meta = (ClampMin = "1"))
+	float WaitingRoomMaxPollInterval = 30.0f;
+
+	/**
+	 * WaitingRoomLongPollSeconds - 轮询请求在服务器端最多挂起的时间（秒），0 表示不使用长轮询
+	 *
+	 * 服务器支持时在放行的同时返回，客户端不必等到下一次轮询；不支持的服务器忽略该参数并立即返回。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Waiting Room", meta = (ClampMin = "0"))
+	float WaitingRoomLongPollSeconds = 20.0f;
+
+	/** WaitingRoomMaxWait - 最长排队时间（秒），超过后离开队列并以 LOCAL_SERVER_BUSY 失败，0 表示不限制 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Waiting Room", meta = (ClampMin = "0"))
+	float WaitingRoomMaxWait = 900.0f;
+
+	/**
+	 * DispatchFrameBudgetMs - 每帧执行结果回调的时间预算（毫秒）
+	 *
+	 * 同一帧内完成的操作超出预算时，剩余的回调排队到后续帧执行，交互操作（登录、注册等）优先。
+	 * 设置为 0 时所有回调在请求完成时立即执行。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Dispatch", meta = (ClampMin = "0"))
+	float DispatchFrameBudgetMs = 2.0f;
+
+	/**
+	 * bEnableLatencyBeacons - 是否上传客户端延迟信标
+	 *
+	 * 记录每个请求的首字节时间与总耗时，按接口聚合为直方图后定期压缩上传，
+	 * 用于观察玩家实际感受到的账号服务延迟。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Latency Beacons")
+	bool bEnableLatencyBeacons = false;
+
+	/** LatencyBeaconURL - 信标上传地址，留空时使用 AccountServerURL 下的 /api/account/metrics/latency */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Latency Beacons")
+	FString LatencyBeaconURL;
+
+	/** LatencyBeaconRegion - 随信标上传的地区标识，例如玩家所在的匹配区域 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Latency Beacons")
+	FString LatencyBeaconRegion;
+
+	/** LatencyBeaconSampleRate - 记录请求的比例 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Latency Beacons", meta = (ClampMin = "0", ClampMax = "1"))
+	float LatencyBeaconSampleRate = 1.0f;
+
+	/** LatencyBeaconUploadInterval - 上传间隔（秒），缓冲区为空时跳过 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Latency Beacons", meta = (ClampMin = "5"))
+	float LatencyBeaconUploadInterval = 60.0f;
+
+	/** LatencyBeaconBufferSize - 环形缓冲区容量，两次上传之间超出的记录覆盖最旧的记录 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Latency Beacons", meta = (ClampMin = "16"))
+	int32 LatencyBeaconBufferSize = 512;
+
+	/**
+	 * bEnableTracing - 是否为账号请求附加 W3C traceparent / tracestate 请求头并记录 span
+	 *
+	 * 请求头总是附加，便于在服务器日志中按 trace-id 找到对应的请求；只有被采样的追踪才记录并导出 span。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Tracing")
+	bool bEnableTracing = false;
+
+	/** TraceSampleRate - 记录并导出 span 的追踪比例，生产环境建议保持较低的值 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Tracing", meta = (ClampMin = "0", ClampMax = "1"))
+	float TraceSampleRate = 0.01f;
+
+	/** TraceState - 随请求发送的 tracestate 请求头，留空时不发送 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Tracing")
+	FString TraceState;
+
+	/** TraceExportFile - 以 OTLP JSON 格式逐行追加 span 的文件，相对路径保存在 Saved/DreamAccount/Spans，留空时不写文件 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Tracing")
+	FString TraceExportFile;
+
+	/** TraceCollectorURL - 接收 OTLP/HTTP JSON 的收集器地址，例如 http://127.0.0.1:4318/v1/traces，留空时不上传 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Tracing")
+	FString TraceCollectorURL;
+
+	/** TraceExportInterval - 导出 span 的间隔（秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Tracing", meta = (ClampMin = "1"))
+	float TraceExportInterval = 10.0f;
+
+	/** TraceMaxBufferedSpans - 等待导出的 span 上限，超出时丢弃新的 span */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Tracing", meta = (ClampMin = "16"))
+	int32 TraceMaxBufferedSpans = 2048;
+
+	/**
+	 * bEnableRequestHedging - 是否对幂等请求进行对冲
+	 *
+	 * 令牌认证、用户信息查询、用户名检查等请求在学习到的延迟分位数内没有响应时，
+	 * 再发送一个相同的请求并采用先到的响应，另一个请求被取消。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Hedging")
+	bool bEnableRequestHedging = false;
+
+	/** HedgePercentile - 等待多久后发出对冲请求，以该接口近期延迟的分位数表示 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Hedging", meta = (ClampMin = "0.5", ClampMax = "0.999"))
+	float HedgePercentile = 0.95f;
+
+	/** HedgeMinDelay - 对冲等待时间的下限（秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Hedging", meta = (ClampMin = "0"))
+	float HedgeMinDelay = 0.05f;
+
+	/** HedgeMinSamples - 接口积累到多少个延迟样本后才开始对冲 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Hedging", meta = (ClampMin = "1"))
+	int32 HedgeMinSamples = 20;
+
+	/**
+	 * HedgeBudgetRatio - 对冲预算
+	 *
+	 * 每个可对冲请求积累该比例的预算，每次对冲消耗 1，额外请求数因此不超过可对冲请求数的该比例（允许少量突发）。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Hedging", meta = (ClampMin = "0", ClampMax = "1"))
+	float HedgeBudgetRatio = 0.05f;
+
+	/**
+	 * HedgeAlternateEndpoints - 对冲请求的备用地址
+	 *
+	 * 键为主请求地址的前缀（如 AccountServerURL 或某个分片地址），值为替换后的地址，
+	 * 对冲请求发往该地址；未匹配时对冲请求发往原地址。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Hedging")
+	TMap<FString, FString> HedgeAlternateEndpoints;
+
+	/**
+	 * bEnableAdaptiveTimeouts - 是否按接口根据观测到的延迟自适应调整超时时间
+	 *
+	 * 启用后未显式设置超时的请求不再统一使用 TimeoutTime，而是使用该接口的平滑延迟加 4 倍延迟偏差，
+	 * 样本不足时仍使用 TimeoutTime，超时后翻倍。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Adaptive Timeout")
+	bool bEnableAdaptiveTimeouts = false;
+
+	/** AdaptiveTimeoutMin - 自适应超时时间的下限（秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Adaptive Timeout", meta = (ClampMin = "0.1"))
+	float AdaptiveTimeoutMin = 1.0f;
+
+	/** AdaptiveTimeoutMax - 自适应超时时间的上限（秒），连续超时翻倍时也不超过该值 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Adaptive Timeout", meta = (ClampMin = "0.1"))
+	float AdaptiveTimeoutMax = 30.0f;
+
+	/** AdaptiveTimeoutMinSamples - 接口积累到多少个延迟样本后才使用估计的超时时间 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Adaptive Timeout", meta = (ClampMin = "1"))
+	int32 AdaptiveTimeoutMinSamples = 5;
+
+	/**
+	 * NetworkSimulation - 网络模拟参数
+	 *
+	 * 用于在本地复现弱网环境，仅建议在开发环境中启用。
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Config, Category = "Network Simulation")
+	FDreamAccountNetworkSimulationSettings NetworkSimulation;
 };
@@ -0,0 +1,129 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @class FDreamAccountShardRouter
+ * @brief 按一致性哈希把账号请求路由到多个服务器分片。
+ *
+ * 每个分片在哈希环上占有若干虚拟节点，请求按路由键（用户名或 UserID 的哈希）
+ * 顺时针找到第一个虚拟节点所属的分片。分片增减时只有相邻区间的键改变归属。
+ *
+ * 分片列表可以在运行时替换。替换后的迁移窗口内，归属发生变化的幂等请求（GET、bHedgeable 或 bShardFallback）
+ * 在新分片回答不归它所有（404/421）时会改发到原分片一次；网络错误、认证失败和其他错误不回退，
+ * 避免注册等请求在两个分片上各执行一次。仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountShardRouter
+{
+public:
+	static FDreamAccountShardRouter& Get();
+
+	/** 以用户名作为路由键，空用户名返回 0（不分片） */
+	static uint64 HashUserName(const FString& UserName);
+
+	/** 以 UserID 作为路由键 */
+	static uint64 HashUserID(int32 UserID);
+
+	/**
+	 * @brief 替换分片列表。
+	 *
+	 * @param Endpoints 分片地址列表，为空时关闭分片。
+	 * @param VirtualNodesPerShard 每个分片的虚拟节点数。
+	 * @param RebalanceWindowSeconds 迁移窗口（秒）。
+	 */
+	void SetShards(const TArray<FString>& Endpoints, int32 VirtualNodesPerShard, double RebalanceWindowSeconds);
+
+	/**
+	 * @brief 按项目设置中的分片配置初始化。
+	 */
+	void ApplySettings();
+
+	/** 是否启用了分片 */
+	bool IsEnabled() const { return Current.Endpoints.Num() > 0; }
+
+	/** 当前分片列表 */
+	const TArray<FString>& GetShards() const { return Current.Endpoints; }
+
+	/**
+	 * @brief 获取路由键对应的服务器地址，未启用分片或路由键为 0 时返回 AccountServerURL。
+	 */
+	FString ResolveBaseURL(uint64 KeyHash) const;
+
+	/**
+	 * @brief 把以 AccountServerURL 开头的地址改写为路由键对应分片的地址，其他地址保持不变。
+	 */
+	FString RouteURL(const FString& URL, uint64 KeyHash) const;
+
+	/**
+	 * @brief 按路由键发送请求，并记录分片统计。
+	 *
+	 * @param KeyHash 路由键，0 表示不分片。
+	 * @param Request 请求描述，URL 使用 API_* 宏生成的地址即可。
+	 * @param OnComplete 请求完成后的回调函数。
+	 */
+	void SendHttpRequest(uint64 KeyHash, const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& OnComplete);
+
+	/**
+	 * @brief 按路由键发送请求，参数与 FDreamAccountUtil::SendHttpRequest 相同。
+	 */
+	void SendHttpRequest(uint64 KeyHash, const FString& URL, const FString& Verb, const FString& Content, const TMap<FString, FString>& Headers, const FDreamAccountHttpCallback& OnComplete);
+
+	/**
+	 * @brief 获取各分片统计，包括已被移除但仍有统计数据的分片。
+	 */
+	TArray<FDreamAccountShardStats> GetStats() const;
+
+	/**
+	 * @brief 清空统计。
+	 */
+	void ResetStats();
+
+private:
+	FDreamAccountShardRouter();
+
+	struct FRing
+	{
+		TArray<FString> Endpoints;
+
+		/** 按哈希值排序的虚拟节点：哈希值与分片下标 */
+		TArray<TPair<uint64, int32>> Points;
+
+		/** 查找路由键所属分片，未启用时返回 INDEX_NONE */
+		int32 FindShard(uint64 KeyHash) const;
+
+		/** 各分片在环上所占比例 */
+		TArray<float> ComputeKeyShares() const;
+
+		static FRing Build(const TArray<FString>& Endpoints, int32 VirtualNodesPerShard);
+	};
+
+	struct FEndpointStats
+	{
+		int32 RequestCount = 0;
+		int32 ErrorCount = 0;
+		int32 FallbackCount = 0;
+		double TotalLatencySeconds = 0.0;
+		double RecentLatencySeconds = 0.0;
+		double MaxLatencySeconds = 0.0;
+	};
+
+	/** 请求重发到原分片是否安全 */
+	static bool CanFallback(const FDreamAccountHttpRequest& Request);
+
+	/** 迁移窗口内，需要回退到原分片的响应：新分片明确表示数据不在这里 */
+	static bool ShouldFallback(const FDreamAccountHttpResponse& Response);
+
+	void RecordResponse(const FString& Endpoint, const FDreamAccountHttpResponse& Response, bool bFallback);
+
+	FRing Current;
+	FRing Previous;
+
+	/** 迁移窗口结束时间 */
+	double RebalanceDeadline = 0.0;
+
+	TMap<FString, FEndpointStats> Stats;
+};
@@ -3,8 +3,18 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/Ticker.h"
 #include "Subsystems/EngineSubsystem.h"
+#include "DreamAccountConditionalCache.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountKeyDerivation.h"
 #include "DreamAccountTypes.h"
+#include "DreamAccountUserCache.h"
+#include "DreamAccountUsernameChecker.h"
+#include "DreamAccountValidation.h"
+#include "DreamAccountPushChannel.h"
+#include "DreamAccountWaitingRoom.h"
+#include "DreamAccountSession.h"
 #include "DreamAccountSubsystem.generated.h"
 
 /**
@@ -26,11 +36,41 @@ public:
 	 */
 	DECLARE_DYNAMIC_DELEGATE_OneParam(FOnAccountResult, const FDreamAccountResult&, Result);
 
+	/**
+	 * @brief 动态委托定义：用于批量用户查询结果的回调。
+	 * @param Result 查询结果信息。
+	 */
+	DECLARE_DYNAMIC_DELEGATE_OneParam(FOnUserLookupResult, const FDreamAccountUserLookupResult&, Result);
+
+	/**
+	 * @brief 动态委托定义：用于用户名可用性检查结果的回调。
+	 * @param Result 检查结果信息。
+	 */
+	DECLARE_DYNAMIC_DELEGATE_OneParam(FOnUsernameCheckResult, const FDreamAccountUsernameCheckResult&, Result);
+
 	/**
 	 * @brief 多播动态委托定义：当用户令牌发生变化时触发。
 	 */
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnTokenChanged);
 
+	/**
+	 * @brief 多播动态委托定义：会话发生变化时触发。
+	 * @param Change 变化类型与变化前后的用户。
+	 */
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSessionEvent, const FDreamAccountSessionChange&, Change);
+
+	/**
+	 * @brief 多播动态委托定义：收到服务器推送事件时触发。
+	 * @param Event 推送事件。
+	 */
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPushEvent, const FDreamAccountPushEvent&, Event);
+
+	/**
+	 * @brief 多播动态委托定义：推送通道连接状态变化时触发。
+	 * @param bConnected 是否已连接。
+	 */
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPushChannelStateChanged, bool, bConnected);
+
 public:
 	/**
 	 * @brief 蓝图可绑定事件：当用户令牌变化时调用。
@@ -38,7 +78,36 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnTokenChanged OnTokenChanged;
 
+	/**
+	 * @brief 蓝图可绑定事件：登录、刷新、过期、封禁、登出时调用。
+	 *
+	 * C++ 中请使用 FDreamAccountSessionEventBus，可以拿到变化前后的完整快照且不经过反射。
+	 */
+	UPROPERTY(BlueprintAssignable)
+	FOnSessionEvent OnSessionEvent;
+
+	/**
+	 * @brief 蓝图可绑定事件：收到令牌吊销、封禁或强制登出推送时调用，此时本地令牌已被清除。
+	 */
+	UPROPERTY(BlueprintAssignable)
+	FOnPushEvent OnPushEvent;
+
+	/**
+	 * @brief 蓝图可绑定事件：推送通道连接或断开时调用。
+	 */
+	UPROPERTY(BlueprintAssignable)
+	FOnPushChannelStateChanged OnPushChannelStateChanged;
+
 public:
+	/**
+	 * @brief 令牌刷新处理函数：完成后调用传入的回调，成功时会话中应已是新令牌。
+	 */
+	using FTokenRefreshHandler = TFunction<void(FDreamAccountResultCallback)>;
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
 	/**
 	 * @brief 注册一个新用户。
 	 *
@@ -68,10 +137,152 @@ public:
 	/**
 	 * @brief 内部实现版本的用户登录方法。
 	 *
+	 * 启用 bEnableWaitingRoom 时，服务器限流并下发排队票据的登录会等待放行后自动重新登录，回调在最终结果确定后才调用。
+	 *
 	 * @param User 登录所需的用户信息。
 	 * @param Callback 登录完成后的回调函数。
+	 * @param OnQueueUpdate 进入排队以及排队位置变化时的回调，可以为空。
+	 * @return 本次登录的排队过程，可以交给 CancelWaitingRoom 只取消这一次登录的排队；未启用排队或参数无效时为空。
+	 */
+	TSharedPtr<FDreamAccountWaitingRoom> UserLogin_Internal(FDreamAccountInfo User, FDreamAccountResultCallback Callback, FDreamAccountQueueCallback OnQueueUpdate = nullptr);
+
+	/**
+	 * @brief 离开所有正在进行的登录排队，对应的登录以 LOCAL_REQUEST_CANCELLED 结束。
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DreamAccount|Users")
+	void CancelLoginQueue();
+
+	/**
+	 * @brief 只离开指定登录的排队，对应的登录以 LOCAL_REQUEST_CANCELLED 结束，其他登录的排队不受影响。
+	 *
+	 * @param WaitingRoom UserLogin_Internal 返回的排队过程，为空或已经放行时什么也不做。
+	 */
+	void CancelWaitingRoom(const TSharedPtr<FDreamAccountWaitingRoom>& WaitingRoom);
+
+	/**
+	 * @brief 是否有登录正在排队等待放行。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Users")
+	bool IsInLoginQueue() const;
+
+	/**
+	 * @brief 注册并登录，一次请求同时完成注册和获取令牌。
+	 *
+	 * 服务器不支持该接口时自动退回为先注册再登录两次请求。
+	 *
+	 * @param User 需要注册的用户信息。
+	 * @param OnResult 完成后的回调函数。
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DreamAccount|Users")
+	void UserRegisterAndLogin(FDreamAccountInfo User, FOnAccountResult OnResult);
+
+	/**
+	 * @brief 内部实现版本的注册并登录方法。
+	 *
+	 * @param User 需要注册的用户信息。
+	 * @param Callback 完成后的回调函数。
+	 */
+	void UserRegisterAndLogin_Internal(FDreamAccountInfo User, FDreamAccountResultCallback Callback);
+
+	/**
+	 * @brief 检查用户名是否可用，用于注册界面的实时提示。
+	 *
+	 * 同一输入框的连续输入会被防抖，新的检查会取代尚未完成的旧检查（旧检查以 LOCAL_REQUEST_CANCELLED 结束），
+	 * 结果在本地短时缓存。
+	 *
+	 * @param FieldKey 输入框标识。
+	 * @param UserName 需要检查的用户名。
+	 * @param OnResult 检查完成后的回调函数。
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DreamAccount|Users")
+	void CheckUsernameAvailability(FName FieldKey, const FString& UserName, FOnUsernameCheckResult OnResult);
+
+	/**
+	 * @brief 内部实现版本的用户名可用性检查方法。
+	 *
+	 * @param FieldKey 输入框标识。
+	 * @param UserName 需要检查的用户名。
+	 * @param Callback 检查完成后的回调函数。
+	 */
+	void CheckUsernameAvailability_Internal(FName FieldKey, const FString& UserName, FDreamAccountUsernameCheckCallback Callback);
+
+	/**
+	 * @brief 取消指定输入框尚未完成的用户名检查。
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DreamAccount|Users")
+	void CancelUsernameCheck(FName FieldKey);
+
+	/**
+	 * @brief 从服务器重新下载校验规则，失败时保留当前规则。
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DreamAccount|Users|Validation")
+	void RefreshValidationRules();
+
+	/**
+	 * @brief 获取当前使用的校验规则。
+	 */
+	const FDreamAccountValidationRules& GetValidationRules() const { return ValidationRules; }
+
+	/**
+	 * @brief 获取各账号服务器分片的请求统计，只统计经过分片路由的请求。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Sharding")
+	static TArray<FDreamAccountShardStats> GetShardStats();
+
+	/**
+	 * @brief 获取各接口的请求对冲统计。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Hedging")
+	static TArray<FDreamAccountHedgeStats> GetHedgeStats();
+
+	/**
+	 * @brief 获取各接口的自适应超时统计，只有启用 bEnableAdaptiveTimeouts 后才有数据。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Timeouts")
+	static TArray<FDreamAccountTimeoutStats> GetTimeoutStats();
+
+	/**
+	 * @brief 获取结果回调按帧预算分发的排队延迟与预算超出统计。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Dispatch")
+	static FDreamAccountDispatchStats GetDispatchStats();
+
+	/**
+	 * @brief 获取客户端延迟信标的采集与上传统计。
 	 */
-	void UserLogin_Internal(FDreamAccountInfo User, FDreamAccountResultCallback Callback);
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Diagnostics")
+	static FDreamAccountLatencyBeaconStats GetLatencyBeaconStats();
+
+	/**
+	 * @brief 获取请求追踪的采样与 span 导出统计。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Diagnostics")
+	static FDreamAccountTracingStats GetTracingStats();
+
+	/**
+	 * @brief 获取玩家加入时令牌校验的排队与等待时间统计。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Admission")
+	static FDreamAccountAdmissionStats GetAdmissionStats();
+
+	/**
+	 * @brief 按本地封禁列表判断用户是否被封禁，不发送请求，可在任意线程调用。
+	 *
+	 * 需要启用 bEnableBanListSync，尚未完成首次同步时总是返回 false。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Ban List")
+	static bool IsUserBanned(int32 UserID);
+
+	/**
+	 * @brief 获取本地封禁列表的内存占用与同步延迟等统计。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Ban List")
+	static FDreamAccountBanListStats GetBanListStats();
+
+	/**
+	 * @brief 获取用户名检查器，用于读取缓存统计。
+	 */
+	const FDreamAccountUsernameChecker& GetUsernameChecker() const { return UsernameChecker; }
 
 	/**
 	 * @brief 对当前已登录用户进行身份验证（使用 Token）。
@@ -88,6 +299,104 @@ public:
 	 */
 	void AuthenticationToken_Internal(FDreamAccountResultCallback Callback);
 
+	/**
+	 * @brief 校验任意令牌（例如专用服务器校验加入玩家的令牌），不影响本地会话。
+	 *
+	 * @param Token 需要校验的令牌。
+	 * @param UserName 令牌所属的用户名，仅用于分片路由，可以为空。
+	 * @param Callback 校验完成后的回调函数。
+	 */
+	void ValidateToken_Internal(const FString& Token, const FString& UserName, FDreamAccountResultCallback Callback);
+
+	/**
+	 * @brief 使用当前令牌换取新令牌。
+	 *
+	 * @param OnResult 刷新完成后的回调函数。
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DreamAccount|Users|Auth")
+	void RefreshToken(FOnAccountResult OnResult);
+
+	/**
+	 * @brief 内部实现版本的令牌刷新方法。
+	 *
+	 * @param Callback 刷新完成后的回调函数。
+	 */
+	void RefreshToken_Internal(FDreamAccountResultCallback Callback);
+
+	/**
+	 * @brief 以当前用户身份向其他游戏服务发送请求，自动附带 Bearer 令牌。
+	 *
+	 * 请求因令牌失效被拒绝（401 / INVALID_TOKEN）时，会进入等待队列；
+	 * 同一时间只进行一次令牌刷新，刷新成功后用新令牌重发队列中的所有请求，
+	 * 失败时把原始的拒绝响应交给各自的回调。每个请求最多重发一次。
+	 *
+	 * @param Request 请求描述，URL 可以指向任意服务。
+	 * @param Callback 完成后的回调函数。
+	 */
+	void SendAuthenticatedRequest(const FDreamAccountHttpRequest& Request, FDreamAccountHttpCallback Callback);
+
+	/**
+	 * @brief 替换令牌刷新方式，例如改为用平台凭据重新登录。传入空函数恢复默认的 RefreshToken_Internal。
+	 */
+	void SetTokenRefreshHandler(FTokenRefreshHandler Handler);
+
+	/**
+	 * @brief 按 UserID 批量查询用户信息。
+	 *
+	 * 优先从本地 LRU 缓存返回，缺失的 UserID 合并为一次请求向服务器获取，
+	 * 已在请求中的 UserID 不会重复发送。
+	 *
+	 * @param UserIDs 需要查询的用户ID列表。
+	 * @param OnResult 查询完成后的回调函数。
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DreamAccount|Users|Lookup")
+	void LookupUsers(const TArray<int32>& UserIDs, FOnUserLookupResult OnResult);
+
+	/**
+	 * @brief 内部实现版本的批量用户查询方法。
+	 *
+	 * @param UserIDs 需要查询的用户ID列表。
+	 * @param Callback 查询完成后的回调函数。
+	 */
+	void LookupUsers_Internal(const TArray<int32>& UserIDs, FDreamAccountUserLookupCallback Callback);
+
+	/**
+	 * @brief 清空用户信息缓存。
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DreamAccount|Users|Lookup")
+	void ClearUserCache();
+
+	/**
+	 * @brief 获取用户信息缓存，用于读取缓存统计。
+	 */
+	const FDreamAccountUserCache& GetUserCache() const { return UserCache; }
+
+	/**
+	 * @brief 获取令牌认证与用户查询的条件请求统计（304 次数、节省的字节与解析时间）。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Users|Lookup")
+	FDreamAccountConditionalStats GetConditionalStats() const;
+
+	/**
+	 * @brief 使用当前令牌建立推送通道。
+	 *
+	 * 启用 bEnablePushChannel 时，令牌变化会自动连接或断开，一般不需要手动调用。
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DreamAccount|Users|Push")
+	void ConnectPushChannel();
+
+	/**
+	 * @brief 断开推送通道并停止重连。
+	 */
+	UFUNCTION(BlueprintCallable, Category = "DreamAccount|Users|Push")
+	void DisconnectPushChannel();
+
+	/**
+	 * @brief 推送通道当前是否已连接。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Users|Push")
+	bool IsPushChannelConnected() const;
+
 	/**
 	 * @brief 用户登出，清除本地保存的用户状态。
 	 */
@@ -106,18 +415,281 @@ public:
 	 * @return 当前用户的认证令牌字符串。
 	 */
 	UFUNCTION(BlueprintPure, Category = "DreamAccount|Users|Auth")
-	FString GetToken() const { return Token; }
+	FString GetToken() const { return GetSession()->Token; }
+
+	/**
+	 * @brief 获取当前登录的用户信息，未登录时为默认值。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Users|Auth")
+	FDreamAccountUser GetSessionUser() const { return GetSession()->User; }
+
+	/**
+	 * @brief 获取当前会话代数，每次令牌变化时递增。
+	 */
+	UFUNCTION(BlueprintPure, Category = "DreamAccount|Users|Auth")
+	int64 GetSessionGeneration() const { return static_cast<int64>(FDreamAccountSessionStore::Get().GetGeneration()); }
+
+	/**
+	 * @brief 获取当前会话快照。快照不可变，可以在任意线程调用并长期持有。
+	 */
+	static FDreamAccountSessionRef GetSession() { return FDreamAccountSessionStore::Get().Acquire(); }
+
+	/**
+	 * @brief 注册、登录请求链上下文的累计新分配次数，用于确认稳定状态下认证路径不再为其分配内存。
+	 */
+	uint64 GetCredentialContextAllocations() const { return CredentialContextAllocations; }
 
 protected:
 	/**
-	 * @brief 设置当前用户的认证令牌，并触发 OnTokenChanged 事件。
+	 * @brief 设置当前用户的认证令牌，并触发会话事件。
 	 *
 	 * @param NewToken 新的认证令牌。
 	 */
 	void SetToken(FString NewToken);
 
 	/**
-	 * @brief 存储当前用户的认证令牌。
+	 * @brief 发布新的会话快照（令牌、用户和过期时间），并在会话确有变化时广播会话事件。
+	 *
+	 * @param ClearReason 清除会话（NewToken 为空）时的事件类型。
+	 */
+	void SetSession(FString NewToken, FDreamAccountUser NewUser, FDateTime ExpiresAt,
+		EDreamAccountSessionEventType ClearReason = EDreamAccountSessionEventType::LoggedOut);
+
+	/**
+	 * @brief 清除会话并以指定的事件类型广播。
+	 */
+	void ClearSession(EDreamAccountSessionEventType Reason);
+
+	/**
+	 * @brief 服务器确认令牌失效时清除会话，按错误类型区分过期与封禁。
+	 *
+	 * @return 是否清除了会话。
+	 */
+	bool ClearSessionOnAuthError(EDreamAccountErrorType ErrorType);
+
+	/**
+	 * @brief 把会话事件转发给蓝图事件 OnSessionEvent 和 OnTokenChanged。
+	 */
+	void BroadcastBlueprintSessionEvent(const FDreamAccountSessionEvent& Event);
+
+	/**
+	 * @brief 先注册再登录的两步流程，用于服务器不支持注册并登录接口时。
+	 */
+	void UserRegisterThenLogin(FDreamAccountInfo User, FDreamAccountResultCallback Callback);
+
+	/**
+	 * @brief 一次注册、登录请求链上共享的账号信息（含原始密码）和结果回调，派生失败路径、排队路径和响应路径共用同一份。
+	 *
+	 * 由 AcquireCredentialContext 从池中取出，得到最终结果时调用 Release 取出回调并清除密码；
+	 * 请求链上的闭包全部释放后该上下文回到空闲状态，下一次请求直接复用，不再分配。
+	 */
+	struct FCredentialContext
+	{
+		FDreamAccountInfo User;
+		FDreamAccountResultCallback Callback;
+
+		/** 取出结果回调并清零密码，每条请求链只调用一次 */
+		FDreamAccountResultCallback Release();
+	};
+	using FCredentialContextRef = TSharedRef<FCredentialContext>;
+
+	/**
+	 * @brief 取出一个空闲的请求链上下文，把账号信息和回调移动进去；池中没有空闲项时才新分配。
+	 */
+	FCredentialContextRef AcquireCredentialContext(FDreamAccountInfo&& User, FDreamAccountResultCallback&& Callback);
+
+	/**
+	 * @brief 可复用的请求链上下文，引用计数为 1 时表示空闲。
+	 */
+	TArray<FCredentialContextRef> CredentialContextPool;
+
+	/**
+	 * @brief 新分配请求链上下文的累计次数，稳定状态下不再增长。
+	 */
+	uint64 CredentialContextAllocations = 0;
+
+	/**
+	 * @brief 服务器是否已确认不支持注册并登录接口。
+	 */
+	bool bRegisterAndLoginUnsupported = false;
+
+	/**
+	 * @brief 发送注册、登录类请求，启用客户端密钥派生时先派生密码再发送。
+	 *
+	 * @param Context 用户名、原始密码和结果回调，派生失败时直接以失败结束。
+	 * @param URL 请求地址。
+	 * @param ResultType 派生失败时回调的操作类型。
+	 * @param OnResponse 请求完成后的回调。
+	 * @param QueueAdmission 登录排队放行后得到的准入凭证，非空时附加在 X-Queue-Admission 请求头中。
+	 */
+	void SendCredentialRequest(const FCredentialContextRef& Context, const FString& URL, EDreamAccountResultType ResultType,
+		FDreamAccountHttpCallback OnResponse, const FString& QueueAdmission = FString());
+
+	/**
+	 * @brief 发送一次登录请求，被要求排队时进入 WaitingRoom 等待放行。
+	 *
+	 * @param WaitingRoom 本次登录的排队过程，未启用排队时为空。
+	 * @param QueueAdmission 放行后重新登录时使用的准入凭证。
+	 */
+	void SendLoginRequest(const FCredentialContextRef& Context,
+		TSharedPtr<FDreamAccountWaitingRoom> WaitingRoom, const FString& QueueAdmission);
+
+	/**
+	 * @brief 持有服务器下发的票据开始排队，放行后重新发送登录请求。
+	 */
+	void EnterLoginQueue(const FCredentialContextRef& Context,
+		const TSharedRef<FDreamAccountWaitingRoom>& WaitingRoom, const FDreamAccountQueueStatus& QueueStatus, double PollAfter);
+
+	/**
+	 * @brief 正在排队或放行后正在重新登录的排队过程。
+	 */
+	TArray<TSharedPtr<FDreamAccountWaitingRoom>> WaitingRooms;
+
+	/**
+	 * @brief 获取派生参数并在后台线程派生密码，完成后在游戏线程回调。
+	 *
+	 * 服务器不支持密钥派生时以 NORMAL 和空的 DerivedKey 回调，调用方退回发送原始密码。
+	 */
+	void DeriveCredential(const FCredentialContextRef& Context, TFunction<void(EDreamAccountErrorType ErrorType, const FString& DerivedKey)> Callback);
+
+	/**
+	 * @brief 服务器是否已确认不支持客户端密钥派生。
+	 */
+	bool bKeyDerivationUnsupported = false;
+
+	/**
+	 * @brief 最近一次派生的结果，注册后紧接着登录时不必再派生一次。
+	 */
+	struct FDerivedCredential
+	{
+		FString UserName;
+		/** 只保存原始密码的 SHA-256，用于判断是否为同一密码 */
+		TArray<uint8> PasswordHash;
+		FDreamAccountKdfParams Params;
+		FString DerivedKey;
+	};
+	FDerivedCredential LastDerivedCredential;
+
+	/**
+	 * @brief 等待令牌刷新后重发的请求。
+	 */
+	struct FPendingAuthenticatedRequest
+	{
+		FDreamAccountHttpRequest Request;
+		FDreamAccountHttpCallback Callback;
+		FDreamAccountHttpResponse RejectedResponse;
+	};
+
+	/**
+	 * @brief 发送一次带令牌的请求。
+	 *
+	 * @param bIsReplay 是否为刷新后的重发，重发的请求再次被拒绝时不再排队。
+	 */
+	void SendAuthenticatedRequestAttempt(FDreamAccountHttpRequest Request, FDreamAccountHttpCallback Callback, bool bIsReplay);
+
+	/**
+	 * @brief 开始一次令牌刷新，已在刷新时直接返回。
+	 */
+	void BeginTokenRefresh();
+
+	/**
+	 * @brief 令牌刷新结束，重发或失败等待队列中的请求。
+	 */
+	void FinishTokenRefresh(const FDreamAccountResult& Result);
+
+	/**
+	 * @brief 响应是否表示令牌已失效。
+	 */
+	static bool IsTokenRejected(const FDreamAccountHttpResponse& Response);
+
+	/**
+	 * @brief 自定义令牌刷新方式，为空时使用 RefreshToken_Internal。
+	 */
+	FTokenRefreshHandler TokenRefreshHandler;
+
+	/**
+	 * @brief 是否正在刷新令牌。
+	 */
+	bool bTokenRefreshInProgress = false;
+
+	/**
+	 * @brief 等待令牌刷新的请求。
+	 */
+	TArray<FPendingAuthenticatedRequest> PendingAuthenticatedRequests;
+
+	/**
+	 * @brief 处理推送通道收到的事件。
+	 */
+	void HandlePushEvent(const FDreamAccountPushEvent& Event);
+
+	/**
+	 * @brief 定期认证轮询，推送通道连接期间可以暂停。
+	 */
+	bool TickAuthPolling(float DeltaTime);
+
+	/**
+	 * @brief 推送通道。
+	 */
+	TUniquePtr<FDreamAccountPushChannel> PushChannel;
+
+	/**
+	 * @brief 定期认证轮询的 Ticker。
+	 */
+	FTSTicker::FDelegateHandle AuthPollingHandle;
+
+	/**
+	 * @brief 蓝图事件适配器在会话事件流上的订阅。
+	 */
+	FDreamAccountSessionEventHandle BlueprintSessionEventHandle;
+
+	/**
+	 * @brief 一次批量查询的等待状态，可能同时等待多个网络请求。
+	 */
+	struct FPendingUserLookup
+	{
+		TArray<int32> UserIDs;
+		TMap<int32, FDreamAccountUser> ResolvedUsers;
+		TArray<int32> MissingUserIDs;
+		int32 OutstandingCount = 0;
+		int32 CacheHitCount = 0;
+		EDreamAccountErrorType ErrorType = EDreamAccountErrorType::NORMAL;
+		FDreamAccountUserLookupCallback Callback;
+	};
+
+	/**
+	 * @brief 向这些 UserID 所属的分片发送一次批量查询请求。
+	 */
+	void SendUserLookupRequest(TArray<int32> UserIDsToFetch);
+
+	/**
+	 * @brief 批量查询请求完成后，分发结果给所有等待这些 UserID 的查询。
+	 */
+	void CompleteUserLookupRequest(const TArray<int32>& RequestedUserIDs, const TArray<FDreamAccountUser>& Users, EDreamAccountErrorType ErrorType);
+
+	static void FinishUserLookup(const TSharedRef<FPendingUserLookup>& Pending);
+
+	/**
+	 * @brief 用户信息 LRU 缓存。
+	 */
+	FDreamAccountUserCache UserCache;
+
+	/**
+	 * @brief 令牌认证与用户查询响应的校验器与解析结果。
+	 */
+	FDreamAccountConditionalCache ConditionalCache;
+
+	/**
+	 * @brief 本地校验规则，默认为内置规则。
+	 */
+	FDreamAccountValidationRules ValidationRules;
+
+	/**
+	 * @brief 用户名可用性检查器。
+	 */
+	FDreamAccountUsernameChecker UsernameChecker;
+
+	/**
+	 * @brief 正在请求中的 UserID 及等待它们的查询。
 	 */
-	FString Token;
+	TMap<int32, TArray<TSharedRef<FPendingUserLookup>>> InFlightUserLookups;
 };
@@ -0,0 +1,93 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @class FDreamAccountTimeoutEstimator
+ * @brief 按接口根据观测到的延迟自适应调整请求超时时间。
+ *
+ * 与 TCP 的重传超时（RFC 6298）相同：维护平滑延迟 SRTT 与延迟偏差 RTTVAR，
+ * 超时时间为 SRTT + 4 * RTTVAR，并限制在 AdaptiveTimeoutMin 与 AdaptiveTimeoutMax 之间。
+ * 样本不足时使用 TimeoutTime；请求超时后超时时间翻倍，直到收到新的响应。
+ *
+ * 只对没有显式设置 FDreamAccountHttpRequest::Timeout 的请求生效，
+ * 由 FDreamAccountUtil::SendHttpRequest 自动采样，仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountTimeoutEstimator
+{
+public:
+	static FDreamAccountTimeoutEstimator& Get();
+
+	/** 是否启用自适应超时（回放录制时总是关闭） */
+	bool IsEnabled() const;
+
+	/**
+	 * @brief 获取接口当前的超时时间（秒）。
+	 *
+	 * @param EndpointKey 由 FDreamAccountRequestHedger::GetEndpointKey 生成的接口标识。
+	 */
+	double GetTimeout(const FString& EndpointKey) const;
+
+	/**
+	 * @brief 用完成的请求更新估计。
+	 *
+	 * @param Request 请求描述。
+	 * @param TimeoutSeconds 发送时使用的超时时间，用于判断传输失败是否为超时。
+	 * @param Response 请求的响应。
+	 */
+	void HandleResponse(const FDreamAccountHttpRequest& Request, double TimeoutSeconds, const FDreamAccountHttpResponse& Response);
+
+	/**
+	 * @brief 获取各接口的超时估计统计。
+	 */
+	TArray<FDreamAccountTimeoutStats> GetStats() const;
+
+	/**
+	 * @brief 清空所有接口的估计，恢复使用 TimeoutTime。
+	 */
+	void ResetStats();
+
+private:
+	FDreamAccountTimeoutEstimator();
+
+	/** 平滑延迟的增益 */
+	static constexpr double Alpha = 1.0 / 8.0;
+
+	/** 延迟偏差的增益 */
+	static constexpr double Beta = 1.0 / 4.0;
+
+	/** 延迟偏差的倍数 */
+	static constexpr double VarianceFactor = 4.0;
+
+	/** 延迟偏差项的下限（秒），避免延迟非常稳定时超时时间贴近平均延迟 */
+	static constexpr double MinVarianceTerm = 0.01;
+
+	/** 连续超时时最多翻倍的次数 */
+	static constexpr int32 MaxBackoffCount = 6;
+
+	struct FEndpointState
+	{
+		/** 平滑延迟（秒） */
+		double SmoothedSeconds = 0.0;
+
+		/** 延迟偏差（秒） */
+		double VariationSeconds = 0.0;
+
+		int32 SampleCount = 0;
+		int32 TimeoutCount = 0;
+
+		/** 当前超时时间已翻倍的次数，收到响应后清零 */
+		int32 BackoffCount = 0;
+
+		void AddSample(double Seconds);
+	};
+
+	/** 根据估计与设置计算超时时间 */
+	static double ComputeTimeout(const FEndpointState* Endpoint);
+
+	TMap<FString, FEndpointState> Endpoints;
+};
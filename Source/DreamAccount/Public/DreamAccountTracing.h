@@ -0,0 +1,192 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Containers/Ticker.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @brief 一个正在记录的 span
+ */
+struct DREAMACCOUNT_API FDreamAccountSpan
+{
+	/** span 自身的上下文，子 span 与请求头以它为父级 */
+	FDreamAccountTraceContext Context;
+
+	FString ParentSpanId;
+	FString Name;
+
+	/** OTLP 的 SpanKind：1 内部，3 客户端 */
+	int32 Kind = 1;
+
+	double StartTime = 0.0;
+	double EndTime = 0.0;
+	bool bError = false;
+
+	TArray<TPair<FString, FString>> StringAttributes;
+	TArray<TPair<FString, int64>> IntAttributes;
+
+	/** 添加属性，未采样的 span 不保存 */
+	void SetAttribute(const FString& Key, const FString& Value);
+	void SetAttribute(const FString& Key, int64 Value);
+};
+
+/**
+ * @class FDreamAccountTracer
+ * @brief 为账号请求生成 W3C Trace Context，并以 OTLP JSON 导出 span。
+ *
+ * 每个账号请求都附加 traceparent 请求头，服务器可以据此把日志与客户端的一次操作对应起来。
+ * 被采样的追踪记录网络请求、响应解析、回调排队与回调执行四类 span，定期写入本地文件或上传到收集器；
+ * 未被采样的追踪只生成 ID，不分配其他内存。导出内容在游戏线程序列化，写文件在后台线程依次进行。当前上下文保存在游戏线程上，请求完成时恢复为该请求的 span，
+ * 因此在完成回调中发出的请求、解析与分发的回调自动归入同一个追踪。仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountTracer
+{
+public:
+	static FDreamAccountTracer& Get();
+
+	/**
+	 * @brief 按当前设置开始追踪与定期导出。
+	 */
+	void Start();
+
+	/**
+	 * @brief 导出剩余的 span 并停止追踪。
+	 */
+	void Stop();
+
+	/** 是否启用追踪 */
+	bool IsEnabled() const { return bEnabled; }
+
+	/**
+	 * @brief 获取游戏线程上的当前上下文，没有进行中的追踪时返回空上下文。
+	 */
+	static const FDreamAccountTraceContext& GetCurrentContext();
+
+	/**
+	 * @brief 为新的操作确定追踪上下文：有当前上下文时沿用，否则按采样率开始新的追踪。
+	 */
+	FDreamAccountTraceContext StartTrace();
+
+	/**
+	 * @brief 开始一个子 span；父级无效时开始新的追踪。
+	 *
+	 * @param Kind OTLP 的 SpanKind，1 为内部操作，3 为客户端请求。
+	 */
+	FDreamAccountSpan BeginSpan(const FString& Name, const FDreamAccountTraceContext& Parent, int32 Kind = 1);
+
+	/**
+	 * @brief 结束 span，被采样时放入导出缓冲区。
+	 */
+	void EndSpan(FDreamAccountSpan& Span);
+
+	/**
+	 * @brief 记录一个已经结束的 span，例如回调的排队时间。
+	 */
+	void RecordSpan(const FString& Name, const FDreamAccountTraceContext& Parent, double StartTime, double EndTime);
+
+	/**
+	 * @brief 立即导出缓冲区中的 span。
+	 */
+	void Flush();
+
+	/**
+	 * @brief 获取追踪统计。
+	 */
+	FDreamAccountTracingStats GetStats() const;
+
+	/**
+	 * @brief 清空统计。
+	 */
+	void ResetStats();
+
+private:
+	friend class FDreamAccountTraceScope;
+
+	FDreamAccountTracer();
+
+	bool Tick(float DeltaTime);
+
+	/** 将 span 序列化为一个 OTLP ExportTraceServiceRequest */
+	FString BuildExportRequest(const TArray<FDreamAccountSpan>& Spans) const;
+
+	/**
+	 * @brief 上一次写文件完成后，把积累的导出内容交给后台线程追加到文件。
+	 *
+	 * @param bWait 是否等待写入完成，停止追踪时使用。
+	 */
+	void WriteExportFile(bool bWait);
+
+	/** 将 FPlatformTime::Seconds 转换为 Unix 纳秒时间戳 */
+	FString ToUnixNanos(double PlatformSeconds) const;
+
+	static FString NewTraceId();
+	static FString NewSpanId();
+
+	static FDreamAccountTraceContext CurrentContext;
+
+	TArray<FDreamAccountSpan> PendingSpans;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+	bool bEnabled = false;
+	float SampleRate = 0.0f;
+	int32 MaxBufferedSpans = 0;
+	FString ExportFilePath;
+	FString CollectorURL;
+
+	/** 等待写入文件的导出内容，每行一个 ExportTraceServiceRequest */
+	FString PendingFileContent;
+
+	/** 进行中的后台写文件，同一时间只有一个，保证各行按导出顺序写入 */
+	TFuture<bool> FileWrite;
+
+	/** FPlatformTime::Seconds 与 Unix 时间的差（秒） */
+	double UnixTimeOffset = 0.0;
+
+	int32 StartedTraceCount = 0;
+	int32 SampledTraceCount = 0;
+	int32 RecordedSpanCount = 0;
+	int32 DroppedSpanCount = 0;
+	int32 ExportedSpanCount = 0;
+	int32 ExportFailureCount = 0;
+};
+
+/**
+ * @class FDreamAccountTraceScope
+ * @brief 在作用域内把游戏线程的当前上下文设置为指定的上下文，离开作用域时恢复。
+ */
+class DREAMACCOUNT_API FDreamAccountTraceScope
+{
+public:
+	explicit FDreamAccountTraceScope(const FDreamAccountTraceContext& Context);
+	~FDreamAccountTraceScope();
+
+private:
+	FDreamAccountTraceContext Previous;
+	bool bActive = false;
+};
+
+/**
+ * @class FDreamAccountScopedSpan
+ * @brief 在作用域内记录当前上下文的一个子 span，并把它设为当前上下文；当前追踪未被采样时什么也不做。
+ */
+class DREAMACCOUNT_API FDreamAccountScopedSpan
+{
+public:
+	explicit FDreamAccountScopedSpan(const TCHAR* Name);
+	FDreamAccountScopedSpan(const TCHAR* Name, const FDreamAccountTraceContext& Parent);
+	~FDreamAccountScopedSpan();
+
+	/** 是否正在记录 */
+	bool IsRecording() const { return Span.IsSet(); }
+
+	/** 记录中的 span，未记录时为空 */
+	FDreamAccountSpan* Get() { return Span.GetPtrOrNull(); }
+
+private:
+	TOptional<FDreamAccountSpan> Span;
+	TOptional<FDreamAccountTraceScope> Scope;
+};
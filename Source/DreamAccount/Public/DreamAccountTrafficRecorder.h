@@ -0,0 +1,133 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DreamAccountHttp.h"
+
+/**
+ * @brief 录制文件中的一条请求记录
+ *
+ * 请求体只保存 CRC，避免把密码等凭据写入磁盘；回放时用它区分同一路径上请求体不同的请求。
+ */
+struct DREAMACCOUNT_API FDreamAccountTraceEntry
+{
+	/** 请求发出时距离录制开始的时间（秒） */
+	double StartOffsetSeconds = 0.0;
+
+	/** 请求耗时（秒） */
+	float ElapsedSeconds = 0.0f;
+
+	FString Verb;
+	FString Path;
+	uint32 RequestContentCrc = 0;
+
+	bool bSucceeded = false;
+	int32 ResponseCode = 0;
+	FString ResponseContent;
+	TMap<FString, FString> ResponseHeaders;
+
+	friend FArchive& operator<<(FArchive& Ar, FDreamAccountTraceEntry& Entry);
+};
+
+/**
+ * @class FDreamAccountTrafficRecorder
+ * @brief 账号请求的录制与回放。
+ *
+ * 录制模式下记录经过 FDreamAccountUtil::SendHttpRequest 的请求、响应、状态码和耗时，
+ * 停止时写入压缩的二进制录制文件；回放模式下不发出任何请求，
+ * 按请求方法、路径和请求体 CRC 匹配录制内容，并按原始耗时（可加速）返回响应。
+ * 同一路径上没有请求体相同的记录时按录制顺序取下一条，并计入 UnmatchedCount。
+ * 仅在游戏线程使用。
+ *
+ * 可以通过控制台命令 DreamAccount.Trace.Record / Replay / Stop，
+ * 或命令行参数 -DreamAccountRecord=<File>、-DreamAccountReplay=<File> -DreamAccountReplaySpeed=<Speed> 控制。
+ */
+class DREAMACCOUNT_API FDreamAccountTrafficRecorder
+{
+public:
+	static FDreamAccountTrafficRecorder& Get();
+
+	bool IsRecording() const { return bRecording; }
+	bool IsReplaying() const { return bReplaying; }
+
+	/**
+	 * @brief 开始录制，已有的录制或回放会被停止。
+	 *
+	 * @param FilePath 录制文件路径，相对路径基于 Saved/DreamAccount/Traces。
+	 */
+	void StartRecording(const FString& FilePath);
+
+	/**
+	 * @brief 停止录制并写入文件。
+	 *
+	 * @return 是否成功写入。
+	 */
+	bool StopRecording();
+
+	/**
+	 * @brief 加载录制文件并开始回放。
+	 *
+	 * @param FilePath 录制文件路径，相对路径基于 Saved/DreamAccount/Traces。
+	 * @param Speed 回放速度倍率，1 为原始速度，0 表示不等待立即返回。
+	 * @return 是否成功加载。
+	 */
+	bool StartReplay(const FString& FilePath, float Speed = 1.0f);
+
+	/**
+	 * @brief 停止回放。
+	 */
+	void StopReplay();
+
+	/**
+	 * @brief 记录一次已完成的请求（录制模式）。
+	 */
+	void RecordExchange(const FDreamAccountHttpRequest& Request, double StartTime, const FDreamAccountHttpResponse& Response);
+
+	/**
+	 * @brief 以录制内容响应请求（回放模式）。
+	 */
+	void ReplayRequest(const FDreamAccountHttpRequest& Request, const FDreamAccountHttpCallback& OnComplete);
+
+	/** 回放统计，UnmatchedCount 包含没有记录以及请求体与记录不符的请求 */
+	int32 GetReplayedCount() const { return ReplayedCount; }
+	int32 GetUnmatchedCount() const { return UnmatchedCount; }
+	int32 GetRemainingCount() const;
+
+	static bool SaveTrace(const FString& FilePath, const TArray<FDreamAccountTraceEntry>& Entries);
+	static bool LoadTrace(const FString& FilePath, TArray<FDreamAccountTraceEntry>& OutEntries);
+
+	/** 将相对路径解析到 Saved/DreamAccount/Traces 目录 */
+	static FString ResolveTracePath(const FString& FilePath);
+
+private:
+	FDreamAccountTrafficRecorder() = default;
+
+	static FString MakeMatchKey(const FString& Verb, const FString& Path);
+
+	bool bRecording = false;
+	FString RecordingPath;
+	double RecordingStartTime = 0.0;
+	TArray<FDreamAccountTraceEntry> RecordedEntries;
+
+	bool bReplaying = false;
+	float ReplaySpeed = 1.0f;
+	TArray<FDreamAccountTraceEntry> ReplayEntries;
+
+	struct FReplayQueue
+	{
+		/** 条目索引，按录制顺序排列 */
+		TArray<int32> EntryIndices;
+
+		/** 第一条尚未回放的条目在 EntryIndices 中的位置 */
+		int32 Cursor = 0;
+	};
+
+	/** 按 "Verb Path" 分组的待回放条目 */
+	TMap<FString, FReplayQueue> ReplayQueues;
+
+	/** 已回放的条目，下标与 ReplayEntries 对应 */
+	TBitArray<> ConsumedEntries;
+	int32 ReplayedCount = 0;
+	int32 UnmatchedCount = 0;
+};
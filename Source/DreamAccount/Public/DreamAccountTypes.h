@@ -7,10 +7,18 @@
 
 struct FDreamAccountUser;
 struct FDreamAccountResult;
+struct FDreamAccountUserLookupResult;
+struct FDreamAccountUsernameCheckResult;
+struct FDreamAccountAdmissionResult;
+struct FDreamAccountQueueStatus;
 enum class EDreamAccountResultType : uint8;
 enum class EDreamAccountErrorType : uint8;
 
 using FDreamAccountResultCallback = TFunction<void(const FDreamAccountResult&)>;
+using FDreamAccountUserLookupCallback = TFunction<void(const FDreamAccountUserLookupResult&)>;
+using FDreamAccountUsernameCheckCallback = TFunction<void(const FDreamAccountUsernameCheckResult&)>;
+using FDreamAccountAdmissionCallback = TFunction<void(const FDreamAccountAdmissionResult&)>;
+using FDreamAccountQueueCallback = TFunction<void(const FDreamAccountQueueStatus&)>;
 
 /**
  * @brief 账户操作结果类型枚举
@@ -25,6 +33,9 @@ enum class EDreamAccountResultType : uint8
 	Register, // 注册操作
 	Login, // 登录操作
 	Auth, // 认证操作
+	Lookup, // 用户信息查询
+	RegisterAndLogin, // 注册并登录
+	Refresh, // 刷新令牌
 };
 
 /**
@@ -59,6 +70,38 @@ enum class EDreamAccountErrorType : uint8
 	// 本地错误
 	LOCAL_INPUT_DATA_NOT_VALID UMETA(DisplayName = "Input Data Not Valid"), // 输入数据错误
 	LOCAL_TOKEN_NOT_VALID UMETA(DisplayName = "Token Not Valid"), // 令牌无效
+	LOCAL_REQUEST_CANCELLED UMETA(DisplayName = "Request Cancelled"), // 请求已被取消或被新的请求取代
+	LOCAL_SERVER_BUSY UMETA(DisplayName = "Server Busy"), // 服务器繁忙，排队人数已满或等待超时
+	LOCAL_KEY_DERIVATION_FAILED UMETA(DisplayName = "Key Derivation Failed"), // 密码派生失败，服务器下发的参数无效或超出内存上限
+};
+
+/**
+ * @brief 服务器推送事件类型枚举
+ * 
+ * 通过推送通道实时下发的会话事件类型
+ */
+UENUM(BlueprintType)
+enum class EDreamAccountPushEventType : uint8
+{
+	Unknown, // 未知事件
+	TokenRevoked, // 令牌已被吊销
+	UserBanned, // 账号已被封禁
+	ForcedLogout, // 被强制登出（例如在其他设备登录）
+};
+
+/**
+ * @brief 会话事件类型枚举
+ * 
+ * 会话发生变化的原因，Expired、Banned、LoggedOut 发生时会话已被清除
+ */
+UENUM(BlueprintType)
+enum class EDreamAccountSessionEventType : uint8
+{
+	LoggedIn, // 登录（包括注册并登录、切换到其他账号）
+	Refreshed, // 同一用户的令牌、用户信息或过期时间更新
+	Expired, // 令牌被服务器确认失效或被吊销
+	Banned, // 账号被封禁
+	LoggedOut, // 主动登出或被强制登出
 };
 
 USTRUCT(BlueprintType)
@@ -75,6 +118,14 @@ public:
 
 public:
 	FString Serialize() const;
+
+	/**
+	 * @brief 序列化到已有的字符串中，复用其缓冲区。
+	 *
+	 * @param PasswordOverride 不为空时代替 Password 发送（客户端派生后的密钥）。
+	 * @param KdfAlgorithm 不为空时附带 password_kdf 字段。
+	 */
+	void SerializeTo(FString& OutJsonString, const FString* PasswordOverride = nullptr, const TCHAR* KdfAlgorithm = nullptr) const;
 };
 
 /**
@@ -158,7 +209,7 @@ public:
 	 * @param InUser 账户用户信息对象
 	 */
 	FDreamAccountResult(EDreamAccountResultType InResultType, EDreamAccountErrorType InErrorType, FDreamAccountUser InUser)
-		: ResultType(InResultType), ErrorType(InErrorType), User(InUser), bIsValidResult(true)
+		: ResultType(InResultType), ErrorType(InErrorType), User(MoveTemp(InUser)), bIsValidResult(true)
 	{
 	}
 
@@ -173,7 +224,7 @@ public:
 	 * @param InToken 访问令牌字符串
 	 */
 	FDreamAccountResult(EDreamAccountResultType InResultType, EDreamAccountErrorType InErrorType, FDreamAccountUser InUser, FString InToken)
-		: ResultType(InResultType), ErrorType(InErrorType), User(InUser), Token(InToken), bIsValidResult(true)
+		: ResultType(InResultType), ErrorType(InErrorType), User(MoveTemp(InUser)), Token(MoveTemp(InToken)), bIsValidResult(true)
 	{
 	}
 
@@ -196,3 +247,619 @@ public:
 	/** 结果有效性标志，标识该结果对象是否包含有效数据 */
 	bool bIsValidResult;
 };
+
+
+/**
+ * @brief 批量用户信息查询结果结构体
+ * 
+ * 用于封装按 UserID 批量查询用户信息的结果，
+ * 包含查询到的用户、未找到的用户ID以及缓存命中数量。
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountUserLookupResult
+{
+	GENERATED_BODY()
+
+public:
+	FDreamAccountUserLookupResult()
+		: bIsValidResult(false)
+	{
+	}
+
+	FDreamAccountUserLookupResult(EDreamAccountErrorType InErrorType)
+		: ErrorType(InErrorType), bIsValidResult(true)
+	{
+	}
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EDreamAccountErrorType ErrorType = EDreamAccountErrorType::UNKNOWN;
+
+	/** 查询到的用户信息，顺序与请求的 UserID 顺序一致 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FDreamAccountUser> Users;
+
+	/** 服务器上不存在的用户ID */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<int32> MissingUserIDs;
+
+	/** 直接由本地缓存返回的用户数量 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 CacheHitCount = 0;
+
+	/** 结果有效性标志，标识该结果对象是否包含有效数据 */
+	bool bIsValidResult;
+};
+
+
+/**
+ * @brief 用户名可用性检查结果结构体
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountUsernameCheckResult
+{
+	GENERATED_BODY()
+
+public:
+	FDreamAccountUsernameCheckResult()
+		: bIsValidResult(false)
+	{
+	}
+
+	FDreamAccountUsernameCheckResult(EDreamAccountErrorType InErrorType, FString InUserName)
+		: ErrorType(InErrorType), UserName(MoveTemp(InUserName)), bIsValidResult(true)
+	{
+	}
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EDreamAccountErrorType ErrorType = EDreamAccountErrorType::UNKNOWN;
+
+	/** 被检查的用户名 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString UserName;
+
+	/** 用户名是否可用，仅在 ErrorType 为 NORMAL 时有意义 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bAvailable = false;
+
+	/** 是否直接由本地缓存返回 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bFromCache = false;
+
+	/** 结果有效性标志，标识该结果对象是否包含有效数据 */
+	bool bIsValidResult;
+};
+
+
+/**
+ * @brief 玩家加入时的令牌校验结果结构体
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountAdmissionResult
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EDreamAccountErrorType ErrorType = EDreamAccountErrorType::UNKNOWN;
+
+	/** 令牌对应的用户，仅在 ErrorType 为 NORMAL 时有效 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FDreamAccountUser User;
+
+	/** 排队等待准入的时间（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float WaitMs = 0.0f;
+
+	/** 校验请求的耗时（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ValidationMs = 0.0f;
+
+	/** 是否复用了近期的校验结果 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bFromCache = false;
+
+	/** 结果有效性标志，标识该结果对象是否包含有效数据 */
+	bool bIsValidResult = false;
+};
+
+
+/**
+ * @brief 结果回调按帧预算分发的统计
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountDispatchStats
+{
+	GENERATED_BODY()
+
+public:
+	/** 分发的回调总数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 DispatchedCount = 0;
+
+	/** 因本帧预算用完而排队到后续帧的回调数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 DeferredCount = 0;
+
+	/** 当前排队的回调数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 QueueLength = 0;
+
+	/** 排队回调数的峰值 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 PeakQueueLength = 0;
+
+	/** 交互操作回调的平均排队延迟（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float InteractiveAverageLatencyMs = 0.0f;
+
+	/** 后台操作回调的平均排队延迟（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float BackgroundAverageLatencyMs = 0.0f;
+
+	/** 最大排队延迟（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MaxQueueLatencyMs = 0.0f;
+
+	/** 预算用完后仍有回调排队的帧数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 BudgetExceededFrameCount = 0;
+
+	/** 单个回调的耗时就超过整帧预算的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 SlowCallbackCount = 0;
+
+	/** 单个回调的最长耗时（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float LongestCallbackMs = 0.0f;
+};
+
+
+/**
+ * @brief 客户端延迟信标的采集与上传统计
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountLatencyBeaconStats
+{
+	GENERATED_BODY()
+
+public:
+	/** 记录的请求数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 RecordedCount = 0;
+
+	/** 上传前被环形缓冲区覆盖而丢弃的记录数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 OverwrittenCount = 0;
+
+	/** 当前缓冲区中等待上传的记录数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 BufferedCount = 0;
+
+	/** 上传成功的批次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 UploadCount = 0;
+
+	/** 上传失败的批次数，失败批次中的记录不再重传 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 UploadFailureCount = 0;
+
+	/** 最近一批压缩前的字节数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 LastBatchRawBytes = 0;
+
+	/** 最近一批压缩后的字节数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 LastBatchCompressedBytes = 0;
+};
+
+
+/**
+ * @brief 请求追踪与 span 导出统计
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountTracingStats
+{
+	GENERATED_BODY()
+
+public:
+	/** 开始的追踪数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 StartedTraceCount = 0;
+
+	/** 其中被采样的追踪数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 SampledTraceCount = 0;
+
+	/** 记录的 span 数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 RecordedSpanCount = 0;
+
+	/** 缓冲区已满而丢弃的 span 数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 DroppedSpanCount = 0;
+
+	/** 已导出的 span 数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ExportedSpanCount = 0;
+
+	/** 写入文件或上传收集器失败的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ExportFailureCount = 0;
+};
+
+
+/**
+ * @brief 条件请求（ETag / Last-Modified）统计
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountConditionalStats
+{
+	GENERATED_BODY()
+
+public:
+	/** 保存了校验器的请求数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 EntryCount = 0;
+
+	/** 附带校验器发出的条件请求数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ConditionalRequestCount = 0;
+
+	/** 服务器返回 304 并复用缓存结果的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 NotModifiedCount = 0;
+
+	/** 条件请求中返回 304 的比例 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float NotModifiedRate = 0.0f;
+
+	/** 少下载的响应体字节数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int64 BytesSaved = 0;
+
+	/** 省去的 JSON 解析时间（毫秒），按保存条目时的解析耗时估算 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ParseTimeSavedMs = 0.0f;
+};
+
+
+/**
+ * @brief 登录排队状态
+ *
+ * 服务器限流登录时下发排队票据，客户端等待放行期间定期更新排队位置与预计等待时间。
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountQueueStatus
+{
+	GENERATED_BODY()
+
+public:
+	/** 服务器下发的排队票据 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString Ticket;
+
+	/** 当前排队位置，1 表示下一个被放行 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Position = 0;
+
+	/** 服务器估计的剩余等待时间（秒），小于 0 表示未知 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float EtaSeconds = -1.0f;
+
+	/** 从开始排队到现在的等待时间（秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float WaitedSeconds = 0.0f;
+
+	/** 是否已被放行，随后会自动重新发送登录请求 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bAdmitted = false;
+};
+
+
+/**
+ * @brief 玩家加入时令牌校验的准入统计
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountAdmissionStats
+{
+	GENERATED_BODY()
+
+public:
+	/** 通过校验的加入次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 AdmittedCount = 0;
+
+	/** 因令牌无效、封禁等被拒绝的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 RejectedCount = 0;
+
+	/** 因排队已满或等待超时被拒绝的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 BusyCount = 0;
+
+	/** 复用近期结果的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 CacheHitCount = 0;
+
+	/** 实际发出的校验请求数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ValidationCount = 0;
+
+	/** 进行中的校验请求数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 InFlightCount = 0;
+
+	/** 当前排队的令牌数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 QueueLength = 0;
+
+	/** 排队长度峰值 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 PeakQueueLength = 0;
+
+	/** 平均排队时间（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float AverageWaitMs = 0.0f;
+
+	/** 最长排队时间（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MaxWaitMs = 0.0f;
+};
+
+
+/**
+ * @brief 单个账号服务器分片的统计
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountShardStats
+{
+	GENERATED_BODY()
+
+public:
+	/** 分片地址 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString Endpoint;
+
+	/** 是否仍在当前的分片列表中 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bActive = false;
+
+	/** 该分片在哈希环上所占的比例 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float KeyShare = 0.0f;
+
+	/** 请求数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 RequestCount = 0;
+
+	/** 失败数（传输失败或 5xx） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 ErrorCount = 0;
+
+	/** 迁移窗口内回退到旧分片的请求数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 FallbackCount = 0;
+
+	/** 平均延迟（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float AverageLatencyMs = 0.0f;
+
+	/** 指数平滑后的近期延迟（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float RecentLatencyMs = 0.0f;
+
+	/** 最大延迟（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MaxLatencyMs = 0.0f;
+};
+
+
+/**
+ * @brief 单个接口的请求对冲统计
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountHedgeStats
+{
+	GENERATED_BODY()
+
+public:
+	/** 接口（请求方法与去掉查询参数的地址） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString Endpoint;
+
+	/** 可对冲的请求数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 RequestCount = 0;
+
+	/** 发出对冲的请求数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 HedgeCount = 0;
+
+	/** 对冲请求先返回的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 HedgeWinCount = 0;
+
+	/** 因预算不足未能对冲的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 BudgetDeniedCount = 0;
+
+	/** 对冲率 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float HedgeRate = 0.0f;
+
+	/** 当前学习到的对冲等待时间（毫秒），样本不足时为 0 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float HedgeDelayMs = 0.0f;
+
+	/** 主请求延迟的分位数（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float P50LatencyMs = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float P95LatencyMs = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float P99LatencyMs = 0.0f;
+
+	/** 对冲节省的总延迟估计（毫秒），按被取消的主请求的尾部平均延迟估算 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float EstimatedSavedMs = 0.0f;
+};
+
+
+/**
+ * @brief 单个接口的自适应超时统计
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountTimeoutStats
+{
+	GENERATED_BODY()
+
+public:
+	/** 接口（请求方法与去掉查询参数的地址） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString Endpoint;
+
+	/** 参与估计的延迟样本数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 SampleCount = 0;
+
+	/** 超时的请求数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 TimeoutCount = 0;
+
+	/** 当前超时时间因连续超时翻倍的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 BackoffCount = 0;
+
+	/** 平滑延迟（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float SmoothedLatencyMs = 0.0f;
+
+	/** 延迟偏差（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float LatencyVariationMs = 0.0f;
+
+	/** 当前使用的超时时间（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float TimeoutMs = 0.0f;
+};
+
+
+/**
+ * @brief 本地封禁列表的同步统计
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountBanListStats
+{
+	GENERATED_BODY()
+
+public:
+	/** 是否已完成至少一次同步 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bReady = false;
+
+	/** 服务器上的封禁列表版本 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int64 Version = -1;
+
+	/** 封禁的用户数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 BannedCount = 0;
+
+	/** 尚未合并进基础表的增量条目数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 OverlayCount = 0;
+
+	/** 占用的内存（字节） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int64 MemoryBytes = 0;
+
+	/** 同步延迟（秒）：本地列表至少与多少秒前的服务器数据一致，尚未同步时为 -1 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float LagSeconds = -1.0f;
+
+	/** 最近一次同步从发出请求到发布的耗时（毫秒） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float LastSyncDurationMs = 0.0f;
+
+	/** 下载完整快照的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 SnapshotCount = 0;
+
+	/** 应用增量的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 DeltaCount = 0;
+
+	/** 同步失败的次数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 FailureCount = 0;
+};
+
+
+/**
+ * @brief 服务器推送事件结构体
+ * 
+ * 推送通道收到的会话事件，事件到达时本地令牌已被清除。
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountPushEvent
+{
+	GENERATED_BODY()
+
+public:
+	/** 事件类型 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EDreamAccountPushEventType EventType = EDreamAccountPushEventType::Unknown;
+
+	/** 与事件对应的错误类型，例如封禁对应 NETWORK_USER_BANNED */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EDreamAccountErrorType ErrorType = EDreamAccountErrorType::UNKNOWN;
+
+	/** 服务器给出的原因说明 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString Reason;
+};
+
+
+/**
+ * @brief 会话变化结构体
+ * 
+ * 会话事件在蓝图中的表示，C++ 中可以直接订阅 FDreamAccountSessionEventBus 获取变化前后的完整快照。
+ */
+USTRUCT(BlueprintType)
+struct FDreamAccountSessionChange
+{
+	GENERATED_BODY()
+
+public:
+	/** 事件类型 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EDreamAccountSessionEventType EventType = EDreamAccountSessionEventType::LoggedOut;
+
+	/** 变化前的用户，变化前未登录时为空 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FDreamAccountUser PreviousUser;
+
+	/** 变化后的用户，会话被清除时为空 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FDreamAccountUser CurrentUser;
+
+	/** 变化后是否已登录 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bIsLoggedIn = false;
+
+	/** 令牌是否发生变化 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bTokenChanged = false;
+
+	/** 变化后的令牌过期时间（UTC） */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FDateTime ExpiresAt = FDateTime::MaxValue();
+
+	/** 变化后的会话代数 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int64 Generation = 0;
+};
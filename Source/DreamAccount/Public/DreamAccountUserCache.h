@@ -0,0 +1,106 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @class FDreamAccountUserCache
+ * @brief 以 UserID 为键的用户信息 LRU 缓存。
+ *
+ * 缓存同时受条目数量、内存占用和过期时间（TTL）三重限制：
+ * 超出数量或内存上限时淘汰最久未使用的条目，过期条目在查询时惰性移除。
+ * 仅在游戏线程使用，不做线程同步。
+ */
+class DREAMACCOUNT_API FDreamAccountUserCache
+{
+public:
+	FDreamAccountUserCache();
+	~FDreamAccountUserCache();
+
+	FDreamAccountUserCache(const FDreamAccountUserCache&) = delete;
+	FDreamAccountUserCache& operator=(const FDreamAccountUserCache&) = delete;
+
+	/**
+	 * @brief 配置缓存上限，超出新上限的条目会被立即淘汰。
+	 *
+	 * @param InMaxEntries 最大条目数，小于等于 0 时禁用缓存。
+	 * @param InMaxMemoryBytes 最大内存占用（字节），小于等于 0 时不限制。
+	 * @param InTimeToLiveSeconds 条目存活时间（秒），小于等于 0 时永不过期。
+	 */
+	void Configure(int32 InMaxEntries, int64 InMaxMemoryBytes, double InTimeToLiveSeconds);
+
+	/**
+	 * @brief 查询用户信息，命中时将条目移动到最近使用位置。
+	 *
+	 * @param UserID 用户ID。
+	 * @param OutUser 命中时输出的用户信息。
+	 * @return 是否命中未过期的条目。
+	 */
+	bool Find(int32 UserID, FDreamAccountUser& OutUser);
+
+	/**
+	 * @brief 添加或更新用户信息。
+	 *
+	 * @param User 用户信息。
+	 */
+	void Add(const FDreamAccountUser& User);
+
+	/**
+	 * @brief 移除指定用户的缓存条目。
+	 *
+	 * @param UserID 用户ID。
+	 */
+	void Remove(int32 UserID);
+
+	/**
+	 * @brief 清空缓存。
+	 */
+	void Empty();
+
+	/** 当前条目数 */
+	int32 Num() const { return Entries.Num(); }
+
+	/** 当前估算的内存占用（字节） */
+	int64 GetMemoryBytes() const { return MemoryBytes; }
+
+	/** 缓存统计 */
+	uint64 GetHitCount() const { return HitCount; }
+	uint64 GetMissCount() const { return MissCount; }
+	uint64 GetEvictionCount() const { return EvictionCount; }
+
+private:
+	struct FEntry
+	{
+		FDreamAccountUser User;
+		double ExpireTime = 0.0;
+		int64 Bytes = 0;
+		FEntry* Prev = nullptr;
+		FEntry* Next = nullptr;
+	};
+
+	static int64 EstimateBytes(const FDreamAccountUser& User);
+
+	void LinkHead(FEntry* Entry);
+	void Unlink(FEntry* Entry);
+	void RemoveEntry(FEntry* Entry);
+	void EvictToLimits();
+
+	TMap<int32, TUniquePtr<FEntry>> Entries;
+
+	/** 最近使用的条目 */
+	FEntry* Head = nullptr;
+
+	/** 最久未使用的条目 */
+	FEntry* Tail = nullptr;
+
+	int32 MaxEntries = 0;
+	int64 MaxMemoryBytes = 0;
+	double TimeToLiveSeconds = 0.0;
+	int64 MemoryBytes = 0;
+
+	uint64 HitCount = 0;
+	uint64 MissCount = 0;
+	uint64 EvictionCount = 0;
+};
@@ -0,0 +1,120 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @class FDreamAccountUsernameChecker
+ * @brief 用户名可用性检查，带防抖、取代取消和短时缓存。
+ *
+ * 每个输入框（以 FieldKey 区分）同一时间只有一次检查：新的检查会取代尚未发出或仍在请求中的旧检查，
+ * 被取代的检查以 LOCAL_REQUEST_CANCELLED 结束。结果按用户名缓存，已占用与可用分别使用不同的存活时间。
+ *
+ * 服务器在响应中返回被检查用户名所有前缀里已被占用的部分（"taken_prefixes"）时，
+ * 每个前缀都会被缓存，因此删除字符回退到更短的用户名时不需要再次请求。仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountUsernameChecker
+{
+public:
+	FDreamAccountUsernameChecker();
+	~FDreamAccountUsernameChecker();
+
+	FDreamAccountUsernameChecker(const FDreamAccountUsernameChecker&) = delete;
+	FDreamAccountUsernameChecker& operator=(const FDreamAccountUsernameChecker&) = delete;
+
+	/**
+	 * @brief 配置防抖时间与缓存时间。
+	 *
+	 * @param InDebounceSeconds 防抖时间（秒），小于等于 0 时立即发送。
+	 * @param InTakenTimeToLive 已占用用户名的缓存时间（秒）。
+	 * @param InAvailableTimeToLive 可用用户名的缓存时间（秒）。
+	 */
+	void Configure(double InDebounceSeconds, double InTakenTimeToLive, double InAvailableTimeToLive);
+
+	/**
+	 * @brief 检查用户名是否可用。
+	 *
+	 * @param FieldKey 输入框标识，同一输入框的新检查会取代旧检查。
+	 * @param UserName 需要检查的用户名。
+	 * @param Callback 完成、命中缓存或被取代时调用，每次检查恰好调用一次。
+	 */
+	void Check(FName FieldKey, const FString& UserName, FDreamAccountUsernameCheckCallback Callback);
+
+	/**
+	 * @brief 取消指定输入框的检查。
+	 */
+	void Cancel(FName FieldKey);
+
+	/**
+	 * @brief 取消所有输入框的检查。
+	 */
+	void CancelAll();
+
+	/**
+	 * @brief 查询缓存。
+	 *
+	 * @param UserName 用户名。
+	 * @param bOutAvailable 命中时输出是否可用。
+	 * @return 是否命中未过期的条目。
+	 */
+	bool FindCached(const FString& UserName, bool& bOutAvailable) const;
+
+	/**
+	 * @brief 记录用户名已被占用，例如注册成功或注册返回 USERNAME_EXISTS 时。
+	 */
+	void MarkTaken(const FString& UserName);
+
+	/**
+	 * @brief 清空缓存。
+	 */
+	void Empty();
+
+	/** 当前缓存条目数 */
+	int32 Num() const { return Cache.Num(); }
+
+	/** 统计 */
+	uint64 GetRequestCount() const { return RequestCount; }
+	uint64 GetCacheHitCount() const { return CacheHitCount; }
+	uint64 GetSupersededCount() const { return SupersededCount; }
+
+	/** 缓存条目上限，超出时先清理过期条目 */
+	static constexpr int32 MaxCacheEntries = 4096;
+
+private:
+	struct FFieldState
+	{
+		FString UserName;
+		FDreamAccountUsernameCheckCallback Callback;
+		FTSTicker::FDelegateHandle DebounceHandle;
+		TSharedPtr<FDreamAccountHttpCancellation> Cancellation;
+		uint32 Serial = 0;
+	};
+
+	struct FCacheEntry
+	{
+		bool bAvailable = false;
+		double ExpireTime = 0.0;
+	};
+
+	/** 停止输入框当前的检查，返回需要以取消结果回调的函数 */
+	FDreamAccountUsernameCheckCallback TakePending(FFieldState& State);
+
+	void SendCheck(FName FieldKey, uint32 Serial);
+	void HandleResponse(FName FieldKey, uint32 Serial, const FDreamAccountHttpResponse& Response);
+	void AddCacheEntry(const FString& UserName, bool bAvailable, double Now);
+
+	TMap<FName, FFieldState> Fields;
+	TMap<FString, FCacheEntry> Cache;
+
+	double DebounceSeconds = 0.3;
+	double TakenTimeToLive = 120.0;
+	double AvailableTimeToLive = 10.0;
+
+	uint64 RequestCount = 0;
+	uint64 CacheHitCount = 0;
+	uint64 SupersededCount = 0;
+};
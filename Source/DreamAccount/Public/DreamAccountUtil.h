@@ -3,9 +3,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "DreamAccountHttp.h"
 #include "DreamAccountSettings.h"
 #include "DreamAccountTypes.h"
-#include "Interfaces/IHttpRequest.h"
 
 /**
  * FDreamAccountUtil类
@@ -20,14 +20,14 @@ public:
 	 * @param Verb HTTP请求方法（如GET、POST等）
 	 * @param Content 请求体内容
 	 * @param Headers HTTP请求头信息映射表
-	 * @param OnComplete 请求完成后的回调函数，参数分别为：请求指针、响应指针、是否成功标志
+	 * @param OnComplete 请求完成后的回调函数
 	 */
 	static void SendHttpRequest(
 		const FString& URL,
 		const FString& Verb,
 		const FString& Content,
 		const TMap<FString, FString>& Headers,
-		const TFunction<void(FHttpRequestPtr, FHttpResponsePtr, bool)>& OnComplete
+		const FDreamAccountHttpCallback& OnComplete
 	);
 
 	/**
@@ -35,22 +35,44 @@ public:
 	 * @param URL 请求的目标URL地址
 	 * @param Verb HTTP请求方法（如GET、POST等）
 	 * @param Headers HTTP请求头信息映射表
-	 * @param OnComplete 请求完成后的回调函数，参数分别为：请求指针、响应指针、是否成功标志
+	 * @param OnComplete 请求完成后的回调函数
 	 */
 	static void SendHttpRequest(
 		const FString& URL,
 		const FString& Verb,
 		const TMap<FString, FString>& Headers,
-		const TFunction<void(FHttpRequestPtr, FHttpResponsePtr, bool)>& OnComplete
+		const FDreamAccountHttpCallback& OnComplete
+	);
+
+	/**
+	 * 发送HTTP请求
+	 * 启用网络模拟时请求会先经过 FDreamAccountNetworkSimulator。
+	 * 设置 Request.Cancellation 后可以随时取消，取消后不再回调。
+	 * @param Request 请求描述
+	 * @param OnComplete 请求完成后的回调函数
+	 */
+	static void SendHttpRequest(
+		const FDreamAccountHttpRequest& Request,
+		const FDreamAccountHttpCallback& OnComplete
+	);
+
+	/**
+	 * 绕过所有中间层，直接通过引擎HTTP模块发送请求
+	 * @param Request 请求描述
+	 * @param OnComplete 请求完成后的回调函数
+	 */
+	static void SendPlatformHttpRequest(
+		const FDreamAccountHttpRequest& Request,
+		const FDreamAccountHttpCallback& OnComplete
 	);
 
 	/**
 	 * 从HTTP响应中解析JSON对象
-	 * @param Response HTTP响应指针
+	 * @param Response HTTP响应
 	 * @return 解析后的JSON对象共享指针，解析失败时返回空指针
 	 */
 	static TSharedPtr<FJsonObject> ParseJsonFromResponse(
-		FHttpResponsePtr Response);
+		const FDreamAccountHttpResponse& Response);
 
 	/**
 	* 从JSON对象中解析账户信息
@@ -58,7 +80,15 @@ public:
 	* @return 解析后的账户信息对象
 	*/
 	static FDreamAccountUser ParseAccountUserFromJson(
-		TSharedPtr<FJsonObject> JsonObject);
+		const TSharedPtr<FJsonObject>& JsonObject);
+
+	/**
+	* 从JSON对象中解析用户信息数组（"users" 字段），缺少 user_id 的条目被跳过
+	* @param JsonObject JSON对象共享指针
+	* @return 解析后的用户信息数组
+	*/
+	static TArray<FDreamAccountUser> ParseAccountUsersFromJson(
+		const TSharedPtr<FJsonObject>& JsonObject);
 
 	/**
 	 *  从JSON对象中解析Token
@@ -66,21 +96,49 @@ public:
 	 * @return 解析后的Token
 	 */
 	static FString ParseTokenFromJson(
-		TSharedPtr<FJsonObject> JsonObject);
+		const TSharedPtr<FJsonObject>& JsonObject);
+
+	/**
+	 *  从JSON对象中解析Token过期时间（"expires_in" 字段，单位秒）
+	 * @param JsonObject JSON对象
+	 * @return 过期时间（UTC），服务器未提供时为 FDateTime::MaxValue()
+	 */
+	static FDateTime ParseTokenExpiryFromJson(
+		const TSharedPtr<FJsonObject>& JsonObject);
 
 	/**
 	 * 处理通用错误响应
-	 * @param Response HTTP响应指针
+	 * @param Response HTTP响应
 	 * @param Type 账户结果类型枚举值
 	 * @param OnResult 账户结果回调函数
 	 */
 	static void HandleCommonErrorResponse(
-		FHttpResponsePtr Response,
+		const FDreamAccountHttpResponse& Response,
 		EDreamAccountResultType Type,
 		const FDreamAccountResultCallback& OnResult
 	);
 
+	/**
+	 * 从错误响应中解析错误类型
+	 * @param Response HTTP响应
+	 * @return 响应中 "error" 字段对应的错误类型
+	 */
+	static EDreamAccountErrorType ParseErrorTypeFromResponse(
+		const FDreamAccountHttpResponse& Response);
+
 	static EDreamAccountErrorType GetErrorTypeFromString(const FString& ErrorString);
+
+	/**
+	 * 将字符串内容清零后释放，用于含密码的请求体
+	 * @param Value 要清除的字符串
+	 */
+	static void ScrubString(FString& Value);
+
+private:
+	/** 交给网络模拟器或引擎HTTP模块发送 */
+	static void SendTransportRequest(
+		const FDreamAccountHttpRequest& Request,
+		const FDreamAccountHttpCallback& OnComplete);
 };
 
 namespace FDreamAccountAPI
@@ -89,7 +147,18 @@ namespace FDreamAccountAPI
 #define API_MAKE(API_URL)		FString(API_SERVER_URL + TEXT(API_URL))
 #define API_REGISTER			API_MAKE("/api/account/register")
 #define API_LOGIN				API_MAKE("/api/account/login")
+#define API_LOGIN_QUEUE			API_MAKE("/api/account/login/queue")
+#define API_LOGIN_QUEUE_LEAVE	API_MAKE("/api/account/login/queue/leave")
+#define API_REGISTER_LOGIN		API_MAKE("/api/account/register_login")
 #define API_AUTH				API_MAKE("/api/account/auth")
+#define API_REFRESH				API_MAKE("/api/account/refresh")
+#define API_USERS_LOOKUP		API_MAKE("/api/account/users/lookup")
+#define API_USERNAME_AVAILABLE	API_MAKE("/api/account/username_available")
+#define API_VALIDATION_RULES	API_MAKE("/api/account/validation_rules")
+#define API_PUSH				API_MAKE("/api/account/push")
+#define API_BANS				API_MAKE("/api/account/bans")
+#define API_KDF_PARAMS			API_MAKE("/api/account/kdf_params")
+#define API_LATENCY_BEACONS		API_MAKE("/api/account/metrics/latency")
 }
 
 namespace FDreamAccountFields
@@ -98,4 +167,30 @@ namespace FDreamAccountFields
 	static FString FIELD_USER_PASSWORD = TEXT("user_password");
 	static FString FIELD_USER_ID = TEXT("user_id");
 	static FString FIELD_TOKEN = TEXT("token");
+	static FString FIELD_USER = TEXT("user");
+	static FString FIELD_USERS = TEXT("users");
+	static FString FIELD_USER_IDS = TEXT("user_ids");
+	static FString FIELD_EXPIRES_IN = TEXT("expires_in");
+	static FString FIELD_AVAILABLE = TEXT("available");
+	static FString FIELD_TAKEN_PREFIXES = TEXT("taken_prefixes");
+	static FString FIELD_VERSION = TEXT("version");
+	static FString FIELD_SINCE = TEXT("since");
+	static FString FIELD_SNAPSHOT = TEXT("snapshot");
+	static FString FIELD_ADDED = TEXT("added");
+	static FString FIELD_REMOVED = TEXT("removed");
+	static FString FIELD_PASSWORD_KDF = TEXT("password_kdf");
+	static FString FIELD_KDF_ALGORITHM = TEXT("algorithm");
+	static FString FIELD_KDF_SALT = TEXT("salt");
+	static FString FIELD_KDF_COST = TEXT("n");
+	static FString FIELD_KDF_BLOCK_SIZE = TEXT("r");
+	static FString FIELD_KDF_PARALLELISM = TEXT("p");
+	static FString FIELD_KDF_KEY_LENGTH = TEXT("length");
+	static FString FIELD_QUEUE = TEXT("queue");
+	static FString FIELD_QUEUE_TICKET = TEXT("ticket");
+	static FString FIELD_QUEUE_STATUS = TEXT("status");
+	static FString FIELD_QUEUE_POSITION = TEXT("position");
+	static FString FIELD_QUEUE_ETA = TEXT("eta_seconds");
+	static FString FIELD_QUEUE_POLL_AFTER = TEXT("poll_after");
+	static FString FIELD_QUEUE_ADMISSION = TEXT("admission");
+	static FString FIELD_QUEUE_WAIT = TEXT("wait");
 }
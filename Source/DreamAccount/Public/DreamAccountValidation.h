@@ -0,0 +1,102 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DreamAccountTypes.h"
+#include "Internationalization/Regex.h"
+
+class FJsonObject;
+
+/**
+ * @class FDreamAccountValidationRules
+ * @brief 用户名和密码的本地校验规则，与服务器的校验规则保持一致。
+ *
+ * 规则以 JSON 描述，加载时编译（字符集展开为查找表，正则表达式预先构造），
+ * 校验时不再解析字符串。规则格式：
+ *
+ *   {
+ *     "user_name":     {"min_length": 3, "max_length": 32, "charset": "A-Za-z0-9_", "pattern": "", "check_on_login": true},
+ *     "user_password": {"min_length": 6, "max_length": 64, "charset": "", "pattern": "", "check_on_login": false}
+ *   }
+ *
+ * charset 为空表示不限制字符，"-" 位于首尾时表示字面字符；pattern 需要匹配整个字符串，为空表示不检查。
+ * check_on_login 为 false 时登录不检查该字段，避免规则收紧后旧账号无法登录。
+ */
+class DREAMACCOUNT_API FDreamAccountValidationRules
+{
+public:
+	FDreamAccountValidationRules();
+
+	/**
+	 * @brief 插件内置的默认规则，无法获取服务器规则时使用。
+	 *
+	 * 只要求用户名和密码非空，登录时不检查，不会拒绝服务器本身接受的请求。
+	 */
+	static const TCHAR* GetDefaultRulesJson();
+
+	/**
+	 * @brief 从 JSON 字符串加载并编译规则，失败时保持原有规则不变。
+	 *
+	 * @param Json 规则 JSON。
+	 * @param OutError 失败原因。
+	 * @return 是否加载成功。
+	 */
+	bool LoadFromJson(const FString& Json, FString* OutError = nullptr);
+
+	/**
+	 * @brief 校验注册信息。
+	 *
+	 * @return NORMAL、NETWORK_INVALID_USERNAME 或 NETWORK_INVALID_PASSWORD。
+	 */
+	EDreamAccountErrorType ValidateRegister(const FDreamAccountInfo& Info) const;
+
+	/**
+	 * @brief 校验登录信息，只检查 check_on_login 为 true 的字段。
+	 *
+	 * @return NORMAL、NETWORK_INVALID_USERNAME 或 NETWORK_INVALID_PASSWORD。
+	 */
+	EDreamAccountErrorType ValidateLogin(const FDreamAccountInfo& Info) const;
+
+	/** 用户名是否符合规则 */
+	bool IsValidUserName(const FString& UserName) const { return UserNameRule.Matches(UserName); }
+
+	/** 密码是否符合规则 */
+	bool IsValidPassword(const FString& Password) const { return PasswordRule.Matches(Password); }
+
+	/** 当前规则是否来自服务器 */
+	bool IsFromServer() const { return bFromServer; }
+
+	/** 标记规则来源 */
+	void SetFromServer(bool bInFromServer) { bFromServer = bInFromServer; }
+
+private:
+	struct FFieldRule
+	{
+		int32 MinLength = 0;
+		int32 MaxLength = 0;
+
+		/** 是否限制字符集 */
+		bool bHasCharset = false;
+
+		/** ASCII 字符的查找表 */
+		uint64 AsciiMask[2] = {0, 0};
+
+		/** 非 ASCII 字符的允许区间 */
+		TArray<TPair<TCHAR, TCHAR>> Ranges;
+
+		TOptional<FRegexPattern> Pattern;
+
+		bool bCheckOnLogin = true;
+
+		bool Matches(const FString& Value) const;
+		bool IsAllowedChar(TCHAR Char) const;
+	};
+
+	static bool CompileField(const TSharedPtr<FJsonObject>& Json, bool bDefaultCheckOnLogin, FFieldRule& OutRule, FString& OutError);
+	static bool CompileCharset(const FString& Charset, FFieldRule& OutRule);
+
+	FFieldRule UserNameRule;
+	FFieldRule PasswordRule;
+	bool bFromServer = false;
+};
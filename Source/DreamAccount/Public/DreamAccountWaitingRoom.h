@@ -0,0 +1,94 @@
+﻿// Copyright 2025 Dream Moon. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "DreamAccountHttp.h"
+#include "DreamAccountTypes.h"
+
+/**
+ * @class FDreamAccountWaitingRoom
+ * @brief 一次登录的排队过程。
+ *
+ * 服务器限流登录时在 TOO_MANY_REQUESTS 响应中下发排队票据：
+ * {"error": "TOO_MANY_REQUESTS", "queue": {"ticket": "...", "position": 120, "eta_seconds": 45, "poll_after": 5}}
+ * 之后按服务器建议的间隔查询排队状态；没有建议时按预计等待时间估算，离放行越近轮询越频繁，位置长时间不变时逐渐放慢，
+ * 并加入随机抖动，避免同时排队的大量客户端在同一时刻轮询。启用长轮询时服务器可以挂起查询，在放行的同时返回。
+ * 放行后得到一次性的准入凭证，由 UDreamAccountSubsystem 附加在 X-Queue-Admission 请求头中重新登录。仅在游戏线程使用。
+ */
+class DREAMACCOUNT_API FDreamAccountWaitingRoom : public TSharedFromThis<FDreamAccountWaitingRoom>
+{
+public:
+	/** 排队结束时调用，ErrorType 为 NORMAL 时 Admission 为准入凭证，票据失效时为空（应重新登录以重新排队） */
+	using FOnFinished = TFunction<void(EDreamAccountErrorType ErrorType, const FString& Admission)>;
+
+	/**
+	 * @param InKeyHash 登录请求的分片路由键，排队查询发往同一分片。
+	 * @param InOnUpdate 排队状态变化时调用，可以为空。
+	 */
+	FDreamAccountWaitingRoom(uint64 InKeyHash, FDreamAccountQueueCallback InOnUpdate);
+	~FDreamAccountWaitingRoom();
+
+	/**
+	 * @brief 从被限流的登录响应中读取排队信息。
+	 *
+	 * @param OutPollAfter 服务器建议的轮询间隔（秒），没有建议时为负数；也接受 Retry-After 响应头。
+	 * @return 响应中包含排队票据时返回 true。
+	 */
+	static bool ParseQueueResponse(const FDreamAccountHttpResponse& Response, FDreamAccountQueueStatus& OutStatus, double& OutPollAfter);
+
+	/**
+	 * @brief 持有票据开始等待，重新登录后再次被要求排队时使用新的票据继续等待，总等待时间从第一次排队算起。
+	 */
+	void Wait(const FDreamAccountQueueStatus& InStatus, double PollAfter, FOnFinished InOnFinished);
+
+	/**
+	 * @brief 离开队列，通知服务器释放票据，并以 LOCAL_REQUEST_CANCELLED 结束等待。
+	 */
+	void Cancel();
+
+	/** 是否正在等待放行 */
+	bool IsWaiting() const { return OnFinished != nullptr; }
+
+	/** 获取最近一次的排队状态 */
+	const FDreamAccountQueueStatus& GetStatus() const { return Status; }
+
+private:
+	/** 安排下一次查询 */
+	void SchedulePoll(double PollAfter);
+
+	/** 计算下一次查询前的等待时间 */
+	double ComputePollDelay(double PollAfter) const;
+
+	bool HandlePollTimer(float DeltaTime);
+	void Poll();
+	void HandlePollResponse(const FDreamAccountHttpResponse& Response);
+
+	/** 通知服务器释放票据，不等待结果 */
+	void Leave();
+
+	void Finish(EDreamAccountErrorType ErrorType, const FString& Admission = FString());
+	void NotifyUpdate();
+
+	/** 连续查询失败多少次后放弃 */
+	static constexpr int32 MaxConsecutiveFailures = 3;
+
+	/** 位置不变时每次查询间隔放大的倍数 */
+	static constexpr double StallBackoff = 1.5;
+
+	uint64 KeyHash = 0;
+	FDreamAccountQueueCallback OnUpdate;
+	FOnFinished OnFinished;
+
+	FDreamAccountQueueStatus Status;
+	double EnterTime = 0.0;
+
+	FTSTicker::FDelegateHandle PollHandle;
+	TSharedPtr<FDreamAccountHttpCancellation> PollCancellation;
+
+	int32 ConsecutiveFailures = 0;
+
+	/** 位置连续未前进的查询次数 */
+	int32 StallCount = 0;
+};
@@ -0,0 +1,803 @@
+#!/usr/bin/env python3
+# Copyright 2025 Dream Moon. All Rights Reserved.
+"""
+DreamAccount 本地替身服务器（stand-in server）。
+
+只依赖 Python 标准库，在内存中模拟 64hzAccountServer 的接口，
+用于在没有真实服务端的开发机上调试插件。数据不落盘，重启即清空。
+
+用法:
+    python dream_account_stand_in.py [--host 127.0.0.1] [--port 8080] [--seed-users 100] [--token-ttl 60] [--kdf-log-n 14] [--login-rate 5]
+
+然后在项目设置中将 AccountServerURL 设置为 http://127.0.0.1:8080
+"""
+
+import argparse
+import base64
+import hashlib
+import hmac
+import json
+import re
+import secrets
+import struct
+import threading
+import time
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse, parse_qs
+
+
+class AccountStore:
+    """内存中的账号数据。"""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.users_by_id = {}
+        self.users_by_name = {}
+        self.tokens = {}
+        self.banned = {}
+        self.ban_version = 0
+        self.ban_log = []
+        self.next_user_id = 10000
+        self.token_ttl = 0
+        self.kdf_secret = secrets.token_bytes(16)
+        self.kdf_params = {"algorithm": "scrypt", "n": 16384, "r": 8, "p": 1, "length": 32}
+
+    def create_user(self, name, password, derived=False):
+        with self.lock:
+            if name in self.users_by_name:
+                return None
+            user = {"user_id": self.next_user_id, "user_name": name, "user_password": "" if derived else password,
+                    "kdf_verifier": kdf_verifier(password) if derived else ""}
+            self.next_user_id += 1
+            self.users_by_id[user["user_id"]] = user
+            self.users_by_name[name] = user
+            return user
+
+    def issue_token(self, user):
+        token = secrets.token_hex(24)
+        expires_at = time.time() + self.token_ttl if self.token_ttl > 0 else None
+        with self.lock:
+            self.tokens[token] = (user["user_id"], expires_at)
+        return token
+
+    def token_json(self, user):
+        """登录类接口返回的 token 字段，设置了 token_ttl 时附带 expires_in。"""
+        result = {"user": public_user(user), "token": self.issue_token(user)}
+        if self.token_ttl > 0:
+            result["expires_in"] = self.token_ttl
+        return result
+
+    def kdf_salt(self, name):
+        """按用户名生成固定的盐，不存在的用户名也返回参数，不泄露账号是否存在。"""
+        return hmac.new(self.kdf_secret, name.encode("utf-8"), hashlib.sha256).digest()[:16]
+
+    def check_password(self, user, password, derived):
+        """校验密码；客户端派生的密码与只有原始密码的旧账号比对成功时升级为派生校验值。"""
+        if not derived:
+            return bool(user["user_password"]) and user["user_password"] == password
+        if user["kdf_verifier"]:
+            return hmac.compare_digest(user["kdf_verifier"], kdf_verifier(password))
+        if not user["user_password"]:
+            return False
+        params = self.kdf_params
+        expected = hashlib.scrypt(user["user_password"].encode("utf-8"), salt=self.kdf_salt(user["user_name"]),
+                                  n=params["n"], r=params["r"], p=params["p"], dklen=params["length"],
+                                  maxmem=256 * 1024 * 1024).hex()
+        if not hmac.compare_digest(expected, password):
+            return False
+        with self.lock:
+            user["kdf_verifier"] = kdf_verifier(password)
+            user["user_password"] = ""
+        return True
+
+    def user_for_token(self, token, allow_expired=False):
+        with self.lock:
+            entry = self.tokens.get(token)
+            if entry is None:
+                return None
+            user_id, expires_at = entry
+            if not allow_expired and expires_at is not None and time.time() >= expires_at:
+                return None
+            return self.users_by_id.get(user_id)
+
+    def revoke_token(self, token):
+        with self.lock:
+            self.tokens.pop(token, None)
+
+    def revoke_tokens(self, user_id):
+        with self.lock:
+            for token in [t for t, entry in self.tokens.items() if entry[0] == user_id]:
+                del self.tokens[token]
+
+    def set_banned(self, user_id, reason, banned):
+        """修改封禁状态并记入变更日志，供 /api/account/bans 返回增量。"""
+        with self.lock:
+            if banned:
+                self.banned[user_id] = reason
+            else:
+                self.banned.pop(user_id, None)
+            self.ban_version += 1
+            self.ban_log.append((self.ban_version, user_id, banned))
+            del self.ban_log[:-BAN_LOG_LIMIT]
+
+    def bans_since(self, since):
+        """返回 since 之后的增量，日志已不包含该版本时返回完整快照。"""
+        with self.lock:
+            oldest = self.ban_log[0][0] - 1 if self.ban_log else self.ban_version
+            if since is None or since < oldest or since > self.ban_version:
+                return {"version": self.ban_version, "snapshot": True, "user_ids": list(self.banned)}
+            latest = {}
+            for version, user_id, banned in self.ban_log:
+                if version > since:
+                    latest[user_id] = banned
+            return {
+                "version": self.ban_version,
+                "snapshot": False,
+                "added": [user_id for user_id, banned in latest.items() if banned],
+                "removed": [user_id for user_id, banned in latest.items() if not banned],
+            }
+
+
+def kdf_verifier(derived_key):
+    """服务器只对客户端派生的结果做一次 SHA-256。"""
+    return hashlib.sha256(derived_key.encode("utf-8")).hexdigest()
+
+
+# 封禁变更日志保留的条数，更早的客户端需要重新下载快照
+BAN_LOG_LIMIT = 1024
+
+
+# 与插件内置的默认规则一致（FDreamAccountValidationRules::GetDefaultRulesJson）
+VALIDATION_RULES = {
+    "user_name": {"min_length": 3, "max_length": 32, "charset": "A-Za-z0-9_", "pattern": "", "check_on_login": True},
+    "user_password": {"min_length": 6, "max_length": 64, "charset": "", "pattern": "", "check_on_login": False},
+}
+
+
+def matches_rule(value, rule):
+    if len(value) < rule["min_length"] or (rule["max_length"] > 0 and len(value) > rule["max_length"]):
+        return False
+    if rule["charset"] and not re.fullmatch("[%s]*" % rule["charset"], value):
+        return False
+    if rule["pattern"] and not re.fullmatch(rule["pattern"], value):
+        return False
+    return True
+
+
+def validation_error(name, password, derived=False):
+    if not matches_rule(name, VALIDATION_RULES["user_name"]):
+        return "INVALID_USERNAME"
+    # 派生后的密码无法检查原始密码的规则，由客户端在派生前检查
+    if not derived and not matches_rule(password, VALIDATION_RULES["user_password"]):
+        return "INVALID_PASSWORD"
+    return None
+
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+
+class PushHub:
+    """推送通道上已连接的客户端，按 user_id 分组。"""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.clients = {}
+
+    def add(self, user_id, handler):
+        with self.lock:
+            self.clients.setdefault(user_id, []).append(handler)
+
+    def remove(self, user_id, handler):
+        with self.lock:
+            handlers = self.clients.get(user_id, [])
+            if handler in handlers:
+                handlers.remove(handler)
+
+    def send(self, user_id, payload, close=False):
+        with self.lock:
+            handlers = list(self.clients.get(user_id, []))
+        for handler in handlers:
+            try:
+                handler.ws_send(0x1, json.dumps(payload).encode("utf-8"))
+                if close:
+                    handler.ws_send(0x8, struct.pack("!H", 1000))
+            except OSError:
+                pass
+        return len(handlers)
+
+
+# 准入凭证的有效期（秒）
+ADMISSION_TTL = 30.0
+
+# 长轮询最多挂起的时间（秒）
+LONG_POLL_LIMIT = 30.0
+
+
+class LoginQueue:
+    """登录排队：每秒放行 rate 个登录，超出的登录领取票据，按序号依次放行。
+
+    放行游标按 rate 匀速前进，序号小于游标的票据已被放行；直接放行的登录也占用一个序号。
+    """
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.rate = 0.0
+        self.cursor = 0.0
+        self.issued = 0
+        self.advanced_at = time.monotonic()
+        self.tickets = {}
+        self.admissions = {}
+
+    def set_rate(self, rate):
+        with self.lock:
+            self.rate = max(rate, 0.0)
+            self.cursor = self.issued + self.burst()
+            self.advanced_at = time.monotonic()
+
+    def burst(self):
+        """空闲时最多积累一秒的放行额度，至少一个。"""
+        return max(self.rate, 1.0) if self.rate > 0 else 0.0
+
+    def _advance(self):
+        now = time.monotonic()
+        self.cursor = min(self.cursor + (now - self.advanced_at) * self.rate, self.issued + self.burst())
+        self.advanced_at = now
+
+    def _queue_json(self, ticket, sequence):
+        eta = (sequence + 1 - self.cursor) / self.rate
+        return {
+            "ticket": ticket,
+            "status": "waiting",
+            "position": sequence - int(self.cursor) + 1,
+            "eta_seconds": max(int(eta + 0.999), 0),
+            # 剩余时间越短查询越频繁，各客户端的查询时间随位置错开
+            "poll_after": min(max(round(eta / 4, 1), 1.0), 15.0),
+        }
+
+    def admit(self, name, admission):
+        """返回 None 表示放行，否则返回排队对象。"""
+        with self.lock:
+            if self.rate <= 0:
+                return None
+            found = self.admissions.pop(admission, None) if admission else None
+            if found and found[0] == name and found[1] > time.monotonic():
+                return None
+            self._advance()
+            # 同一用户再次登录时沿用原来的票据，不重新排到队尾
+            for ticket, (ticket_name, sequence) in self.tickets.items():
+                if ticket_name == name:
+                    return self._queue_json(ticket, sequence)
+            if self.cursor - self.issued >= 1.0:
+                self.issued += 1
+                return None
+            ticket = secrets.token_hex(16)
+            sequence = self.issued
+            self.issued += 1
+            self.tickets[ticket] = (name, sequence)
+            return self._queue_json(ticket, sequence)
+
+    def poll(self, ticket, wait):
+        """返回排队对象，票据不存在时返回 None；wait 大于 0 时挂起到放行或超时。"""
+        deadline = time.monotonic() + min(max(wait, 0.0), LONG_POLL_LIMIT)
+        while True:
+            with self.lock:
+                entry = self.tickets.get(ticket)
+                if entry is None:
+                    return None
+                self._advance()
+                name, sequence = entry
+                if sequence < self.cursor:
+                    del self.tickets[ticket]
+                    now = time.monotonic()
+                    self.admissions = {key: value for key, value in self.admissions.items() if value[1] > now}
+                    admission = secrets.token_hex(16)
+                    self.admissions[admission] = (name, now + ADMISSION_TTL)
+                    return {"ticket": ticket, "status": "admitted", "admission": admission}
+                remaining = deadline - time.monotonic()
+                if remaining <= 0:
+                    queue = self._queue_json(ticket, sequence)
+                    if wait > 0:
+                        # 长轮询的客户端可以立即再次查询
+                        queue["poll_after"] = 0
+                    return queue
+                until_admitted = (sequence + 1 - self.cursor) / self.rate
+            time.sleep(min(remaining, max(until_admitted, 0.05)))
+
+    def leave(self, ticket):
+        with self.lock:
+            return self.tickets.pop(ticket, None) is not None
+
+
+# 收集器接口保留的 span 数
+SPAN_LIMIT = 10000
+
+
+class LatencyMetrics:
+    """按地区和接口合并客户端上传的延迟直方图，并保存收集器接口收到的 span。"""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.batches = 0
+        self.bounds_ms = []
+        self.endpoints = {}
+        self.spans = []
+
+    def merge(self, batch):
+        with self.lock:
+            self.batches += 1
+            self.bounds_ms = batch.get("bounds_ms", self.bounds_ms)
+            region = batch.get("region", "")
+            for endpoint in batch.get("endpoints", []):
+                key = (region, endpoint.get("endpoint", ""))
+                merged = self.endpoints.setdefault(key, {"count": 0, "failures": 0, "server_errors": 0,
+                                                         "first_byte": [], "total": [], "total_sum_ms": 0.0})
+                for field in ("count", "failures", "server_errors", "total_sum_ms"):
+                    merged[field] += endpoint.get(field, 0)
+                for field in ("first_byte", "total"):
+                    counts = endpoint.get(field, [])
+                    merged[field] += [0] * (len(counts) - len(merged[field]))
+                    for index, value in enumerate(counts):
+                        merged[field][index] += value
+
+    def add_spans(self, spans):
+        with self.lock:
+            self.spans.extend(spans)
+            del self.spans[:-SPAN_LIMIT]
+
+    def spans_for(self, trace_id):
+        with self.lock:
+            return [span for span in self.spans if trace_id is None or span.get("traceId") == trace_id]
+
+    def summary(self):
+        with self.lock:
+            return {
+                "batches": self.batches,
+                "bounds_ms": self.bounds_ms,
+                "endpoints": [dict(values, region=region, endpoint=endpoint)
+                              for (region, endpoint), values in self.endpoints.items()],
+            }
+
+
+def read_credentials(handler):
+    """读取用户名和密码，返回 (name, password, derived, error)。"""
+    body = handler.read_json()
+    if not body or not body.get("user_name") or not body.get("user_password"):
+        return None, None, False, "MISSING_FIELDS"
+    kdf = body.get("password_kdf") or ""
+    if kdf and kdf != "scrypt":
+        return None, None, False, "VALIDATION_ERROR"
+    return body["user_name"], body["user_password"], bool(kdf), None
+
+
+def public_user(user):
+    return {"user_id": user["user_id"], "user_name": user["user_name"]}
+
+
+class StandInHandler(BaseHTTPRequestHandler):
+    store = AccountStore()
+    push_hub = PushHub()
+    metrics = LatencyMetrics()
+    login_queue = LoginQueue()
+    routes = {}
+
+    protocol_version = "HTTP/1.1"
+
+    # ------------------------------------------------------------------
+    # 基础设施
+
+    def send_json(self, status, payload, headers=None):
+        body = json.dumps(payload).encode("utf-8")
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json;charset=UTF-8")
+        self.send_header("Content-Length", str(len(body)))
+        for key, value in (headers or {}).items():
+            self.send_header(key, value)
+        self.end_headers()
+        self.wfile.write(body)
+
+    def send_cacheable_json(self, payload):
+        """带 ETag 发送 200 响应，请求的 If-None-Match 与内容一致时只返回 304。"""
+        body = json.dumps(payload).encode("utf-8")
+        etag = '"%s"' % hashlib.sha256(body).hexdigest()[:16]
+        if self.headers.get("If-None-Match") == etag:
+            self.send_response(304)
+            self.send_header("ETag", etag)
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json;charset=UTF-8")
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("ETag", etag)
+        self.end_headers()
+        self.wfile.write(body)
+
+    def send_error_code(self, status, code):
+        self.send_json(status, {"error": code})
+
+    def read_body(self):
+        length = int(self.headers.get("Content-Length") or 0)
+        return self.rfile.read(length) if length > 0 else b""
+
+    def read_json(self):
+        try:
+            return json.loads(self.read_body() or b"{}")
+        except ValueError:
+            return None
+
+    def ws_send(self, opcode, payload):
+        header = bytes([0x80 | opcode])
+        if len(payload) < 126:
+            header += bytes([len(payload)])
+        elif len(payload) < 65536:
+            header += bytes([126]) + struct.pack("!H", len(payload))
+        else:
+            header += bytes([127]) + struct.pack("!Q", len(payload))
+        with self.ws_lock:
+            self.wfile.write(header + payload)
+            self.wfile.flush()
+
+    def ws_read(self):
+        head = self.rfile.read(2)
+        if len(head) < 2:
+            return 0x8, b""
+        opcode = head[0] & 0x0F
+        length = head[1] & 0x7F
+        if length == 126:
+            length = struct.unpack("!H", self.rfile.read(2))[0]
+        elif length == 127:
+            length = struct.unpack("!Q", self.rfile.read(8))[0]
+        mask = self.rfile.read(4) if head[1] & 0x80 else None
+        payload = self.rfile.read(length)
+        if mask:
+            payload = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+        return opcode, payload
+
+    def bearer_user(self):
+        header = self.headers.get("Authorization")
+        if not header:
+            self.send_error_code(401, "USER_NOT_AUTHENTICATED")
+            return None
+        if not header.startswith("Bearer "):
+            self.send_error_code(401, "INVALID_AUTH_HEADER")
+            return None
+        user = self.store.user_for_token(header[len("Bearer "):])
+        if user is None:
+            self.send_error_code(401, "INVALID_TOKEN")
+        elif user["user_id"] in self.store.banned:
+            self.send_error_code(403, "USER_BANNED")
+            return None
+        return user
+
+    def dispatch(self, verb):
+        parsed = urlparse(self.path)
+        handler = self.routes.get((verb, parsed.path))
+        if handler is None:
+            self.read_body()
+            self.send_error_code(404, "NOT_FOUND")
+            return
+        self.query = parse_qs(parsed.query)
+        handler(self)
+
+    def do_GET(self):
+        self.dispatch("GET")
+
+    def do_POST(self):
+        self.dispatch("POST")
+
+    def log_message(self, fmt, *args):
+        # 带上客户端的 trace-id，便于与插件导出的 span 对应
+        parts = (self.headers.get("traceparent", "") if self.headers else "").split("-")
+        trace = " trace=%s parent=%s" % (parts[1], parts[2]) if len(parts) == 4 else ""
+        print("[stand-in] %s - %s%s" % (self.address_string(), fmt % args, trace))
+
+
+def route(verb, path):
+    def decorator(func):
+        StandInHandler.routes[(verb, path)] = func
+        return func
+    return decorator
+
+
+# ----------------------------------------------------------------------
+# 账号接口
+
+@route("POST", "/api/account/register")
+def handle_register(handler):
+    name, password, derived, error = read_credentials(handler)
+    if error:
+        return handler.send_error_code(400, error)
+    error = validation_error(name, password, derived)
+    if error:
+        return handler.send_error_code(400, error)
+    user = handler.store.create_user(name, password, derived)
+    if user is None:
+        return handler.send_error_code(409, "USERNAME_EXISTS")
+    handler.send_json(201, {"user": public_user(user)})
+
+
+@route("POST", "/api/account/login")
+def handle_login(handler):
+    name, password, derived, error = read_credentials(handler)
+    if error:
+        return handler.send_error_code(400, error)
+    user = handler.store.users_by_name.get(name)
+    if user is None:
+        return handler.send_error_code(404, "USER_NOT_FOUND")
+    if not handler.store.check_password(user, password, derived):
+        return handler.send_error_code(401, "INVALID_CREDENTIALS")
+    if user["user_id"] in handler.store.banned:
+        return handler.send_error_code(403, "USER_BANNED")
+    queue = handler.login_queue.admit(name, handler.headers.get("X-Queue-Admission"))
+    if queue is not None:
+        return handler.send_json(429, {"error": "TOO_MANY_REQUESTS", "queue": queue})
+    handler.send_json(200, handler.store.token_json(user))
+
+
+@route("GET", "/api/account/login/queue")
+def handle_login_queue(handler):
+    ticket = handler.query.get("ticket", [""])[0]
+    try:
+        wait = float(handler.query.get("wait", ["0"])[0])
+    except ValueError:
+        wait = 0.0
+    queue = handler.login_queue.poll(ticket, wait)
+    if queue is None:
+        return handler.send_error_code(404, "QUEUE_TICKET_NOT_FOUND")
+    handler.send_json(200, {"queue": queue})
+
+
+@route("POST", "/api/account/login/queue/leave")
+def handle_login_queue_leave(handler):
+    body = handler.read_json() or {}
+    if not body.get("ticket"):
+        return handler.send_error_code(400, "MISSING_FIELDS")
+    handler.send_json(200, {"left": handler.login_queue.leave(body["ticket"])})
+
+
+@route("POST", "/api/account/register_login")
+def handle_register_login(handler):
+    name, password, derived, error = read_credentials(handler)
+    if error:
+        return handler.send_error_code(400, error)
+    error = validation_error(name, password, derived)
+    if error:
+        return handler.send_error_code(400, error)
+    user = handler.store.create_user(name, password, derived)
+    if user is None:
+        return handler.send_error_code(409, "USERNAME_EXISTS")
+    handler.send_json(201, handler.store.token_json(user))
+
+
+@route("GET", "/api/account/auth")
+def handle_auth(handler):
+    user = handler.bearer_user()
+    if user is not None:
+        handler.send_cacheable_json({"user": public_user(user)})
+
+
+@route("POST", "/api/account/refresh")
+def handle_refresh(handler):
+    """用当前令牌换取新令牌，已过期（但未被吊销）的令牌也可以刷新。"""
+    handler.read_body()
+    header = handler.headers.get("Authorization", "")
+    if not header.startswith("Bearer "):
+        return handler.send_error_code(401, "USER_NOT_AUTHENTICATED")
+    old_token = header[len("Bearer "):]
+    user = handler.store.user_for_token(old_token, allow_expired=True)
+    if user is None:
+        return handler.send_error_code(401, "INVALID_TOKEN")
+    if user["user_id"] in handler.store.banned:
+        return handler.send_error_code(403, "USER_BANNED")
+    handler.store.revoke_token(old_token)
+    handler.send_json(200, handler.store.token_json(user))
+
+
+@route("GET", "/api/account/validation_rules")
+def handle_validation_rules(handler):
+    handler.send_json(200, VALIDATION_RULES)
+
+
+@route("GET", "/api/account/username_available")
+def handle_username_available(handler):
+    name = (handler.query.get("user_name") or [""])[0]
+    if not name:
+        return handler.send_error_code(400, "MISSING_FIELDS")
+    # 同时返回所有已被占用的前缀，客户端据此缓存更短的用户名
+    taken = [name[:n] for n in range(1, len(name) + 1) if name[:n] in handler.store.users_by_name]
+    handler.send_json(200, {"available": name not in handler.store.users_by_name, "taken_prefixes": taken})
+
+
+@route("GET", "/api/account/kdf_params")
+def handle_kdf_params(handler):
+    name = (handler.query.get("user_name") or [""])[0]
+    if not name:
+        return handler.send_error_code(400, "MISSING_FIELDS")
+    params = dict(handler.store.kdf_params)
+    params["salt"] = base64.b64encode(handler.store.kdf_salt(name)).decode("ascii")
+    handler.send_json(200, params)
+
+
+@route("GET", "/api/account/bans")
+def handle_bans(handler):
+    since = (handler.query.get("since") or [None])[0]
+    try:
+        since = int(since) if since is not None else None
+    except ValueError:
+        return handler.send_error_code(400, "MISSING_FIELDS")
+    handler.send_json(200, handler.store.bans_since(since))
+
+
+@route("POST", "/api/account/users/lookup")
+def handle_users_lookup(handler):
+    body = handler.read_json()
+    if not body or not isinstance(body.get("user_ids"), list):
+        return handler.send_error_code(400, "MISSING_FIELDS")
+    users = []
+    for user_id in body["user_ids"]:
+        user = handler.store.users_by_id.get(user_id)
+        if user is not None:
+            users.append(public_user(user))
+    handler.send_cacheable_json({"users": users})
+
+
+# ----------------------------------------------------------------------
+# 推送通道（WebSocket）
+
+@route("GET", "/api/account/push")
+def handle_push(handler):
+    key = handler.headers.get("Sec-WebSocket-Key")
+    if not key or handler.headers.get("Upgrade", "").lower() != "websocket":
+        return handler.send_error_code(400, "VALIDATION_ERROR")
+    user = handler.bearer_user()
+    if user is None:
+        return
+
+    accept = base64.b64encode(hashlib.sha1((key + WS_GUID).encode("ascii")).digest()).decode("ascii")
+    handler.send_response(101)
+    handler.send_header("Upgrade", "websocket")
+    handler.send_header("Connection", "Upgrade")
+    handler.send_header("Sec-WebSocket-Accept", accept)
+    handler.end_headers()
+    handler.wfile.flush()
+
+    handler.ws_lock = threading.Lock()
+    handler.push_hub.add(user["user_id"], handler)
+    try:
+        while True:
+            opcode, payload = handler.ws_read()
+            if opcode == 0x8:
+                handler.ws_send(0x8, payload[:2])
+                break
+            if opcode == 0x9:
+                handler.ws_send(0xA, payload)
+    except OSError:
+        pass
+    finally:
+        handler.push_hub.remove(user["user_id"], handler)
+        handler.close_connection = True
+
+
+# ----------------------------------------------------------------------
+# 客户端延迟信标
+
+@route("POST", "/api/account/metrics/latency")
+def handle_latency_beacons(handler):
+    """接收一批压缩的延迟直方图：{"encoding": "zlib", "size": 原始字节数, "data": Base64}。"""
+    body = handler.read_json()
+    if not body or body.get("encoding") != "zlib" or not isinstance(body.get("data"), str):
+        return handler.send_error_code(400, "MISSING_FIELDS")
+    try:
+        batch = json.loads(zlib.decompress(base64.b64decode(body["data"])))
+    except (ValueError, zlib.error):
+        return handler.send_error_code(400, "VALIDATION_ERROR")
+    handler.metrics.merge(batch)
+    handler.send_response(204)
+    handler.send_header("Content-Length", "0")
+    handler.end_headers()
+
+
+@route("POST", "/v1/traces")
+def handle_otlp_traces(handler):
+    """最简单的 OTLP/HTTP JSON 收集器，保存最近收到的 span。"""
+    body = handler.read_json()
+    if body is None:
+        return handler.send_error_code(400, "VALIDATION_ERROR")
+    spans = [span for resource in body.get("resourceSpans", [])
+             for scope in resource.get("scopeSpans", [])
+             for span in scope.get("spans", [])]
+    handler.metrics.add_spans(spans)
+    handler.send_json(200, {})
+
+
+@route("GET", "/v1/traces")
+def handle_otlp_trace_list(handler):
+    """按 trace_id 查询参数过滤收到的 span，供测试检查导出结果。"""
+    trace_id = (handler.query.get("trace_id") or [None])[0]
+    handler.send_json(200, {"spans": handler.metrics.spans_for(trace_id)})
+
+
+@route("GET", "/api/account/metrics/latency")
+def handle_latency_summary(handler):
+    """返回合并后的直方图，供测试检查上传结果。"""
+    handler.send_json(200, handler.metrics.summary())
+
+
+# ----------------------------------------------------------------------
+# 管理接口：用于在测试中触发推送事件
+
+def admin_target(handler):
+    body = handler.read_json()
+    if not body or not isinstance(body.get("user_id"), int):
+        handler.send_error_code(400, "MISSING_FIELDS")
+        return None, None
+    return body["user_id"], body.get("reason", "")
+
+
+@route("POST", "/api/admin/revoke")
+def handle_admin_revoke(handler):
+    user_id, reason = admin_target(handler)
+    if user_id is not None:
+        handler.store.revoke_tokens(user_id)
+        sent = handler.push_hub.send(user_id, {"type": "token_revoked", "reason": reason}, close=True)
+        handler.send_json(200, {"notified": sent})
+
+
+@route("POST", "/api/admin/ban")
+def handle_admin_ban(handler):
+    user_id, reason = admin_target(handler)
+    if user_id is not None:
+        handler.store.set_banned(user_id, reason, True)
+        handler.store.revoke_tokens(user_id)
+        sent = handler.push_hub.send(user_id, {"type": "user_banned", "reason": reason}, close=True)
+        handler.send_json(200, {"notified": sent})
+
+
+@route("POST", "/api/admin/unban")
+def handle_admin_unban(handler):
+    user_id, reason = admin_target(handler)
+    if user_id is not None:
+        handler.store.set_banned(user_id, reason, False)
+        handler.send_json(200, {})
+
+
+@route("POST", "/api/admin/force_logout")
+def handle_admin_force_logout(handler):
+    user_id, reason = admin_target(handler)
+    if user_id is not None:
+        handler.store.revoke_tokens(user_id)
+        sent = handler.push_hub.send(user_id, {"type": "force_logout", "reason": reason}, close=True)
+        handler.send_json(200, {"notified": sent})
+
+
+# ----------------------------------------------------------------------
+
+def main():
+    parser = argparse.ArgumentParser(description="DreamAccount stand-in server")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--seed-users", type=int, default=0, help="预先创建 user_0 ... user_N 账号，密码同用户名")
+    parser.add_argument("--token-ttl", type=int, default=0, help="令牌有效期（秒），0 表示永不过期")
+    parser.add_argument("--kdf-log-n", type=int, default=14, help="下发给客户端的 scrypt 参数 N 的以 2 为底的对数")
+    parser.add_argument("--login-rate", type=float, default=0, help="每秒放行的登录数，超出的登录进入排队，0 表示不限制")
+    args = parser.parse_args()
+
+    StandInHandler.store.token_ttl = args.token_ttl
+    StandInHandler.store.kdf_params["n"] = 1 << args.kdf_log_n
+    StandInHandler.login_queue.set_rate(args.login_rate)
+
+    for index in range(args.seed_users):
+        name = "user_%d" % index
+        StandInHandler.store.create_user(name, name)
+
+    server = ThreadingHTTPServer((args.host, args.port), StandInHandler)
+    print("[stand-in] listening on http://%s:%d" % (args.host, args.port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()